@@ -12,12 +12,30 @@ namespace KaldiNativeFbankSharp.DLL
         [DllImport(dllName, EntryPoint = "GetFbankOptions", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
         internal static extern IntPtr GetFbankOptions(float dither, bool snip_edges, float sample_rate, int num_bins, int num_ceps = 40, float frame_shift = 10.0f, float frame_length = 25.0f, float energy_floor = 0.0f, bool debug_mel = false, string window_type = "hamming", string feature_type = "fbank");
 
+        [DllImport(dllName, EntryPoint = "SetWindowType", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SetWindowType(IntPtr opts, int window_type, bool periodic, float coeff);
+
         [DllImport(dllName, EntryPoint = "GetOnlineFbank", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
         internal static extern KnfOnlineFeature GetOnlineFbank(IntPtr opts);
 
+        [DllImport(dllName, EntryPoint = "GetOnlineMultiFeature", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern KnfOnlineFeature GetOnlineMultiFeature(IntPtr opts, int[] heads, int num_heads);
+
+        [DllImport(dllName, EntryPoint = "GetFeatureHeadLayout", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetFeatureHeadLayout(KnfOnlineFeature knfOnlineFeature, int head, out int offset, out int dim);
+
         [DllImport(dllName, EntryPoint = "AcceptWaveform", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
         internal static extern void AcceptWaveform(KnfOnlineFeature knfOnlineFeature, float sample_rate, float[] samples, int samples_size);
 
+        [DllImport(dllName, EntryPoint = "AcceptWaveformInterleaved", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int AcceptWaveformInterleaved(KnfOnlineFeature knfOnlineFeature, float sample_rate, float[] samples, int num_frames, int num_channels);
+
+        [DllImport(dllName, EntryPoint = "AcceptWaveformChannels", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int AcceptWaveformChannels(IntPtr[] handles, int num_channels, float sample_rate, float[] samples, int num_frames);
+
+        [DllImport(dllName, EntryPoint = "ComputeFeaturesFromFile", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern long ComputeFeaturesFromFile(KnfOnlineFeature knfOnlineFeature, string filename, int raw_format, float raw_sample_rate, int raw_num_channels, bool normalize);
+
         [DllImport(dllName, EntryPoint = "InputFinished", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
         internal static extern void InputFinished(KnfOnlineFeature knfOnlineFeature);
 
@@ -30,5 +48,168 @@ namespace KaldiNativeFbankSharp.DLL
         [DllImport(dllName, EntryPoint = "GetFbanks", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
         internal static extern void GetFbanks(KnfOnlineFeature knfOnlineFeature, int lastFrameIndex, ref FbankDatas fbankDatas);
 
+        /// <summary>
+        /// callback: native function pointer void(IntPtr user_data, IntPtr frames, int num_frames, int dim, int first_frame),
+        /// e.g. an [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) })] method or Marshal.GetFunctionPointerForDelegate
+        /// </summary>
+        [DllImport(dllName, EntryPoint = "SetFramesCallback", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void SetFramesCallback(KnfOnlineFeature knfOnlineFeature, IntPtr callback, IntPtr user_data, bool async);
+
+        [DllImport(dllName, EntryPoint = "FlushFramesCallback", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void FlushFramesCallback(KnfOnlineFeature knfOnlineFeature);
+
+        [DllImport(dllName, EntryPoint = "DestroyOnlineFbank", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void DestroyOnlineFbank(KnfOnlineFeature knfOnlineFeature);
+
+        [DllImport(dllName, EntryPoint = "EnableIngestQueue", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int EnableIngestQueue(KnfOnlineFeature knfOnlineFeature, float sample_rate, int capacity, int overrun_policy, int worker_interval_ms);
+
+        [DllImport(dllName, EntryPoint = "PushWaveform", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int PushWaveform(KnfOnlineFeature knfOnlineFeature, float[] samples, int samples_size);
+
+        [DllImport(dllName, EntryPoint = "GetIngestStats", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void GetIngestStats(KnfOnlineFeature knfOnlineFeature, ref KnfIngestStats pStats);
+
+        [DllImport(dllName, EntryPoint = "GetFeatureDim", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetFeatureDim(KnfOnlineFeature knfOnlineFeature);
+
+        [DllImport(dllName, EntryPoint = "GetNumFramesPublished", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetNumFramesPublished(KnfOnlineFeature knfOnlineFeature);
+
+        [DllImport(dllName, EntryPoint = "ReadFrames", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int ReadFrames(KnfOnlineFeature knfOnlineFeature, int begin, int end, float[] output);
+
+        [DllImport(dllName, EntryPoint = "ReadFramesAs", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int ReadFramesAs(KnfOnlineFeature knfOnlineFeature, int begin, int end, int format, ushort[] output, float[]? row_scales);
+
+        [DllImport(dllName, EntryPoint = "ReadFramesAs", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int ReadFramesAsInt8(KnfOnlineFeature knfOnlineFeature, int begin, int end, int format, sbyte[] output, float[] row_scales);
+
+        [DllImport(dllName, EntryPoint = "ReleaseFrames", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void ReleaseFrames(KnfOnlineFeature knfOnlineFeature, int end);
+
+        [DllImport(dllName, EntryPoint = "ReadFramesChannels", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int ReadFramesChannels(IntPtr[] handles, int num_channels, int begin, int end, float[] output);
+
+        [DllImport(dllName, EntryPoint = "CompressFrames", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CompressFrames(KnfOnlineFeature knfOnlineFeature, int begin, int end, int method, byte[]? output, int out_size);
+
+        [DllImport(dllName, EntryPoint = "DecompressMatrix", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int DecompressMatrix(byte[] data, int size, out int rows, out int cols, float[]? output, int out_size);
+
+        [DllImport(dllName, EntryPoint = "GetOptionsFingerprint", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern ulong GetOptionsFingerprint(KnfOnlineFeature knfOnlineFeature);
+
+        [DllImport(dllName, EntryPoint = "SaveState", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SaveState(KnfOnlineFeature knfOnlineFeature, byte[]? output, int out_size);
+
+        [DllImport(dllName, EntryPoint = "LoadState", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int LoadState(KnfOnlineFeature knfOnlineFeature, byte[] data, int size);
+
+        [DllImport(dllName, EntryPoint = "CreateFeatureStoreWriter", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern IntPtr CreateFeatureStoreWriter(string filename);
+
+        [DllImport(dllName, EntryPoint = "FeatureStoreWrite", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int FeatureStoreWrite(IntPtr writer, string key, float[] data, int rows, int cols, ulong fingerprint);
+
+        [DllImport(dllName, EntryPoint = "CloseFeatureStoreWriter", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CloseFeatureStoreWriter(IntPtr writer);
+
+        [DllImport(dllName, EntryPoint = "OpenFeatureStore", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern IntPtr OpenFeatureStore(string filename);
+
+        [DllImport(dllName, EntryPoint = "FeatureStoreNumUtterances", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int FeatureStoreNumUtterances(IntPtr store);
+
+        [DllImport(dllName, EntryPoint = "FeatureStoreFind", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int FeatureStoreFind(IntPtr store, string key);
+
+        [DllImport(dllName, EntryPoint = "FeatureStoreGetKey", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern IntPtr FeatureStoreGetKey(IntPtr store, int index);
+
+        [DllImport(dllName, EntryPoint = "FeatureStoreGetInfo", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int FeatureStoreGetInfo(IntPtr store, int index, out int rows, out int cols, out ulong fingerprint);
+
+        [DllImport(dllName, EntryPoint = "FeatureStoreGetFrames", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern IntPtr FeatureStoreGetFrames(IntPtr store, int index, int begin, int end);
+
+        [DllImport(dllName, EntryPoint = "CloseFeatureStore", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void CloseFeatureStore(IntPtr store);
+
+        [DllImport(dllName, EntryPoint = "CreateFeatureCache", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern IntPtr CreateFeatureCache(long max_memory_bytes, string? directory);
+
+        [DllImport(dllName, EntryPoint = "DestroyFeatureCache", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void DestroyFeatureCache(IntPtr cache);
+
+        [DllImport(dllName, EntryPoint = "GetFeatureCacheStats", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void GetFeatureCacheStats(IntPtr cache, ref KnfFeatureCacheStats pStats);
+
+        [DllImport(dllName, EntryPoint = "ResetFeatureCacheStats", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void ResetFeatureCacheStats(IntPtr cache);
+
+        [DllImport(dllName, EntryPoint = "GetOfflineFeature", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern IntPtr GetOfflineFeature(IntPtr opts);
+
+        [DllImport(dllName, EntryPoint = "SetOfflineFeatureCache", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void SetOfflineFeatureCache(IntPtr knfOfflineFeature, IntPtr cache);
+
+        [DllImport(dllName, EntryPoint = "GetOfflineFeatureDim", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetOfflineFeatureDim(IntPtr knfOfflineFeature);
+
+        [DllImport(dllName, EntryPoint = "GetOfflineNumFrames", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetOfflineNumFrames(IntPtr knfOfflineFeature, long num_samples);
+
+        [DllImport(dllName, EntryPoint = "ComputeOfflineFeatures", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int ComputeOfflineFeatures(IntPtr knfOfflineFeature, float[] samples, int num_samples, float[] output, int out_size);
+
+        [DllImport(dllName, EntryPoint = "DestroyOfflineFeature", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void DestroyOfflineFeature(IntPtr knfOfflineFeature);
+
+        [DllImport(dllName, EntryPoint = "SetFrameRetention", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void SetFrameRetention(KnfOnlineFeature knfOnlineFeature, int max_frames, long max_bytes, bool release_on_read);
+
+        [DllImport(dllName, EntryPoint = "GetFrameStoreStats", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void GetFrameStoreStats(KnfOnlineFeature knfOnlineFeature, ref KnfFrameStoreStats pStats);
+
+        [DllImport(dllName, EntryPoint = "GetFeatureStats", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void GetFeatureStats(KnfOnlineFeature knfOnlineFeature, out KnfStats pStats);
+
+        [DllImport(dllName, EntryPoint = "GetGlobalFeatureStats", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void GetGlobalFeatureStats(out KnfStats pStats);
+
+        [DllImport(dllName, EntryPoint = "ResetFeatureStats", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void ResetFeatureStats(KnfOnlineFeature knfOnlineFeature);
+
+        [DllImport(dllName, EntryPoint = "ResetGlobalFeatureStats", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void ResetGlobalFeatureStats();
+
+        [DllImport(dllName, EntryPoint = "SetLfrCmvn", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SetLfrCmvn(KnfOnlineFeature knfOnlineFeature, int lfr_m, int lfr_n, string? mvn_filename);
+
+        [DllImport(dllName, EntryPoint = "SetLfrCmvnStats", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SetLfrCmvnStats(KnfOnlineFeature knfOnlineFeature, int lfr_m, int lfr_n, float[] neg_mean, float[] inv_stddev, int dim);
+
+        [DllImport(dllName, EntryPoint = "SetOnlineCmvn", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SetOnlineCmvn(KnfOnlineFeature knfOnlineFeature, int cmn_window, int speaker_frames, int global_frames, bool normalize_variance, double[]? global_stats, double[]? speaker_stats, int stats_size);
+
+        [DllImport(dllName, EntryPoint = "GetOnlineCmvnSpeakerStats", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetOnlineCmvnSpeakerStats(KnfOnlineFeature knfOnlineFeature, double[] speaker_stats, int stats_size);
+
+        [DllImport(dllName, EntryPoint = "SetDeltas", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SetDeltas(KnfOnlineFeature knfOnlineFeature, int order, int window);
+
+        [DllImport(dllName, EntryPoint = "EnableVad", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int EnableVad(KnfOnlineFeature knfOnlineFeature, float energy_threshold, float unvoiced_energy_margin, float zcr_threshold, int hangover_frames, IntPtr callback, IntPtr user_data);
+
+        [DllImport(dllName, EntryPoint = "GetVadFlags", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetVadFlags(KnfOnlineFeature knfOnlineFeature, int begin, int end, byte[] flags);
+
+        [DllImport(dllName, EntryPoint = "GetVadState", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetVadState(KnfOnlineFeature knfOnlineFeature, ref KnfVadState pState);
+
+        [DllImport(dllName, EntryPoint = "GetStageLatency", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetStageLatency(KnfOnlineFeature knfOnlineFeature);
+
     }
 }
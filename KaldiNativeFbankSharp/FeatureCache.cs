@@ -0,0 +1,72 @@
+﻿// See https://github.com/manyeyes for more information
+// Copyright (c)  2026 by manyeyes
+using KaldiNativeFbankSharp.DLL;
+using KaldiNativeFbankSharp.Struct;
+
+namespace KaldiNativeFbankSharp
+{
+    /// <summary>
+    /// Cache of the features of whole utterances, keyed by a hash of the audio and the feature options,
+    /// so that repeated audio is not processed again. Share one between OfflineFbank objects, also across threads.
+    /// </summary>
+    public class FeatureCache : IDisposable
+    {
+        internal IntPtr _cache;
+
+        /// <param name="maxMemoryBytes">bound on the features kept in memory, least recently used first out; 0 = none</param>
+        /// <param name="directory">existing directory to also keep the features on disk, across runs; null = none</param>
+        public FeatureCache(long maxMemoryBytes = 256L << 20, string? directory = null)
+        {
+            _cache = KaldiNativeFbank.CreateFeatureCache(maxMemoryBytes, directory);
+        }
+
+        /// <summary>
+        /// Hit/miss counters and the size of the memory tier
+        /// </summary>
+        public KnfFeatureCacheStats GetStats()
+        {
+            KnfFeatureCacheStats stats = new KnfFeatureCacheStats();
+            KaldiNativeFbank.GetFeatureCacheStats(Handle, ref stats);
+            return stats;
+        }
+
+        public void ResetStats()
+        {
+            KaldiNativeFbank.ResetFeatureCacheStats(Handle);
+        }
+
+        internal IntPtr Handle
+        {
+            get
+            {
+                if (_cache == IntPtr.Zero)
+                {
+                    throw new ObjectDisposedException(nameof(FeatureCache));
+                }
+                return _cache;
+            }
+        }
+
+        /// <summary>
+        /// OfflineFbank objects using the cache keep it alive until they are disposed
+        /// </summary>
+        public void Dispose()
+        {
+            if (_cache != IntPtr.Zero)
+            {
+                KaldiNativeFbank.DestroyFeatureCache(_cache);
+                _cache = IntPtr.Zero;
+            }
+            GC.SuppressFinalize(this);
+        }
+
+        ~FeatureCache()
+        {
+            if (_cache != IntPtr.Zero)
+            {
+                KaldiNativeFbank.DestroyFeatureCache(_cache);
+                _cache = IntPtr.Zero;
+            }
+        }
+    }
+}
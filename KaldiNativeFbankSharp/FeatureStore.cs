@@ -0,0 +1,167 @@
+﻿// See https://github.com/manyeyes for more information
+// Copyright (c)  2026 by manyeyes
+using KaldiNativeFbankSharp.DLL;
+using System.Runtime.InteropServices;
+
+namespace KaldiNativeFbankSharp
+{
+    /// <summary>
+    /// Writes an indexed feature store: one matrix per utterance, read back with FeatureStore
+    /// </summary>
+    public class FeatureStoreWriter : IDisposable
+    {
+        private IntPtr _writer;
+
+        public FeatureStoreWriter(string path)
+        {
+            _writer = KaldiNativeFbank.CreateFeatureStoreWriter(path);
+            if (_writer == IntPtr.Zero)
+            {
+                throw new IOException("cannot create " + path);
+            }
+        }
+
+        /// <summary>
+        /// Append the features of an utterance
+        /// </summary>
+        /// <param name="frames">rows * cols floats, row major, e.g. from OnlineFbank.ReadFrames</param>
+        /// <param name="fingerprint">e.g. OnlineFbank.GetOptionsFingerprint()</param>
+        /// <returns>false if the key was already written or the matrix is empty</returns>
+        public bool Write(string key, float[] frames, int cols, ulong fingerprint = 0)
+        {
+            if (_writer == IntPtr.Zero)
+            {
+                throw new ObjectDisposedException(nameof(FeatureStoreWriter));
+            }
+            return KaldiNativeFbank.FeatureStoreWrite(_writer, key, frames, frames.Length / cols, cols, fingerprint) == 0;
+        }
+
+        /// <summary>
+        /// Write the index; the store can be read afterwards
+        /// </summary>
+        /// <returns>false if the store is incomplete, e.g. the disk is full</returns>
+        public bool Close()
+        {
+            if (_writer == IntPtr.Zero)
+            {
+                return false;
+            }
+            bool ok = KaldiNativeFbank.CloseFeatureStoreWriter(_writer) == 0;
+            _writer = IntPtr.Zero;
+            return ok;
+        }
+
+        public void Dispose()
+        {
+            Close();
+            GC.SuppressFinalize(this);
+        }
+
+        ~FeatureStoreWriter()
+        {
+            Close();
+        }
+    }
+
+    /// <summary>
+    /// Random access to the utterances of a feature store. The file is memory mapped;
+    /// GetFramesPointer returns pointers into the mapping, valid until the store is disposed.
+    /// </summary>
+    public class FeatureStore : IDisposable
+    {
+        private IntPtr _store;
+
+        public FeatureStore(string path)
+        {
+            _store = KaldiNativeFbank.OpenFeatureStore(path);
+            if (_store == IntPtr.Zero)
+            {
+                throw new IOException(path + " is not a feature store");
+            }
+        }
+
+        public int NumUtterances => KaldiNativeFbank.FeatureStoreNumUtterances(Handle);
+
+        /// <summary>
+        /// Index of an utterance, -1 if there is none
+        /// </summary>
+        public int Find(string key)
+        {
+            return KaldiNativeFbank.FeatureStoreFind(Handle, key);
+        }
+
+        public string GetKey(int index)
+        {
+            IntPtr key = KaldiNativeFbank.FeatureStoreGetKey(Handle, index);
+            if (key == IntPtr.Zero)
+            {
+                throw new ArgumentOutOfRangeException(nameof(index));
+            }
+            return Marshal.PtrToStringAnsi(key) ?? "";
+        }
+
+        public void GetInfo(int index, out int rows, out int cols, out ulong fingerprint)
+        {
+            if (KaldiNativeFbank.FeatureStoreGetInfo(Handle, index, out rows, out cols, out fingerprint) != 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(index));
+            }
+        }
+
+        /// <summary>
+        /// Frames [begin, end) of an utterance, without copying: (end - begin) * cols floats, row major
+        /// </summary>
+        public IntPtr GetFramesPointer(int index, int begin, int end)
+        {
+            IntPtr frames = KaldiNativeFbank.FeatureStoreGetFrames(Handle, index, begin, end);
+            if (frames == IntPtr.Zero)
+            {
+                throw new ArgumentOutOfRangeException(nameof(end));
+            }
+            return frames;
+        }
+
+        /// <summary>
+        /// A copy of frames [begin, end) of an utterance, row major
+        /// </summary>
+        public float[] GetFrames(int index, int begin, int end)
+        {
+            GetInfo(index, out _, out int cols, out _);
+            IntPtr frames = GetFramesPointer(index, begin, end);
+            float[] buffer = new float[(end - begin) * cols];
+            Marshal.Copy(frames, buffer, 0, buffer.Length);
+            return buffer;
+        }
+
+        private IntPtr Handle
+        {
+            get
+            {
+                if (_store == IntPtr.Zero)
+                {
+                    throw new ObjectDisposedException(nameof(FeatureStore));
+                }
+                return _store;
+            }
+        }
+
+        public void Dispose()
+        {
+            if (_store != IntPtr.Zero)
+            {
+                KaldiNativeFbank.CloseFeatureStore(_store);
+                _store = IntPtr.Zero;
+            }
+            GC.SuppressFinalize(this);
+        }
+
+        ~FeatureStore()
+        {
+            if (_store != IntPtr.Zero)
+            {
+                KaldiNativeFbank.CloseFeatureStore(_store);
+                _store = IntPtr.Zero;
+            }
+        }
+    }
+}
@@ -0,0 +1,118 @@
+﻿// See https://github.com/manyeyes for more information
+// Copyright (c)  2026 by manyeyes
+using KaldiNativeFbankSharp.DLL;
+using KaldiNativeFbankSharp.Struct;
+
+namespace KaldiNativeFbankSharp
+{
+    /// <summary>
+    /// Features of whole utterances; reuse one object for many utterances, from one thread at a time.
+    /// Takes the same options as OnlineFbank ("fbank", "mfcc" or "whisper").
+    /// </summary>
+    public class OfflineFbank : IDisposable
+    {
+        private IntPtr _opts;
+        private IntPtr _offlineFeature;
+
+        public OfflineFbank(float dither, bool snip_edges, float sample_rate, int num_bins, int num_ceps = 40, float frame_shift = 10.0f, float frame_length = 25.0f, float energy_floor = 0.0f, bool debug_mel = false, string window_type = "hamming", string feature_type = "fbank", FeatureCache? cache = null)
+        {
+            _opts = KaldiNativeFbank.GetFbankOptions(
+                 dither: dither,
+                 snip_edges: snip_edges,
+                 sample_rate: sample_rate,
+                 num_bins: num_bins,
+                 num_ceps: num_ceps,
+                 frame_shift: frame_shift,
+                 frame_length: frame_length,
+                 energy_floor: energy_floor,
+                 debug_mel: debug_mel,
+                 window_type: window_type,
+                 feature_type: feature_type
+                 );
+            _offlineFeature = KaldiNativeFbank.GetOfflineFeature(_opts);
+            if (_offlineFeature == IntPtr.Zero)
+            {
+                throw new ArgumentException("feature_type must be fbank, mfcc or whisper", nameof(feature_type));
+            }
+            if (cache != null)
+            {
+                KaldiNativeFbank.SetOfflineFeatureCache(_offlineFeature, cache.Handle);
+            }
+        }
+
+        /// <summary>
+        /// Same as above with the window given by type, see OnlineFbank
+        /// </summary>
+        public OfflineFbank(float dither, bool snip_edges, float sample_rate, int num_bins, WindowType window_type, bool periodic = false, float? window_coeff = null, int num_ceps = 40, float frame_shift = 10.0f, float frame_length = 25.0f, float energy_floor = 0.0f, bool debug_mel = false, string feature_type = "fbank", FeatureCache? cache = null)
+        {
+            _opts = KaldiNativeFbank.GetFbankOptions(
+                 dither: dither,
+                 snip_edges: snip_edges,
+                 sample_rate: sample_rate,
+                 num_bins: num_bins,
+                 num_ceps: num_ceps,
+                 frame_shift: frame_shift,
+                 frame_length: frame_length,
+                 energy_floor: energy_floor,
+                 debug_mel: debug_mel,
+                 feature_type: feature_type
+                 );
+            OnlineFbank.SetWindowType(_opts, window_type, periodic, window_coeff);
+            _offlineFeature = KaldiNativeFbank.GetOfflineFeature(_opts);
+            if (_offlineFeature == IntPtr.Zero)
+            {
+                throw new ArgumentException("feature_type must be fbank, mfcc or whisper", nameof(feature_type));
+            }
+            if (cache != null)
+            {
+                KaldiNativeFbank.SetOfflineFeatureCache(_offlineFeature, cache.Handle);
+            }
+        }
+
+        public int Dim => KaldiNativeFbank.GetOfflineFeatureDim(Handle);
+
+        /// <summary>
+        /// Features of a whole utterance, taken from the cache if it was seen before
+        /// </summary>
+        /// <param name="samples">at the sample rate of the options</param>
+        /// <returns>frames, row major; its length is (number of frames) * Dim</returns>
+        public float[] Compute(float[] samples)
+        {
+            int numFrames = KaldiNativeFbank.GetOfflineNumFrames(Handle, samples.Length);
+            float[] buffer = new float[numFrames * Dim];
+            KaldiNativeFbank.ComputeOfflineFeatures(Handle, samples, samples.Length, buffer, buffer.Length);
+            return buffer;
+        }
+
+        private IntPtr Handle
+        {
+            get
+            {
+                if (_offlineFeature == IntPtr.Zero)
+                {
+                    throw new ObjectDisposedException(nameof(OfflineFbank));
+                }
+                return _offlineFeature;
+            }
+        }
+
+        public void Dispose()
+        {
+            if (_offlineFeature != IntPtr.Zero)
+            {
+                KaldiNativeFbank.DestroyOfflineFeature(_offlineFeature);
+                _offlineFeature = IntPtr.Zero;
+            }
+            GC.SuppressFinalize(this);
+        }
+
+        ~OfflineFbank()
+        {
+            if (_offlineFeature != IntPtr.Zero)
+            {
+                KaldiNativeFbank.DestroyOfflineFeature(_offlineFeature);
+                _offlineFeature = IntPtr.Zero;
+            }
+        }
+    }
+}
@@ -32,6 +32,90 @@ namespace KaldiNativeFbankSharp
             this._knfOnlineFeature = KaldiNativeFbank.GetOnlineFbank(this._opts);
         }
 
+        /// <summary>
+        /// Same as above with the window given by type
+        /// </summary>
+        /// <param name="periodic">the periodic form of the window, e.g. for parity with torch.stft</param>
+        /// <param name="window_coeff">blackman coefficient (default 0.42) or kaiser beta (default 12)</param>
+        public OnlineFbank(float dither, bool snip_edges, float sample_rate, int num_bins, WindowType window_type, bool periodic = false, float? window_coeff = null, int num_ceps = 40, float frame_shift = 10.0f, float frame_length = 25.0f, float energy_floor = 0.0f, bool debug_mel = false, string feature_type = "fbank")
+        {
+            _sample_rate = sample_rate;
+            _num_bins = num_bins;
+            this._opts = KaldiNativeFbank.GetFbankOptions(
+                 dither: dither,
+                 snip_edges: snip_edges,
+                 sample_rate: sample_rate,
+                 num_bins: num_bins,
+                 num_ceps: num_ceps,
+                 frame_shift: frame_shift,
+                 frame_length: frame_length,
+                 energy_floor: energy_floor,
+                 debug_mel: debug_mel,
+                 feature_type: feature_type
+                 );
+            SetWindowType(this._opts, window_type, periodic, window_coeff);
+            this._knfOnlineFeature = KaldiNativeFbank.GetOnlineFbank(this._opts);
+        }
+
+        internal static void SetWindowType(IntPtr opts, WindowType window_type, bool periodic, float? window_coeff)
+        {
+            float coeff = window_coeff ?? (window_type == WindowType.Kaiser ? 12.0f : 0.42f);
+            if (KaldiNativeFbank.SetWindowType(opts, (int)window_type, periodic, coeff) != 0)
+            {
+                throw new ArgumentException("unknown window type", nameof(window_type));
+            }
+        }
+
+        /// <summary>
+        /// Compute several features per frame from one shared FFT, e.g. log fbank and MFCC for two models.
+        /// Each frame is the concatenation of the heads in the given order; see GetFeatureHeadLayout.
+        /// </summary>
+        /// <param name="heads">features to compute, each at most once</param>
+        public OnlineFbank(float dither, bool snip_edges, float sample_rate, int num_bins, FeatureHead[] heads, int num_ceps = 13, float frame_shift = 10.0f, float frame_length = 25.0f, float energy_floor = 0.0f, bool debug_mel = false, string window_type = "hamming")
+        {
+            _sample_rate = sample_rate;
+            this._opts = KaldiNativeFbank.GetFbankOptions(
+                 dither: dither,
+                 snip_edges: snip_edges,
+                 sample_rate: sample_rate,
+                 num_bins: num_bins,
+                 num_ceps: num_ceps,
+                 frame_shift: frame_shift,
+                 frame_length: frame_length,
+                 energy_floor: energy_floor,
+                 debug_mel: debug_mel,
+                 window_type: window_type
+                 );
+            int[] headIds = Array.ConvertAll(heads, x => (int)x);
+            this._knfOnlineFeature = KaldiNativeFbank.GetOnlineMultiFeature(this._opts, headIds, headIds.Length);
+            if (this._knfOnlineFeature.impl == IntPtr.Zero)
+            {
+                throw new ArgumentException("heads must be non-empty and without repeats, and num_ceps <= num_bins", nameof(heads));
+            }
+            _num_bins = KaldiNativeFbank.GetFeatureDim(_knfOnlineFeature);
+        }
+
+        /// <summary>
+        /// Where a head is within each frame of a multi-feature OnlineFbank
+        /// </summary>
+        /// <returns>false if this object does not compute that head</returns>
+        public bool GetFeatureHeadLayout(FeatureHead head, out int offset, out int dim)
+        {
+            return KaldiNativeFbank.GetFeatureHeadLayout(_knfOnlineFeature, (int)head, out offset, out dim) == 0;
+        }
+
+        /// <summary>
+        /// Sampling rate of the samples passed to GetFbank(), GetFbankIndoor()
+        /// and EnableIngestQueue(), if it differs from the one given to the
+        /// constructor (e.g. 8000, 44100 or 48000); the samples are then
+        /// resampled on the fly. Call before passing any samples.
+        /// </summary>
+        /// <param name="sampleRate"></param>
+        public void SetInputSampleRate(float sampleRate)
+        {
+            _sample_rate = sampleRate;
+        }
+
         /// <summary>
         /// Get one frame at a time
         /// </summary>
@@ -77,15 +161,484 @@ namespace KaldiNativeFbankSharp
             return _fbankDatas;
         }
 
+        /// <summary>
+        /// Accept interleaved multi-channel samples, averaged to mono in native code.
+        /// Read the frames with ReadFrames or a frames callback.
+        /// </summary>
+        /// <param name="samples">numChannels samples per time step, interleaved</param>
+        public bool AcceptWaveformInterleaved(float[] samples, int numChannels)
+        {
+            return KaldiNativeFbank.AcceptWaveformInterleaved(_knfOnlineFeature, _sample_rate, samples, samples.Length / numChannels, numChannels) == 0;
+        }
+
+        /// <summary>
+        /// Feed interleaved multi-channel samples to one OnlineFbank per channel
+        /// (normally created with the same options); channel c goes to channels[c].
+        /// The samples are de-interleaved in native code.
+        /// </summary>
+        /// <param name="samples">channels.Length samples per time step, interleaved</param>
+        public static bool AcceptWaveformChannels(OnlineFbank[] channels, float[] samples)
+        {
+            IntPtr[] handles = Array.ConvertAll(channels, x => x._knfOnlineFeature.impl);
+            return KaldiNativeFbank.AcceptWaveformChannels(handles, handles.Length, channels[0]._sample_rate, samples, samples.Length / handles.Length) == 0;
+        }
+
+        /// <summary>
+        /// ReadFrames for every channel of AcceptWaveformChannels, clipped to the frames all channels have,
+        /// i.e. starting at the first frame no channel has released
+        /// </summary>
+        /// <returns>[channel][frame][dim]; its length is channels.Length * (number of frames read) * dim</returns>
+        public static float[] ReadFramesChannels(OnlineFbank[] channels, int begin, int end)
+        {
+            IntPtr[] handles = Array.ConvertAll(channels, x => x._knfOnlineFeature.impl);
+            int dim = KaldiNativeFbank.GetFeatureDim(channels[0]._knfOnlineFeature);
+            foreach (OnlineFbank channel in channels)
+            {
+                end = Math.Min(end, channel.GetNumFramesPublished());
+            }
+            float[] buffer = new float[handles.Length * Math.Max(end - begin, 0) * dim];
+            int n = KaldiNativeFbank.ReadFramesChannels(handles, handles.Length, begin, end, buffer);
+            if (n < 0)
+            {
+                throw new ArgumentException("the channels must have the same feature dim and must not release frames while they are read", nameof(channels));
+            }
+            if (handles.Length * n * dim != buffer.Length)
+            {
+                Array.Resize(ref buffer, handles.Length * n * dim);
+            }
+            return buffer;
+        }
+
         public void InputFinished()
         {
             KaldiNativeFbank.InputFinished(_knfOnlineFeature);
         }
 
+        /// <summary>
+        /// Compute the features of a whole WAV file (PCM16/PCM24/float32) natively, without loading it into managed memory.
+        /// Channels are averaged and InputFinished is called at the end. Read the frames with ReadFrames or a frames callback;
+        /// for long files, set a callback or SetFrameRetention so that memory stays bounded.
+        /// </summary>
+        /// <param name="normalize">scale samples to [-1, 1) instead of the 16-bit range</param>
+        /// <returns>number of samples read, or -1 if the file cannot be read</returns>
+        public long ComputeFeaturesFromFile(string path, bool normalize = false)
+        {
+            return KaldiNativeFbank.ComputeFeaturesFromFile(_knfOnlineFeature, path, -1, 0, 0, normalize);
+        }
+
+        /// <summary>
+        /// ComputeFeaturesFromFile for a headerless file of interleaved samples
+        /// </summary>
+        public long ComputeFeaturesFromFile(string path, SampleFormat format, float sampleRate, int numChannels = 1, bool normalize = false)
+        {
+            return KaldiNativeFbank.ComputeFeaturesFromFile(_knfOnlineFeature, path, (int)format, sampleRate, numChannels, normalize);
+        }
+
+        /// <summary>
+        /// Receive new frames through a native callback instead of polling.
+        /// The callback must stay alive until it is unregistered (IntPtr.Zero) or the object is disposed.
+        /// </summary>
+        /// <param name="callback">void(IntPtr user_data, IntPtr frames, int num_frames, int dim, int first_frame), cdecl</param>
+        /// <param name="userData">passed back unchanged as user_data</param>
+        /// <param name="async">if true, invoked on a native worker thread; otherwise inside AcceptWaveform/InputFinished</param>
+        public void SetFramesCallback(IntPtr callback, IntPtr userData, bool async = false)
+        {
+            KaldiNativeFbank.SetFramesCallback(_knfOnlineFeature, callback, userData, async);
+        }
+
+        /// <summary>
+        /// Wait until an async callback has received every frame computed so far
+        /// </summary>
+        public void FlushFramesCallback()
+        {
+            KaldiNativeFbank.FlushFramesCallback(_knfOnlineFeature);
+        }
+
+        /// <summary>
+        /// Create the lock-free sample ring used by PushWaveform. Call once, before capture starts.
+        /// </summary>
+        /// <param name="capacity">number of samples, rounded up to a power of two</param>
+        /// <param name="policy">what PushWaveform does when the ring is full</param>
+        /// <param name="workerIntervalMs">if > 0, a native worker drains the ring at this interval; otherwise it is drained at the next read</param>
+        /// <returns>true on success</returns>
+        public bool EnableIngestQueue(int capacity, OverrunPolicy policy = OverrunPolicy.Drop, int workerIntervalMs = 0)
+        {
+            return KaldiNativeFbank.EnableIngestQueue(_knfOnlineFeature, _sample_rate, capacity, (int)policy, workerIntervalMs) == 0;
+        }
+
+        /// <summary>
+        /// Non-blocking push from a single capture thread
+        /// </summary>
+        /// <returns>number of samples stored</returns>
+        public int PushWaveform(float[] samples)
+        {
+            return KaldiNativeFbank.PushWaveform(_knfOnlineFeature, samples, samples.Length);
+        }
+
+        public KnfIngestStats GetIngestStats()
+        {
+            KnfIngestStats stats = new KnfIngestStats();
+            KaldiNativeFbank.GetIngestStats(_knfOnlineFeature, ref stats);
+            return stats;
+        }
+
+        /// <summary>
+        /// Number of frames computed so far. Lock-free, safe to call while another thread feeds audio.
+        /// </summary>
+        public int GetNumFramesPublished()
+        {
+            return KaldiNativeFbank.GetNumFramesPublished(_knfOnlineFeature);
+        }
+
+        /// <summary>
+        /// Lock-free read of frames [begin, end), safe while another thread feeds audio.
+        /// The frames read are discarded afterwards unless SetFrameRetention turned that off.
+        /// </summary>
+        /// <returns>frames, row major, starting at begin; its length is (number of frames read) * dim</returns>
+        /// <exception cref="ArgumentOutOfRangeException">begin is below GetFrameStoreStats().first_available_index:
+        /// the frames were already released</exception>
+        public float[] ReadFrames(int begin, int end)
+        {
+            int dim = KaldiNativeFbank.GetFeatureDim(_knfOnlineFeature);
+            end = Math.Min(end, GetNumFramesPublished());
+            float[] buffer = new float[Math.Max(end - begin, 0) * dim];
+            int n = KaldiNativeFbank.ReadFrames(_knfOnlineFeature, begin, end, buffer);
+            ThrowIfReleased(n, begin);
+            if (n * dim != buffer.Length)
+            {
+                Array.Resize(ref buffer, n * dim);
+            }
+            return buffer;
+        }
+
+        /// <summary>
+        /// ReadFrames as IEEE fp16 bit patterns, e.g. for an fp16 ONNX model, converted natively
+        /// </summary>
+        /// <returns>frames, row major; its length is (number of frames read) * dim</returns>
+        public ushort[] ReadFramesFloat16(int begin, int end)
+        {
+            return ReadFramesAs(begin, end, FeatureFormat.Float16);
+        }
+
+        /// <summary>
+        /// ReadFrames as bfloat16 bit patterns (the upper 16 bits of each float, rounded)
+        /// </summary>
+        public ushort[] ReadFramesBFloat16(int begin, int end)
+        {
+            return ReadFramesAs(begin, end, FeatureFormat.BFloat16);
+        }
+
+        /// <summary>
+        /// ReadFrames quantized to int8 per frame: value = scales[frame] * q
+        /// </summary>
+        public sbyte[] ReadFramesInt8(int begin, int end, out float[] scales)
+        {
+            int dim = KaldiNativeFbank.GetFeatureDim(_knfOnlineFeature);
+            end = Math.Min(end, GetNumFramesPublished());
+            int count = Math.Max(end - begin, 0);
+            sbyte[] buffer = new sbyte[count * dim];
+            scales = new float[count];
+            int n = KaldiNativeFbank.ReadFramesAsInt8(_knfOnlineFeature, begin, end, (int)FeatureFormat.Int8, buffer, scales);
+            ThrowIfReleased(n, begin);
+            if (n != count)
+            {
+                Array.Resize(ref buffer, n * dim);
+                Array.Resize(ref scales, n);
+            }
+            return buffer;
+        }
+
+        private ushort[] ReadFramesAs(int begin, int end, FeatureFormat format)
+        {
+            int dim = KaldiNativeFbank.GetFeatureDim(_knfOnlineFeature);
+            end = Math.Min(end, GetNumFramesPublished());
+            ushort[] buffer = new ushort[Math.Max(end - begin, 0) * dim];
+            int n = KaldiNativeFbank.ReadFramesAs(_knfOnlineFeature, begin, end, (int)format, buffer, null);
+            ThrowIfReleased(n, begin);
+            if (n * dim != buffer.Length)
+            {
+                Array.Resize(ref buffer, n * dim);
+            }
+            return buffer;
+        }
+
+        private static void ThrowIfReleased(int n, int begin)
+        {
+            if (n < 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(begin), begin, "the frames from begin on were already released");
+            }
+        }
+
+        /// <summary>
+        /// ReadFrames into a Kaldi compressed matrix, the bytes Kaldi's CompressedMatrix::Write writes in binary mode
+        /// (an archive entry is "key " + "\0B" + these bytes)
+        /// </summary>
+        /// <returns>the compressed matrix, or an empty array if there are no frames in [begin, end)</returns>
+        public byte[] CompressFrames(int begin, int end, CompressionMethod method = CompressionMethod.Automatic)
+        {
+            int size = KaldiNativeFbank.CompressFrames(_knfOnlineFeature, begin, end, (int)method, null, 0);
+            if (size < 0)
+            {
+                return new byte[0];
+            }
+            byte[] buffer = new byte[size];
+            if (KaldiNativeFbank.CompressFrames(_knfOnlineFeature, begin, end, (int)method, buffer, size) != size)
+            {
+                return new byte[0];
+            }
+            return buffer;
+        }
+
+        /// <summary>
+        /// Decode a Kaldi compressed matrix (CM, CM2 or CM3), e.g. from CompressFrames
+        /// </summary>
+        /// <returns>rows * cols floats, row major</returns>
+        public static float[] DecompressMatrix(byte[] data, out int rows, out int cols)
+        {
+            if (KaldiNativeFbank.DecompressMatrix(data, data.Length, out rows, out cols, null, 0) < 0 && rows * cols == 0)
+            {
+                throw new ArgumentException("not a Kaldi compressed matrix", nameof(data));
+            }
+            float[] buffer = new float[rows * cols];
+            if (KaldiNativeFbank.DecompressMatrix(data, data.Length, out rows, out cols, buffer, buffer.Length) < 0)
+            {
+                throw new ArgumentException("not a Kaldi compressed matrix", nameof(data));
+            }
+            return buffer;
+        }
+
+        /// <summary>
+        /// Fingerprint of the feature options (not of the post-processing stages), to record with stored features
+        /// </summary>
+        public ulong GetOptionsFingerprint()
+        {
+            return KaldiNativeFbank.GetOptionsFingerprint(_knfOnlineFeature);
+        }
+
+        /// <summary>
+        /// Save the waveform-dependent state of an idle stream (buffered samples, unreleased frames, resampler
+        /// history), so that it can be disposed and resumed later with LoadState, possibly in another process
+        /// </summary>
+        /// <returns>the state, or an empty array if the stream has post-processing stages (e.g. online CMVN) or a VAD</returns>
+        public byte[] SaveState()
+        {
+            while (true)
+            {
+                int size = KaldiNativeFbank.SaveState(_knfOnlineFeature, null, 0);
+                if (size < 0)
+                {
+                    return new byte[0];
+                }
+                byte[] buffer = new byte[size];
+                int n = KaldiNativeFbank.SaveState(_knfOnlineFeature, buffer, size);
+                if (n == size)
+                {
+                    return buffer;
+                }
+                if (n < 0)
+                {
+                    return new byte[0];
+                }
+                // more waveform was accepted in between; try again
+            }
+        }
+
+        /// <summary>
+        /// Resume from SaveState on a new stream with the same options, before any waveform is accepted.
+        /// Frame callbacks and retention settings are not part of the state.
+        /// </summary>
+        /// <returns>false if the state is not valid or is for other options</returns>
+        public bool LoadState(byte[] state)
+        {
+            return KaldiNativeFbank.LoadState(_knfOnlineFeature, state, state.Length) == 0;
+        }
+
+        /// <summary>
+        /// Discard all frames with index &lt; end
+        /// </summary>
+        public void ReleaseFrames(int end)
+        {
+            KaldiNativeFbank.ReleaseFrames(_knfOnlineFeature, end);
+        }
+
+        /// <summary>
+        /// Bound the memory kept for computed frames, for long-running sessions
+        /// </summary>
+        /// <param name="maxFrames">keep at most this many frames, -1 = no limit</param>
+        /// <param name="maxBytes">keep about this many bytes of frame data at most, -1 = no limit</param>
+        /// <param name="releaseOnRead">discard frames once ReadFrames or a frames callback returned them (default on);
+        /// turn it off when the same frames are also fetched with GetFbank/GetFbankIndoor</param>
+        public void SetFrameRetention(int maxFrames = -1, long maxBytes = -1, bool releaseOnRead = true)
+        {
+            KaldiNativeFbank.SetFrameRetention(_knfOnlineFeature, maxFrames, maxBytes, releaseOnRead);
+        }
+
+        public KnfFrameStoreStats GetFrameStoreStats()
+        {
+            KnfFrameStoreStats stats = new KnfFrameStoreStats();
+            KaldiNativeFbank.GetFrameStoreStats(_knfOnlineFeature, ref stats);
+            return stats;
+        }
+
+        /// <summary>
+        /// Per-stage timings of this stream; all zero (enabled == 0) unless the native library was built with KNF_ENABLE_STATS
+        /// </summary>
+        public KnfStats GetFeatureStats()
+        {
+            KaldiNativeFbank.GetFeatureStats(_knfOnlineFeature, out KnfStats stats);
+            return stats;
+        }
+
+        public void ResetFeatureStats()
+        {
+            KaldiNativeFbank.ResetFeatureStats(_knfOnlineFeature);
+        }
+
+        /// <summary>
+        /// Per-stage timings summed over every stream of the process
+        /// </summary>
+        public static KnfStats GetGlobalFeatureStats()
+        {
+            KaldiNativeFbank.GetGlobalFeatureStats(out KnfStats stats);
+            return stats;
+        }
+
+        public static void ResetGlobalFeatureStats()
+        {
+            KaldiNativeFbank.ResetGlobalFeatureStats();
+        }
+
+        /// <summary>
+        /// Output low frame rate stacked, CMVN-normalized frames (Paraformer/SenseVoice model input) instead of plain features.
+        /// Call before the first GetFbank/GetFbankIndoor/PushWaveform and before SetFramesCallback.
+        /// </summary>
+        /// <param name="lfrM">number of frames stacked</param>
+        /// <param name="lfrN">stride, in frames</param>
+        /// <param name="mvnPath">FunASR am.mvn file; null for no CMVN</param>
+        /// <returns>true on success</returns>
+        public bool SetLfrCmvn(int lfrM = 7, int lfrN = 6, string? mvnPath = null)
+        {
+            bool ok = KaldiNativeFbank.SetLfrCmvn(_knfOnlineFeature, lfrM, lfrN, mvnPath) == 0;
+            _num_bins = KaldiNativeFbank.GetFeatureDim(_knfOnlineFeature);
+            return ok;
+        }
+
+        /// <summary>
+        /// Same as SetLfrCmvn, with the CMVN given as arrays of lfrM * feature dim values each
+        /// </summary>
+        public bool SetLfrCmvn(int lfrM, int lfrN, float[] negMean, float[] invStddev)
+        {
+            if (negMean.Length != invStddev.Length)
+            {
+                return false;
+            }
+            bool ok = KaldiNativeFbank.SetLfrCmvnStats(_knfOnlineFeature, lfrM, lfrN, negMean, invStddev, negMean.Length) == 0;
+            _num_bins = KaldiNativeFbank.GetFeatureDim(_knfOnlineFeature);
+            return ok;
+        }
+
+        /// <summary>
+        /// Normalize the output online over a sliding window of past frames (Kaldi OnlineCmvn).
+        /// Same restrictions as SetLfrCmvn; applied after it if both are used.
+        /// </summary>
+        /// <param name="cmnWindow">number of frames in the window, including the current one</param>
+        /// <param name="speakerFrames">top up windows shorter than cmnWindow with at most this many frames of speakerStats</param>
+        /// <param name="globalFrames">then with at most this many frames of globalStats</param>
+        /// <param name="globalStats">Kaldi cmvn stats, 2 x (dim + 1) row major, or null</param>
+        /// <param name="speakerStats">from GetOnlineCmvnSpeakerStats of a previous utterance of the same speaker, or null</param>
+        /// <returns>true on success</returns>
+        public bool SetOnlineCmvn(int cmnWindow = 600, int speakerFrames = 600, int globalFrames = 200, bool normalizeVariance = false, double[]? globalStats = null, double[]? speakerStats = null)
+        {
+            int statsSize = globalStats?.Length ?? speakerStats?.Length ?? 0;
+            if (globalStats != null && speakerStats != null && globalStats.Length != speakerStats.Length)
+            {
+                return false;
+            }
+            return KaldiNativeFbank.SetOnlineCmvn(_knfOnlineFeature, cmnWindow, speakerFrames, globalFrames, normalizeVariance, globalStats, speakerStats, statsSize) == 0;
+        }
+
+        /// <summary>
+        /// Speaker stats to carry over to the next utterance of the same speaker, or null if SetOnlineCmvn was not called
+        /// </summary>
+        public double[]? GetOnlineCmvnSpeakerStats()
+        {
+            double[] stats = new double[2 * (KaldiNativeFbank.GetFeatureDim(_knfOnlineFeature) + 1)];
+            int n = KaldiNativeFbank.GetOnlineCmvnSpeakerStats(_knfOnlineFeature, stats, stats.Length);
+            return n < 0 ? null : stats;
+        }
+
+        /// <summary>
+        /// Append deltas and delta-deltas (Kaldi add-deltas) to every frame.
+        /// Adds order * window frames of latency, see GetStageLatency. Same restrictions as SetLfrCmvn.
+        /// </summary>
+        /// <returns>true on success</returns>
+        public bool SetDeltas(int order = 2, int window = 2)
+        {
+            bool ok = KaldiNativeFbank.SetDeltas(_knfOnlineFeature, order, window) == 0;
+            _num_bins = KaldiNativeFbank.GetFeatureDim(_knfOnlineFeature);
+            return ok;
+        }
+
+        /// <summary>
+        /// Only compute features for frames an energy / zero-crossing VAD classifies as speech; silence frames are
+        /// not stored, so frame indices count speech frames only. Call before the first GetFbank/GetFbankIndoor/PushWaveform.
+        /// </summary>
+        /// <param name="energyThreshold">log energy (natural log of the frame's sum of squares) of speech; 13 suits 16-bit sample values</param>
+        /// <param name="unvoicedEnergyMargin">quieter frames down to energyThreshold - unvoicedEnergyMargin are speech if their zero-crossing rate is high</param>
+        /// <param name="zcrThreshold">zero-crossing rate (0..1) of such unvoiced speech</param>
+        /// <param name="hangoverFrames">frames that stay speech after the last loud frame</param>
+        /// <param name="callback">void(IntPtr user_data, int event, int frame, int speech_frame), cdecl, called at each segment boundary
+        /// (event is a VadEvent); IntPtr.Zero for none. It must stay alive as long as this object.</param>
+        /// <returns>true on success</returns>
+        public bool EnableVad(float energyThreshold = 13.0f, float unvoicedEnergyMargin = 2.0f, float zcrThreshold = 0.3f, int hangoverFrames = 20, IntPtr callback = default, IntPtr userData = default)
+        {
+            return KaldiNativeFbank.EnableVad(_knfOnlineFeature, energyThreshold, unvoicedEnergyMargin, zcrThreshold, hangoverFrames, callback, userData) == 0;
+        }
+
+        /// <summary>
+        /// Speech flags (1 speech, 0 silence) of frames [begin, end), counting all frames, or null if EnableVad was not called.
+        /// Flags are released along with the frames and bounded by SetFrameRetention, so begin is clipped to
+        /// GetVadState().first_flag.
+        /// </summary>
+        public byte[]? GetVadFlags(int begin, int end)
+        {
+            byte[] flags = new byte[Math.Max(end - begin, 0)];
+            int n = KaldiNativeFbank.GetVadFlags(_knfOnlineFeature, begin, end, flags);
+            if (n < 0)
+            {
+                return null;
+            }
+            if (n != flags.Length)
+            {
+                Array.Resize(ref flags, n);
+            }
+            return flags;
+        }
+
+        public KnfVadState GetVadState()
+        {
+            KnfVadState state = new KnfVadState();
+            KaldiNativeFbank.GetVadState(_knfOnlineFeature, ref state);
+            return state;
+        }
+
+        /// <summary>
+        /// Number of frames the output of SetLfrCmvn and other post-processing lags behind the computed features
+        /// </summary>
+        public int GetStageLatency()
+        {
+            return KaldiNativeFbank.GetStageLatency(_knfOnlineFeature);
+        }
+
         protected override void Dispose(bool disposing)
         {
             if (!disposing)
             {
+                if (this._knfOnlineFeature.impl != IntPtr.Zero)
+                {
+                    KaldiNativeFbank.DestroyOnlineFbank(this._knfOnlineFeature);
+                }
                 this._opts = IntPtr.Zero;
                 this._knfOnlineFeature.impl = IntPtr.Zero;
                 this._disposed = true;
@@ -20,4 +20,144 @@ namespace KaldiNativeFbankSharp.Struct
     {
         public IntPtr impl;
     };
+
+    public struct KnfIngestStats
+    {
+        public long pushed_samples;
+        public long drained_samples;
+        public long dropped_samples;
+        public long overwritten_samples;
+        public long rejected_samples;
+        public long overruns;
+        public int capacity;
+        public int size;
+    };
+
+    public struct KnfFrameStoreStats
+    {
+        public int num_frames;
+        public int first_available_index;
+        public int retained_frames;
+        public int peak_retained_frames;
+        public long retained_bytes;
+        public long peak_retained_bytes;
+    };
+
+    public struct KnfFeatureCacheStats
+    {
+        public long memory_hits;
+        public long disk_hits;
+        public long misses;
+        public long insertions;
+        public long evictions;
+        public long memory_entries;
+        public long memory_bytes;
+    };
+
+    public struct KnfStageStats
+    {
+        public long count;
+        public long total_ns;
+        public long max_ns;
+        /// <summary>
+        /// histogram[i] counts calls that took [2^i, 2^(i+1)) nanoseconds
+        /// </summary>
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 32)]
+        public long[] histogram;
+    };
+
+    public struct KnfStats
+    {
+        public int enabled;
+        public int num_stages;
+        public long num_frames;
+        /// <summary>
+        /// indexed by FeatureStage
+        /// </summary>
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 6)]
+        public KnfStageStats[] stages;
+    };
+
+    public enum FeatureStage
+    {
+        Window = 0,
+        Fft = 1,
+        PowerSpectrum = 2,
+        Mel = 3,
+        Log = 4,
+        Copy = 5,
+    };
+
+    public struct KnfVadState
+    {
+        public int num_frames;
+        public int num_speech_frames;
+        public int in_speech;
+        public int first_flag;
+    };
+
+    public enum VadEvent
+    {
+        SpeechStart = 0,
+        SpeechEnd = 1,
+    };
+
+    public enum FeatureHead
+    {
+        LogFbank = 0,
+        Mfcc = 1,
+        PowerSpectrum = 2,
+        LogEnergy = 3,
+    };
+
+    public enum OverrunPolicy
+    {
+        Drop = 0,
+        Overwrite = 1,
+        Report = 2,
+    };
+
+    public enum SampleFormat
+    {
+        Pcm16 = 0,
+        Pcm24 = 1,
+        Float32 = 2,
+    };
+
+    /// <summary>
+    /// Window functions, the same as the window_type names ("hanning", "sine", ...).
+    /// Each has a symmetric form, Kaldi's, and a periodic one, like torch.hann_window.
+    /// </summary>
+    public enum WindowType
+    {
+        Hanning = 0,
+        Sine = 1,
+        Hamming = 2,
+        Povey = 3,
+        Rectangular = 4,
+        Blackman = 5,
+        Kaiser = 6,
+    };
+
+    /// <summary>
+    /// Formats of ReadFramesFloat16/BFloat16/Int8, rounded to nearest even
+    /// </summary>
+    public enum FeatureFormat
+    {
+        Float32 = 0,
+        Float16 = 1,
+        BFloat16 = 2,
+        Int8 = 3,
+    };
+
+    /// <summary>
+    /// Kaldi's compression methods (copy-feats --compression-method)
+    /// </summary>
+    public enum CompressionMethod
+    {
+        Automatic = 1,
+        SpeechFeature = 2,
+        TwoByteAuto = 3,
+        OneByteAuto = 5,
+    };
 }
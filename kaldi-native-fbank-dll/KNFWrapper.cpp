@@ -1,9 +1,26 @@
 //KNFWrapper.cpp
 #include "pch.h"
 #include "KNFWrapper.h"
+#include "compressed-matrix.h"
+#include "feature-cmvn.h"
+#include "feature-delta.h"
+#include "feature-format.h"
+#include "feature-cache.h"
+#include "feature-lfr.h"
+#include "feature-store.h"
+#include "hash.h"
+#include "multichannel.h"
+#include "offline-feature.h"
+#include "wave-reader.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <string>
+#include <utility>
 #include "stdlib.h";
 #include <cassert>
 
@@ -12,12 +29,70 @@ namespace knf
 {
 	/*int32_t last_frame_index_ = 0;
 	int32_t last_frame_num_ = 0;*/
-	std::mutex mutex_;
 
 	struct KnfOnlineFeature {
-		knf::IOnlineFeature* impl;
+		knf::IOnlineFeature* impl = nullptr;
+		// guards impl; each handle has its own so that streams never wait for each other
+		std::mutex mutex;
+		// set iff an async frames callback is registered; shared so that
+		// FlushFramesCallback() keeps it alive outside of the lock
+		std::shared_ptr<FrameDispatcher> dispatcher;
+		// set iff EnableIngestQueue() was called; PushWaveform() uses it without the lock
+		std::unique_ptr<AudioIngestQueue> ingest;
+		float ingest_sample_rate = 16000;
+		// read without the lock by ReadFrames()
+		std::atomic<bool> release_on_read{ true };
+		// set iff SetOnlineCmvn() was called; owned by impl
+		OnlineCmvnStage* cmvn = nullptr;
 	};
 
+	struct KnfFeatureStoreWriter {
+		FeatureStoreWriter writer;
+	};
+
+	struct KnfFeatureStore {
+		FeatureStoreReader reader;
+	};
+
+	struct KnfFeatureCache {
+		std::shared_ptr<FeatureCache> cache;
+	};
+
+	struct KnfOfflineFeature {
+		std::unique_ptr<OfflineFeature> impl;
+		std::vector<float> wave;
+		std::vector<float> feats;
+	};
+
+	static void ToKnfStats(const FeatureStats& stats, KnfStats* pStats) {
+		static_assert(kNumFeatureStages == sizeof(pStats->stages) / sizeof(pStats->stages[0]), "KnfStats is out of date");
+		static_assert(kNumStatsBuckets == sizeof(pStats->stages[0].histogram) / sizeof(int64_t), "KnfStageStats is out of date");
+		pStats->enabled = FeatureStatsEnabled() ? 1 : 0;
+		pStats->num_stages = kNumFeatureStages;
+		pStats->num_frames = stats.num_frames;
+		for (int32_t s = 0; s != kNumFeatureStages; ++s) {
+			const StageStats& src = stats.stages[s];
+			KnfStageStats& dst = pStats->stages[s];
+			dst.count = src.count;
+			dst.total_ns = src.total_ns;
+			dst.max_ns = src.max_ns;
+			std::copy(src.histogram, src.histogram + kNumStatsBuckets, dst.histogram);
+		}
+	}
+
+	// Move samples queued by PushWaveform() into the extractor.
+	// The caller must hold knfOnlineFeature->mutex.
+	static void DrainIngestQueue(KnfOnlineFeature* knfOnlineFeature) {
+		if (!knfOnlineFeature->ingest) {
+			return;
+		}
+		IOnlineFeature* impl = knfOnlineFeature->impl;
+		float sample_rate = knfOnlineFeature->ingest_sample_rate;
+		knfOnlineFeature->ingest->DrainTo([impl, sample_rate](const float* samples, int32_t n) {
+			impl->AcceptWaveform(sample_rate, samples, n);
+			});
+	}
+
 	FeatureOptions* GetFbankOptions(float dither, bool snip_edges, float sample_rate, int32_t num_bins, int32_t num_ceps, float frame_shift, float frame_length, float energy_floor, bool debug_mel, const char* window_type, const char* feature_type)
 	{
 		FeatureOptions* opts = new FeatureOptions;
@@ -35,60 +110,219 @@ namespace knf
 		return opts;
 	}
 
+	int32_t SetWindowType(FeatureOptions* opts, int32_t window_type, bool periodic, float coeff)
+	{
+		std::string name = WindowTypeName(static_cast<WindowType>(window_type), periodic);
+		if (name.empty()) {
+			return -1;
+		}
+		opts->window_type = name;
+		if (window_type == static_cast<int32_t>(WindowType::kBlackman)) {
+			opts->blackman_coeff = coeff;
+		}
+		if (window_type == static_cast<int32_t>(WindowType::kKaiser)) {
+			opts->kaiser_beta = coeff;
+		}
+		return 0;
+	}
+
+	// The extractor options of FeatureOptions, shared by the online and
+	// offline extractors
+	static FbankOptions ToFbankOptions(const FeatureOptions* opts) {
+		FbankOptions opts_;
+		opts_.frame_opts.dither = opts->dither;
+		opts_.frame_opts.snip_edges = opts->snip_edges;
+		opts_.frame_opts.samp_freq = opts->sample_rate;
+		opts_.frame_opts.window_type = opts->window_type;
+		opts_.frame_opts.blackman_coeff = opts->blackman_coeff;
+		opts_.frame_opts.kaiser_beta = opts->kaiser_beta;
+		opts_.frame_opts.frame_shift_ms = opts->frame_shift;
+		opts_.frame_opts.frame_length_ms = opts->frame_length;
+		opts_.mel_opts.num_bins = opts->num_bins;
+		opts_.mel_opts.debug_mel = opts->debug_mel;
+		opts_.energy_floor = opts->energy_floor;
+		opts_.frame_opts.allow_downsample = true;
+		opts_.frame_opts.allow_upsample = true;
+		return opts_;
+	}
+
+	static MfccOptions ToMfccOptions(const FeatureOptions* opts) {
+		MfccOptions opts_;
+		opts_.frame_opts.dither = opts->dither;//eg. 0
+		opts_.num_ceps = opts->num_ceps;//eg. 40
+		opts_.mel_opts.num_bins = opts->num_bins;//eg. 40
+		opts_.mel_opts.high_freq = -200;//eg. -200
+		opts_.frame_opts.snip_edges = opts->snip_edges;//eg. false
+		opts_.frame_opts.allow_downsample = true;
+		opts_.frame_opts.allow_upsample = true;
+		return opts_;
+	}
+
+	static WhisperFeatureOptions ToWhisperOptions(const FeatureOptions* opts) {
+		WhisperFeatureOptions opts_;
+		opts_.dim = opts->num_bins;
+		opts_.frame_opts.allow_downsample = true;
+		opts_.frame_opts.allow_upsample = true;
+		return opts_;
+	}
+
 	KnfOnlineFeature* GetOnlineFbank(FeatureOptions* opts)
 	{
 		KnfOnlineFeature* knfOnlineFeature = new KnfOnlineFeature;
 		if (opts->feature_type == "fbank") {
-			FbankOptions* opts_ = new FbankOptions;
-			opts_->frame_opts.dither = opts->dither;
-			opts_->frame_opts.snip_edges = opts->snip_edges;
-			opts_->frame_opts.samp_freq = opts->sample_rate;
-			opts_->frame_opts.window_type = opts->window_type;
-			opts_->frame_opts.frame_shift_ms = opts->frame_shift;
-			opts_->frame_opts.frame_length_ms = opts->frame_length;
-			opts_->mel_opts.num_bins = opts->num_bins;
-			opts_->mel_opts.debug_mel = opts->debug_mel;
-			opts_->energy_floor = opts->energy_floor;
-			knfOnlineFeature->impl = new knf::OnlineFbankAdapter(*opts_);
+			knfOnlineFeature->impl = new knf::OnlineFbankAdapter(ToFbankOptions(opts));
 		}
 		if (opts->feature_type == "mfcc") {
-			MfccOptions* opts_ = new MfccOptions;
-			opts_->frame_opts.dither = opts->dither;//eg. 0
-			opts_->num_ceps = opts->num_ceps;//eg. 40
-			opts_->mel_opts.num_bins = opts->num_bins;//eg. 40
-			opts_->mel_opts.high_freq = -200;//eg. -200
-			opts_->frame_opts.snip_edges = opts->snip_edges;//eg. false
-			knfOnlineFeature->impl = new knf::OnlineMfccAdapter(*opts_);
+			knfOnlineFeature->impl = new knf::OnlineMfccAdapter(ToMfccOptions(opts));
 		}
 		if (opts->feature_type == "whisper") {
-			WhisperFeatureOptions* opts_ = new WhisperFeatureOptions;
-			opts_->dim = opts->num_bins;
-			knfOnlineFeature->impl = new knf::OnlineWhisperFbankAdapter(*opts_);
+			knfOnlineFeature->impl = new knf::OnlineWhisperFbankAdapter(ToWhisperOptions(opts));
+		}
+		return knfOnlineFeature;
+
+	}
+
+	KnfOnlineFeature* GetOnlineMultiFeature(FeatureOptions* opts, const int32_t* heads, int32_t num_heads)
+	{
+		MultiFeatureOptions opts_;
+		opts_.heads.clear();
+		const int32_t num_known_heads = static_cast<int32_t>(FeatureHead::kLogEnergy) + 1;
+		bool seen[num_known_heads] = {};
+		for (int32_t i = 0; i != num_heads; ++i) {
+			int32_t head = heads[i];
+			if (head < 0 || head >= num_known_heads || seen[head]) {
+				return nullptr;
+			}
+			seen[head] = true;
+			opts_.heads.push_back(static_cast<FeatureHead>(head));
 		}
+		if (opts_.heads.empty()) {
+			return nullptr;
+		}
+		opts_.frame_opts.dither = opts->dither;
+		opts_.frame_opts.snip_edges = opts->snip_edges;
+		opts_.frame_opts.samp_freq = opts->sample_rate;
+		opts_.frame_opts.window_type = opts->window_type;
+		opts_.frame_opts.blackman_coeff = opts->blackman_coeff;
+		opts_.frame_opts.kaiser_beta = opts->kaiser_beta;
+		opts_.frame_opts.frame_shift_ms = opts->frame_shift;
+		opts_.frame_opts.frame_length_ms = opts->frame_length;
+		opts_.mel_opts.num_bins = opts->num_bins;
+		opts_.mel_opts.debug_mel = opts->debug_mel;
+		opts_.num_ceps = opts->num_ceps;
+		opts_.energy_floor = opts->energy_floor;
+		opts_.frame_opts.allow_downsample = true;
+		opts_.frame_opts.allow_upsample = true;
+		if (seen[static_cast<int32_t>(FeatureHead::kMfcc)] && opts_.num_ceps > opts_.mel_opts.num_bins) {
+			return nullptr;
+		}
+
+		KnfOnlineFeature* knfOnlineFeature = new KnfOnlineFeature;
+		knfOnlineFeature->impl = new knf::OnlineMultiFeatureAdapter(opts_);
 		return knfOnlineFeature;
+	}
 
+	int32_t GetFeatureHeadLayout(KnfOnlineFeature* knfOnlineFeature, int32_t head, int32_t* /*out*/ offset, int32_t* /*out*/ dim) {
+		auto* multi = dynamic_cast<OnlineMultiFeatureAdapter*>(knfOnlineFeature->impl);
+		if (multi == nullptr || multi->HeadDim(static_cast<FeatureHead>(head)) == 0) {
+			return -1;
+		}
+		*offset = multi->HeadOffset(static_cast<FeatureHead>(head));
+		*dim = multi->HeadDim(static_cast<FeatureHead>(head));
+		return 0;
 	}
 
 	void AcceptWaveform(KnfOnlineFeature* knfOnlineFeature, float sample_rate, float* samples, int samples_size)
 	{
-		std::lock_guard<std::mutex> lock(mutex_);
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		DrainIngestQueue(knfOnlineFeature);
 		std::vector<float> waveform{ samples, samples + samples_size };
 		knfOnlineFeature->impl->AcceptWaveform(sample_rate, waveform.data(), waveform.size());
 	}
 
+	int32_t AcceptWaveformInterleaved(KnfOnlineFeature* knfOnlineFeature, float sample_rate, const float* samples, int32_t num_frames, int32_t num_channels) {
+		if (num_frames < 0 || num_channels <= 0) {
+			return -1;
+		}
+		std::vector<float> waveform(num_frames);
+		DownmixInterleaved(samples, num_frames, num_channels, waveform.data());
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		DrainIngestQueue(knfOnlineFeature);
+		knfOnlineFeature->impl->AcceptWaveform(sample_rate, waveform.data(), num_frames);
+		return 0;
+	}
+
+	int32_t AcceptWaveformChannels(KnfOnlineFeature** handles, int32_t num_channels, float sample_rate, const float* samples, int32_t num_frames) {
+		if (num_frames < 0 || num_channels <= 0) {
+			return -1;
+		}
+		for (int32_t c = 0; c != num_channels; ++c) {
+			if (handles[c] == nullptr) {
+				return -1;
+			}
+		}
+		// one pass over the interleaved samples for all channels
+		std::vector<float> planar(static_cast<size_t>(num_frames) * num_channels);
+		std::vector<float*> channels(num_channels);
+		for (int32_t c = 0; c != num_channels; ++c) {
+			channels[c] = planar.data() + static_cast<size_t>(c) * num_frames;
+		}
+		DeinterleaveChannels(samples, num_frames, num_channels, channels.data());
+		for (int32_t c = 0; c != num_channels; ++c) {
+			std::lock_guard<std::mutex> lock(handles[c]->mutex);
+			DrainIngestQueue(handles[c]);
+			handles[c]->impl->AcceptWaveform(sample_rate, channels[c], num_frames);
+		}
+		return 0;
+	}
+
 	void  InputFinished(KnfOnlineFeature* knfOnlineFeature) {
-		std::lock_guard<std::mutex> lock(mutex_);
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		DrainIngestQueue(knfOnlineFeature);
+		knfOnlineFeature->impl->InputFinished();
+	}
+
+	int64_t ComputeFeaturesFromFile(KnfOnlineFeature* knfOnlineFeature, const char* filename, int32_t raw_format, float raw_sample_rate, int32_t raw_num_channels, bool normalize) {
+		WaveFileReader reader;
+		bool opened = false;
+		if (raw_format < 0) {
+			opened = reader.Open(filename);
+		}
+		else if (raw_format <= static_cast<int32_t>(SampleFormat::kFloat32)) {
+			opened = reader.OpenRaw(filename, static_cast<int32_t>(raw_sample_rate), raw_num_channels, static_cast<SampleFormat>(raw_format));
+		}
+		if (!opened) {
+			return -1;
+		}
+		float scale = normalize ? 1.0f / 32768 : 1.0f;
+		float sample_rate = static_cast<float>(reader.Info().sample_rate);
+		// a few seconds of audio; only this much is ever converted at once
+		std::vector<float> chunk(1 << 16);
+		int64_t num_samples = 0;
+
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		DrainIngestQueue(knfOnlineFeature);
+		int32_t n = 0;
+		while ((n = reader.ReadMono(chunk.data(), static_cast<int32_t>(chunk.size()), scale)) > 0) {
+			knfOnlineFeature->impl->AcceptWaveform(sample_rate, chunk.data(), n);
+			num_samples += n;
+		}
+		if (n < 0) {
+			return -1;
+		}
 		knfOnlineFeature->impl->InputFinished();
+		return num_samples;
 	}
 
 	int32_t  GetNumFramesReady(KnfOnlineFeature* knfOnlineFeature) {
-		std::lock_guard<std::mutex> lock(mutex_);
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		DrainIngestQueue(knfOnlineFeature);
 		int32_t n = knfOnlineFeature->impl->NumFramesReady();
 		return n;
 	}
 
 	void GetFbank(KnfOnlineFeature* knfOnlineFeature, int currFrameIndex, FbankData* /*out*/ pData) {
-		std::lock_guard<std::mutex> lock(mutex_);
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
 		int32_t n = knfOnlineFeature->impl->NumFramesReady();
 		assert(n > 0 && "Please first call AcceptWaveform()");
 		//dis frame num, first is 0,second's next is 1
@@ -130,8 +364,580 @@ namespace knf
 		}
 	}
 
+	void SetFramesCallback(KnfOnlineFeature* knfOnlineFeature, KnfFramesCallback callback, void* user_data, bool async) {
+		std::shared_ptr<FrameDispatcher> old_dispatcher;
+		{
+			std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+			old_dispatcher = std::move(knfOnlineFeature->dispatcher);
+			if (callback == nullptr) {
+				knfOnlineFeature->impl->SetFramesCallback(nullptr);
+			}
+			else {
+				int32_t dim = knfOnlineFeature->impl->Dim();
+				FramesReadyCallback deliver = [callback, user_data, dim](const float* frames, int32_t num_frames, int32_t first_frame) {
+					callback(user_data, frames, num_frames, dim, first_frame);
+				};
+				if (async) {
+					FrameDispatcher* dispatcher = new FrameDispatcher(dim, std::move(deliver));
+					knfOnlineFeature->dispatcher.reset(dispatcher);
+					// Replaced under the lock before the dispatcher can go, so
+					// the raw pointer is enough here.
+					// The dispatcher has its own copy, so the frames may go now.
+					knfOnlineFeature->impl->SetFramesCallback([knfOnlineFeature, dispatcher](const float* frames, int32_t num_frames, int32_t first_frame) {
+						dispatcher->Post(frames, num_frames, first_frame);
+						if (knfOnlineFeature->release_on_read.load(std::memory_order_relaxed)) {
+							knfOnlineFeature->impl->ReleaseFrames(first_frame + num_frames);
+						}
+						});
+				}
+				else {
+					knfOnlineFeature->impl->SetFramesCallback([knfOnlineFeature, deliver](const float* frames, int32_t num_frames, int32_t first_frame) {
+						deliver(frames, num_frames, first_frame);
+						if (knfOnlineFeature->release_on_read.load(std::memory_order_relaxed)) {
+							knfOnlineFeature->impl->ReleaseFrames(first_frame + num_frames);
+						}
+						});
+				}
+			}
+		}
+		// Destroyed outside of the lock: it drains its queue, and the user
+		// callback may call back into this library. A concurrent
+		// FlushFramesCallback() may hold the last reference instead.
+		old_dispatcher.reset();
+	}
+
+	void FlushFramesCallback(KnfOnlineFeature* knfOnlineFeature) {
+		std::shared_ptr<FrameDispatcher> dispatcher;
+		{
+			std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+			dispatcher = knfOnlineFeature->dispatcher;
+		}
+		// Flushed without the lock, as frames are delivered meanwhile; a
+		// concurrent SetFramesCallback() cannot free it under us.
+		if (dispatcher != nullptr) {
+			dispatcher->Flush();
+		}
+	}
+
+	void DestroyOnlineFbank(KnfOnlineFeature* knfOnlineFeature) {
+		if (knfOnlineFeature == nullptr) {
+			return;
+		}
+		// stop the ingest worker first; it takes the handle lock
+		knfOnlineFeature->ingest.reset();
+		SetFramesCallback(knfOnlineFeature, nullptr, nullptr, false);
+		delete knfOnlineFeature->impl;
+		delete knfOnlineFeature;
+	}
+
+	int32_t EnableIngestQueue(KnfOnlineFeature* knfOnlineFeature, float sample_rate, int32_t capacity, int32_t overrun_policy, int32_t worker_interval_ms) {
+		if (capacity <= 0 || overrun_policy < 0 || overrun_policy > static_cast<int32_t>(OverrunPolicy::kReport)) {
+			return -1;
+		}
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		if (knfOnlineFeature->ingest) {
+			// the producer may already be using it
+			return -1;
+		}
+		knfOnlineFeature->ingest_sample_rate = sample_rate;
+		knfOnlineFeature->ingest = std::make_unique<AudioIngestQueue>(capacity, static_cast<OverrunPolicy>(overrun_policy));
+		if (worker_interval_ms > 0) {
+			knfOnlineFeature->ingest->StartWorker([knfOnlineFeature]() {
+				std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+				DrainIngestQueue(knfOnlineFeature);
+				}, worker_interval_ms);
+		}
+		return 0;
+	}
+
+	int32_t PushWaveform(KnfOnlineFeature* knfOnlineFeature, const float* samples, int32_t samples_size) {
+		// no lock here: this is the capture thread's wait-free path
+		AudioIngestQueue* ingest = knfOnlineFeature->ingest.get();
+		if (ingest == nullptr) {
+			return -1;
+		}
+		return ingest->Push(samples, samples_size);
+	}
+
+	void GetIngestStats(KnfOnlineFeature* knfOnlineFeature, KnfIngestStats* /*out*/ pStats) {
+		AudioIngestQueue* ingest = knfOnlineFeature->ingest.get();
+		*pStats = KnfIngestStats();
+		if (ingest == nullptr) {
+			return;
+		}
+		AudioIngestStats stats = ingest->GetStats();
+		pStats->pushed_samples = stats.pushed_samples;
+		pStats->drained_samples = stats.drained_samples;
+		pStats->dropped_samples = stats.dropped_samples;
+		pStats->overwritten_samples = stats.overwritten_samples;
+		pStats->rejected_samples = stats.rejected_samples;
+		pStats->overruns = stats.overruns;
+		pStats->capacity = stats.capacity;
+		pStats->size = stats.size;
+	}
+
+	int32_t GetFeatureDim(KnfOnlineFeature* knfOnlineFeature) {
+		return knfOnlineFeature->impl->Dim();
+	}
+
+	int32_t GetNumFramesPublished(KnfOnlineFeature* knfOnlineFeature) {
+		return knfOnlineFeature->impl->NumFramesReady();
+	}
+
+	int32_t ReadFrames(KnfOnlineFeature* knfOnlineFeature, int32_t begin, int32_t end, float* out) {
+		// Clip first, so that we never release frames published after the copy.
+		end = std::min(end, knfOnlineFeature->impl->NumFramesReady());
+		int32_t n = knfOnlineFeature->impl->ReadFrames(begin, end, out);
+		if (n > 0 && knfOnlineFeature->release_on_read.load(std::memory_order_relaxed)) {
+			knfOnlineFeature->impl->ReleaseFrames(end);
+		}
+		return n;
+	}
+
+	int32_t ReadFramesAs(KnfOnlineFeature* knfOnlineFeature, int32_t begin, int32_t end, int32_t format, void* out, float* row_scales) {
+		FeatureFormat feature_format = static_cast<FeatureFormat>(format);
+		if (BytesPerValue(feature_format) == 0 || (feature_format == FeatureFormat::kInt8 && row_scales == nullptr)) {
+			return -1;
+		}
+		if (feature_format == FeatureFormat::kFloat32) {
+			return ReadFrames(knfOnlineFeature, begin, end, static_cast<float*>(out));
+		}
+		// Sized for the frames that exist, not for end: a large end is valid
+		// and only clipped by ReadFrames().
+		end = std::min(end, knfOnlineFeature->impl->NumFramesReady());
+		if (begin < 0) {
+			return -1;
+		}
+		// per thread, so that concurrent readers of different streams do not
+		// allocate for every chunk
+		thread_local std::vector<float> frames;
+		int32_t dim = knfOnlineFeature->impl->Dim();
+		frames.resize(static_cast<size_t>(std::max(end - begin, 0)) * dim);
+		int32_t n = ReadFrames(knfOnlineFeature, begin, end, frames.data());
+		if (n > 0) {
+			ConvertFeatures(frames.data(), n, dim, feature_format, out, row_scales);
+		}
+		return n;
+	}
+
+	void ReleaseFrames(KnfOnlineFeature* knfOnlineFeature, int32_t end) {
+		knfOnlineFeature->impl->ReleaseFrames(end);
+	}
+
+	int32_t ReadFramesChannels(KnfOnlineFeature** handles, int32_t num_channels, int32_t begin, int32_t end, float* out) {
+		if (num_channels <= 0) {
+			return -1;
+		}
+		int32_t dim = handles[0]->impl->Dim();
+		for (int32_t c = 0; c != num_channels; ++c) {
+			if (handles[c]->impl->Dim() != dim) {
+				return -1;
+			}
+			end = std::min(end, handles[c]->impl->NumFramesReady());
+			// start where every channel still has its frames, so that the
+			// blocks stay aligned
+			begin = std::max(begin, handles[c]->impl->GetFrameStoreStats().first_available_index);
+		}
+		if (begin >= end) {
+			return 0;
+		}
+		int32_t n = end - begin;
+		for (int32_t c = 0; c != num_channels; ++c) {
+			if (handles[c]->impl->ReadFrames(begin, end, out + static_cast<size_t>(c) * n * dim) != n) {
+				return -1;  // released by another thread meanwhile
+			}
+		}
+		// only once every channel was read
+		for (int32_t c = 0; c != num_channels; ++c) {
+			if (handles[c]->release_on_read.load(std::memory_order_relaxed)) {
+				handles[c]->impl->ReleaseFrames(end);
+			}
+		}
+		return n;
+	}
+
+	int32_t CompressFrames(KnfOnlineFeature* knfOnlineFeature, int32_t begin, int32_t end, int32_t method, uint8_t* out, int32_t out_size) {
+		int32_t dim = knfOnlineFeature->impl->Dim();
+		end = std::min(end, knfOnlineFeature->impl->NumFramesReady());
+		if (begin >= end) {
+			return -1;
+		}
+		int32_t n = end - begin;
+		size_t size = CompressedMatrixSize(n, dim, static_cast<CompressionMethod>(method));
+		if (size == 0) {
+			return -1;
+		}
+		if (size > static_cast<size_t>(out_size)) {
+			return static_cast<int32_t>(size);
+		}
+		std::vector<float> frames(static_cast<size_t>(n) * dim);
+		if (knfOnlineFeature->impl->ReadFrames(begin, end, frames.data()) != n) {
+			return -1;  // already released
+		}
+		std::vector<uint8_t> compressed;
+		if (!CompressMatrix(frames.data(), n, dim, static_cast<CompressionMethod>(method), &compressed)) {
+			return -1;
+		}
+		std::copy(compressed.begin(), compressed.end(), out);
+		if (knfOnlineFeature->release_on_read.load(std::memory_order_relaxed)) {
+			knfOnlineFeature->impl->ReleaseFrames(end);
+		}
+		return static_cast<int32_t>(size);
+	}
+
+	int32_t DecompressMatrix(const uint8_t* data, int32_t size, int32_t* /*out*/ rows, int32_t* /*out*/ cols, float* out, int32_t out_size) {
+		*rows = 0;
+		*cols = 0;
+		size_t num_bytes = 0;
+		if (size < 0 || !GetCompressedMatrixInfo(data, size, rows, cols, &num_bytes)) {
+			return -1;
+		}
+		if (static_cast<int64_t>(*rows) * *cols > out_size) {
+			return -1;
+		}
+		return knf::DecompressMatrix(data, size, out) ? 0 : -1;
+	}
+
+	void SetFrameRetention(KnfOnlineFeature* knfOnlineFeature, int32_t max_frames, int64_t max_bytes, bool release_on_read) {
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		knfOnlineFeature->release_on_read.store(release_on_read, std::memory_order_relaxed);
+		knfOnlineFeature->impl->SetRetention(max_frames, max_bytes);
+	}
+
+	void GetFrameStoreStats(KnfOnlineFeature* knfOnlineFeature, KnfFrameStoreStats* /*out*/ pStats) {
+		FrameStoreStats stats = knfOnlineFeature->impl->GetFrameStoreStats();
+		pStats->num_frames = stats.num_frames;
+		pStats->first_available_index = stats.first_available_index;
+		pStats->retained_frames = stats.retained_frames;
+		pStats->peak_retained_frames = stats.peak_retained_frames;
+		pStats->retained_bytes = stats.retained_bytes;
+		pStats->peak_retained_bytes = stats.peak_retained_bytes;
+	}
+
+	void GetFeatureStats(KnfOnlineFeature* knfOnlineFeature, KnfStats* /*out*/ pStats) {
+		ToKnfStats(knfOnlineFeature->impl->GetFeatureStats(), pStats);
+	}
+
+	void GetGlobalFeatureStats(KnfStats* /*out*/ pStats) {
+		ToKnfStats(FeatureStatsCollector::GetGlobal(), pStats);
+	}
+
+	void ResetFeatureStats(KnfOnlineFeature* knfOnlineFeature) {
+		knfOnlineFeature->impl->ResetFeatureStats();
+	}
+
+	void ResetGlobalFeatureStats() {
+		FeatureStatsCollector::ResetGlobal();
+	}
+
+	static int32_t AddStage(KnfOnlineFeature* knfOnlineFeature, std::unique_ptr<OnlineFeatureStage> stage) {
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		return knfOnlineFeature->impl->AddStage(std::move(stage)) ? 0 : -1;
+	}
+
+	static int32_t AddLfrCmvnStage(KnfOnlineFeature* knfOnlineFeature, const LfrCmvnOptions& opts) {
+		int32_t input_dim = knfOnlineFeature->impl->Dim();
+		if (opts.lfr_m <= 0 || opts.lfr_n <= 0 ||
+			(!opts.neg_mean.empty() && static_cast<int32_t>(opts.neg_mean.size()) != input_dim * opts.lfr_m)) {
+			return -1;
+		}
+		return AddStage(knfOnlineFeature, std::make_unique<LfrCmvnStage>(input_dim, opts));
+	}
+
+	int32_t SetLfrCmvn(KnfOnlineFeature* knfOnlineFeature, int32_t lfr_m, int32_t lfr_n, const char* mvn_filename) {
+		LfrCmvnOptions opts;
+		opts.lfr_m = lfr_m;
+		opts.lfr_n = lfr_n;
+		if (mvn_filename != nullptr && mvn_filename[0] != '\0' &&
+			!ReadAmMvn(std::string(mvn_filename), &opts.neg_mean, &opts.inv_stddev)) {
+			return -1;
+		}
+		return AddLfrCmvnStage(knfOnlineFeature, opts);
+	}
+
+	int32_t SetLfrCmvnStats(KnfOnlineFeature* knfOnlineFeature, int32_t lfr_m, int32_t lfr_n, const float* neg_mean, const float* inv_stddev, int32_t dim) {
+		LfrCmvnOptions opts;
+		opts.lfr_m = lfr_m;
+		opts.lfr_n = lfr_n;
+		if (neg_mean != nullptr && inv_stddev != nullptr && dim > 0) {
+			opts.neg_mean.assign(neg_mean, neg_mean + dim);
+			opts.inv_stddev.assign(inv_stddev, inv_stddev + dim);
+		}
+		return AddLfrCmvnStage(knfOnlineFeature, opts);
+	}
+
+	int32_t SetOnlineCmvn(KnfOnlineFeature* knfOnlineFeature, int32_t cmn_window, int32_t speaker_frames, int32_t global_frames, bool normalize_variance, const double* global_stats, const double* speaker_stats, int32_t stats_size) {
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		int32_t dim = knfOnlineFeature->impl->Dim();
+		if (knfOnlineFeature->cmvn != nullptr || cmn_window <= 0 ||
+			((global_stats != nullptr || speaker_stats != nullptr) && stats_size != 2 * (dim + 1))) {
+			return -1;
+		}
+		OnlineCmvnOptions opts;
+		opts.cmn_window = cmn_window;
+		opts.speaker_frames = speaker_frames;
+		opts.global_frames = global_frames;
+		opts.normalize_variance = normalize_variance;
+		OnlineCmvnState state;
+		if (global_stats != nullptr) {
+			state.global_stats.assign(global_stats, global_stats + stats_size);
+		}
+		if (speaker_stats != nullptr) {
+			state.speaker_stats.assign(speaker_stats, speaker_stats + stats_size);
+		}
+		auto stage = std::make_unique<OnlineCmvnStage>(dim, opts, state);
+		OnlineCmvnStage* cmvn = stage.get();
+		if (!knfOnlineFeature->impl->AddStage(std::move(stage))) {
+			return -1;
+		}
+		knfOnlineFeature->cmvn = cmvn;
+		return 0;
+	}
+
+	int32_t GetOnlineCmvnSpeakerStats(KnfOnlineFeature* knfOnlineFeature, double* /*out*/ speaker_stats, int32_t stats_size) {
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		if (knfOnlineFeature->cmvn == nullptr) {
+			return -1;
+		}
+		OnlineCmvnState state = knfOnlineFeature->cmvn->GetState();
+		int32_t n = static_cast<int32_t>(state.speaker_stats.size());
+		if (stats_size < n) {
+			return -1;
+		}
+		std::copy(state.speaker_stats.begin(), state.speaker_stats.end(), speaker_stats);
+		return n;
+	}
+
+	int32_t SetDeltas(KnfOnlineFeature* knfOnlineFeature, int32_t order, int32_t window) {
+		if (order < 0 || window <= 0) {
+			return -1;
+		}
+		DeltaFeaturesOptions opts;
+		opts.order = order;
+		opts.window = window;
+		return AddStage(knfOnlineFeature, std::make_unique<OnlineDeltaStage>(knfOnlineFeature->impl->Dim(), opts));
+	}
+
+	int32_t EnableVad(KnfOnlineFeature* knfOnlineFeature, float energy_threshold, float unvoiced_energy_margin, float zcr_threshold, int32_t hangover_frames, KnfVadCallback callback, void* user_data) {
+		if (hangover_frames < 0) {
+			return -1;
+		}
+		EnergyVadOptions opts;
+		opts.energy_threshold = energy_threshold;
+		opts.unvoiced_energy_margin = unvoiced_energy_margin;
+		opts.zcr_threshold = zcr_threshold;
+		opts.hangover_frames = hangover_frames;
+		VadEventCallback deliver;
+		if (callback != nullptr) {
+			deliver = [callback, user_data](const VadEvent& event) {
+				callback(user_data, event.type, event.frame, event.speech_frame);
+			};
+		}
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		return knfOnlineFeature->impl->EnableVad(opts, std::move(deliver)) ? 0 : -1;
+	}
+
+	int32_t GetVadFlags(KnfOnlineFeature* knfOnlineFeature, int32_t begin, int32_t end, uint8_t* /*out*/ flags) {
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		const EnergyVad* vad = knfOnlineFeature->impl->GetVad();
+		if (vad == nullptr) {
+			return -1;
+		}
+		return vad->GetFlags(begin, end, flags);
+	}
+
+	int32_t GetVadState(KnfOnlineFeature* knfOnlineFeature, KnfVadState* /*out*/ pState) {
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		const EnergyVad* vad = knfOnlineFeature->impl->GetVad();
+		if (vad == nullptr) {
+			return -1;
+		}
+		pState->num_frames = vad->NumFrames();
+		pState->num_speech_frames = vad->NumSpeechFrames();
+		pState->in_speech = vad->InSpeech() ? 1 : 0;
+		pState->first_flag = vad->FirstFlag();
+		return 0;
+	}
+
+	int32_t GetStageLatency(KnfOnlineFeature* knfOnlineFeature) {
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		return knfOnlineFeature->impl->StageLatency();
+	}
+
+	uint64_t GetOptionsFingerprint(KnfOnlineFeature* knfOnlineFeature) {
+		return OptionsFingerprint(knfOnlineFeature->impl->OptionsString());
+	}
+
+	int32_t SaveState(KnfOnlineFeature* knfOnlineFeature, uint8_t* out, int32_t out_size) {
+		std::string state;
+		{
+			std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+			DrainIngestQueue(knfOnlineFeature);
+			if (!knfOnlineFeature->impl->SaveState(&state)) {
+				return -1;
+			}
+		}
+		if (state.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+			return -1;
+		}
+		if (out != nullptr && out_size >= 0 && state.size() <= static_cast<size_t>(out_size)) {
+			std::copy(state.begin(), state.end(), out);
+		}
+		return static_cast<int32_t>(state.size());
+	}
+
+	int32_t LoadState(KnfOnlineFeature* knfOnlineFeature, const uint8_t* data, int32_t size) {
+		if (size < 0) {
+			return -1;
+		}
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		DrainIngestQueue(knfOnlineFeature);
+		return knfOnlineFeature->impl->LoadState(data, static_cast<size_t>(size)) ? 0 : -1;
+	}
+
+	KnfFeatureStoreWriter* CreateFeatureStoreWriter(const char* filename) {
+		KnfFeatureStoreWriter* writer = new KnfFeatureStoreWriter;
+		if (!writer->writer.Open(filename)) {
+			delete writer;
+			return nullptr;
+		}
+		return writer;
+	}
+
+	int32_t FeatureStoreWrite(KnfFeatureStoreWriter* writer, const char* key, const float* data, int32_t rows, int32_t cols, uint64_t fingerprint) {
+		return writer->writer.Write(key, data, rows, cols, fingerprint) ? 0 : -1;
+	}
+
+	int32_t CloseFeatureStoreWriter(KnfFeatureStoreWriter* writer) {
+		bool ok = writer->writer.Close();
+		delete writer;
+		return ok ? 0 : -1;
+	}
+
+	KnfFeatureStore* OpenFeatureStore(const char* filename) {
+		KnfFeatureStore* store = new KnfFeatureStore;
+		if (!store->reader.Open(filename)) {
+			delete store;
+			return nullptr;
+		}
+		return store;
+	}
+
+	int32_t FeatureStoreNumUtterances(KnfFeatureStore* store) {
+		return store->reader.NumUtterances();
+	}
+
+	int32_t FeatureStoreFind(KnfFeatureStore* store, const char* key) {
+		return store->reader.Find(key);
+	}
+
+	const char* FeatureStoreGetKey(KnfFeatureStore* store, int32_t index) {
+		if (index < 0 || index >= store->reader.NumUtterances()) {
+			return nullptr;
+		}
+		return store->reader.Entry(index).key.c_str();
+	}
+
+	int32_t FeatureStoreGetInfo(KnfFeatureStore* store, int32_t index, int32_t* /*out*/ rows, int32_t* /*out*/ cols, uint64_t* /*out*/ fingerprint) {
+		if (index < 0 || index >= store->reader.NumUtterances()) {
+			return -1;
+		}
+		const FeatureStoreEntry& entry = store->reader.Entry(index);
+		*rows = entry.rows;
+		*cols = entry.cols;
+		*fingerprint = entry.fingerprint;
+		return 0;
+	}
+
+	const float* FeatureStoreGetFrames(KnfFeatureStore* store, int32_t index, int32_t begin, int32_t end) {
+		return store->reader.Frames(index, begin, end);
+	}
+
+	void CloseFeatureStore(KnfFeatureStore* store) {
+		delete store;
+	}
+
+	KnfFeatureCache* CreateFeatureCache(int64_t max_memory_bytes, const char* directory) {
+		FeatureCacheOptions opts;
+		opts.max_memory_bytes = std::max<int64_t>(max_memory_bytes, 0);
+		if (directory != nullptr) {
+			opts.directory = directory;
+		}
+		KnfFeatureCache* cache = new KnfFeatureCache;
+		cache->cache = std::make_shared<FeatureCache>(opts);
+		return cache;
+	}
+
+	void DestroyFeatureCache(KnfFeatureCache* cache) {
+		delete cache;
+	}
+
+	void GetFeatureCacheStats(KnfFeatureCache* cache, KnfFeatureCacheStats* /*out*/ pStats) {
+		FeatureCacheStats stats = cache->cache->GetStats();
+		pStats->memory_hits = stats.memory_hits;
+		pStats->disk_hits = stats.disk_hits;
+		pStats->misses = stats.misses;
+		pStats->insertions = stats.insertions;
+		pStats->evictions = stats.evictions;
+		pStats->memory_entries = stats.memory_entries;
+		pStats->memory_bytes = stats.memory_bytes;
+	}
+
+	void ResetFeatureCacheStats(KnfFeatureCache* cache) {
+		cache->cache->ResetStats();
+	}
+
+	KnfOfflineFeature* GetOfflineFeature(FeatureOptions* opts) {
+		std::unique_ptr<OfflineFeature> impl;
+		if (opts->feature_type == "fbank") {
+			impl = std::make_unique<OfflineFbank>(ToFbankOptions(opts));
+		}
+		else if (opts->feature_type == "mfcc") {
+			impl = std::make_unique<OfflineMfcc>(ToMfccOptions(opts));
+		}
+		else if (opts->feature_type == "whisper") {
+			impl = std::make_unique<OfflineWhisperFbank>(ToWhisperOptions(opts));
+		}
+		else {
+			return nullptr;
+		}
+		KnfOfflineFeature* knfOfflineFeature = new KnfOfflineFeature;
+		knfOfflineFeature->impl = std::move(impl);
+		return knfOfflineFeature;
+	}
+
+	void SetOfflineFeatureCache(KnfOfflineFeature* knfOfflineFeature, KnfFeatureCache* cache) {
+		knfOfflineFeature->impl->SetCache(cache != nullptr ? cache->cache : nullptr);
+	}
+
+	int32_t GetOfflineFeatureDim(KnfOfflineFeature* knfOfflineFeature) {
+		return knfOfflineFeature->impl->Dim();
+	}
+
+	int32_t GetOfflineNumFrames(KnfOfflineFeature* knfOfflineFeature, int64_t num_samples) {
+		return NumFrames(num_samples, knfOfflineFeature->impl->GetFrameOptions());
+	}
+
+	int32_t ComputeOfflineFeatures(KnfOfflineFeature* knfOfflineFeature, const float* samples, int32_t num_samples, float* out, int32_t out_size) {
+		OfflineFeature* impl = knfOfflineFeature->impl.get();
+		int32_t num_frames = NumFrames(num_samples, impl->GetFrameOptions());
+		if (static_cast<int64_t>(num_frames) * impl->Dim() > out_size) {
+			return -1;
+		}
+		// the buffers are kept to avoid allocating for every utterance
+		knfOfflineFeature->wave.assign(samples, samples + num_samples);
+		num_frames = impl->Compute(knfOfflineFeature->wave, &knfOfflineFeature->feats);
+		std::copy(knfOfflineFeature->feats.begin(), knfOfflineFeature->feats.end(), out);
+		return num_frames;
+	}
+
+	void DestroyOfflineFeature(KnfOfflineFeature* knfOfflineFeature) {
+		delete knfOfflineFeature;
+	}
+
 	std::vector<float> GetFrames(KnfOnlineFeature* knfOnlineFeature, int lastFrameIndex) {
-		std::lock_guard<std::mutex> lock(mutex_);
+		std::lock_guard<std::mutex> lock(knfOnlineFeature->mutex);
+		DrainIngestQueue(knfOnlineFeature);
 		int32_t n = knfOnlineFeature->impl->NumFramesReady();
 		assert(n - lastFrameIndex >= 0 && "Please first call AcceptWaveform()");		
 		/*int32_t n = framesNum - last_frame_index_;
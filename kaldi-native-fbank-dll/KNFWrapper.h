@@ -15,6 +15,7 @@
 #endif
 
 
+#include "audio-ingest-queue.h"
 #include "feature-fbank.h"
 #include "online-feature.h"
 #include <list>
@@ -63,6 +64,8 @@ extern "C" {
 			bool htk_mode = false;
 			bool is_librosa = false;
 			std::string norm = "slaney";
+			float blackman_coeff = 0.42f;
+			float kaiser_beta = 12.0f;
 			//// Amount of dithering, 0.0 means no dither.
 			//float preemph_coeff = 0.97f;    // Preemphasis coefficient.
 			//bool remove_dc_offset = true;   // Subtract mean of wave before FFT.
@@ -84,15 +87,323 @@ extern "C" {
 			//bool floor_to_int_bin = false;
 		};
 
+		typedef struct KnfIngestStats {
+			int64_t pushed_samples;
+			int64_t drained_samples;
+			int64_t dropped_samples;
+			int64_t overwritten_samples;
+			int64_t rejected_samples;
+			int64_t overruns;
+			int32_t capacity;
+			int32_t size;
+		} KnfIngestStats;
+
+		typedef struct KnfFrameStoreStats {
+			int32_t num_frames;
+			int32_t first_available_index;
+			int32_t retained_frames;
+			int32_t peak_retained_frames;
+			int64_t retained_bytes;
+			int64_t peak_retained_bytes;
+		} KnfFrameStoreStats;
+
+		// Timings of one feature stage, see feature-stats.h.
+		// histogram[i] counts calls that took [2^i, 2^(i+1)) nanoseconds.
+		typedef struct KnfStageStats {
+			int64_t count;
+			int64_t total_ns;
+			int64_t max_ns;
+			int64_t histogram[32];
+		} KnfStageStats;
+
+		// stages[] is indexed by FeatureStage: 0 window, 1 fft,
+		// 2 power spectrum, 3 mel, 4 log (and DCT for mfcc), 5 copy.
+		typedef struct KnfStats {
+			int32_t enabled;  // 0 if the library was built without KNF_ENABLE_STATS
+			int32_t num_stages;
+			int64_t num_frames;
+			KnfStageStats stages[6];
+		} KnfStats;
+
+		// Counters of a feature cache, see feature-cache.h
+		typedef struct KnfFeatureCacheStats {
+			int64_t memory_hits;
+			int64_t disk_hits;
+			int64_t misses;
+			int64_t insertions;
+			int64_t evictions;  // from memory
+			int64_t memory_entries;
+			int64_t memory_bytes;
+		} KnfFeatureCacheStats;
+
+		typedef struct KnfVadState {
+			int32_t num_frames;         // frames classified so far
+			int32_t num_speech_frames;  // of which speech; the frames that were computed
+			int32_t in_speech;          // 1 if a segment is open
+			int32_t first_flag;         // flags of the frames before it were released
+		} KnfVadState;
+
 		typedef struct KnfOnlineFeature KnfOnlineFeature;
+		// Indexed feature files, see feature-store.h
+		typedef struct KnfFeatureStoreWriter KnfFeatureStoreWriter;
+		typedef struct KnfFeatureStore KnfFeatureStore;
+		// Whole-utterance extraction and its cache, see offline-feature.h
+		typedef struct KnfOfflineFeature KnfOfflineFeature;
+		typedef struct KnfFeatureCache KnfFeatureCache;
+
+		// Called with each contiguous block of new frames, see SetFramesCallback().
+		// frames is row major with shape [num_frames][dim] and is only valid
+		// during the call.
+		typedef void (*KnfFramesCallback)(void* user_data, const float* frames, int32_t num_frames, int32_t dim, int32_t first_frame);
+
+		// Called at each speech segment boundary, see EnableVad(). event is 0 for
+		// a segment start and 1 for its end; frame is the index of its first
+		// frame, or one past its last one, counting all frames; speech_frame is
+		// the same position counting only speech (i.e. computed) frames.
+		typedef void (*KnfVadCallback)(void* user_data, int32_t event, int32_t frame, int32_t speech_frame);
 
 		LIBRARY_API FeatureOptions* GetFbankOptions(float dither, bool snip_edges, float sample_rate, int32_t num_bins, int32_t num_ceps, float frame_shift = 10.0f, float frame_length = 25.0f, float energy_floor = 0.0f, bool debug_mel = false, const char* window_type = "hamming", const char* feature_type = "fbank");
+		// Select the window of opts by WindowType (0 hanning, 1 sine, 2 hamming,
+		// 3 povey, 4 rectangular, 5 blackman, 6 kaiser) instead of by name;
+		// periodic selects the periodic form, e.g. that of torch.hann_window.
+		// coeff is the blackman coefficient or the kaiser beta and is ignored by
+		// the other windows. Returns 0 on success, -1 for an unknown type.
+		LIBRARY_API int32_t SetWindowType(FeatureOptions* opts, int32_t window_type, bool periodic, float coeff);
 		LIBRARY_API KnfOnlineFeature* GetOnlineFbank(FeatureOptions* opts);
+		// One handle that computes several features per frame from a single
+		// window and FFT. heads are FeatureHead values (0 log fbank, 1 mfcc,
+		// 2 power spectrum, 3 log energy), in the order they appear in each
+		// frame; num_bins and num_ceps of opts apply. Returns nullptr if a head
+		// is unknown or repeated. Use GetFeatureHeadLayout() to split frames.
+		LIBRARY_API KnfOnlineFeature* GetOnlineMultiFeature(FeatureOptions* opts, const int32_t* heads, int32_t num_heads);
+		// Offset and size of a head within a frame of a GetOnlineMultiFeature()
+		// handle. Returns 0 on success, -1 if the handle is not one or the head
+		// is not computed.
+		LIBRARY_API int32_t GetFeatureHeadLayout(KnfOnlineFeature* knfOnlineFeature, int32_t head, int32_t* /*out*/ offset, int32_t* /*out*/ dim);
+		// sample_rate may differ from the one in the options (e.g. 8000, 44100
+		// or 48000 Hz); the samples are then resampled on the fly, which
+		// delays the last few frames until InputFinished(). It must be the
+		// same in every call for a handle.
 		LIBRARY_API void AcceptWaveform(KnfOnlineFeature* knfOnlineFeature, float sample_rate, float* samples, int samples_size);
+		// Interleaved multi-channel input (num_frames groups of num_channels
+		// samples): the channels are averaged to mono in native code and
+		// accepted like AcceptWaveform(). Returns 0 on success, -1 on error.
+		LIBRARY_API int32_t AcceptWaveformInterleaved(KnfOnlineFeature* knfOnlineFeature, float sample_rate, const float* samples, int32_t num_frames, int32_t num_channels);
+		// Interleaved multi-channel input with one feature pipeline per
+		// channel: channel c is de-interleaved in native code and accepted by
+		// handles[c]. The handles are normally created with the same options
+		// and configured alike. Returns 0 on success, -1 on error.
+		LIBRARY_API int32_t AcceptWaveformChannels(KnfOnlineFeature** handles, int32_t num_channels, float sample_rate, const float* samples, int32_t num_frames);
 		LIBRARY_API void InputFinished(KnfOnlineFeature* knfOnlineFeature);
+		// Compute the features of a whole file and then call InputFinished().
+		// The file is a WAV file (PCM 16/24 bit or 32-bit float) if raw_format
+		// is -1, or else headerless interleaved samples in raw_format
+		// (0 = PCM16, 1 = PCM24, 2 = float32) at raw_sample_rate with
+		// raw_num_channels. It is memory-mapped and converted a chunk at a
+		// time, and channels are averaged. Samples are in the 16-bit range
+		// like Kaldi's, or in [-1, 1) if normalize. Frames are delivered as
+		// with AcceptWaveform(); use a frames callback or SetFrameRetention()
+		// to keep memory bounded for long files. Returns the number of
+		// samples read, or -1 on error.
+		LIBRARY_API int64_t ComputeFeaturesFromFile(KnfOnlineFeature* knfOnlineFeature, const char* filename, int32_t raw_format, float raw_sample_rate, int32_t raw_num_channels, bool normalize);
 		LIBRARY_API int32_t GetNumFramesReady(KnfOnlineFeature* knfOnlineFeature);
 		LIBRARY_API void GetFbank(KnfOnlineFeature* knfOnlineFbank, int currFrameIndex, FbankData* /*out*/ pData);
 		LIBRARY_API void GetFbanks(KnfOnlineFeature* knfOnlineFbank, int lastFrameIndex, FbankDatas* /*out*/ pData);
+		// Deliver new frames to callback instead of polling GetNumFramesReady().
+		// If async is false, callback runs inside AcceptWaveform()/InputFinished()
+		// and must not call back into this handle. If async is true, frames are
+		// copied and delivered in order on a worker thread owned by the handle.
+		// Pass callback = nullptr to unregister.
+		LIBRARY_API void SetFramesCallback(KnfOnlineFeature* knfOnlineFeature, KnfFramesCallback callback, void* user_data, bool async);
+		// Wait until all frames computed so far were delivered to an async callback.
+		LIBRARY_API void FlushFramesCallback(KnfOnlineFeature* knfOnlineFeature);
+		LIBRARY_API void DestroyOnlineFbank(KnfOnlineFeature* knfOnlineFeature);
+		// Give the handle a lock-free single-producer/single-consumer ring of
+		// `capacity` samples (rounded up to a power of two). overrun_policy is
+		// 0 = drop new samples, 1 = overwrite oldest samples, 2 = report (reject
+		// the push). If worker_interval_ms > 0 a worker thread drains the ring
+		// into the extractor at that interval; otherwise it is drained by the
+		// next AcceptWaveform/InputFinished/GetNumFramesReady/GetFbanks call.
+		// Returns 0 on success. Must be called once, before PushWaveform().
+		LIBRARY_API int32_t EnableIngestQueue(KnfOnlineFeature* knfOnlineFeature, float sample_rate, int32_t capacity, int32_t overrun_policy, int32_t worker_interval_ms);
+		// Wait-free (except for the overwrite policy, which is lock-free) push
+		// from a single capture thread. Returns the number of samples stored,
+		// or -1 if EnableIngestQueue() was not called.
+		LIBRARY_API int32_t PushWaveform(KnfOnlineFeature* knfOnlineFeature, const float* samples, int32_t samples_size);
+		LIBRARY_API void GetIngestStats(KnfOnlineFeature* knfOnlineFeature, KnfIngestStats* /*out*/ pStats);
+		// The following four functions take no lock, so a decoder thread can
+		// read frames while another thread is in AcceptWaveform(). Frames are
+		// published one by one as they are computed; a frame read this way stays
+		// valid until it is released by ReleaseFrames(), GetFbank() or GetFbanks().
+		// ReadFrames() is safe against frames being released meanwhile, by
+		// another reader or the retention limits: their memory is only reused
+		// once the reads that may see it have returned.
+		LIBRARY_API int32_t GetFeatureDim(KnfOnlineFeature* knfOnlineFeature);
+		// Number of frames computed so far, without draining the ingest queue.
+		LIBRARY_API int32_t GetNumFramesPublished(KnfOnlineFeature* knfOnlineFeature);
+		// Copy frames [begin, end) to out (room for (end - begin) * dim floats).
+		// end is clipped to the frames computed so far; returns the number of
+		// frames copied, starting at begin, or -1 if begin is below
+		// KnfFrameStoreStats::first_available_index, i.e. frames were already
+		// released (nothing is copied then).
+		LIBRARY_API int32_t ReadFrames(KnfOnlineFeature* knfOnlineFeature, int32_t begin, int32_t end, float* out);
+		// ReadFrames() converted to format (see feature-format.h): 0 float32,
+		// 1 IEEE fp16, 2 bf16, 3 int8 with a scale per frame in row_scales
+		// (room for end - begin floats; may be nullptr otherwise). out has room
+		// for (end - begin) * dim values of the format. Returns the number of
+		// frames, or -1 for an unknown format or released frames.
+		LIBRARY_API int32_t ReadFramesAs(KnfOnlineFeature* knfOnlineFeature, int32_t begin, int32_t end, int32_t format, void* out, float* row_scales);
+		// Discard all frames with index < end.
+		LIBRARY_API void ReleaseFrames(KnfOnlineFeature* knfOnlineFeature, int32_t end);
+		// ReadFrames() for the handles of AcceptWaveformChannels(): [begin, end)
+		// is clipped to the frames every channel has, i.e. it starts at the
+		// first frame none of them has released, and the n frames are copied
+		// to out as [channel][frame][dim] (room for num_channels *
+		// (end - begin) * dim floats). Returns n, or -1 if the dims differ or
+		// frames were released while they were being read.
+		LIBRARY_API int32_t ReadFramesChannels(KnfOnlineFeature** handles, int32_t num_channels, int32_t begin, int32_t end, float* out);
+		// ReadFrames() into a Kaldi compressed matrix, byte-for-byte what
+		// Kaldi's CompressedMatrix::Write() writes for it in binary mode (put
+		// "<key> \0B" in front for an archive entry). method is Kaldi's
+		// compression method: 1 = automatic, 2 = speech feature ("CM", one
+		// byte per value), 3 = two bytes ("CM2"), 5 = one byte ("CM3").
+		// Returns the size in bytes; the data is written (and the frames read)
+		// only if it is at most out_size. Returns -1 on error, e.g. no frames.
+		LIBRARY_API int32_t CompressFrames(KnfOnlineFeature* knfOnlineFeature, int32_t begin, int32_t end, int32_t method, uint8_t* out, int32_t out_size);
+		// Decode a Kaldi compressed matrix ("CM", "CM2" or "CM3", optionally
+		// preceded by "\0B") of size bytes into rows x cols row-major floats.
+		// Returns 0 on success, -1 if it is not valid or out_size < rows * cols;
+		// rows and cols are set in both cases when the header is valid.
+		LIBRARY_API int32_t DecompressMatrix(const uint8_t* data, int32_t size, int32_t* /*out*/ rows, int32_t* /*out*/ cols, float* out, int32_t out_size);
+		// Bound the memory used for computed frames. At most max_frames frames
+		// and about max_bytes bytes are kept (-1 = no limit); older frames are
+		// discarded as new ones are computed. If release_on_read is true (the
+		// default), frames are also discarded once they were returned by
+		// ReadFrames() or delivered to a frames callback, so a handle that is
+		// only consumed that way stays small without any limit. Set it to false
+		// if the same frames are also fetched with GetFbank()/GetFbanks().
+		LIBRARY_API void SetFrameRetention(KnfOnlineFeature* knfOnlineFeature, int32_t max_frames, int64_t max_bytes, bool release_on_read);
+		LIBRARY_API void GetFrameStoreStats(KnfOnlineFeature* knfOnlineFeature, KnfFrameStoreStats* /*out*/ pStats);
+		// Per-stage timings of one handle, or summed over every handle of the
+		// process (including destroyed ones). Cheap enough to poll; reading
+		// never blocks feature computation.
+		LIBRARY_API void GetFeatureStats(KnfOnlineFeature* knfOnlineFeature, KnfStats* /*out*/ pStats);
+		LIBRARY_API void GetGlobalFeatureStats(KnfStats* /*out*/ pStats);
+		// Resetting a handle keeps its counts in the process-wide totals;
+		// resetting the global stats also resets every handle.
+		LIBRARY_API void ResetFeatureStats(KnfOnlineFeature* knfOnlineFeature);
+		LIBRARY_API void ResetGlobalFeatureStats();
+		// Stack lfr_m frames every lfr_n frames (low frame rate, e.g. 7 and 6
+		// for Paraformer/SenseVoice) and apply CMVN in the same pass, so the
+		// handle outputs model input directly; its dim becomes lfr_m times the
+		// feature dim. CMVN is read from a FunASR am.mvn file (nullptr or ""
+		// for none), or given as arrays of dim values each. Must be called
+		// before the first AcceptWaveform() and before SetFramesCallback().
+		// Returns 0 on success, -1 on error.
+		LIBRARY_API int32_t SetLfrCmvn(KnfOnlineFeature* knfOnlineFeature, int32_t lfr_m, int32_t lfr_n, const char* mvn_filename);
+		LIBRARY_API int32_t SetLfrCmvnStats(KnfOnlineFeature* knfOnlineFeature, int32_t lfr_m, int32_t lfr_n, const float* neg_mean, const float* inv_stddev, int32_t dim);
+		// Normalize the output online with running statistics over the last
+		// cmn_window frames (Kaldi's OnlineCmvn). While fewer frames were seen,
+		// the statistics are topped up towards cmn_window frames with at most
+		// speaker_frames frames of speaker_stats, then at most global_frames
+		// frames of global_stats. Both are optional (nullptr)
+		// and are 2 x (dim + 1) matrices in Kaldi's cmvn layout: frame sums and
+		// count, then sums of squares and 0; stats_size must be 2 * (dim + 1).
+		// Same restrictions as SetLfrCmvn(); applied after it if both are used.
+		// Returns 0 on success, -1 on error.
+		LIBRARY_API int32_t SetOnlineCmvn(KnfOnlineFeature* knfOnlineFeature, int32_t cmn_window, int32_t speaker_frames, int32_t global_frames, bool normalize_variance, const double* global_stats, const double* speaker_stats, int32_t stats_size);
+		// Speaker statistics to pass to SetOnlineCmvn() for the next utterance
+		// of the same speaker: the ones it was given plus all frames seen so
+		// far. Returns the number of values written (2 * (dim + 1)), or -1 if
+		// SetOnlineCmvn() was not called or stats_size is too small.
+		LIBRARY_API int32_t GetOnlineCmvnSpeakerStats(KnfOnlineFeature* knfOnlineFeature, double* /*out*/ speaker_stats, int32_t stats_size);
+		// Append Kaldi-style deltas (add-deltas) up to order to every frame; the
+		// dim becomes (order + 1) times the previous one. A frame is output
+		// once its order * window frames of right context were computed.
+		// Same restrictions as SetLfrCmvn(). Returns 0 on success, -1 on error.
+		LIBRARY_API int32_t SetDeltas(KnfOnlineFeature* knfOnlineFeature, int32_t order, int32_t window);
+		// Gate feature computation with an energy / zero-crossing VAD: silence
+		// frames skip the FFT and everything after it and are not stored, so
+		// frame indices count speech frames only. A frame is speech if its log
+		// energy (after DC removal) is >= energy_threshold, or >=
+		// energy_threshold - unvoiced_energy_margin with a zero-crossing rate
+		// >= zcr_threshold, or within hangover_frames after such a frame.
+		// callback (may be nullptr) runs inside AcceptWaveform()/InputFinished()
+		// and must not call back into this handle. Must be called before the
+		// first AcceptWaveform(). Returns 0 on success, -1 on error.
+		LIBRARY_API int32_t EnableVad(KnfOnlineFeature* knfOnlineFeature, float energy_threshold, float unvoiced_energy_margin, float zcr_threshold, int32_t hangover_frames, KnfVadCallback callback, void* user_data);
+		// Copy the speech flags (1 speech, 0 silence) of frames [begin, end),
+		// counting all frames, to flags. Flags are released with the frames
+		// they precede and bounded by SetFrameRetention(), so begin is clipped
+		// to KnfVadState::first_flag. Returns the number copied, or -1 if
+		// EnableVad() was not called.
+		LIBRARY_API int32_t GetVadFlags(KnfOnlineFeature* knfOnlineFeature, int32_t begin, int32_t end, uint8_t* /*out*/ flags);
+		LIBRARY_API int32_t GetVadState(KnfOnlineFeature* knfOnlineFeature, KnfVadState* /*out*/ pState);
+		// Number of computed frames the output of the post-processing stages
+		// lags behind (0 without stages).
+		LIBRARY_API int32_t GetStageLatency(KnfOnlineFeature* knfOnlineFeature);
+		// Fingerprint of the feature options (not of the stages), to record in
+		// a feature store and check when reading it.
+		LIBRARY_API uint64_t GetOptionsFingerprint(KnfOnlineFeature* knfOnlineFeature);
+		// Save the waveform-dependent state of an idle stream (the samples and
+		// frames it still holds, the resampler history, whether the input
+		// finished) so that it can be freed and resumed later with LoadState(),
+		// possibly in another process. Returns the size in bytes; the state is
+		// written only if it is at most out_size. Returns -1 if the stream
+		// has post-processing stages (e.g. online CMVN) or a VAD.
+		LIBRARY_API int32_t SaveState(KnfOnlineFeature* knfOnlineFeature, uint8_t* out, int32_t out_size);
+		// Resume from a state of SaveState() on a new handle created with the
+		// same options, before any waveform is accepted. The callbacks and
+		// retention settings are not part of the state. Returns 0 on success,
+		// -1 if the state is not valid or is for other options.
+		LIBRARY_API int32_t LoadState(KnfOnlineFeature* knfOnlineFeature, const uint8_t* data, int32_t size);
+
+		// Returns nullptr if the file cannot be created.
+		LIBRARY_API KnfFeatureStoreWriter* CreateFeatureStoreWriter(const char* filename);
+		// Append a rows x cols row-major matrix. Returns -1 if the key was
+		// already written, the matrix is empty, or on a write error.
+		LIBRARY_API int32_t FeatureStoreWrite(KnfFeatureStoreWriter* writer, const char* key, const float* data, int32_t rows, int32_t cols, uint64_t fingerprint);
+		// Write the index and free the writer. Returns -1 if the file is not
+		// complete; it cannot be opened then.
+		LIBRARY_API int32_t CloseFeatureStoreWriter(KnfFeatureStoreWriter* writer);
+		// Map a store for reading. Returns nullptr if it is not a valid store.
+		LIBRARY_API KnfFeatureStore* OpenFeatureStore(const char* filename);
+		LIBRARY_API int32_t FeatureStoreNumUtterances(KnfFeatureStore* store);
+		// Index of an utterance, -1 if there is none
+		LIBRARY_API int32_t FeatureStoreFind(KnfFeatureStore* store, const char* key);
+		// The key of an utterance, valid until CloseFeatureStore(); nullptr if
+		// index is out of range.
+		LIBRARY_API const char* FeatureStoreGetKey(KnfFeatureStore* store, int32_t index);
+		LIBRARY_API int32_t FeatureStoreGetInfo(KnfFeatureStore* store, int32_t index, int32_t* /*out*/ rows, int32_t* /*out*/ cols, uint64_t* /*out*/ fingerprint);
+		// Frames [begin, end) of an utterance, row major, pointing into the
+		// mapped file (no copy) and valid until CloseFeatureStore(). nullptr if
+		// the range is not inside the utterance.
+		LIBRARY_API const float* FeatureStoreGetFrames(KnfFeatureStore* store, int32_t index, int32_t begin, int32_t end);
+		LIBRARY_API void CloseFeatureStore(KnfFeatureStore* store);
+
+		// A cache of the features of whole utterances keyed by the audio and the
+		// options, for ComputeOfflineFeatures(). max_memory_bytes bounds the
+		// in-memory tier (0 = none); directory, if not empty or nullptr, is an
+		// existing directory for the on-disk tier. Thread-safe.
+		LIBRARY_API KnfFeatureCache* CreateFeatureCache(int64_t max_memory_bytes, const char* directory);
+		// Extractors using the cache keep it alive until they are destroyed.
+		LIBRARY_API void DestroyFeatureCache(KnfFeatureCache* cache);
+		LIBRARY_API void GetFeatureCacheStats(KnfFeatureCache* cache, KnfFeatureCacheStats* /*out*/ pStats);
+		LIBRARY_API void ResetFeatureCacheStats(KnfFeatureCache* cache);
+		// Extractor of whole utterances with the options of GetOnlineFbank()
+		// ("fbank", "mfcc" or "whisper"); reuse it for many utterances, from
+		// one thread at a time. Returns nullptr for another feature type.
+		LIBRARY_API KnfOfflineFeature* GetOfflineFeature(FeatureOptions* opts);
+		// Look utterances up in cache (nullptr: no cache) before computing them
+		LIBRARY_API void SetOfflineFeatureCache(KnfOfflineFeature* knfOfflineFeature, KnfFeatureCache* cache);
+		LIBRARY_API int32_t GetOfflineFeatureDim(KnfOfflineFeature* knfOfflineFeature);
+		// Number of frames of num_samples samples
+		LIBRARY_API int32_t GetOfflineNumFrames(KnfOfflineFeature* knfOfflineFeature, int64_t num_samples);
+		// Features of a whole utterance at the sampling rate of the options,
+		// row major. Returns the number of frames, or -1 if out_size is less
+		// than GetOfflineNumFrames() * dim.
+		LIBRARY_API int32_t ComputeOfflineFeatures(KnfOfflineFeature* knfOfflineFeature, const float* samples, int32_t num_samples, float* out, int32_t out_size);
+		LIBRARY_API void DestroyOfflineFeature(KnfOfflineFeature* knfOfflineFeature);
 		std::vector<float> GetFrames(KnfOnlineFeature* knfOnlineFbank, int lastFrameIndex);
 	}
 #ifdef __cplusplus
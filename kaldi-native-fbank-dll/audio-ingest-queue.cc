@@ -0,0 +1,203 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "audio-ingest-queue.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <utility>
+
+#include "feature-window.h"
+
+namespace knf {
+
+// Number of samples DrainTo() passes to its sink at a time
+static constexpr int32_t kDrainChunkSize = 4096;
+
+AudioIngestQueue::AudioIngestQueue(int32_t capacity, OverrunPolicy policy)
+    : mask_(RoundUpToNearestPowerOfTwo(capacity) - 1),
+      policy_(policy),
+      buffer_(new std::atomic<float>[mask_ + 1]),
+      scratch_(kDrainChunkSize) {
+  for (uint64_t i = 0; i <= mask_; ++i) {
+    buffer_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+AudioIngestQueue::~AudioIngestQueue() { StopWorker(); }
+
+int32_t AudioIngestQueue::Push(const float *samples, int32_t n) {
+  if (n <= 0) {
+    return 0;
+  }
+
+  const uint64_t capacity = mask_ + 1;
+  uint64_t w = write_.load(std::memory_order_relaxed);
+  uint64_t r = read_.load(std::memory_order_acquire);
+  uint64_t num_free = capacity - (w - r);
+
+  int32_t accepted = n;
+  int32_t to_write = n;
+
+  if (num_free < static_cast<uint64_t>(n)) {
+    overruns_.fetch_add(1, std::memory_order_relaxed);
+    switch (policy_) {
+      case OverrunPolicy::kDrop:
+        to_write = static_cast<int32_t>(num_free);
+        accepted = to_write;
+        dropped_.fetch_add(n - to_write, std::memory_order_relaxed);
+        break;
+      case OverrunPolicy::kReport:
+        rejected_.fetch_add(n, std::memory_order_relaxed);
+        return 0;
+      case OverrunPolicy::kOverwrite: {
+        if (static_cast<uint64_t>(n) > capacity) {
+          // only the newest `capacity` samples can survive
+          int32_t skipped = n - static_cast<int32_t>(capacity);
+          overwritten_.fetch_add(skipped, std::memory_order_relaxed);
+          samples += skipped;
+          to_write = static_cast<int32_t>(capacity);
+        }
+        // Move the consumer's read index forward. Drain() commits with a
+        // CAS as well, so whoever loses simply retries.
+        uint64_t new_r = w + to_write - capacity;
+        while (r < new_r) {
+          if (read_.compare_exchange_weak(r, new_r,
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_acquire)) {
+            overwritten_.fetch_add(static_cast<int64_t>(new_r - r),
+                                   std::memory_order_relaxed);
+            break;
+          }
+        }
+        break;
+      }
+    }
+  }
+
+  for (int32_t i = 0; i != to_write; ++i) {
+    buffer_[(w + i) & mask_].store(samples[i], std::memory_order_relaxed);
+  }
+  write_.store(w + to_write, std::memory_order_release);
+
+  pushed_.fetch_add(accepted, std::memory_order_relaxed);
+  return accepted;
+}
+
+int32_t AudioIngestQueue::Drain(float *out, int32_t max_n) {
+  uint64_t n = 0;
+  while (true) {
+    uint64_t r = read_.load(std::memory_order_acquire);
+    uint64_t w = write_.load(std::memory_order_acquire);
+    n = std::min<uint64_t>(w - r, static_cast<uint64_t>(std::max(max_n, 0)));
+    if (n == 0) {
+      return 0;
+    }
+
+    for (uint64_t i = 0; i != n; ++i) {
+      out[i] = buffer_[(r + i) & mask_].load(std::memory_order_relaxed);
+    }
+
+    if (policy_ != OverrunPolicy::kOverwrite) {
+      // we are the only one that moves read_
+      read_.store(r + n, std::memory_order_release);
+      break;
+    }
+
+    // The producer may have overwritten what we just copied; if so it has
+    // also moved read_ and we try again from the new position.
+    if (read_.compare_exchange_strong(r, r + n, std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+      break;
+    }
+  }
+
+  drained_.fetch_add(static_cast<int64_t>(n), std::memory_order_relaxed);
+  return static_cast<int32_t>(n);
+}
+
+void AudioIngestQueue::DrainTo(
+    const std::function<void(const float *, int32_t)> &sink) {
+  // Bound the work to what is queued now so that a fast producer cannot
+  // keep the consumer here forever.
+  int32_t remaining = Size();
+  while (remaining > 0) {
+    int32_t n = Drain(scratch_.data(),
+                      std::min<int32_t>(remaining, kDrainChunkSize));
+    if (n == 0) {
+      break;
+    }
+    sink(scratch_.data(), n);
+    remaining -= n;
+  }
+}
+
+void AudioIngestQueue::StartWorker(std::function<void()> drain,
+                                   int32_t interval_ms) {
+  StopWorker();
+
+  stop_worker_ = false;
+  worker_ = std::thread([this, drain = std::move(drain), interval_ms]() {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    while (!stop_worker_) {
+      worker_cond_.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                            [this] { return stop_worker_; });
+      if (stop_worker_) {
+        break;
+      }
+      lock.unlock();
+      drain();
+      lock.lock();
+    }
+  });
+}
+
+void AudioIngestQueue::StopWorker() {
+  if (!worker_.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    stop_worker_ = true;
+  }
+  worker_cond_.notify_all();
+  worker_.join();
+}
+
+int32_t AudioIngestQueue::Size() const {
+  uint64_t r = read_.load(std::memory_order_acquire);
+  uint64_t w = write_.load(std::memory_order_acquire);
+  return static_cast<int32_t>(w - r);
+}
+
+AudioIngestStats AudioIngestQueue::GetStats() const {
+  AudioIngestStats stats;
+  stats.pushed_samples = pushed_.load(std::memory_order_relaxed);
+  stats.drained_samples = drained_.load(std::memory_order_relaxed);
+  stats.dropped_samples = dropped_.load(std::memory_order_relaxed);
+  stats.overwritten_samples = overwritten_.load(std::memory_order_relaxed);
+  stats.rejected_samples = rejected_.load(std::memory_order_relaxed);
+  stats.overruns = overruns_.load(std::memory_order_relaxed);
+  stats.capacity = Capacity();
+  stats.size = Size();
+  return stats;
+}
+
+}  // namespace knf
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_AUDIO_INGEST_QUEUE_H_
+#define KALDI_NATIVE_FBANK_CSRC_AUDIO_INGEST_QUEUE_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace knf {
+
+// What AudioIngestQueue::Push() does when the ring has less free space
+// than the number of samples pushed.
+enum class OverrunPolicy : int32_t {
+  // Store what fits and discard the rest of the pushed samples.
+  kDrop = 0,
+  // Store everything and discard the oldest unread samples.
+  kOverwrite = 1,
+  // Store nothing; Push() returns 0 so that the caller can decide.
+  kReport = 2,
+};
+
+struct AudioIngestStats {
+  int64_t pushed_samples = 0;       // accepted by Push()
+  int64_t drained_samples = 0;      // handed to the feature extractor
+  int64_t dropped_samples = 0;      // kDrop: discarded new samples
+  int64_t overwritten_samples = 0;  // kOverwrite: discarded old samples
+  int64_t rejected_samples = 0;     // kReport: samples Push() refused
+  int64_t overruns = 0;             // number of Push() calls that overran
+  int32_t capacity = 0;
+  int32_t size = 0;                 // samples currently queued
+};
+
+// A single-producer/single-consumer ring of audio samples.
+//
+// Push() is called from the capture thread only. It never takes a lock,
+// never allocates and, except with OverrunPolicy::kOverwrite, finishes in a
+// bounded number of steps (with kOverwrite it is lock-free: it may retry
+// if it races with a concurrent Drain()).
+//
+// Drain() is called from one consumer thread at a time, typically with the
+// lock of the stream that owns the queue held.
+class AudioIngestQueue {
+ public:
+  // @param capacity  Number of samples. It is rounded up to a power of two.
+  AudioIngestQueue(int32_t capacity, OverrunPolicy policy);
+  ~AudioIngestQueue();
+
+  AudioIngestQueue(const AudioIngestQueue &) = delete;
+  AudioIngestQueue &operator=(const AudioIngestQueue &) = delete;
+
+  // Producer side. Returns the number of samples from [samples, samples + n)
+  // that were stored.
+  int32_t Push(const float *samples, int32_t n);
+
+  // Consumer side. Copy up to max_n of the oldest samples to out and remove
+  // them from the ring. Returns the number of samples copied.
+  int32_t Drain(float *out, int32_t max_n);
+
+  // Consumer side. Drain everything currently queued, passing it to sink in
+  // pieces of at most a few thousand samples.
+  void DrainTo(const std::function<void(const float *, int32_t)> &sink);
+
+  // Call drain every interval_ms on a worker thread until StopWorker() or
+  // destruction. The producer never signals the worker, so Push() stays
+  // wait-free.
+  void StartWorker(std::function<void()> drain, int32_t interval_ms);
+  void StopWorker();
+
+  int32_t Capacity() const { return static_cast<int32_t>(mask_ + 1); }
+  int32_t Size() const;
+
+  AudioIngestStats GetStats() const;
+
+ private:
+  uint64_t mask_;
+  OverrunPolicy policy_;
+  // Relaxed atomics so that Drain() may race with an overwriting Push()
+  // without a data race; on common hardware they compile to plain loads
+  // and stores.
+  std::unique_ptr<std::atomic<float>[]> buffer_;
+
+  // Samples in [read_, write_) are queued. Both only ever increase.
+  alignas(64) std::atomic<uint64_t> write_{0};
+  alignas(64) std::atomic<uint64_t> read_{0};
+
+  alignas(64) std::atomic<int64_t> pushed_{0};
+  std::atomic<int64_t> drained_{0};
+  std::atomic<int64_t> dropped_{0};
+  std::atomic<int64_t> overwritten_{0};
+  std::atomic<int64_t> rejected_{0};
+  std::atomic<int64_t> overruns_{0};
+
+  std::vector<float> scratch_;  // used by DrainTo()
+
+  std::mutex worker_mutex_;
+  std::condition_variable worker_cond_;
+  bool stop_worker_ = false;
+  std::thread worker_;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_AUDIO_INGEST_QUEUE_H_
@@ -0,0 +1,408 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is copied/modified from kaldi/src/matrix/compressed-matrix.cc
+
+#include "pch.h"
+#include "compressed-matrix.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace knf {
+
+namespace {
+
+// Kaldi's DataFormat
+enum DataFormat : int32_t {
+  kOneByteWithColHeaders = 1,
+  kTwoByte = 2,
+  kOneByte = 3,
+};
+
+// Kaldi's GlobalHeader without the format, which is written as the token
+struct GlobalHeader {
+  float min_value;
+  float range;
+  int32_t num_rows;
+  int32_t num_cols;
+};
+
+struct PerColHeader {
+  uint16_t percentile_0;
+  uint16_t percentile_25;
+  uint16_t percentile_75;
+  uint16_t percentile_100;
+};
+
+static_assert(sizeof(GlobalHeader) == 16, "GlobalHeader must be packed");
+static_assert(sizeof(PerColHeader) == 8, "PerColHeader must be packed");
+
+const char *Token(DataFormat format) {
+  switch (format) {
+    case kOneByteWithColHeaders:
+      return "CM ";
+    case kTwoByte:
+      return "CM2 ";
+    case kOneByte:
+      return "CM3 ";
+  }
+  return "";
+}
+
+bool GetFormat(CompressionMethod method, int32_t rows, DataFormat *format) {
+  switch (method) {
+    case CompressionMethod::kAutomatic:
+      *format = rows > 8 ? kOneByteWithColHeaders : kTwoByte;
+      return true;
+    case CompressionMethod::kSpeechFeature:
+      *format = kOneByteWithColHeaders;
+      return true;
+    case CompressionMethod::kTwoByteAuto:
+      *format = kTwoByte;
+      return true;
+    case CompressionMethod::kOneByteAuto:
+      *format = kOneByte;
+      return true;
+  }
+  return false;
+}
+
+size_t PayloadSize(DataFormat format, int32_t rows, int32_t cols) {
+  size_t n = static_cast<size_t>(rows) * cols;
+  switch (format) {
+    case kOneByteWithColHeaders:
+      return cols * sizeof(PerColHeader) + n;
+    case kTwoByte:
+      return 2 * n;
+    case kOneByte:
+      return n;
+  }
+  return 0;
+}
+
+// The conversions below keep Kaldi's expressions, including their mix of
+// float and double arithmetic, so that the bytes and values are identical.
+
+inline uint16_t FloatToUint16(const GlobalHeader &h, float value) {
+  float f = (value - h.min_value) / h.range;
+  if (f > 1.0) f = 1.0;  // Note: this should not happen.
+  if (f < 0.0) f = 0.0;  // Note: this should not happen.
+  return static_cast<int>(f * 65535 + 0.499);  // + 0.499 is to
+  // round to closest int; avoids bias.
+}
+
+inline uint8_t FloatToUint8(const GlobalHeader &h, float value) {
+  float f = (value - h.min_value) / h.range;
+  if (f > 1.0) f = 1.0;  // Note: this should not happen.
+  if (f < 0.0) f = 0.0;  // Note: this should not happen.
+  return static_cast<int>(f * 255 + 0.499);  // + 0.499 is to
+  // round to closest int; avoids bias.
+}
+
+inline float Uint16ToFloat(const GlobalHeader &h, uint16_t value) {
+  // the constant 1.52590218966964e-05 is 1/65535.
+  return h.min_value + h.range * 1.52590218966964e-05F * value;
+}
+
+inline uint8_t FloatToChar(float p0, float p25, float p75, float p100,
+                           float value) {
+  int ans;
+  if (value < p25) {  // range [ p0, p25 ) covered by
+    // characters 0 .. 64.  We round to the closest int.
+    float f = (value - p0) / (p25 - p0);
+    ans = static_cast<int>(f * 64 + 0.5);
+    // Note: the checks on the next two lines
+    // are necessary in pathological cases when all the elements in a row
+    // are the same and the percentile_* values are separated by one.
+    if (ans < 0) ans = 0;
+    if (ans > 64) ans = 64;
+  } else if (value < p75) {  // range [ p25, p75 )covered
+    // by characters 64 .. 192.  We round to the closest int.
+    float f = (value - p25) / (p75 - p25);
+    ans = 64 + static_cast<int>(f * 128 + 0.5);
+    if (ans < 64) ans = 64;
+    if (ans > 192) ans = 192;
+  } else {  // range [ p75, p100 ] covered by
+    // characters 192 .. 255.  Note: this last range
+    // has fewer characters than the left range, because
+    // we go up to 255, not 256.
+    float f = (value - p75) / (p100 - p75);
+    ans = 192 + static_cast<int>(f * 63 + 0.5);
+    if (ans < 192) ans = 192;
+    if (ans > 255) ans = 255;
+  }
+  return static_cast<uint8_t>(ans);
+}
+
+inline float CharToFloat(float p0, float p25, float p75, float p100,
+                         uint8_t value) {
+  if (value <= 64) {
+    return p0 + (p25 - p0) * value * (1 / 64.0);
+  } else if (value <= 192) {
+    return p25 + (p75 - p25) * (value - 64) * (1 / 128.0);
+  } else {
+    return p75 + (p100 - p75) * (value - 192) * (1 / 63.0);
+  }
+}
+
+void ComputeColHeader(const GlobalHeader &h, const float *data, int32_t stride,
+                      std::vector<float> *scratch, PerColHeader *header) {
+  int32_t num_rows = h.num_rows;
+  std::vector<float> &v = *scratch;
+  v.resize(num_rows);
+  for (int32_t i = 0; i < num_rows; i++) {
+    v[i] = data[static_cast<size_t>(i) * stride];
+  }
+
+  if (num_rows >= 5) {
+    int32_t quarter_nr = num_rows / 4;
+    // The elements at positions 0, quarter_nr, 3*quarter_nr, and
+    // num_rows-1 need to be in sorted order; the same as std::sort() for
+    // them, but faster.
+    auto start = v.begin();
+    auto end = v.end();
+    std::nth_element(start, start + quarter_nr, end);
+    std::nth_element(start, start, start + quarter_nr);
+    std::nth_element(start + quarter_nr + 1, start + 3 * quarter_nr, end);
+    std::nth_element(start + 3 * quarter_nr + 1, end - 1, end);
+
+    header->percentile_0 = std::min<uint16_t>(FloatToUint16(h, v[0]), 65532);
+    header->percentile_25 = std::min<uint16_t>(
+        std::max<uint16_t>(FloatToUint16(h, v[quarter_nr]),
+                           header->percentile_0 + static_cast<uint16_t>(1)),
+        65533);
+    header->percentile_75 = std::min<uint16_t>(
+        std::max<uint16_t>(FloatToUint16(h, v[3 * quarter_nr]),
+                           header->percentile_25 + static_cast<uint16_t>(1)),
+        65534);
+    header->percentile_100 = std::max<uint16_t>(
+        FloatToUint16(h, v[num_rows - 1]),
+        header->percentile_75 + static_cast<uint16_t>(1));
+  } else {  // handle this pathological case.
+    std::sort(v.begin(), v.end());
+    // Note: we know num_rows is at least 1.
+    header->percentile_0 = std::min<uint16_t>(FloatToUint16(h, v[0]), 65532);
+    if (num_rows > 1) {
+      header->percentile_25 = std::min<uint16_t>(
+          std::max<uint16_t>(FloatToUint16(h, v[1]), header->percentile_0 + 1),
+          65533);
+    } else {
+      header->percentile_25 = header->percentile_0 + 1;
+    }
+    if (num_rows > 2) {
+      header->percentile_75 = std::min<uint16_t>(
+          std::max<uint16_t>(FloatToUint16(h, v[2]),
+                             header->percentile_25 + 1),
+          65534);
+    } else {
+      header->percentile_75 = header->percentile_25 + 1;
+    }
+    if (num_rows > 3) {
+      header->percentile_100 = std::max<uint16_t>(
+          FloatToUint16(h, v[num_rows - 1]), header->percentile_75 + 1);
+    } else {
+      header->percentile_100 = header->percentile_75 + 1;
+    }
+  }
+}
+
+bool ParseHeader(const uint8_t *data, size_t size, DataFormat *format,
+                 GlobalHeader *h, size_t *header_size) {
+  size_t pos = 0;
+  if (size >= 2 && data[0] == '\0' && data[1] == 'B') {
+    pos = 2;
+  }
+  if (size - pos >= 3 && std::memcmp(data + pos, "CM ", 3) == 0) {
+    *format = kOneByteWithColHeaders;
+    pos += 3;
+  } else if (size - pos >= 4 && std::memcmp(data + pos, "CM2 ", 4) == 0) {
+    *format = kTwoByte;
+    pos += 4;
+  } else if (size - pos >= 4 && std::memcmp(data + pos, "CM3 ", 4) == 0) {
+    *format = kOneByte;
+    pos += 4;
+  } else {
+    return false;
+  }
+  if (size - pos < sizeof(GlobalHeader)) {
+    return false;
+  }
+  std::memcpy(h, data + pos, sizeof(GlobalHeader));
+  pos += sizeof(GlobalHeader);
+  if (h->num_rows <= 0 || h->num_cols <= 0 ||
+      size - pos < PayloadSize(*format, h->num_rows, h->num_cols)) {
+    return false;
+  }
+  *header_size = pos;
+  return true;
+}
+
+}  // namespace
+
+size_t CompressedMatrixSize(int32_t rows, int32_t cols,
+                            CompressionMethod method) {
+  DataFormat format;
+  if (rows <= 0 || cols <= 0 || !GetFormat(method, rows, &format)) {
+    return 0;
+  }
+  return std::strlen(Token(format)) + sizeof(GlobalHeader) +
+         PayloadSize(format, rows, cols);
+}
+
+bool CompressMatrix(const float *data, int32_t rows, int32_t cols,
+                    CompressionMethod method, std::vector<uint8_t> *out) {
+  DataFormat format;
+  if (rows <= 0 || cols <= 0 || !GetFormat(method, rows, &format)) {
+    return false;
+  }
+
+  size_t n = static_cast<size_t>(rows) * cols;
+  float min_value = data[0];
+  float max_value = data[0];
+  for (size_t i = 0; i != n; ++i) {
+    if (!std::isfinite(data[i])) {
+      return false;  // Kaldi cannot compress it either
+    }
+    min_value = std::min(min_value, data[i]);
+    max_value = std::max(max_value, data[i]);
+  }
+  // ensure that max_value is strictly greater than min_value, even if matrix
+  // is constant; this avoids crashes in ComputeColHeader when compressing
+  // speech features.
+  if (max_value == min_value) {
+    max_value = min_value + (1.0 + std::fabs(min_value));
+  }
+
+  GlobalHeader h;
+  h.min_value = min_value;
+  h.range = max_value - min_value;
+  h.num_rows = rows;
+  h.num_cols = cols;
+
+  const char *token = Token(format);
+  size_t token_size = std::strlen(token);
+  size_t offset = out->size();
+  out->resize(offset + token_size + sizeof(h) + PayloadSize(format, rows, cols));
+  uint8_t *p = out->data() + offset;
+  std::memcpy(p, token, token_size);
+  p += token_size;
+  std::memcpy(p, &h, sizeof(h));
+  p += sizeof(h);
+
+  if (format == kOneByteWithColHeaders) {
+    uint8_t *byte_data = p + cols * sizeof(PerColHeader);
+    std::vector<float> scratch;
+    for (int32_t c = 0; c < cols; ++c) {
+      PerColHeader header;
+      ComputeColHeader(h, data + c, cols, &scratch, &header);
+      std::memcpy(p + c * sizeof(PerColHeader), &header, sizeof(header));
+
+      float p0 = Uint16ToFloat(h, header.percentile_0);
+      float p25 = Uint16ToFloat(h, header.percentile_25);
+      float p75 = Uint16ToFloat(h, header.percentile_75);
+      float p100 = Uint16ToFloat(h, header.percentile_100);
+      // stored column by column
+      for (int32_t r = 0; r < rows; ++r) {
+        byte_data[r] = FloatToChar(p0, p25, p75, p100,
+                                   data[static_cast<size_t>(r) * cols + c]);
+      }
+      byte_data += rows;
+    }
+  } else if (format == kTwoByte) {
+    for (size_t i = 0; i != n; ++i) {
+      uint16_t v = FloatToUint16(h, data[i]);
+      std::memcpy(p + 2 * i, &v, sizeof(v));
+    }
+  } else {
+    for (size_t i = 0; i != n; ++i) {
+      p[i] = FloatToUint8(h, data[i]);
+    }
+  }
+  return true;
+}
+
+bool GetCompressedMatrixInfo(const uint8_t *data, size_t size, int32_t *rows,
+                             int32_t *cols, size_t *num_bytes) {
+  DataFormat format;
+  GlobalHeader h;
+  size_t header_size;
+  if (!ParseHeader(data, size, &format, &h, &header_size)) {
+    return false;
+  }
+  *rows = h.num_rows;
+  *cols = h.num_cols;
+  *num_bytes = header_size + PayloadSize(format, h.num_rows, h.num_cols);
+  return true;
+}
+
+bool DecompressMatrix(const uint8_t *data, size_t size, float *out) {
+  DataFormat format;
+  GlobalHeader h;
+  size_t header_size;
+  if (!ParseHeader(data, size, &format, &h, &header_size)) {
+    return false;
+  }
+  const uint8_t *p = data + header_size;
+  int32_t rows = h.num_rows;
+  int32_t cols = h.num_cols;
+
+  if (format == kOneByteWithColHeaders) {
+    const uint8_t *byte_data = p + cols * sizeof(PerColHeader);
+    // CharToFloat() of every byte value, so that decoding is a lookup
+    // instead of a branch and a multiply-add per element
+    float table[256];
+    for (int32_t c = 0; c < cols; ++c) {
+      PerColHeader header;
+      std::memcpy(&header, p + c * sizeof(PerColHeader), sizeof(header));
+      float p0 = Uint16ToFloat(h, header.percentile_0);
+      float p25 = Uint16ToFloat(h, header.percentile_25);
+      float p75 = Uint16ToFloat(h, header.percentile_75);
+      float p100 = Uint16ToFloat(h, header.percentile_100);
+      for (int32_t v = 0; v != 256; ++v) {
+        table[v] = CharToFloat(p0, p25, p75, p100, static_cast<uint8_t>(v));
+      }
+      float *dst = out + c;
+      for (int32_t r = 0; r < rows; ++r) {
+        dst[static_cast<size_t>(r) * cols] = table[byte_data[r]];
+      }
+      byte_data += rows;
+    }
+  } else if (format == kTwoByte) {
+    float min_value = h.min_value;
+    float increment = h.range * (1.0 / 65535.0);
+    size_t n = static_cast<size_t>(rows) * cols;
+    for (size_t i = 0; i != n; ++i) {
+      uint16_t v;
+      std::memcpy(&v, p + 2 * i, sizeof(v));
+      out[i] = min_value + v * increment;
+    }
+  } else {
+    float min_value = h.min_value;
+    float increment = h.range * (1.0 / 255.0);
+    size_t n = static_cast<size_t>(rows) * cols;
+    for (size_t i = 0; i != n; ++i) {
+      out[i] = min_value + p[i] * increment;
+    }
+  }
+  return true;
+}
+
+}  // namespace knf
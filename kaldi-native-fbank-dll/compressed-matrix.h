@@ -0,0 +1,74 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is copied/modified from kaldi/src/matrix/compressed-matrix.h
+//
+// Encoder and decoder for Kaldi's CompressedMatrix formats, as they appear
+// in binary archives, e.g. written by "copy-feats --compress=true". The
+// output is byte-for-byte what Kaldi writes for the same float matrix.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_COMPRESSED_MATRIX_H_
+#define KALDI_NATIVE_FBANK_CSRC_COMPRESSED_MATRIX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace knf {
+
+// The values are those of Kaldi's CompressionMethod, which is what
+// "copy-feats --compression-method" takes. The integer-only methods are
+// not supported.
+enum class CompressionMethod : int32_t {
+  // kSpeechFeature if there are more than 8 rows, else kTwoByteAuto
+  kAutomatic = 1,
+  // "CM": a byte per element, quantized between the 0th, 25th, 75th and
+  // 100th percentiles of its column. About 4x smaller than floats.
+  kSpeechFeature = 2,
+  // "CM2": 16 bits per element, linear between the min and max of the
+  // matrix
+  kTwoByteAuto = 3,
+  // "CM3": 8 bits per element, linear between the min and max of the matrix
+  kOneByteAuto = 5,
+};
+
+// Encode the rows x cols row-major matrix data and append it to out as
+// CompressedMatrix::Write(os, true) does, i.e. the "CM ", "CM2 " or "CM3 "
+// token followed by the headers and data. Prefix it with "\0B" for an
+// archive entry. Returns false if the matrix is empty, the method is not
+// supported, or data contains NaN or infinity.
+bool CompressMatrix(const float *data, int32_t rows, int32_t cols,
+                    CompressionMethod method, std::vector<uint8_t> *out);
+
+// Size in bytes of what CompressMatrix() appends
+size_t CompressedMatrixSize(int32_t rows, int32_t cols,
+                            CompressionMethod method);
+
+// Parse the headers of a matrix encoded as above (a leading "\0B" is
+// skipped): its size, and the number of bytes of data it takes. Returns
+// false if data does not start with a valid compressed matrix.
+bool GetCompressedMatrixInfo(const uint8_t *data, size_t size, int32_t *rows,
+                             int32_t *cols, size_t *num_bytes);
+
+// Decode it into rows x cols row-major floats, the same values as Kaldi's
+// CompressedMatrix::CopyToMat(). Returns false as above.
+bool DecompressMatrix(const uint8_t *data, size_t size, float *out);
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_COMPRESSED_MATRIX_H_
@@ -0,0 +1,124 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "energy-vad.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace knf {
+
+EnergyVad::EnergyVad(const EnergyVadOptions &opts, VadEventCallback callback)
+    : opts_(opts), callback_(std::move(callback)) {}
+
+void EnergyVad::Emit(VadEvent::Type type) {
+  if (callback_) {
+    VadEvent event;
+    event.type = type;
+    event.frame = NumFrames();
+    event.speech_frame = num_speech_frames_;
+    callback_(event);
+  }
+}
+
+bool EnergyVad::AcceptFrame(float log_energy, float zero_crossing_rate) {
+  bool active = log_energy >= opts_.energy_threshold ||
+                (log_energy >=
+                     opts_.energy_threshold - opts_.unvoiced_energy_margin &&
+                 zero_crossing_rate >= opts_.zcr_threshold);
+
+  bool speech = false;
+  if (active) {
+    speech = true;
+    hangover_left_ = opts_.hangover_frames;
+  } else if (in_speech_ && hangover_left_ > 0) {
+    speech = true;
+    --hangover_left_;
+  }
+
+  if (speech != in_speech_) {
+    // NumFrames() does not include this frame yet
+    Emit(speech ? VadEvent::kSpeechStart : VadEvent::kSpeechEnd);
+    in_speech_ = speech;
+  }
+
+  flags_.push_back(speech ? 1 : 0);
+  ++num_frames_;
+  num_speech_frames_ += speech ? 1 : 0;
+  if (max_flags_ != -1 && num_frames_ - first_flag_ > max_flags_) {
+    PopFlag();
+    CompactFlags();
+  }
+  return speech;
+}
+
+void EnergyVad::PopFlag() {
+  num_released_speech_ += flags_[flags_begin_];
+  ++flags_begin_;
+  ++first_flag_;
+}
+
+void EnergyVad::CompactFlags() {
+  // amortized O(1) per flag: each one is moved at most once per halving
+  if (flags_begin_ * 2 >= flags_.size()) {
+    flags_.erase(flags_.begin(), flags_.begin() + flags_begin_);
+    flags_begin_ = 0;
+  }
+}
+
+void EnergyVad::ReleaseSpeechFrames(int32_t speech_end) {
+  while (num_released_speech_ < speech_end && first_flag_ < num_frames_) {
+    PopFlag();
+  }
+  CompactFlags();
+}
+
+void EnergyVad::SetMaxFlags(int32_t max_flags) {
+  max_flags_ = max_flags <= 0 ? -1 : max_flags;
+  if (max_flags_ != -1) {
+    while (num_frames_ - first_flag_ > max_flags_) {
+      PopFlag();
+    }
+    CompactFlags();
+  }
+}
+
+void EnergyVad::InputFinished() {
+  if (finished_) {
+    return;
+  }
+  finished_ = true;
+  if (in_speech_) {
+    Emit(VadEvent::kSpeechEnd);
+    in_speech_ = false;
+  }
+}
+
+int32_t EnergyVad::GetFlags(int32_t begin, int32_t end, uint8_t *flags) const {
+  begin = std::max(begin, first_flag_);
+  end = std::min(end, NumFrames());
+  if (begin >= end) {
+    return 0;
+  }
+  auto first = flags_.begin() + flags_begin_ + (begin - first_flag_);
+  std::copy(first, first + (end - begin), flags);
+  return end - begin;
+}
+
+}  // namespace knf
@@ -0,0 +1,141 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A cheap energy / zero-crossing voice activity detector that runs on the
+// frames extracted by OnlineGenericBaseFeature, before the FFT, so that
+// silence frames cost only the window extraction.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_ENERGY_VAD_H_
+#define KALDI_NATIVE_FBANK_CSRC_ENERGY_VAD_H_
+
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace knf {
+
+struct EnergyVadOptions {
+  // A frame is speech if its log energy (natural log of the sum of squared
+  // samples after DC removal, see ProcessWindow()) is at least this.
+  // The default is about -34 dBFS for a 25 ms frame of 16-bit samples;
+  // subtract 2 * log(32768) (about 20.8) for samples in [-1, 1).
+  float energy_threshold = 13.0f;
+
+  // A quieter frame, down to energy_threshold - unvoiced_energy_margin, is
+  // also speech if its zero-crossing rate is at least zcr_threshold; this
+  // keeps unvoiced consonants such as "s" and "f". Set zcr_threshold > 1
+  // to disable it.
+  float unvoiced_energy_margin = 2.0f;
+  float zcr_threshold = 0.3f;
+
+  // Number of frames that are still speech after the last frame that
+  // passed the thresholds, to bridge short pauses and word endings.
+  int32_t hangover_frames = 20;
+
+  std::string ToString() const {
+    std::ostringstream os;
+    os << "energy_threshold: " << energy_threshold << "\n";
+    os << "unvoiced_energy_margin: " << unvoiced_energy_margin << "\n";
+    os << "zcr_threshold: " << zcr_threshold << "\n";
+    os << "hangover_frames: " << hangover_frames << "\n";
+    return os.str();
+  }
+};
+
+struct VadEvent {
+  enum Type : int32_t {
+    kSpeechStart = 0,
+    kSpeechEnd = 1,
+  };
+
+  Type type;
+  // Index of the first speech frame (kSpeechStart), or one past the last
+  // one (kSpeechEnd), counting every extracted frame.
+  int32_t frame;
+  // The same position counting only speech frames, i.e. as an index into
+  // the frames that are computed and stored.
+  int32_t speech_frame;
+};
+
+using VadEventCallback = std::function<void(const VadEvent &event)>;
+
+class EnergyVad {
+ public:
+  explicit EnergyVad(const EnergyVadOptions &opts,
+                     VadEventCallback callback = nullptr);
+
+  // Classify the next frame; returns true if it is speech. Frames must be
+  // given in order, starting at 0.
+  bool AcceptFrame(float log_energy, float zero_crossing_rate);
+
+  // No more frames follow; ends an open segment.
+  void InputFinished();
+
+  bool InSpeech() const { return in_speech_; }
+
+  int32_t NumFrames() const { return num_frames_; }
+  int32_t NumSpeechFrames() const { return num_speech_frames_; }
+
+  // Index of the oldest frame whose flag is kept; the flags of the frames
+  // before it were released.
+  int32_t FirstFlag() const { return first_flag_; }
+
+  // Copy the speech flags (1 speech, 0 silence) of frames [begin, end),
+  // clipped to [FirstFlag(), NumFrames()), to flags; returns the number
+  // copied, starting at max(begin, FirstFlag()).
+  int32_t GetFlags(int32_t begin, int32_t end, uint8_t *flags) const;
+
+  // Release the flags of the frames up to and including speech frame
+  // speech_end - 1 (an index counting speech frames only), e.g. once the
+  // computed frames below speech_end were released.
+  void ReleaseSpeechFrames(int32_t speech_end);
+
+  // Keep the flags of at most max_flags frames; older ones are released as
+  // new frames are classified. -1 means no limit.
+  void SetMaxFlags(int32_t max_flags);
+
+ private:
+  void Emit(VadEvent::Type type);
+  void PopFlag();
+  // Free the space of the released flags once it is most of flags_
+  void CompactFlags();
+
+  EnergyVadOptions opts_;
+  VadEventCallback callback_;
+
+  // flags_[flags_begin_] is the flag of frame first_flag_; the ones before
+  // it were released
+  std::vector<uint8_t> flags_;
+  size_t flags_begin_ = 0;
+  int32_t first_flag_ = 0;
+  int32_t max_flags_ = -1;
+  // speech frames among the released flags
+  int32_t num_released_speech_ = 0;
+
+  int32_t num_frames_ = 0;
+  int32_t num_speech_frames_ = 0;
+  bool in_speech_ = false;
+  int32_t hangover_left_ = 0;
+  bool finished_ = false;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_ENERGY_VAD_H_
@@ -0,0 +1,228 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "feature-cache.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#include "hash.h"
+
+namespace knf {
+
+namespace {
+
+// File of the disk tier: the magic, num_samples (int64), rows and cols
+// (int32), then the features
+constexpr char kDiskMagic[8] = {'K', 'N', 'F', 'C', 'A', 'C', 'H', '1'};
+
+}  // namespace
+
+FeatureCacheKey MakeFeatureCacheKey(const float *samples, int64_t num_samples,
+                                    uint64_t options_fingerprint) {
+  FeatureCacheKey key;
+  key.audio = Hash64(samples, static_cast<size_t>(num_samples) * sizeof(float));
+  key.options = options_fingerprint;
+  key.num_samples = num_samples;
+  return key;
+}
+
+FeatureCache::FeatureCache(const FeatureCacheOptions &opts) : opts_(opts) {
+  if (!opts_.directory.empty() && opts_.directory.back() != '/' &&
+      opts_.directory.back() != '\\') {
+    opts_.directory += '/';
+  }
+}
+
+bool FeatureCache::Lookup(const FeatureCacheKey &key,
+                          std::vector<float> *feats, int32_t *rows,
+                          int32_t *cols) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      const Entry &entry = *it->second;
+      feats->assign(entry.feats.begin(), entry.feats.end());
+      *rows = entry.rows;
+      *cols = entry.cols;
+      ++stats_.memory_hits;
+      return true;
+    }
+  }
+
+  Entry entry;
+  if (!ReadFromDisk(key, &entry)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.misses;
+    return false;
+  }
+  feats->assign(entry.feats.begin(), entry.feats.end());
+  *rows = entry.rows;
+  *cols = entry.cols;
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.disk_hits;
+  if (index_.count(key) == 0) {
+    InsertInMemory(std::move(entry));
+  }
+  return true;
+}
+
+void FeatureCache::Insert(const FeatureCacheKey &key, const float *feats,
+                          int32_t rows, int32_t cols) {
+  Entry entry;
+  entry.key = key;
+  entry.rows = rows;
+  entry.cols = cols;
+  entry.feats.assign(feats, feats + static_cast<size_t>(rows) * cols);
+  if (!opts_.directory.empty()) {
+    WriteToDisk(entry);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.insertions;
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    // computed twice at the same time; the features are the same
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return;
+  }
+  InsertInMemory(std::move(entry));
+}
+
+void FeatureCache::InsertInMemory(Entry entry) {
+  int64_t bytes = static_cast<int64_t>(entry.feats.size() * sizeof(float));
+  if (bytes > opts_.max_memory_bytes) {
+    return;
+  }
+  while (stats_.memory_bytes + bytes > opts_.max_memory_bytes) {
+    const Entry &last = lru_.back();
+    stats_.memory_bytes -=
+        static_cast<int64_t>(last.feats.size() * sizeof(float));
+    --stats_.memory_entries;
+    ++stats_.evictions;
+    index_.erase(last.key);
+    lru_.pop_back();
+  }
+  FeatureCacheKey key = entry.key;
+  lru_.push_front(std::move(entry));
+  index_[key] = lru_.begin();
+  stats_.memory_bytes += bytes;
+  ++stats_.memory_entries;
+}
+
+FeatureCacheStats FeatureCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void FeatureCache::ResetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t memory_entries = stats_.memory_entries;
+  int64_t memory_bytes = stats_.memory_bytes;
+  stats_ = FeatureCacheStats();
+  stats_.memory_entries = memory_entries;
+  stats_.memory_bytes = memory_bytes;
+}
+
+void FeatureCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  lru_.clear();
+  index_.clear();
+  stats_.memory_entries = 0;
+  stats_.memory_bytes = 0;
+}
+
+std::string FeatureCache::DiskPath(const FeatureCacheKey &key) const {
+  char name[64];
+  snprintf(name, sizeof(name), "%016" PRIx64 "-%016" PRIx64 ".knfc",
+           key.audio, key.options);
+  return opts_.directory + name;
+}
+
+bool FeatureCache::ReadFromDisk(const FeatureCacheKey &key,
+                                Entry *entry) const {
+  if (opts_.directory.empty()) {
+    return false;
+  }
+  std::ifstream is(DiskPath(key), std::ios::binary);
+  if (!is) {
+    return false;
+  }
+  char magic[sizeof(kDiskMagic)];
+  int64_t num_samples = 0;
+  int32_t rows = 0;
+  int32_t cols = 0;
+  is.read(magic, sizeof(magic));
+  is.read(reinterpret_cast<char *>(&num_samples), sizeof(num_samples));
+  is.read(reinterpret_cast<char *>(&rows), sizeof(rows));
+  is.read(reinterpret_cast<char *>(&cols), sizeof(cols));
+  if (!is || std::memcmp(magic, kDiskMagic, sizeof(magic)) != 0 ||
+      num_samples != key.num_samples || rows <= 0 || cols <= 0) {
+    return false;
+  }
+  entry->key = key;
+  entry->rows = rows;
+  entry->cols = cols;
+  entry->feats.resize(static_cast<size_t>(rows) * cols);
+  is.read(reinterpret_cast<char *>(entry->feats.data()),
+          static_cast<std::streamsize>(entry->feats.size() * sizeof(float)));
+  return static_cast<bool>(is);
+}
+
+void FeatureCache::WriteToDisk(const Entry &entry) const {
+  // Write to a file of our own and rename it, so that readers, including
+  // other processes, never see a partial file
+  static std::atomic<uint64_t> counter{0};
+  uint64_t id[3] = {
+      counter.fetch_add(1),
+      static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&counter)),
+      static_cast<uint64_t>(
+          std::chrono::steady_clock::now().time_since_epoch().count())};
+  std::string path = DiskPath(entry.key);
+  char suffix[64];
+  snprintf(suffix, sizeof(suffix), ".%016" PRIx64 ".tmp",
+           Hash64(id, sizeof(id)));
+  std::string tmp = path + suffix;
+  {
+    std::ofstream os(tmp, std::ios::binary);
+    os.write(kDiskMagic, sizeof(kDiskMagic));
+    os.write(reinterpret_cast<const char *>(&entry.key.num_samples),
+             sizeof(entry.key.num_samples));
+    os.write(reinterpret_cast<const char *>(&entry.rows), sizeof(entry.rows));
+    os.write(reinterpret_cast<const char *>(&entry.cols), sizeof(entry.cols));
+    os.write(reinterpret_cast<const char *>(entry.feats.data()),
+             static_cast<std::streamsize>(entry.feats.size() * sizeof(float)));
+    os.close();
+    if (!os) {
+      std::remove(tmp.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    // e.g. another process wrote it first (Windows does not replace)
+    std::remove(tmp.c_str());
+  }
+}
+
+}  // namespace knf
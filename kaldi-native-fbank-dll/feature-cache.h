@@ -0,0 +1,134 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A content-addressed cache of the features of whole utterances, so that
+// audio seen before (prompts, hold music, retried requests) is not
+// processed again. Entries are keyed by a hash of the samples and the
+// fingerprint of the feature options, see hash.h.
+//
+// There is an in-memory tier with least-recently-used eviction and an
+// optional on-disk tier, one file per utterance in a directory, which
+// survives restarts and can be shared by processes. New entries go to both
+// tiers; a disk hit is copied to memory.
+//
+// All methods may be called from several threads at once.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_CACHE_H_
+#define KALDI_NATIVE_FBANK_CSRC_FEATURE_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace knf {
+
+struct FeatureCacheOptions {
+  // Bound on the feature data kept in memory; 0 disables the memory tier
+  int64_t max_memory_bytes = 256 << 20;
+  // Directory of the disk tier, which must exist; empty disables it
+  std::string directory;
+};
+
+struct FeatureCacheKey {
+  uint64_t audio = 0;    // Hash64() of the samples
+  uint64_t options = 0;  // OptionsFingerprint() of the feature options
+  int64_t num_samples = 0;
+
+  bool operator==(const FeatureCacheKey &other) const {
+    return audio == other.audio && options == other.options &&
+           num_samples == other.num_samples;
+  }
+};
+
+FeatureCacheKey MakeFeatureCacheKey(const float *samples, int64_t num_samples,
+                                    uint64_t options_fingerprint);
+
+struct FeatureCacheStats {
+  int64_t memory_hits = 0;
+  int64_t disk_hits = 0;
+  int64_t misses = 0;
+  int64_t insertions = 0;
+  int64_t evictions = 0;  // from memory
+  int64_t memory_entries = 0;
+  int64_t memory_bytes = 0;
+};
+
+class FeatureCache {
+ public:
+  explicit FeatureCache(const FeatureCacheOptions &opts = {});
+
+  FeatureCache(const FeatureCache &) = delete;
+  FeatureCache &operator=(const FeatureCache &) = delete;
+
+  // If the features of key are cached, copy them to feats (resized to
+  // rows * cols, row major) and return true
+  bool Lookup(const FeatureCacheKey &key, std::vector<float> *feats,
+              int32_t *rows, int32_t *cols);
+
+  // Add the rows x cols row-major features of key
+  void Insert(const FeatureCacheKey &key, const float *feats, int32_t rows,
+              int32_t cols);
+
+  FeatureCacheStats GetStats() const;
+
+  // Zero the counters; the entries are kept
+  void ResetStats();
+
+  // Drop the memory tier; the disk tier is kept
+  void Clear();
+
+  const FeatureCacheOptions &GetOptions() const { return opts_; }
+
+ private:
+  struct KeyHash {
+    size_t operator()(const FeatureCacheKey &key) const {
+      return static_cast<size_t>(key.audio ^ (key.options * 31) ^
+                                 static_cast<uint64_t>(key.num_samples));
+    }
+  };
+
+  struct Entry {
+    FeatureCacheKey key;
+    int32_t rows = 0;
+    int32_t cols = 0;
+    std::vector<float> feats;
+  };
+
+  // Requires mutex_
+  void InsertInMemory(Entry entry);
+
+  std::string DiskPath(const FeatureCacheKey &key) const;
+  bool ReadFromDisk(const FeatureCacheKey &key, Entry *entry) const;
+  void WriteToDisk(const Entry &entry) const;
+
+  FeatureCacheOptions opts_;
+
+  mutable std::mutex mutex_;
+  // most recently used first
+  std::list<Entry> lru_;
+  std::unordered_map<FeatureCacheKey, std::list<Entry>::iterator, KeyHash>
+      index_;
+  FeatureCacheStats stats_;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FEATURE_CACHE_H_
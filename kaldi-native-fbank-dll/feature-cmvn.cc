@@ -0,0 +1,159 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "feature-cmvn.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "log.h"
+
+namespace knf {
+
+namespace {
+
+// Add scale * src to dst; both are 2 x (dim + 1) statistics
+void AddStats(const std::vector<double> &src, double scale,
+              std::vector<double> *dst) {
+  for (size_t i = 0; i != dst->size(); ++i) {
+    (*dst)[i] += scale * src[i];
+  }
+}
+
+}  // namespace
+
+OnlineCmvnStage::OnlineCmvnStage(int32_t dim, const OnlineCmvnOptions &opts,
+                                 const OnlineCmvnState &state)
+    : dim_(dim),
+      opts_(opts),
+      state_(state),
+      window_stats_(2 * (dim + 1), 0),
+      utterance_stats_(2 * (dim + 1), 0),
+      stats_(2 * (dim + 1), 0) {
+  KNF_CHECK_GT(opts_.cmn_window, 0);
+  KNF_CHECK(state_.speaker_stats.empty() ||
+            state_.speaker_stats.size() == window_stats_.size());
+  KNF_CHECK(state_.global_stats.empty() ||
+            state_.global_stats.size() == window_stats_.size());
+  ring_.resize(static_cast<size_t>(opts_.cmn_window) * dim_);
+}
+
+void OnlineCmvnStage::Process(const float *in, int32_t num_frames,
+                              bool /*input_finished*/,
+                              std::vector<float> *out) {
+  size_t offset = out->size();
+  out->resize(offset + static_cast<size_t>(num_frames) * dim_);
+  for (int32_t f = 0; f != num_frames; ++f) {
+    NormalizeFrame(in + static_cast<size_t>(f) * dim_,
+                   out->data() + offset + static_cast<size_t>(f) * dim_);
+  }
+}
+
+void OnlineCmvnStage::NormalizeFrame(const float *in, float *out) {
+  double *sum = window_stats_.data();
+  double *sumsq = sum + dim_ + 1;
+  float *slot = ring_.data() + static_cast<size_t>(ring_next_) * dim_;
+
+  // Slide the window: drop the oldest frame if it is full, add this one.
+  if (ring_size_ == opts_.cmn_window) {
+    for (int32_t d = 0; d != dim_; ++d) {
+      double x = slot[d];
+      sum[d] -= x;
+      sumsq[d] -= x * x;
+    }
+  } else {
+    ++ring_size_;
+  }
+  std::copy(in, in + dim_, slot);
+  ring_next_ = (ring_next_ + 1) % opts_.cmn_window;
+
+  double *utt_sum = utterance_stats_.data();
+  double *utt_sumsq = utt_sum + dim_ + 1;
+  for (int32_t d = 0; d != dim_; ++d) {
+    double x = in[d];
+    sum[d] += x;
+    sumsq[d] += x * x;
+    utt_sum[d] += x;
+    utt_sumsq[d] += x * x;
+  }
+  sum[dim_] = ring_size_;
+  utt_sum[dim_] += 1;
+
+  // Top up a short window with speaker, then global statistics, as
+  // OnlineCmvn::SmoothOnlineCmvnStats() does.
+  std::copy(window_stats_.begin(), window_stats_.end(), stats_.begin());
+  double count = stats_[dim_];
+  double cmn_window = opts_.cmn_window;
+  if (count < cmn_window && !state_.speaker_stats.empty()) {
+    double speaker_count = state_.speaker_stats[dim_];
+    double count_from_speaker = std::min(
+        {cmn_window - count, static_cast<double>(opts_.speaker_frames),
+         speaker_count});
+    if (count_from_speaker > 0.0) {
+      AddStats(state_.speaker_stats, count_from_speaker / speaker_count,
+               &stats_);
+    }
+    count = stats_[dim_];
+  }
+  if (count < cmn_window && !state_.global_stats.empty()) {
+    double global_count = state_.global_stats[dim_];
+    double count_from_global = std::min(
+        cmn_window - count, static_cast<double>(opts_.global_frames));
+    if (count_from_global > 0.0 && global_count > 0.0) {
+      AddStats(state_.global_stats, count_from_global / global_count,
+               &stats_);
+    }
+    count = stats_[dim_];
+  }
+
+  // Apply them with the float roundings of Kaldi's ApplyCmvn()
+  const double *mean_sum = stats_.data();
+  const double *var_sum = mean_sum + dim_ + 1;
+  if (!opts_.normalize_variance) {
+    if (!opts_.normalize_mean) {
+      std::copy(in, in + dim_, out);
+      return;
+    }
+    float scale = static_cast<float>(-1.0 / count);
+    for (int32_t d = 0; d != dim_; ++d) {
+      out[d] = in[d] + static_cast<float>(scale * mean_sum[d]);
+    }
+    return;
+  }
+  for (int32_t d = 0; d != dim_; ++d) {
+    double mean = mean_sum[d] / count;
+    double variance = std::max(var_sum[d] / count - mean * mean, 1.0e-20);
+    double scale = 1.0 / std::sqrt(variance);
+    float offset = opts_.normalize_mean ? static_cast<float>(-(mean * scale))
+                                        : 0.0f;
+    out[d] = in[d] * static_cast<float>(scale) + offset;
+  }
+}
+
+OnlineCmvnState OnlineCmvnStage::GetState() const {
+  OnlineCmvnState state = state_;
+  if (state.speaker_stats.empty()) {
+    state.speaker_stats.assign(utterance_stats_.size(), 0);
+  }
+  AddStats(utterance_stats_, 1.0, &state.speaker_stats);
+  return state;
+}
+
+}  // namespace knf
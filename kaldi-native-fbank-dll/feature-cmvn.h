@@ -0,0 +1,110 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Online cepstral mean (and variance) normalization, after OnlineCmvn in
+// kaldi/src/feat/online-feature.h
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_CMVN_H_
+#define KALDI_NATIVE_FBANK_CSRC_FEATURE_CMVN_H_
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "feature-stage.h"
+
+namespace knf {
+
+struct OnlineCmvnOptions {
+  // Number of frames of sliding context for the statistics; the window
+  // ends at (and includes) the frame being normalized.
+  int32_t cmn_window = 600;
+
+  // While the window has fewer than cmn_window frames, it is topped up
+  // with at most this many frames of speaker statistics from previous
+  // utterances, if any.
+  int32_t speaker_frames = 600;
+
+  // If it still has fewer than cmn_window frames, it is topped up with at
+  // most this many frames of the global statistics, if any.
+  int32_t global_frames = 200;
+
+  bool normalize_mean = true;
+  bool normalize_variance = false;
+
+  std::string ToString() const {
+    std::ostringstream os;
+    os << "cmn_window: " << cmn_window << "\n";
+    os << "speaker_frames: " << speaker_frames << "\n";
+    os << "global_frames: " << global_frames << "\n";
+    os << "normalize_mean: " << normalize_mean << "\n";
+    os << "normalize_variance: " << normalize_variance << "\n";
+    return os.str();
+  }
+};
+
+// CMVN statistics in Kaldi's layout, i.e. a 2 x (dim + 1) matrix, row
+// major: row 0 is the sum of the frames followed by the frame count, row 1
+// the sum of their squares followed by 0. Empty means no statistics.
+struct OnlineCmvnState {
+  std::vector<double> speaker_stats;
+  std::vector<double> global_stats;
+};
+
+// Normalizes every frame as soon as it arrives, using running sums over
+// the last cmn_window frames, so each frame costs O(dim).
+class OnlineCmvnStage : public OnlineFeatureStage {
+ public:
+  OnlineCmvnStage(int32_t dim, const OnlineCmvnOptions &opts,
+                  const OnlineCmvnState &state = {});
+
+  int32_t InputDim() const override { return dim_; }
+  int32_t Dim() const override { return dim_; }
+
+  void Process(const float *in, int32_t num_frames, bool input_finished,
+               std::vector<float> *out) override;
+
+  // The state to start the next utterance of the same speaker with: the
+  // speaker statistics plus those of every frame seen so far.
+  OnlineCmvnState GetState() const;
+
+ private:
+  void NormalizeFrame(const float *in, float *out);
+
+  int32_t dim_;
+  OnlineCmvnOptions opts_;
+  OnlineCmvnState state_;
+
+  // The last min(cmn_window, frames seen) input frames
+  std::vector<float> ring_;
+  int32_t ring_size_ = 0;
+  int32_t ring_next_ = 0;
+
+  // Statistics of the frames in ring_, and of all frames, in the layout
+  // of OnlineCmvnState
+  std::vector<double> window_stats_;
+  std::vector<double> utterance_stats_;
+
+  // workspace
+  std::vector<double> stats_;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FEATURE_CMVN_H_
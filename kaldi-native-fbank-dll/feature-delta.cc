@@ -0,0 +1,125 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "feature-delta.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "log.h"
+
+namespace knf {
+
+OnlineDeltaStage::OnlineDeltaStage(int32_t input_dim,
+                                   const DeltaFeaturesOptions &opts)
+    : input_dim_(input_dim),
+      opts_(opts),
+      context_(opts.order * opts.window) {
+  KNF_CHECK_GE(opts_.order, 0);
+  KNF_CHECK_GT(opts_.window, 0);
+
+  // Same as DeltaFeatures::DeltaFeatures() in Kaldi, but every order is
+  // padded to the full context so that they can share one loop.
+  std::vector<std::vector<float>> scales(opts_.order + 1);
+  scales[0] = {1.0f};
+  for (int32_t i = 1; i <= opts_.order; ++i) {
+    const std::vector<float> &prev = scales[i - 1];
+    std::vector<float> &cur = scales[i];
+    int32_t window = opts_.window;
+    int32_t prev_offset = (static_cast<int32_t>(prev.size()) - 1) / 2;
+    int32_t cur_offset = prev_offset + window;
+    cur.assign(prev.size() + 2 * window, 0.0f);
+
+    float normalizer = 0.0f;
+    for (int32_t j = -window; j <= window; ++j) {
+      normalizer += j * j;
+      for (int32_t k = -prev_offset; k <= prev_offset; ++k) {
+        cur[j + k + cur_offset] += j * prev[k + prev_offset];
+      }
+    }
+    // cur_scales.Scale(1.0 / normalizer), which rounds differently than
+    // dividing by it
+    float alpha = 1.0 / normalizer;
+    for (auto &s : cur) {
+      s *= alpha;
+    }
+  }
+
+  scales_.resize(opts_.order + 1);
+  for (int32_t i = 0; i <= opts_.order; ++i) {
+    int32_t offset = (static_cast<int32_t>(scales[i].size()) - 1) / 2;
+    scales_[i].assign(2 * context_ + 1, 0.0f);
+    std::copy(scales[i].begin(), scales[i].end(),
+              scales_[i].begin() + (context_ - offset));
+  }
+
+  ring_frames_ = 2 * context_ + 1;
+  ring_.resize(static_cast<size_t>(ring_frames_) * input_dim_);
+}
+
+void OnlineDeltaStage::EmitFrame(std::vector<float> *out) {
+  size_t offset = out->size();
+  out->resize(offset + Dim(), 0.0f);
+  float *dst = out->data() + offset;
+
+  int64_t t = num_outputs_;
+  int64_t last = num_inputs_ - 1;
+  for (int32_t j = -context_; j <= context_; ++j) {
+    int64_t index = std::max<int64_t>(0, std::min(t + j, last));
+    const float *src =
+        ring_.data() + static_cast<size_t>(index % ring_frames_) * input_dim_;
+
+    for (int32_t i = 0; i <= opts_.order; ++i) {
+      float scale = scales_[i][j + context_];
+      if (scale == 0.0f) {
+        continue;
+      }
+      // contiguous, so the compiler vectorizes it over the dimension
+      float *block = dst + i * input_dim_;
+      for (int32_t d = 0; d != input_dim_; ++d) {
+        block[d] += scale * src[d];
+      }
+    }
+  }
+  ++num_outputs_;
+}
+
+void OnlineDeltaStage::Process(const float *in, int32_t num_frames,
+                               bool input_finished, std::vector<float> *out) {
+  for (int32_t f = 0; f != num_frames; ++f) {
+    const float *frame = in + static_cast<size_t>(f) * input_dim_;
+    std::copy(frame, frame + input_dim_,
+              ring_.begin() + (num_inputs_ % ring_frames_) * input_dim_);
+    ++num_inputs_;
+
+    // the right context of frame num_outputs_ is complete
+    while (num_outputs_ + context_ < num_inputs_) {
+      EmitFrame(out);
+    }
+  }
+
+  if (input_finished && !finished_) {
+    finished_ = true;
+    while (num_outputs_ < num_inputs_) {
+      EmitFrame(out);
+    }
+  }
+}
+
+}  // namespace knf
@@ -0,0 +1,87 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Streaming delta features, after DeltaFeatures in
+// kaldi/src/feat/feature-functions.h (add-deltas)
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_DELTA_H_
+#define KALDI_NATIVE_FBANK_CSRC_FEATURE_DELTA_H_
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "feature-stage.h"
+
+namespace knf {
+
+struct DeltaFeaturesOptions {
+  int32_t order = 2;   // 2 means features, deltas and delta-deltas
+  int32_t window = 2;  // the context is window * order frames on each side
+
+  std::string ToString() const {
+    std::ostringstream os;
+    os << "order: " << order << "\n";
+    os << "window: " << window << "\n";
+    return os.str();
+  }
+};
+
+// Appends deltas up to opts.order to every frame, with the same result as
+// Kaldi's add-deltas on the whole utterance.
+//
+// A frame is output once its right context of order * window frames has
+// arrived, or at the end of the input. Frames beyond either end of the
+// utterance are replaced by the first or last frame.
+class OnlineDeltaStage : public OnlineFeatureStage {
+ public:
+  OnlineDeltaStage(int32_t input_dim, const DeltaFeaturesOptions &opts);
+
+  int32_t InputDim() const override { return input_dim_; }
+  int32_t Dim() const override { return input_dim_ * (opts_.order + 1); }
+  int32_t Latency() const override { return context_; }
+
+  void Process(const float *in, int32_t num_frames, bool input_finished,
+               std::vector<float> *out) override;
+
+ private:
+  // Append output frame num_outputs_ to out
+  void EmitFrame(std::vector<float> *out);
+
+  int32_t input_dim_;
+  DeltaFeaturesOptions opts_;
+  int32_t context_;  // order * window
+
+  // scales_[i][j + context_] is the weight of frame t + j in the i-th
+  // order block of output frame t
+  std::vector<std::vector<float>> scales_;
+
+  // The last 2 * context_ + 1 input frames; frame t is in slot
+  // t % (2 * context_ + 1)
+  std::vector<float> ring_;
+  int32_t ring_frames_;
+
+  int64_t num_inputs_ = 0;
+  int64_t num_outputs_ = 0;
+  bool finished_ = false;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FEATURE_DELTA_H_
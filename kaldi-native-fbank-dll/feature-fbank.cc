@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "feature-functions.h"
+#include "feature-stats.h"
 
 
 namespace knf {
@@ -48,8 +49,11 @@ FbankComputer::FbankComputer(const FbankOptions &opts)
   }
 
   // We'll definitely need the filterbanks info for VTLN warping factor 1.0.
-  // [note: this call caches it.]
-  GetMelBanks(1.0f);
+  // They are shared by all computers with the same options.
+  default_mel_banks_ = GetSharedMelBanks(opts.mel_opts, opts.frame_opts);
+
+  fixed_kernel_ = GetSharedMelKernel(
+      opts.mel_opts, opts.frame_opts.PaddedWindowSize(), default_mel_banks_);
 }
 
 FbankComputer::~FbankComputer() {
@@ -58,6 +62,10 @@ FbankComputer::~FbankComputer() {
 }
 
 const MelBanks *FbankComputer::GetMelBanks(float vtln_warp) {
+  if (vtln_warp == 1.0f) {
+    return default_mel_banks_;
+  }
+
   MelBanks *this_mel_banks = nullptr;
 
   // std::map<float, MelBanks *>::iterator iter = mel_banks_.find(vtln_warp);
@@ -72,24 +80,36 @@ const MelBanks *FbankComputer::GetMelBanks(float vtln_warp) {
 }
 
 void FbankComputer::Compute(float signal_raw_log_energy, float vtln_warp,
-                            std::vector<float> *signal_frame, float *feature) {
-  const MelBanks &mel_banks = *(GetMelBanks(vtln_warp));
-
-  KNF_CHECK_EQ(signal_frame->size(), opts_.frame_opts.PaddedWindowSize());
+                            float *signal_frame, float *feature) {
+  int32_t padded_size = opts_.frame_opts.PaddedWindowSize();
 
   // Compute energy after window function (not the raw one).
   if (opts_.use_energy && !opts_.raw_energy) {
     signal_raw_log_energy = std::log(
-        std::max<float>(InnerProduct(signal_frame->data(), signal_frame->data(),
-                                     signal_frame->size()),
+        std::max<float>(InnerProduct(signal_frame, signal_frame, padded_size),
                         std::numeric_limits<float>::epsilon()));
   }
-  rfft_.Compute(signal_frame->data());  // signal_frame is modified in-place
-  ComputePowerSpectrum(signal_frame);
+  {
+    KNF_STATS_SCOPE(kFft);
+    rfft_.Compute(signal_frame);  // signal_frame is modified in-place
+  }
 
-  // Use magnitude instead of power if requested.
-  if (!opts_.use_power) {
-    Sqrt(signal_frame->data(), signal_frame->size() / 2 + 1);
+  // The compiled-in kernel for these options, if any, takes over from here
+  const MelKernel *kernel = vtln_warp == 1.0f ? fixed_kernel_ : nullptr;
+  const MelBanks *mel_banks = kernel ? nullptr : GetMelBanks(vtln_warp);
+
+  {
+    KNF_STATS_SCOPE(kPowerSpectrum);
+    if (kernel) {
+      kernel->ComputePowerSpectrum(signal_frame, opts_.use_power);
+    } else {
+      ComputePowerSpectrum(signal_frame, padded_size);
+
+      // Use magnitude instead of power if requested.
+      if (!opts_.use_power) {
+        Sqrt(signal_frame, padded_size / 2 + 1);
+      }
+    }
   }
 
   int32_t mel_offset = ((opts_.use_energy && !opts_.htk_compat) ? 1 : 0);
@@ -98,9 +118,20 @@ void FbankComputer::Compute(float signal_raw_log_energy, float vtln_warp,
   float *mel_energies = feature + mel_offset;
 
   // Sum with mel filter banks over the power spectrum
-  mel_banks.Compute(signal_frame->data(), mel_energies);
+  {
+    KNF_STATS_SCOPE(kMel);
+    if (kernel) {
+      kernel->Compute(signal_frame, mel_energies);
+    } else {
+      mel_banks->Compute(signal_frame, mel_energies);
+    }
+  }
 
-  if (opts_.use_log_fbank) {
+  if (opts_.use_log_fbank && kernel) {
+    KNF_STATS_SCOPE(kLog);
+    kernel->ApplyLog(mel_energies);
+  } else if (opts_.use_log_fbank) {
+    KNF_STATS_SCOPE(kLog);
     // Avoid log of zero (which should be prevented anyway by dithering).
     for (int32_t i = 0; i != opts_.mel_opts.num_bins; ++i) {
       auto t = std::max(mel_energies[i], std::numeric_limits<float>::epsilon());
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "feature-window.h"
+#include "fixed-mel-kernel.h"
 #include "mel-computations.h"
 #include "rfft.h"
 
@@ -121,15 +122,32 @@ class FbankComputer {
          the computed feature will be written. It should be pre-allocated.
   */
   void Compute(float signal_raw_log_energy, float vtln_warp,
-               std::vector<float> *signal_frame, float *feature);
+               std::vector<float> *signal_frame, float *feature) {
+    KNF_CHECK_EQ(signal_frame->size(), opts_.frame_opts.PaddedWindowSize());
+    Compute(signal_raw_log_energy, vtln_warp, signal_frame->data(), feature);
+  }
+
+  // The same as above with signal_frame pointing to
+  // GetFrameOptions().PaddedWindowSize() values, which need not be in a
+  // std::vector, e.g., a row of a batch matrix
+  void Compute(float signal_raw_log_energy, float vtln_warp,
+               float *signal_frame, float *feature);
 
  private:
   const MelBanks *GetMelBanks(float vtln_warp);
 
   FbankOptions opts_;
   float log_energy_floor_;
-  std::map<float, MelBanks *> mel_banks_;  // float is VTLN coefficient.
+  // shared, see GetSharedMelBanks(); for vtln_warp == 1.0
+  const MelBanks *default_mel_banks_ = nullptr;
+  // other warps; float is VTLN coefficient.
+  std::map<float, MelBanks *> mel_banks_;
   Rfft rfft_;
+
+  // Not null if the options match a compiled-in FixedMelKernel. It is used
+  // for vtln_warp == 1.0 and replaces the generic code after the FFT.
+  // Shared, see GetSharedMelKernel().
+  const MelKernel *fixed_kernel_ = nullptr;
 };
 
 }  // namespace knf
@@ -0,0 +1,254 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "feature-format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define KNF_HAVE_NEON_FP16 1
+#elif defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+// Compiled for any x86 target: the F16C loop gets its own target attribute
+// and runs only if cpuid reports F16C, so the DLL built without /arch:AVX2
+// still uses it where the CPU has it.
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#define KNF_HAVE_F16C 1
+#endif
+
+namespace knf {
+
+namespace {
+
+inline uint32_t FloatBits(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+inline float BitsToFloat(uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+#if KNF_HAVE_F16C
+bool CpuHasF16C() {
+#if defined(__F16C__)
+  return true;
+#else
+  uint32_t ecx = 0;
+#if defined(_MSC_VER) && !defined(__clang__)
+  int regs[4];
+  __cpuid(regs, 1);
+  ecx = static_cast<uint32_t>(regs[2]);
+#else
+  unsigned int eax, ebx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+#endif
+  // vcvtps2ph on 8 floats needs the OS to save the YMM registers too
+  const uint32_t kOsxsave = 1u << 27, kAvx = 1u << 28, kF16c = 1u << 29;
+  if ((ecx & (kOsxsave | kAvx | kF16c)) != (kOsxsave | kAvx | kF16c)) {
+    return false;
+  }
+#if defined(_MSC_VER) && !defined(__clang__)
+  uint64_t xcr0 = _xgetbv(0);
+#else
+  uint32_t xcr0_low, xcr0_high;
+  __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+  uint64_t xcr0 = (static_cast<uint64_t>(xcr0_high) << 32) | xcr0_low;
+#endif
+  return (xcr0 & 6) == 6;  // XMM and YMM state
+#endif
+}
+
+bool UseF16C() {
+  static const bool use = CpuHasF16C();
+  return use;
+}
+
+// Converts the first n / 8 * 8 values; returns how many
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx,f16c")))
+#endif
+int64_t ConvertToHalfF16C(const float *in, int64_t n, uint16_t *out) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), h);
+  }
+  return i;
+}
+#endif
+
+}  // namespace
+
+int32_t BytesPerValue(FeatureFormat format) {
+  switch (format) {
+    case FeatureFormat::kFloat32:
+      return 4;
+    case FeatureFormat::kFloat16:
+    case FeatureFormat::kBFloat16:
+      return 2;
+    case FeatureFormat::kInt8:
+      return 1;
+  }
+  return 0;
+}
+
+uint16_t FloatToHalf(float f) {
+  uint32_t x = FloatBits(f);
+  uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+  x &= 0x7FFFFFFF;
+  if (x >= 0x7F800000) {
+    // inf, or NaN made quiet, keeping the upper payload bits as F16C does
+    return sign | (x > 0x7F800000 ? 0x7E00 | ((x >> 13) & 0x3FF) : 0x7C00);
+  }
+  if (x >= 0x477FF000) {
+    return sign | 0x7C00;  // >= 65520 rounds to inf
+  }
+  if (x < 0x38800000) {
+    // a subnormal half or zero: adding 0.5 puts the half mantissa in the
+    // low bits of the float mantissa, rounded by the FPU to nearest even
+    float sum = BitsToFloat(x) + 0.5f;
+    return sign | static_cast<uint16_t>(FloatBits(sum) - 0x3F000000);
+  }
+  // rebias the exponent and round the 13 dropped bits to nearest even
+  uint32_t odd = (x >> 13) & 1;
+  x += 0xC8000FFF + odd;
+  return sign | static_cast<uint16_t>(x >> 13);
+}
+
+float HalfToFloat(uint16_t h) {
+  uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+  uint32_t exponent = (h >> 10) & 0x1F;
+  uint32_t mantissa = h & 0x3FF;
+  if (exponent == 0x1F) {
+    return BitsToFloat(sign | 0x7F800000 | (mantissa << 13));
+  }
+  if (exponent == 0) {
+    // zero or subnormal: mantissa * 2^-24
+    float f = static_cast<float>(mantissa) * BitsToFloat(0x33800000);
+    return BitsToFloat(sign | FloatBits(f));
+  }
+  return BitsToFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+uint16_t FloatToBFloat16(float f) {
+  uint32_t x = FloatBits(f);
+  if ((x & 0x7FFFFFFF) > 0x7F800000) {
+    return static_cast<uint16_t>((x >> 16) | 0x40);  // quiet NaN
+  }
+  x += 0x7FFF + ((x >> 16) & 1);
+  return static_cast<uint16_t>(x >> 16);
+}
+
+float BFloat16ToFloat(uint16_t b) {
+  return BitsToFloat(static_cast<uint32_t>(b) << 16);
+}
+
+bool HalfConversionIsSimd() {
+#if KNF_HAVE_F16C
+  return UseF16C();
+#elif KNF_HAVE_NEON_FP16
+  return true;
+#else
+  return false;
+#endif
+}
+
+void ConvertToHalf(const float *in, int64_t n, uint16_t *out) {
+  int64_t i = 0;
+#if KNF_HAVE_F16C
+  if (UseF16C()) {
+    i = ConvertToHalfF16C(in, n, out);
+  }
+#elif KNF_HAVE_NEON_FP16
+  for (; i + 4 <= n; i += 4) {
+    float16x4_t h = vcvt_f16_f32(vld1q_f32(in + i));
+    vst1_u16(out + i, vreinterpret_u16_f16(h));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = FloatToHalf(in[i]);
+  }
+}
+
+void ConvertToBFloat16(const float *in, int64_t n, uint16_t *out) {
+  // integer-only, so compilers vectorize it for any target
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = FloatToBFloat16(in[i]);
+  }
+}
+
+void QuantizeRowsToInt8(const float *in, int32_t rows, int32_t cols,
+                        int8_t *out, float *scales) {
+  for (int32_t r = 0; r != rows; ++r) {
+    const float *row = in + static_cast<int64_t>(r) * cols;
+    int8_t *q = out + static_cast<int64_t>(r) * cols;
+    float max_abs = 0;
+    for (int32_t c = 0; c != cols; ++c) {
+      max_abs = std::max(max_abs, std::fabs(row[c]));
+    }
+    float scale = max_abs / 127;
+    scales[r] = scale;
+    if (scale == 0) {
+      std::fill(q, q + cols, 0);
+      continue;
+    }
+    for (int32_t c = 0; c != cols; ++c) {
+      // to nearest even, as ONNX QuantizeLinear
+      float v = std::nearbyint(row[c] / scale);
+      q[c] = static_cast<int8_t>(std::min(std::max(v, -127.0f), 127.0f));
+    }
+  }
+}
+
+bool ConvertFeatures(const float *in, int32_t rows, int32_t cols,
+                     FeatureFormat format, void *out, float *scales) {
+  int64_t n = static_cast<int64_t>(rows) * cols;
+  switch (format) {
+    case FeatureFormat::kFloat32:
+      std::copy(in, in + n, static_cast<float *>(out));
+      return true;
+    case FeatureFormat::kFloat16:
+      ConvertToHalf(in, n, static_cast<uint16_t *>(out));
+      return true;
+    case FeatureFormat::kBFloat16:
+      ConvertToBFloat16(in, n, static_cast<uint16_t *>(out));
+      return true;
+    case FeatureFormat::kInt8:
+      QuantizeRowsToInt8(in, rows, cols, static_cast<int8_t *>(out), scales);
+      return true;
+  }
+  return false;
+}
+
+}  // namespace knf
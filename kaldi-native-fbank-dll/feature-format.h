@@ -0,0 +1,69 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Conversion of float features to the formats inference engines take
+// directly: IEEE half precision, bfloat16, and int8 with a scale per frame.
+// Rounding is to nearest, ties to even, as in the hardware conversions and
+// numpy / ONNX Runtime, so the results are the same with and without SIMD.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_FORMAT_H_
+#define KALDI_NATIVE_FBANK_CSRC_FEATURE_FORMAT_H_
+
+#include <cstdint>
+
+namespace knf {
+
+enum class FeatureFormat : int32_t {
+  kFloat32 = 0,
+  kFloat16 = 1,   // IEEE 754 binary16
+  kBFloat16 = 2,  // the upper 16 bits of a float
+  // Symmetric int8 with a float scale per row (frame):
+  // value = scale * q, q in [-127, 127], scale = max |value| / 127
+  kInt8 = 3,
+};
+
+// Size of one value, 0 if format is not a FeatureFormat
+int32_t BytesPerValue(FeatureFormat format);
+
+uint16_t FloatToHalf(float f);
+float HalfToFloat(uint16_t h);
+uint16_t FloatToBFloat16(float f);
+float BFloat16ToFloat(uint16_t b);
+
+// Element-wise conversion of n values. ConvertToHalf() uses F16C on x86
+// CPUs that have it, found with cpuid at run time, and NEON on aarch64.
+void ConvertToHalf(const float *in, int64_t n, uint16_t *out);
+void ConvertToBFloat16(const float *in, int64_t n, uint16_t *out);
+
+// True if ConvertToHalf() uses F16C or NEON on this CPU
+bool HalfConversionIsSimd();
+
+// Quantize each row of the rows x cols matrix in to int8, with its scale in
+// scales[row]. A row of zeros gets scale 0.
+void QuantizeRowsToInt8(const float *in, int32_t rows, int32_t cols,
+                        int8_t *out, float *scales);
+
+// Convert a rows x cols row-major matrix to format. out holds
+// rows * cols * BytesPerValue(format) bytes; scales (rows floats) is only
+// used for kInt8. Returns false for an unknown format.
+bool ConvertFeatures(const float *in, int32_t rows, int32_t cols,
+                     FeatureFormat format, void *out, float *scales);
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FEATURE_FORMAT_H_
@@ -26,12 +26,15 @@
 namespace knf {
 
 void ComputePowerSpectrum(std::vector<float> *complex_fft) {
-  int32_t dim = complex_fft->size();
+  ComputePowerSpectrum(complex_fft->data(),
+                       static_cast<int32_t>(complex_fft->size()));
+}
 
+void ComputePowerSpectrum(float *complex_fft, int32_t dim) {
   // now we have in complex_fft, first half of complex spectrum
   // it's stored as [real0, realN/2, real1, im1, real2, im2, ...]
 
-  float *p = complex_fft->data();
+  float *p = complex_fft;
   int32_t half_dim = dim / 2;
   float first_energy = p[0] * p[0];
   float last_energy = p[1] * p[1];  // handle this special case
@@ -20,7 +20,9 @@
 #ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_FUNCTIONS_H_
 #define KALDI_NATIVE_FBANK_CSRC_FEATURE_FUNCTIONS_H_
 
+#include <cstdint>
 #include <vector>
+
 namespace knf {
 
 // ComputePowerSpectrum converts a complex FFT (as produced by the FFT
@@ -33,6 +35,9 @@ namespace knf {
 
 void ComputePowerSpectrum(std::vector<float> *complex_fft);
 
+// The same as above for n values at complex_fft
+void ComputePowerSpectrum(float *complex_fft, int32_t n);
+
 }  // namespace knf
 
 #endif  // KALDI_NATIVE_FBANK_CSRC_FEATURE_FUNCTIONS_H_
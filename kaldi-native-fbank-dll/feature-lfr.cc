@@ -0,0 +1,162 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "feature-lfr.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "log.h"
+
+namespace knf {
+
+namespace {
+
+// Read the numbers between the next "[" and "]" of is
+bool ReadBracketedVector(std::istream &is, std::vector<float> *v) {
+  std::string token;
+  while (is >> token && token != "[") {
+  }
+  if (!is) {
+    return false;
+  }
+
+  v->clear();
+  while (is >> token && token != "]") {
+    char *end = nullptr;
+    float f = std::strtof(token.c_str(), &end);
+    if (end == token.c_str() || *end != '\0') {
+      return false;
+    }
+    v->push_back(f);
+  }
+  return static_cast<bool>(is) && !v->empty();
+}
+
+}  // namespace
+
+bool ReadAmMvn(std::istream &is, std::vector<float> *neg_mean,
+               std::vector<float> *inv_stddev) {
+  bool has_shift = false;
+  bool has_scale = false;
+
+  std::string token;
+  while (is >> token) {
+    if (token == "<AddShift>") {
+      has_shift = ReadBracketedVector(is, neg_mean);
+    } else if (token == "<Rescale>") {
+      has_scale = ReadBracketedVector(is, inv_stddev);
+    }
+  }
+
+  return has_shift && has_scale && neg_mean->size() == inv_stddev->size();
+}
+
+bool ReadAmMvn(const std::string &filename, std::vector<float> *neg_mean,
+               std::vector<float> *inv_stddev) {
+  std::ifstream is(filename);
+  if (!is) {
+    KNF_LOG(WARNING) << "Cannot open " << filename;
+    return false;
+  }
+  return ReadAmMvn(is, neg_mean, inv_stddev);
+}
+
+LfrCmvnStage::LfrCmvnStage(int32_t input_dim, const LfrCmvnOptions &opts)
+    : input_dim_(input_dim), opts_(opts) {
+  KNF_CHECK_GT(opts_.lfr_m, 0);
+  KNF_CHECK_GT(opts_.lfr_n, 0);
+  KNF_CHECK_EQ(opts_.neg_mean.size(), opts_.inv_stddev.size());
+  KNF_CHECK(opts_.neg_mean.empty() ||
+            static_cast<int32_t>(opts_.neg_mean.size()) == Dim());
+}
+
+int32_t LfrCmvnStage::Latency() const {
+  // right context of a frame, beyond the left padding
+  return opts_.lfr_m - 1 - (opts_.lfr_m - 1) / 2;
+}
+
+void LfrCmvnStage::EmitFrame(std::vector<float> *out) {
+  int64_t start = num_outputs_ * opts_.lfr_n;
+  size_t offset = out->size();
+  out->resize(offset + Dim());
+  float *dst = out->data() + offset;
+
+  bool cmvn = !opts_.neg_mean.empty();
+  const float *neg_mean = opts_.neg_mean.data();
+  const float *inv_stddev = opts_.inv_stddev.data();
+
+  for (int32_t k = 0; k != opts_.lfr_m; ++k) {
+    int64_t index = std::min(start + k, num_padded_ - 1);
+    const float *src = buffer_.data() + (index - buffer_start_) * input_dim_;
+    if (cmvn) {
+      for (int32_t d = 0; d != input_dim_; ++d) {
+        dst[d] = (src[d] + neg_mean[d]) * inv_stddev[d];
+      }
+      neg_mean += input_dim_;
+      inv_stddev += input_dim_;
+    } else {
+      std::copy(src, src + input_dim_, dst);
+    }
+    dst += input_dim_;
+  }
+  ++num_outputs_;
+}
+
+void LfrCmvnStage::Process(const float *in, int32_t num_frames,
+                           bool input_finished, std::vector<float> *out) {
+  for (int32_t f = 0; f != num_frames; ++f) {
+    const float *frame = in + static_cast<int64_t>(f) * input_dim_;
+    if (num_inputs_ == 0) {
+      for (int32_t i = 0; i != (opts_.lfr_m - 1) / 2; ++i) {
+        buffer_.insert(buffer_.end(), frame, frame + input_dim_);
+        ++num_padded_;
+      }
+    }
+    buffer_.insert(buffer_.end(), frame, frame + input_dim_);
+    ++num_padded_;
+    ++num_inputs_;
+
+    while (num_outputs_ * opts_.lfr_n + opts_.lfr_m <= num_padded_) {
+      EmitFrame(out);
+    }
+  }
+
+  if (input_finished && !finished_) {
+    finished_ = true;
+    int64_t total = (num_inputs_ + opts_.lfr_n - 1) / opts_.lfr_n;
+    while (num_outputs_ < total) {
+      EmitFrame(out);
+    }
+  }
+
+  // drop the frames that no future output uses
+  int64_t first_needed =
+      std::min(num_outputs_ * opts_.lfr_n, num_padded_);
+  if (first_needed > buffer_start_) {
+    buffer_.erase(buffer_.begin(),
+                  buffer_.begin() + (first_needed - buffer_start_) * input_dim_);
+    buffer_start_ = first_needed;
+  }
+}
+
+}  // namespace knf
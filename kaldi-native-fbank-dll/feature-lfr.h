@@ -0,0 +1,93 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Low frame rate (LFR) stacking followed by CMVN, as used by the input
+// of Paraformer and SenseVoice models.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_LFR_H_
+#define KALDI_NATIVE_FBANK_CSRC_FEATURE_LFR_H_
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "feature-stage.h"
+
+namespace knf {
+
+struct LfrCmvnOptions {
+  // Stack lfr_m consecutive frames, every lfr_n frames
+  int32_t lfr_m = 7;
+  int32_t lfr_n = 6;
+
+  // If not empty, output[i] = (stacked[i] + neg_mean[i]) * inv_stddev[i].
+  // Both have lfr_m * input dim entries.
+  std::vector<float> neg_mean;
+  std::vector<float> inv_stddev;
+};
+
+// Read the <AddShift> and <Rescale> vectors of a Kaldi nnet1 text file,
+// i.e. the am.mvn file shipped with FunASR models, into neg_mean and
+// inv_stddev. Returns false if either is missing or malformed.
+bool ReadAmMvn(std::istream &is, std::vector<float> *neg_mean,
+               std::vector<float> *inv_stddev);
+bool ReadAmMvn(const std::string &filename, std::vector<float> *neg_mean,
+               std::vector<float> *inv_stddev);
+
+// Streaming version of FunASR's apply_lfr() + apply_cmvn().
+//
+// The input is padded with (lfr_m - 1) / 2 copies of the first frame on
+// the left. Output frame i stacks padded frames [i * lfr_n, i * lfr_n +
+// lfr_m); it is output as soon as they are all available. After the input
+// is finished, the remaining frames up to ceil(num_input_frames / lfr_n)
+// are output, padded on the right with copies of the last frame.
+//
+// CMVN is applied while stacking, so every value is written once.
+class LfrCmvnStage : public OnlineFeatureStage {
+ public:
+  LfrCmvnStage(int32_t input_dim, const LfrCmvnOptions &opts);
+
+  int32_t InputDim() const override { return input_dim_; }
+  int32_t Dim() const override { return input_dim_ * opts_.lfr_m; }
+  int32_t Latency() const override;
+
+  void Process(const float *in, int32_t num_frames, bool input_finished,
+               std::vector<float> *out) override;
+
+ private:
+  // Append output frame num_outputs_ to out, padding on the right with
+  // the last buffered frame if needed.
+  void EmitFrame(std::vector<float> *out);
+
+  int32_t input_dim_;
+  LfrCmvnOptions opts_;
+
+  // Padded input frames [buffer_start_, num_padded_), row major
+  std::vector<float> buffer_;
+  int64_t buffer_start_ = 0;
+  int64_t num_padded_ = 0;
+
+  int64_t num_inputs_ = 0;
+  int64_t num_outputs_ = 0;
+  bool finished_ = false;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FEATURE_LFR_H_
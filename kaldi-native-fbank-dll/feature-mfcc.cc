@@ -28,38 +28,13 @@
 #include <vector>
 
 #include "feature-functions.h"
+#include "feature-stats.h"
 #include "feature-window.h"
 #include "kaldi-math.h"
 #include "log.h"
 
 namespace knf {
 
-static std::vector<float> ComputeDctMatrix(int32_t num_rows, int32_t num_cols) {
-  // this function is copied from
-  // https://github.com/kaldi-asr/kaldi/blob/master/src/matrix/matrix-functions.cc#L592
-
-  std::vector<float> ans(num_rows * num_cols);
-  float *p = ans.data();
-
-  float normalizer = std::sqrt(1.0 / num_cols);  // normalizer for X_0
-
-  for (int32_t i = 0; i != num_cols; ++i) {
-    p[i] = normalizer;
-  }
-
-  normalizer = std::sqrt(2.0 / num_cols);  // normalizer for other elements
-
-  for (int32_t k = 1; k != num_rows; ++k) {
-    for (int32_t n = 0; n != num_cols; ++n) {
-      *(p + k * num_cols + n) =
-          normalizer *
-          std::cos(static_cast<double>(M_PI) / num_cols * (n + 0.5) * k);
-    }
-  }
-
-  return ans;
-}
-
 std::ostream &operator<<(std::ostream &os, const MfccOptions &opts) {
   os << opts.ToString();
   return os;
@@ -74,8 +49,8 @@ MfccComputer::MfccComputer(const MfccOptions &opts)
   }
 
   // We'll definitely need the filterbanks info for VTLN warping factor 1.0.
-  // [note: this call caches it.]
-  GetMelBanks(1.0f);
+  // They are shared by all computers with the same options.
+  default_mel_banks_ = GetSharedMelBanks(opts.mel_opts, opts.frame_opts);
 
   int32_t num_bins = opts.mel_opts.num_bins;
 
@@ -99,6 +74,10 @@ MfccComputer::~MfccComputer() {
 }
 
 const MelBanks *MfccComputer::GetMelBanks(float vtln_warp) {
+  if (vtln_warp == 1.0f) {
+    return default_mel_banks_;
+  }
+
   MelBanks *this_mel_banks = nullptr;
 
   // std::map<float, MelBanks *>::iterator iter = mel_banks_.find(vtln_warp);
@@ -113,39 +92,50 @@ const MelBanks *MfccComputer::GetMelBanks(float vtln_warp) {
 }
 
 void MfccComputer::Compute(float signal_raw_log_energy, float vtln_warp,
-                           std::vector<float> *signal_frame, float *feature) {
+                           float *signal_frame, float *feature) {
   const MelBanks &mel_banks = *(GetMelBanks(vtln_warp));
 
-  KNF_CHECK_EQ(signal_frame->size(), opts_.frame_opts.PaddedWindowSize());
+  int32_t padded_size = opts_.frame_opts.PaddedWindowSize();
 
   // Compute energy after window function (not the raw one).
   if (opts_.use_energy && !opts_.raw_energy) {
     signal_raw_log_energy = std::log(
-        std::max<float>(InnerProduct(signal_frame->data(), signal_frame->data(),
-                                     signal_frame->size()),
+        std::max<float>(InnerProduct(signal_frame, signal_frame, padded_size),
                         std::numeric_limits<float>::epsilon()));
   }
-  rfft_.Compute(signal_frame->data());  // signal_frame is modified in-place
-  ComputePowerSpectrum(signal_frame);
+  {
+    KNF_STATS_SCOPE(kFft);
+    rfft_.Compute(signal_frame);  // signal_frame is modified in-place
+  }
+  {
+    KNF_STATS_SCOPE(kPowerSpectrum);
+    ComputePowerSpectrum(signal_frame, padded_size);
+  }
 
   // Sum with mel filter banks over the power spectrum
-  mel_banks.Compute(signal_frame->data(), mel_energies_.data());
-
-  // Avoid log of zero (which should be prevented anyway by dithering).
-  for (int32_t i = 0; i != opts_.mel_opts.num_bins; ++i) {
-    auto t = std::max<float>(mel_energies_[i], std::numeric_limits<float>::epsilon());
-    mel_energies_[i] = std::log(t);
+  {
+    KNF_STATS_SCOPE(kMel);
+    mel_banks.Compute(signal_frame, mel_energies_.data());
   }
 
-  // feature = dct_matrix_ * mel_energies [which now have log]
-  for (int32_t i = 0; i != opts_.num_ceps; ++i) {
-    feature[i] = InnerProduct(dct_matrix_.data() + i * opts_.mel_opts.num_bins,
-                              mel_energies_.data(), opts_.mel_opts.num_bins);
-  }
+  {
+    KNF_STATS_SCOPE(kLog);
+    // Avoid log of zero (which should be prevented anyway by dithering).
+    for (int32_t i = 0; i != opts_.mel_opts.num_bins; ++i) {
+      auto t = std::max<float>(mel_energies_[i], std::numeric_limits<float>::epsilon());
+      mel_energies_[i] = std::log(t);
+    }
 
-  if (opts_.cepstral_lifter != 0.0) {
+    // feature = dct_matrix_ * mel_energies [which now have log]
     for (int32_t i = 0; i != opts_.num_ceps; ++i) {
-      feature[i] *= lifter_coeffs_[i];
+      feature[i] = InnerProduct(dct_matrix_.data() + i * opts_.mel_opts.num_bins,
+                                mel_energies_.data(), opts_.mel_opts.num_bins);
+    }
+
+    if (opts_.cepstral_lifter != 0.0) {
+      for (int32_t i = 0; i != opts_.num_ceps; ++i) {
+        feature[i] *= lifter_coeffs_[i];
+      }
     }
   }
 
@@ -126,14 +126,26 @@ class MfccComputer {
          the computed feature will be written. It should be pre-allocated.
   */
   void Compute(float signal_raw_log_energy, float vtln_warp,
-               std::vector<float> *signal_frame, float *feature);
+               std::vector<float> *signal_frame, float *feature) {
+    KNF_CHECK_EQ(signal_frame->size(), opts_.frame_opts.PaddedWindowSize());
+    Compute(signal_raw_log_energy, vtln_warp, signal_frame->data(), feature);
+  }
+
+  // The same as above with signal_frame pointing to
+  // GetFrameOptions().PaddedWindowSize() values, which need not be in a
+  // std::vector, e.g., a row of a batch matrix
+  void Compute(float signal_raw_log_energy, float vtln_warp,
+               float *signal_frame, float *feature);
 
  private:
   const MelBanks *GetMelBanks(float vtln_warp);
 
   MfccOptions opts_;
   float log_energy_floor_;
-  std::map<float, MelBanks *> mel_banks_;  // float is VTLN coefficient.
+  // shared, see GetSharedMelBanks(); for vtln_warp == 1.0
+  const MelBanks *default_mel_banks_ = nullptr;
+  // other warps; float is VTLN coefficient.
+  std::map<float, MelBanks *> mel_banks_;
   Rfft rfft_;
 
   // temp buffer of size num_mel_bins = opts.mel_opts.num_bins
@@ -0,0 +1,179 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "feature-multi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "feature-functions.h"
+#include "feature-stats.h"
+#include "log.h"
+
+namespace knf {
+
+MultiFeatureComputer::MultiFeatureComputer(const MultiFeatureOptions &opts)
+    : opts_(opts), rfft_(opts.frame_opts.PaddedWindowSize()) {
+  std::fill(offsets_, offsets_ + kNumHeads, -1);
+  std::fill(dims_, dims_ + kNumHeads, 0);
+
+  int32_t num_bins = opts_.mel_opts.num_bins;
+  for (FeatureHead head : opts_.heads) {
+    int32_t h = static_cast<int32_t>(head);
+    KNF_CHECK(h >= 0 && h < kNumHeads) << "Unknown feature head " << h;
+    KNF_CHECK_EQ(offsets_[h], -1) << "Feature head " << h << " is repeated";
+    if (h < 0 || h >= kNumHeads || offsets_[h] != -1) {
+      continue;
+    }
+
+    int32_t d = 0;
+    switch (head) {
+      case FeatureHead::kLogFbank:
+        d = num_bins;
+        need_mel_ = true;
+        break;
+      case FeatureHead::kMfcc:
+        d = opts_.num_ceps;
+        need_mel_ = true;
+        break;
+      case FeatureHead::kPowerSpectrum:
+        d = opts_.frame_opts.PaddedWindowSize() / 2 + 1;
+        break;
+      case FeatureHead::kLogEnergy:
+        d = 1;
+        need_energy_ = true;
+        break;
+    }
+    offsets_[h] = dim_;
+    dims_[h] = d;
+    dim_ += d;
+  }
+
+  if (opts_.energy_floor > 0.0f) {
+    log_energy_floor_ = logf(opts_.energy_floor);
+  }
+
+  if (need_mel_) {
+    mel_banks_ = GetSharedMelBanks(opts_.mel_opts, opts_.frame_opts);
+    log_mel_.resize(num_bins);
+  }
+
+  if (dims_[static_cast<int32_t>(FeatureHead::kMfcc)] > 0) {
+    KNF_CHECK_LE(opts_.num_ceps, num_bins)
+        << "num-ceps cannot be larger than num-mel-bins.";
+    dct_matrix_ = ComputeDctMatrix(opts_.num_ceps, num_bins);
+    if (opts_.cepstral_lifter != 0.0) {
+      lifter_coeffs_ = std::vector<float>(opts_.num_ceps);
+      ComputeLifterCoeffs(opts_.cepstral_lifter, &lifter_coeffs_);
+    }
+  }
+}
+
+int32_t MultiFeatureComputer::HeadOffset(FeatureHead head) const {
+  int32_t h = static_cast<int32_t>(head);
+  return (h >= 0 && h < kNumHeads) ? offsets_[h] : -1;
+}
+
+int32_t MultiFeatureComputer::HeadDim(FeatureHead head) const {
+  int32_t h = static_cast<int32_t>(head);
+  return (h >= 0 && h < kNumHeads) ? dims_[h] : 0;
+}
+
+void MultiFeatureComputer::Compute(float signal_raw_log_energy,
+                                   float vtln_warp,
+                                   float *signal_frame, float *feature) {
+  KNF_CHECK_EQ(vtln_warp, 1.0f) << "VTLN is not supported";
+  int32_t padded_size = opts_.frame_opts.PaddedWindowSize();
+
+  // Energy after the window function (not the raw one).
+  if (need_energy_ && !opts_.raw_energy) {
+    signal_raw_log_energy = std::log(
+        std::max<float>(InnerProduct(signal_frame, signal_frame, padded_size),
+                        std::numeric_limits<float>::epsilon()));
+  }
+
+  {
+    KNF_STATS_SCOPE(kFft);
+    rfft_.Compute(signal_frame);  // signal_frame is modified in-place
+  }
+  {
+    KNF_STATS_SCOPE(kPowerSpectrum);
+    ComputePowerSpectrum(signal_frame, padded_size);
+  }
+
+  const int32_t *offsets = offsets_;
+  const int32_t *dims = dims_;
+  auto offset_of = [offsets](FeatureHead head) {
+    return offsets[static_cast<int32_t>(head)];
+  };
+  auto dim_of = [dims](FeatureHead head) {
+    return dims[static_cast<int32_t>(head)];
+  };
+
+  if (dim_of(FeatureHead::kPowerSpectrum) > 0) {
+    KNF_STATS_SCOPE(kCopy);
+    std::copy(signal_frame,
+              signal_frame + dim_of(FeatureHead::kPowerSpectrum),
+              feature + offset_of(FeatureHead::kPowerSpectrum));
+  }
+
+  if (need_mel_) {
+    int32_t num_bins = opts_.mel_opts.num_bins;
+    {
+      KNF_STATS_SCOPE(kMel);
+      mel_banks_->Compute(signal_frame, log_mel_.data());
+    }
+
+    KNF_STATS_SCOPE(kLog);
+    // Avoid log of zero (which should be prevented anyway by dithering).
+    for (int32_t i = 0; i != num_bins; ++i) {
+      auto t = std::max(log_mel_[i], std::numeric_limits<float>::epsilon());
+      log_mel_[i] = std::log(t);
+    }
+
+    if (dim_of(FeatureHead::kLogFbank) > 0) {
+      std::copy(log_mel_.begin(), log_mel_.end(),
+                feature + offset_of(FeatureHead::kLogFbank));
+    }
+
+    if (dim_of(FeatureHead::kMfcc) > 0) {
+      float *ceps = feature + offset_of(FeatureHead::kMfcc);
+      for (int32_t i = 0; i != opts_.num_ceps; ++i) {
+        ceps[i] = InnerProduct(dct_matrix_.data() + i * num_bins,
+                               log_mel_.data(), num_bins);
+      }
+      if (opts_.cepstral_lifter != 0.0) {
+        for (int32_t i = 0; i != opts_.num_ceps; ++i) {
+          ceps[i] *= lifter_coeffs_[i];
+        }
+      }
+    }
+  }
+
+  if (need_energy_) {
+    if (opts_.energy_floor > 0.0 && signal_raw_log_energy < log_energy_floor_) {
+      signal_raw_log_energy = log_energy_floor_;
+    }
+    feature[offset_of(FeatureHead::kLogEnergy)] = signal_raw_log_energy;
+  }
+}
+
+}  // namespace knf
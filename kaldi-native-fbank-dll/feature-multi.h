@@ -0,0 +1,148 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_MULTI_H_
+#define KALDI_NATIVE_FBANK_CSRC_FEATURE_MULTI_H_
+
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "feature-window.h"
+#include "mel-computations.h"
+#include "rfft.h"
+
+namespace knf {
+
+// One output of MultiFeatureComputer
+enum class FeatureHead : int32_t {
+  // log mel filter bank energies, mel_opts.num_bins values; the same as
+  // FbankComputer with use_energy == false
+  kLogFbank = 0,
+  // num_ceps cepstra with C0 (not energy) first, i.e. MfccComputer with
+  // use_energy == false, computed from the same mel bins as kLogFbank
+  kMfcc = 1,
+  // power spectrum, PaddedWindowSize() / 2 + 1 values
+  kPowerSpectrum = 2,
+  // one value, the log energy of the frame; see raw_energy
+  kLogEnergy = 3,
+};
+
+struct MultiFeatureOptions {
+  FrameExtractionOptions frame_opts;
+  MelBanksOptions mel_opts;
+
+  // Outputs, in the order they appear in each row. Each head may appear
+  // at most once.
+  std::vector<FeatureHead> heads = {FeatureHead::kLogFbank};
+
+  // kMfcc: number of cepstra (including C0) and the liftering constant
+  int32_t num_ceps = 13;
+  float cepstral_lifter = 22.0;
+
+  // kLogEnergy: if true, compute the energy before preemphasis and
+  // windowing, as Kaldi does by default
+  bool raw_energy = true;
+  float energy_floor = 0.0f;
+
+  MultiFeatureOptions() { mel_opts.num_bins = 80; }
+
+  std::string ToString() const {
+    std::ostringstream os;
+    os << "frame_opts: \n";
+    os << frame_opts << "\n";
+    os << "mel_opts: \n";
+    os << mel_opts << "\n";
+    os << "heads:";
+    for (auto h : heads) {
+      os << " " << static_cast<int32_t>(h);
+    }
+    os << "\n";
+    os << "num_ceps: " << num_ceps << "\n";
+    os << "cepstral_lifter: " << cepstral_lifter << "\n";
+    os << "raw_energy: " << raw_energy << "\n";
+    os << "energy_floor: " << energy_floor << "\n";
+    return os.str();
+  }
+};
+
+// Computes several features of a frame from one window extraction and one
+// FFT. Each output row is the concatenation of the heads in
+// opts.heads order; use HeadOffset() and HeadDim() to split it.
+//
+// It has the same interface as FbankComputer, so it can be used with
+// OnlineGenericBaseFeature.
+class MultiFeatureComputer {
+ public:
+  using Options = MultiFeatureOptions;
+
+  explicit MultiFeatureComputer(const MultiFeatureOptions &opts);
+
+  int32_t Dim() const { return dim_; }
+
+  // Offset of head in an output row, or -1 if it is not computed
+  int32_t HeadOffset(FeatureHead head) const;
+
+  // Number of values head has in an output row (0 if it is not computed)
+  int32_t HeadDim(FeatureHead head) const;
+
+  bool NeedRawLogEnergy() const { return need_energy_ && opts_.raw_energy; }
+
+  const FrameExtractionOptions &GetFrameOptions() const {
+    return opts_.frame_opts;
+  }
+
+  const MultiFeatureOptions &GetOptions() const { return opts_; }
+
+  // See FbankComputer::Compute(). vtln_warp must be 1.0.
+  void Compute(float signal_raw_log_energy, float vtln_warp,
+               std::vector<float> *signal_frame, float *feature) {
+    KNF_CHECK_EQ(signal_frame->size(), opts_.frame_opts.PaddedWindowSize());
+    Compute(signal_raw_log_energy, vtln_warp, signal_frame->data(), feature);
+  }
+
+  // The same as above with signal_frame pointing to
+  // GetFrameOptions().PaddedWindowSize() values, which need not be in a
+  // std::vector, e.g., a row of a batch matrix
+  void Compute(float signal_raw_log_energy, float vtln_warp,
+               float *signal_frame, float *feature);
+
+ private:
+  static constexpr int32_t kNumHeads = 4;
+
+  MultiFeatureOptions opts_;
+  int32_t dim_ = 0;
+  int32_t offsets_[kNumHeads];
+  int32_t dims_[kNumHeads];
+
+  bool need_energy_ = false;
+  bool need_mel_ = false;
+  float log_energy_floor_ = 0;
+
+  Rfft rfft_;
+  const MelBanks *mel_banks_ = nullptr;  // shared, see GetSharedMelBanks()
+  std::vector<float> log_mel_;      // workspace, mel_opts.num_bins
+  std::vector<float> dct_matrix_;   // [num_ceps][num_bins]
+  std::vector<float> lifter_coeffs_;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FEATURE_MULTI_H_
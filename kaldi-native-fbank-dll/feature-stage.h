@@ -0,0 +1,60 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_STAGE_H_
+#define KALDI_NATIVE_FBANK_CSRC_FEATURE_STAGE_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace knf {
+
+// A streaming post-processing step between the feature computer and the
+// frame store of OnlineGenericBaseFeature, e.g. frame stacking,
+// normalization or deltas. See OnlineGenericBaseFeature::AddStage().
+//
+// A stage may hold frames back until it has enough right context, and may
+// output fewer (or more) frames than it receives, but it must output them
+// in order.
+class OnlineFeatureStage {
+ public:
+  virtual ~OnlineFeatureStage() = default;
+
+  // Number of floats per input frame
+  virtual int32_t InputDim() const = 0;
+
+  // Number of floats per output frame
+  virtual int32_t Dim() const = 0;
+
+  // Number of input frames a frame waits for before it is output, i.e.
+  // the latency this stage adds.
+  virtual int32_t Latency() const { return 0; }
+
+  // Process num_frames input frames, stored row major in in, and append
+  // every output frame that is now complete to out.
+  //
+  // If input_finished is true, no more input follows and every frame held
+  // back must be output. It is called with input_finished == true exactly
+  // once, possibly with num_frames == 0.
+  virtual void Process(const float *in, int32_t num_frames,
+                       bool input_finished, std::vector<float> *out) = 0;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FEATURE_STAGE_H_
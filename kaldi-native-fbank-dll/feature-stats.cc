@@ -0,0 +1,175 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "feature-stats.h"
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+#include <vector>
+
+namespace knf {
+
+namespace {
+
+// All live collectors, plus what destroyed or reset ones have counted
+struct Registry {
+  std::mutex mutex;
+  std::vector<FeatureStatsCollector *> collectors;
+  FeatureStats retired;
+};
+
+Registry &GetRegistry() {
+  static Registry *registry = new Registry;  // never destroyed
+  return *registry;
+}
+
+thread_local FeatureStatsCollector *current_collector = nullptr;
+
+int32_t Bucket(int64_t ns) {
+  int32_t bucket = 0;
+  while (ns > 1 && bucket < kNumStatsBuckets - 1) {
+    ns >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+void Accumulate(const FeatureStats &src, FeatureStats *dst) {
+  dst->num_frames += src.num_frames;
+  for (int32_t s = 0; s != kNumFeatureStages; ++s) {
+    const StageStats &a = src.stages[s];
+    StageStats &b = dst->stages[s];
+    b.count += a.count;
+    b.total_ns += a.total_ns;
+    b.max_ns = std::max(b.max_ns, a.max_ns);
+    for (int32_t i = 0; i != kNumStatsBuckets; ++i) {
+      b.histogram[i] += a.histogram[i];
+    }
+  }
+}
+
+}  // namespace
+
+bool FeatureStatsEnabled() {
+#if KNF_ENABLE_STATS
+  return true;
+#else
+  return false;
+#endif
+}
+
+FeatureStatsCollector::FeatureStatsCollector() {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.collectors.push_back(this);
+}
+
+FeatureStatsCollector::~FeatureStatsCollector() {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto &v = registry.collectors;
+  v.erase(std::remove(v.begin(), v.end(), this), v.end());
+  TakeInto(&registry.retired);
+}
+
+void FeatureStatsCollector::Add(FeatureStage stage, int64_t ns) {
+  Counters &c = stages_[static_cast<int32_t>(stage)];
+  c.count.fetch_add(1, std::memory_order_relaxed);
+  c.total_ns.fetch_add(ns, std::memory_order_relaxed);
+  c.histogram[Bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+
+  int64_t max_ns = c.max_ns.load(std::memory_order_relaxed);
+  while (ns > max_ns && !c.max_ns.compare_exchange_weak(
+                            max_ns, ns, std::memory_order_relaxed)) {
+  }
+}
+
+FeatureStats FeatureStatsCollector::Get() const {
+  FeatureStats stats;
+  stats.num_frames = num_frames_.load(std::memory_order_relaxed);
+  for (int32_t s = 0; s != kNumFeatureStages; ++s) {
+    const Counters &c = stages_[s];
+    StageStats &out = stats.stages[s];
+    out.count = c.count.load(std::memory_order_relaxed);
+    out.total_ns = c.total_ns.load(std::memory_order_relaxed);
+    out.max_ns = c.max_ns.load(std::memory_order_relaxed);
+    for (int32_t i = 0; i != kNumStatsBuckets; ++i) {
+      out.histogram[i] = c.histogram[i].load(std::memory_order_relaxed);
+    }
+  }
+  return stats;
+}
+
+void FeatureStatsCollector::TakeInto(FeatureStats *out) {
+  // exchange() so that nothing added concurrently is lost
+  FeatureStats stats;
+  stats.num_frames = num_frames_.exchange(0, std::memory_order_relaxed);
+  for (int32_t s = 0; s != kNumFeatureStages; ++s) {
+    Counters &c = stages_[s];
+    StageStats &taken = stats.stages[s];
+    taken.count = c.count.exchange(0, std::memory_order_relaxed);
+    taken.total_ns = c.total_ns.exchange(0, std::memory_order_relaxed);
+    taken.max_ns = c.max_ns.exchange(0, std::memory_order_relaxed);
+    for (int32_t i = 0; i != kNumStatsBuckets; ++i) {
+      taken.histogram[i] = c.histogram[i].exchange(0, std::memory_order_relaxed);
+    }
+  }
+  Accumulate(stats, out);
+}
+
+void FeatureStatsCollector::Reset() {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  TakeInto(&registry.retired);
+}
+
+FeatureStats FeatureStatsCollector::GetGlobal() {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  FeatureStats stats = registry.retired;
+  for (const FeatureStatsCollector *collector : registry.collectors) {
+    Accumulate(collector->Get(), &stats);
+  }
+  return stats;
+}
+
+void FeatureStatsCollector::ResetGlobal() {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  FeatureStats discarded;
+  for (FeatureStatsCollector *collector : registry.collectors) {
+    collector->TakeInto(&discarded);
+  }
+  registry.retired = FeatureStats();
+}
+
+FeatureStatsCollector *FeatureStatsCollector::Current() {
+  return current_collector;
+}
+
+ScopedStatsCollector::ScopedStatsCollector(FeatureStatsCollector *collector)
+    : previous_(current_collector) {
+  current_collector = collector;
+}
+
+ScopedStatsCollector::~ScopedStatsCollector() {
+  current_collector = previous_;
+}
+
+}  // namespace knf
@@ -0,0 +1,174 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Optional per-stage timing of feature extraction.
+//
+// Build with KNF_ENABLE_STATS=1 (cmake -DKALDI_NATIVE_FBANK_ENABLE_STATS=ON,
+// or add it to the preprocessor definitions of the Visual Studio project)
+// to enable it. Otherwise KNF_STATS_SCOPE() expands to nothing and the
+// feature classes carry no collector, so the hot path is unchanged.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_STATS_H_
+#define KALDI_NATIVE_FBANK_CSRC_FEATURE_STATS_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+
+namespace knf {
+
+enum class FeatureStage : int32_t {
+  kWindow = 0,         // ExtractWindow(): dither, dc removal, preemph, window
+  kFft = 1,            // real FFT
+  kPowerSpectrum = 2,  // power (or magnitude) spectrum
+  kMel = 3,            // mel filter banks
+  kLog = 4,            // log, and for MFCC the DCT and liftering
+  kCopy = 5,           // copying computed frames out to the frames callback
+};
+
+constexpr int32_t kNumFeatureStages = 6;
+
+// Bucket i of a histogram counts calls that took [2^i, 2^(i+1)) ns;
+// bucket 0 also counts calls that took less than 1 ns.
+constexpr int32_t kNumStatsBuckets = 32;
+
+struct StageStats {
+  int64_t count = 0;  // number of timed calls
+  int64_t total_ns = 0;
+  int64_t max_ns = 0;
+  int64_t histogram[kNumStatsBuckets] = {};
+};
+
+struct FeatureStats {
+  int64_t num_frames = 0;
+  StageStats stages[kNumFeatureStages];
+};
+
+// True if the library was built with KNF_ENABLE_STATS
+bool FeatureStatsEnabled();
+
+// Accumulates the stage timings of one stream.
+//
+// Only the thread that computes features adds to it; any thread may call
+// Get() or Reset(). Every collector also contributes to a process-wide
+// aggregate, see GetGlobal().
+class FeatureStatsCollector {
+ public:
+  FeatureStatsCollector();
+  ~FeatureStatsCollector();
+
+  FeatureStatsCollector(const FeatureStatsCollector &) = delete;
+  FeatureStatsCollector &operator=(const FeatureStatsCollector &) = delete;
+
+  void Add(FeatureStage stage, int64_t ns);
+  void AddFrames(int32_t n) {
+    num_frames_.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  FeatureStats Get() const;
+
+  // Zero the counters of this stream. The process-wide aggregate keeps
+  // what was counted so far.
+  void Reset();
+
+  // Sum over all collectors, including the ones already destroyed
+  static FeatureStats GetGlobal();
+
+  // Zero the aggregate and the counters of every live stream
+  static void ResetGlobal();
+
+  // The collector that KNF_STATS_SCOPE() charges on this thread, or nullptr
+  static FeatureStatsCollector *Current();
+
+ private:
+  struct Counters {
+    std::atomic<int64_t> count{0};
+    std::atomic<int64_t> total_ns{0};
+    std::atomic<int64_t> max_ns{0};
+    std::atomic<int64_t> histogram[kNumStatsBuckets] = {};
+  };
+
+  // Move the counters into out (adding to it) and zero them
+  void TakeInto(FeatureStats *out);
+
+  Counters stages_[kNumFeatureStages];
+  std::atomic<int64_t> num_frames_{0};
+};
+
+// Make a collector the current one of this thread while in scope
+class ScopedStatsCollector {
+ public:
+  explicit ScopedStatsCollector(FeatureStatsCollector *collector);
+  ~ScopedStatsCollector();
+
+  ScopedStatsCollector(const ScopedStatsCollector &) = delete;
+  ScopedStatsCollector &operator=(const ScopedStatsCollector &) = delete;
+
+ private:
+  FeatureStatsCollector *previous_;
+};
+
+// Charge the time until the end of the enclosing scope to a stage of the
+// current collector. Does nothing if there is none.
+class StageTimer {
+ public:
+  explicit StageTimer(FeatureStage stage)
+      : collector_(FeatureStatsCollector::Current()), stage_(stage) {
+    if (collector_ != nullptr) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~StageTimer() {
+    if (collector_ != nullptr) {
+      auto elapsed = std::chrono::steady_clock::now() - start_;
+      collector_->Add(
+          stage_,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+              .count());
+    }
+  }
+
+  StageTimer(const StageTimer &) = delete;
+  StageTimer &operator=(const StageTimer &) = delete;
+
+ private:
+  FeatureStatsCollector *collector_;
+  FeatureStage stage_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace knf
+
+#if KNF_ENABLE_STATS
+
+#define KNF_STATS_CONCAT_IMPL(a, b) a##b
+#define KNF_STATS_CONCAT(a, b) KNF_STATS_CONCAT_IMPL(a, b)
+
+// e.g., KNF_STATS_SCOPE(kFft);
+#define KNF_STATS_SCOPE(stage)                                   \
+  ::knf::StageTimer KNF_STATS_CONCAT(knf_stage_timer_, __LINE__)( \
+      ::knf::FeatureStage::stage)
+
+#else
+
+#define KNF_STATS_SCOPE(stage)
+
+#endif  // KNF_ENABLE_STATS
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FEATURE_STATS_H_
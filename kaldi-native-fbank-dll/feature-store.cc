@@ -0,0 +1,214 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "feature-store.h"
+
+#include <cstring>
+#include <utility>
+
+namespace knf {
+
+namespace {
+
+constexpr char kMagic[8] = {'K', 'N', 'F', 'S', 'T', 'O', 'R', 'E'};
+constexpr uint32_t kVersion = 1;
+constexpr int64_t kHeaderSize = 64;
+constexpr int64_t kAlignment = 64;
+
+// offset, rows, cols, fingerprint and key length
+constexpr size_t kEntryFixedSize = 8 + 4 + 4 + 8 + 4;
+
+template <typename T>
+void Append(T value, std::string *out) {
+  out->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+T Load(const uint8_t *p) {
+  T value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::string Header(uint32_t num_utts, uint64_t index_offset,
+                   uint64_t index_size) {
+  std::string header(kMagic, sizeof(kMagic));
+  Append(kVersion, &header);
+  Append(num_utts, &header);
+  Append(index_offset, &header);
+  Append(index_size, &header);
+  header.resize(kHeaderSize, '\0');
+  return header;
+}
+
+}  // namespace
+
+bool FeatureStoreWriter::Open(const std::string &filename) {
+  Close();
+  entries_.clear();
+  keys_.clear();
+  os_.open(filename, std::ios::binary | std::ios::trunc);
+  if (!os_.is_open()) {
+    return false;
+  }
+  // a placeholder until Close() knows where the index is
+  std::string header = Header(0, 0, 0);
+  os_.write(header.data(), header.size());
+  offset_ = kHeaderSize;
+  ok_ = static_cast<bool>(os_);
+  return ok_;
+}
+
+bool FeatureStoreWriter::Write(const std::string &key, const float *data,
+                               int32_t rows, int32_t cols,
+                               uint64_t fingerprint) {
+  if (!os_.is_open() || rows <= 0 || cols <= 0 || keys_.count(key) != 0) {
+    return false;
+  }
+  int64_t padding = (kAlignment - offset_ % kAlignment) % kAlignment;
+  static const char zeros[kAlignment] = {};
+  os_.write(zeros, padding);
+  offset_ += padding;
+
+  FeatureStoreEntry entry;
+  entry.key = key;
+  entry.offset = offset_;
+  entry.rows = rows;
+  entry.cols = cols;
+  entry.fingerprint = fingerprint;
+
+  int64_t size = static_cast<int64_t>(rows) * cols * sizeof(float);
+  os_.write(reinterpret_cast<const char *>(data), size);
+  offset_ += size;
+  if (!os_) {
+    ok_ = false;
+    return false;
+  }
+  keys_[key] = static_cast<int32_t>(entries_.size());
+  entries_.push_back(std::move(entry));
+  return true;
+}
+
+bool FeatureStoreWriter::Close() {
+  if (!os_.is_open()) {
+    return false;
+  }
+  std::string index;
+  for (const auto &e : entries_) {
+    Append(static_cast<uint64_t>(e.offset), &index);
+    Append(e.rows, &index);
+    Append(e.cols, &index);
+    Append(e.fingerprint, &index);
+    Append(static_cast<uint32_t>(e.key.size()), &index);
+    index.append(e.key);
+  }
+  os_.write(index.data(), index.size());
+  std::string header = Header(static_cast<uint32_t>(entries_.size()),
+                              static_cast<uint64_t>(offset_), index.size());
+  os_.seekp(0);
+  os_.write(header.data(), header.size());
+  os_.close();
+  bool ok = ok_ && !os_.fail();
+  ok_ = false;
+  entries_.clear();
+  keys_.clear();
+  return ok;
+}
+
+bool FeatureStoreReader::Open(const std::string &filename) {
+  Close();
+  if (!file_.Open(filename) || file_.Size() < kHeaderSize) {
+    Close();
+    return false;
+  }
+  data_ = file_.MapAll();
+  int64_t file_size = file_.Size();
+  if (data_ == nullptr || std::memcmp(data_, kMagic, sizeof(kMagic)) != 0 ||
+      Load<uint32_t>(data_ + 8) != kVersion) {
+    Close();
+    return false;
+  }
+  uint32_t num_utts = Load<uint32_t>(data_ + 12);
+  uint64_t index_offset = Load<uint64_t>(data_ + 16);
+  uint64_t index_size = Load<uint64_t>(data_ + 24);
+  if (index_offset < static_cast<uint64_t>(kHeaderSize) ||
+      index_offset > static_cast<uint64_t>(file_size) ||
+      index_size > static_cast<uint64_t>(file_size) - index_offset) {
+    Close();
+    return false;
+  }
+
+  const uint8_t *p = data_ + index_offset;
+  const uint8_t *end = p + index_size;
+  entries_.reserve(num_utts);
+  for (uint32_t i = 0; i != num_utts; ++i) {
+    if (static_cast<size_t>(end - p) < kEntryFixedSize) {
+      Close();
+      return false;
+    }
+    FeatureStoreEntry e;
+    e.offset = static_cast<int64_t>(Load<uint64_t>(p));
+    e.rows = Load<int32_t>(p + 8);
+    e.cols = Load<int32_t>(p + 12);
+    e.fingerprint = Load<uint64_t>(p + 16);
+    uint32_t key_size = Load<uint32_t>(p + 24);
+    p += kEntryFixedSize;
+    if (static_cast<size_t>(end - p) < key_size || e.rows <= 0 ||
+        e.cols <= 0 || e.offset < kHeaderSize ||
+        e.offset % kAlignment != 0 ||
+        static_cast<uint64_t>(e.offset) +
+                static_cast<uint64_t>(e.rows) * e.cols * sizeof(float) >
+            index_offset) {
+      Close();
+      return false;
+    }
+    e.key.assign(reinterpret_cast<const char *>(p), key_size);
+    p += key_size;
+    keys_.emplace(e.key, static_cast<int32_t>(entries_.size()));
+    entries_.push_back(std::move(e));
+  }
+  return true;
+}
+
+void FeatureStoreReader::Close() {
+  file_.Close();
+  data_ = nullptr;
+  entries_.clear();
+  keys_.clear();
+}
+
+int32_t FeatureStoreReader::Find(const std::string &key) const {
+  auto it = keys_.find(key);
+  return it == keys_.end() ? -1 : it->second;
+}
+
+const float *FeatureStoreReader::Frames(int32_t index, int32_t begin,
+                                        int32_t end) const {
+  if (index < 0 || index >= NumUtterances()) {
+    return nullptr;
+  }
+  const FeatureStoreEntry &e = entries_[index];
+  if (begin < 0 || begin >= end || end > e.rows) {
+    return nullptr;
+  }
+  return reinterpret_cast<const float *>(
+      data_ + e.offset + static_cast<int64_t>(begin) * e.cols * sizeof(float));
+}
+
+}  // namespace knf
@@ -0,0 +1,132 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// An indexed file of feature matrices for random-access reads, e.g. by
+// training data loaders, which Kaldi archives only allow after a scan or
+// through an scp. Layout (all integers little-endian):
+//
+//   header, 64 bytes:
+//     "KNFSTORE"  magic
+//     uint32      version (1)
+//     uint32      number of utterances
+//     uint64      offset of the index
+//     uint64      size of the index in bytes
+//     zeros
+//   data: one row-major float matrix per utterance, each starting at a
+//     multiple of 64 bytes
+//   index, one entry per utterance, in the order they were written:
+//     uint64      offset of the data
+//     int32       rows (frames)
+//     int32       cols (feature dim)
+//     uint64      fingerprint of the options, see OptionsFingerprint()
+//     uint32      key length, followed by the key
+//
+// The index is written last, so a store is written in one pass without
+// knowing the utterances in advance. FeatureStoreReader maps the file and
+// returns pointers into the mapping, without copying.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_STORE_H_
+#define KALDI_NATIVE_FBANK_CSRC_FEATURE_STORE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped-file.h"
+
+namespace knf {
+
+struct FeatureStoreEntry {
+  std::string key;
+  int64_t offset = 0;  // of the data, in bytes
+  int32_t rows = 0;
+  int32_t cols = 0;
+  uint64_t fingerprint = 0;
+};
+
+class FeatureStoreWriter {
+ public:
+  FeatureStoreWriter() = default;
+  ~FeatureStoreWriter() { Close(); }
+
+  FeatureStoreWriter(const FeatureStoreWriter &) = delete;
+  FeatureStoreWriter &operator=(const FeatureStoreWriter &) = delete;
+
+  // Returns false if the file cannot be created
+  bool Open(const std::string &filename);
+
+  // Append the rows x cols row-major matrix data as utterance key. Returns
+  // false if the key was already written, the matrix is empty, or on a
+  // write error.
+  bool Write(const std::string &key, const float *data, int32_t rows,
+             int32_t cols, uint64_t fingerprint);
+
+  // Write the index and the header. Returns false if the store is not
+  // complete, e.g. the disk is full. Nothing can be written afterwards.
+  bool Close();
+
+  bool IsOpen() const { return os_.is_open(); }
+
+ private:
+  std::ofstream os_;
+  int64_t offset_ = 0;  // the current end of the file
+  bool ok_ = false;
+  std::vector<FeatureStoreEntry> entries_;
+  std::unordered_map<std::string, int32_t> keys_;
+};
+
+class FeatureStoreReader {
+ public:
+  // Returns false if the file cannot be read or is not a valid store
+  bool Open(const std::string &filename);
+  void Close();
+
+  int32_t NumUtterances() const {
+    return static_cast<int32_t>(entries_.size());
+  }
+
+  // Utterances in the order they were written
+  const FeatureStoreEntry &Entry(int32_t index) const {
+    return entries_[index];
+  }
+
+  // Index of the utterance key, -1 if there is none
+  int32_t Find(const std::string &key) const;
+
+  // Frames [begin, end) of an utterance, row major; the pointer is into the
+  // mapped file, 4-byte aligned (64-byte at frame 0), and valid until
+  // Close(). Returns nullptr if the range is not inside the utterance.
+  const float *Frames(int32_t index, int32_t begin, int32_t end) const;
+
+  // All frames of an utterance
+  const float *Data(int32_t index) const {
+    return Frames(index, 0, entries_[index].rows);
+  }
+
+ private:
+  MappedFile file_;
+  const uint8_t *data_ = nullptr;  // the whole file
+  std::vector<FeatureStoreEntry> entries_;
+  std::unordered_map<std::string, int32_t> keys_;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FEATURE_STORE_H_
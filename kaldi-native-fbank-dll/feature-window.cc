@@ -8,7 +8,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <tuple>
 #include <vector>
 
 #ifndef M_2PI
@@ -22,41 +26,188 @@ std::ostream &operator<<(std::ostream &os, const FrameExtractionOptions &opts) {
   return os;
 }
 
+namespace {
+
+struct WindowTypeInfo {
+  WindowType type;
+  const char *name;
+};
+
+const WindowTypeInfo kWindowTypes[] = {
+    {WindowType::kHanning, "hanning"},
+    {WindowType::kSine, "sine"},
+    {WindowType::kHamming, "hamming"},
+    {WindowType::kPovey, "povey"},
+    {WindowType::kRectangular, "rectangular"},
+    {WindowType::kBlackman, "blackman"},
+    {WindowType::kKaiser, "kaiser"},
+};
+
+const char kPeriodicSuffix[] = "_periodic";
+
+struct WindowKey {
+  WindowType type;
+  bool periodic;
+  int32_t length;
+  float coeff;
+
+  bool operator<(const WindowKey &other) const {
+    return std::tie(type, periodic, length, coeff) <
+           std::tie(other.type, other.periodic, other.length, other.coeff);
+  }
+};
+
+struct WindowTable {
+  std::vector<float> storage;
+  float *data = nullptr;  // 64-byte aligned, inside storage
+};
+
+}  // namespace
+
+bool ParseWindowType(const std::string &name, WindowType *type,
+                     bool *periodic) {
+  const size_t suffix_len = sizeof(kPeriodicSuffix) - 1;
+  bool is_periodic = name.size() > suffix_len &&
+                     name.compare(name.size() - suffix_len, suffix_len,
+                                  kPeriodicSuffix) == 0;
+  std::string base =
+      is_periodic ? name.substr(0, name.size() - suffix_len) : name;
+
+  for (const auto &info : kWindowTypes) {
+    if (base == info.name) {
+      *type = info.type;
+      *periodic = is_periodic;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string WindowTypeName(WindowType type, bool periodic) {
+  for (const auto &info : kWindowTypes) {
+    if (info.type == type) {
+      return periodic ? std::string(info.name) + kPeriodicSuffix : info.name;
+    }
+  }
+  return {};
+}
+
+// Modified Bessel function of the first kind, order 0, by its power series
+static double BesselI0(double x) {
+  double q = x * x / 4;
+  double term = 1;
+  double sum = 1;
+  for (int32_t k = 1; k != 1000; ++k) {
+    term *= q / (static_cast<double>(k) * k);
+    sum += term;
+    if (term < sum * 1e-17) break;
+  }
+  return sum;
+}
+
+static void ComputeWindow(WindowType type, bool periodic, int32_t length,
+                          float coeff, float *window_data) {
+  // The symmetric window spans [0, length - 1], the periodic one [0, length]
+  int32_t span = periodic ? length : length - 1;
+
+  double a = M_2PI / span;
+  double kaiser_norm = 0;
+  if (type == WindowType::kKaiser) {
+    kaiser_norm = BesselI0(coeff);
+  }
+
+  for (int32_t i = 0; i < length; i++) {
+    double i_fl = static_cast<double>(i);
+    switch (type) {
+      case WindowType::kHanning:
+        window_data[i] = 0.5 - 0.5 * cos(a * i_fl);
+        break;
+      case WindowType::kSine:
+        // when you are checking ws wikipedia, please
+        // note that 0.5 * a = M_PI/(frame_length-1)
+        window_data[i] = sin(0.5 * a * i_fl);
+        break;
+      case WindowType::kHamming:
+        window_data[i] = 0.54 - 0.46 * cos(a * i_fl);
+        break;
+      case WindowType::kPovey:
+        // like hamming but goes to zero at edges.
+        window_data[i] = pow(0.5 - 0.5 * cos(a * i_fl), 0.85);
+        break;
+      case WindowType::kRectangular:
+        window_data[i] = 1.0;
+        break;
+      case WindowType::kBlackman:
+        window_data[i] = coeff - 0.5 * cos(a * i_fl) +
+                         (0.5 - coeff) * cos(2 * a * i_fl);
+        break;
+      case WindowType::kKaiser: {
+        double r = span > 0 ? 2 * i_fl / span - 1 : 0;
+        window_data[i] =
+            BesselI0(coeff * std::sqrt(std::max(0.0, 1 - r * r))) /
+            kaiser_norm;
+        break;
+      }
+    }
+  }
+}
+
+const float *GetSharedWindow(WindowType type, bool periodic, int32_t length,
+                             float coeff) {
+  if (type != WindowType::kBlackman && type != WindowType::kKaiser) {
+    coeff = 0;
+  }
+  WindowKey key{type, periodic, length, coeff};
+
+  static std::mutex mutex;
+  static std::map<WindowKey, WindowTable> tables;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto iter = tables.find(key);
+  if (iter != tables.end()) {
+    return iter->second.data;
+  }
+
+  WindowTable &table = tables[key];
+  constexpr size_t kAlign = 64 / sizeof(float);
+  table.storage.resize(length + kAlign);
+  uintptr_t p = reinterpret_cast<uintptr_t>(table.storage.data());
+  table.data = table.storage.data() + ((64 - p % 64) % 64) / sizeof(float);
+  ComputeWindow(type, periodic, length, coeff, table.data);
+  return table.data;
+}
+
 FeatureWindowFunction::FeatureWindowFunction(const FrameExtractionOptions &opts)
-    : window_(opts.WindowSize()) {
+    : window_size_(opts.WindowSize()) {
   int32_t frame_length = opts.WindowSize();
   KNF_CHECK_GT(frame_length, 0);
 
-  float *window_data = window_.data();
+  WindowType type;
+  bool periodic;
+  if (!ParseWindowType(opts.window_type, &type, &periodic)) {
+    KNF_LOG(FATAL) << "Invalid window type " << opts.window_type;
+  }
 
-  double a = M_2PI / (frame_length - 1);
-  for (int32_t i = 0; i < frame_length; i++) {
-    double i_fl = static_cast<double>(i);
-    if (opts.window_type == "hanning") {
-      window_data[i] = 0.5 - 0.5 * cos(a * i_fl);
-    } else if (opts.window_type == "sine") {
-      // when you are checking ws wikipedia, please
-      // note that 0.5 * a = M_PI/(frame_length-1)
-      window_data[i] = sin(0.5 * a * i_fl);
-    } else if (opts.window_type == "hamming") {
-      window_data[i] = 0.54 - 0.46 * cos(a * i_fl);
-    } else if (opts.window_type ==
-               "povey") {  // like hamming but goes to zero at edges.
-      window_data[i] = pow(0.5 - 0.5 * cos(a * i_fl), 0.85);
-    } else if (opts.window_type == "rectangular") {
-      window_data[i] = 1.0;
-    } else if (opts.window_type == "blackman") {
-      window_data[i] = opts.blackman_coeff - 0.5 * cos(a * i_fl) +
-                       (0.5 - opts.blackman_coeff) * cos(2 * a * i_fl);
-    } else {
-      KNF_LOG(FATAL) << "Invalid window type " << opts.window_type;
-    }
+  float coeff = type == WindowType::kKaiser ? opts.kaiser_beta
+                                            : opts.blackman_coeff;
+  window_ = GetSharedWindow(type, periodic, frame_length, coeff);
+}
+
+// Apply() with the window length fixed at compile time
+template <int32_t kWindowLen>
+static void ApplyFixed(const float *window, float *wave) {
+  for (int32_t k = 0; k != kWindowLen; ++k) {
+    wave[k] *= window[k];
   }
 }
 
 void FeatureWindowFunction::Apply(float *wave) const {
-  int32_t window_size = window_.size();
-  const float *p = window_.data();
+  int32_t window_size = window_size_;
+  const float *p = window_;
+  if (window_size == 400) {  // 25 ms at 16 kHz, also whisper
+    ApplyFixed<400>(p, wave);
+    return;
+  }
   for (int32_t k = 0; k != window_size; ++k) {
     wave[k] *= p[k];
   }
@@ -122,13 +273,29 @@ void ExtractWindow(int64_t sample_offset, const std::vector<float> &wave,
                    int32_t f, const FrameExtractionOptions &opts,
                    const FeatureWindowFunction &window_function,
                    std::vector<float> *window,
-                   float *log_energy_pre_window /*= nullptr*/) {
-  KNF_CHECK(sample_offset >= 0 && wave.size() != 0);
+                   float *log_energy_pre_window /*= nullptr*/,
+                   float *zero_crossing_rate /*= nullptr*/) {
+  int32_t frame_length_padded = opts.PaddedWindowSize();
+  if (window->size() != frame_length_padded) {
+    window->resize(frame_length_padded);
+  }
+
+  ExtractWindow(sample_offset, wave.data(), static_cast<int32_t>(wave.size()),
+                f, opts, window_function, window->data(),
+                log_energy_pre_window, zero_crossing_rate);
+}
+
+void ExtractWindow(int64_t sample_offset, const float *wave, int32_t wave_size,
+                   int32_t f, const FrameExtractionOptions &opts,
+                   const FeatureWindowFunction &window_function, float *window,
+                   float *log_energy_pre_window /*= nullptr*/,
+                   float *zero_crossing_rate /*= nullptr*/) {
+  KNF_CHECK(sample_offset >= 0 && wave_size != 0);
 
   int32_t frame_length = opts.WindowSize();
   int32_t frame_length_padded = opts.PaddedWindowSize();
 
-  int64_t num_samples = sample_offset + wave.size();
+  int64_t num_samples = sample_offset + wave_size;
   int64_t start_sample = FirstSampleOfFrame(f, opts);
   int64_t end_sample = start_sample + frame_length;
 
@@ -138,24 +305,19 @@ void ExtractWindow(int64_t sample_offset, const std::vector<float> &wave,
     KNF_CHECK(sample_offset == 0 || start_sample >= sample_offset);
   }
 
-  if (window->size() != frame_length_padded) {
-    window->resize(frame_length_padded);
-  }
-
   // wave_start and wave_end are start and end indexes into 'wave', for the
   // piece of wave that we're trying to extract.
   int32_t wave_start = int32_t(start_sample - sample_offset);
   int32_t wave_end = wave_start + frame_length;
 
-  if (wave_start >= 0 && wave_end <= wave.size()) {
+  if (wave_start >= 0 && wave_end <= wave_size) {
     // the normal case-- no edge effects to consider.
-    std::copy(wave.begin() + wave_start,
-              wave.begin() + wave_start + frame_length, window->data());
+    std::copy(wave + wave_start, wave + wave_start + frame_length, window);
   } else {
     // Deal with any end effects by reflection, if needed.  This code will only
     // be reached for about two frames per utterance, so we don't concern
     // ourselves excessively with efficiency.
-    int32_t wave_dim = wave.size();
+    int32_t wave_dim = wave_size;
     for (int32_t s = 0; s < frame_length; ++s) {
       int32_t s_in_wave = s + wave_start;
       while (s_in_wave < 0 || s_in_wave >= wave_dim) {
@@ -169,11 +331,16 @@ void ExtractWindow(int64_t sample_offset, const std::vector<float> &wave,
         else
           s_in_wave = 2 * wave_dim - 1 - s_in_wave;
       }
-      (*window)[s] = wave[s_in_wave];
+      window[s] = wave[s_in_wave];
     }
   }
 
-  ProcessWindow(opts, window_function, window->data(), log_energy_pre_window);
+  if (frame_length_padded > frame_length) {
+    std::fill(window + frame_length, window + frame_length_padded, 0.0f);
+  }
+
+  ProcessWindow(opts, window_function, window, log_energy_pre_window,
+                zero_crossing_rate);
 }
 
 static void RemoveDcOffset(float *d, int32_t n) {
@@ -212,7 +379,8 @@ static void Preemphasize(float *d, int32_t n, float preemph_coeff) {
 
 void ProcessWindow(const FrameExtractionOptions &opts,
                    const FeatureWindowFunction &window_function, float *window,
-                   float *log_energy_pre_window /*= nullptr*/) {
+                   float *log_energy_pre_window /*= nullptr*/,
+                   float *zero_crossing_rate /*= nullptr*/) {
   int32_t frame_length = opts.WindowSize();
 
   if (opts.remove_dc_offset) {
@@ -225,6 +393,16 @@ void ProcessWindow(const FrameExtractionOptions &opts,
     *log_energy_pre_window = std::log(energy);
   }
 
+  if (zero_crossing_rate != nullptr) {
+    int32_t crossings = 0;
+    for (int32_t i = 1; i < frame_length; ++i) {
+      crossings += (window[i - 1] < 0) != (window[i] < 0);
+    }
+    *zero_crossing_rate =
+        frame_length > 1 ? static_cast<float>(crossings) / (frame_length - 1)
+                         : 0.0f;
+  }
+
   if (opts.preemph_coeff != 0.0) {
     Preemphasize(window, frame_length, opts.preemph_coeff);
   }
@@ -7,6 +7,7 @@
 #ifndef KALDI_NATIVE_FBANK_CSRC_FEATURE_WINDOW_H_
 #define KALDI_NATIVE_FBANK_CSRC_FEATURE_WINDOW_H_
 
+#include <cstdint>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -35,15 +36,17 @@ struct FrameExtractionOptions {
   float preemph_coeff = 0.97f;    // Preemphasis coefficient.
   bool remove_dc_offset = true;   // Subtract mean of wave before FFT.
   std::string window_type = "povey";  // e.g. Hamming window
-  // May be "hamming", "rectangular", "povey", "hanning", "sine", "blackman"
+  // May be "hamming", "rectangular", "povey", "hanning", "sine", "blackman",
+  // "kaiser", each optionally with a "_periodic" suffix; see WindowType.
   // "povey" is a window I made to be similar to Hamming but to go to zero at
   // the edges, it's pow((0.5 - 0.5*cos(n/N*2*pi)), 0.85) I just don't think the
   // Hamming window makes sense as a windowing function.
   bool round_to_power_of_two = true;
   float blackman_coeff = 0.42f;
+  float kaiser_beta = 12.0f;  // shape of the "kaiser" window, as in torch
   bool snip_edges = true;
-  // bool allow_downsample = false;
-  // bool allow_upsample = false;
+  bool allow_downsample = false;
+  bool allow_upsample = false;
 
   int32_t WindowShift() const {
     return static_cast<int32_t>(samp_freq * 0.001f * frame_shift_ms);
@@ -67,9 +70,10 @@ struct FrameExtractionOptions {
     KNF_PRINT(window_type);
     KNF_PRINT(round_to_power_of_two);
     KNF_PRINT(blackman_coeff);
+    KNF_PRINT(kaiser_beta);
     KNF_PRINT(snip_edges);
-    // KNF_PRINT(allow_downsample);
-    // KNF_PRINT(allow_upsample);
+    KNF_PRINT(allow_downsample);
+    KNF_PRINT(allow_upsample);
 #undef KNF_PRINT
     return os.str();
   }
@@ -77,6 +81,41 @@ struct FrameExtractionOptions {
 
 std::ostream &operator<<(std::ostream &os, const FrameExtractionOptions &opts);
 
+// The window functions, by the names used in
+// FrameExtractionOptions::window_type. Each has a symmetric form, Kaldi's,
+// which is the default, and a periodic one, selected with a "_periodic"
+// suffix, e.g., "hanning_periodic" for torch.hann_window(n) as used by
+// torch.stft. The periodic window of length n is the symmetric window of
+// length n + 1 without its last sample.
+enum class WindowType : int32_t {
+  kHanning = 0,
+  kSine = 1,
+  kHamming = 2,
+  kPovey = 3,
+  kRectangular = 4,
+  kBlackman = 5,  // uses blackman_coeff
+  kKaiser = 6,    // uses kaiser_beta
+};
+
+// Returns false if name is not a known window type
+bool ParseWindowType(const std::string &name, WindowType *type,
+                     bool *periodic);
+
+// The inverse of ParseWindowType(); empty for an unknown type
+std::string WindowTypeName(WindowType type, bool periodic);
+
+/**
+   Returns a window of `length` samples, computed on the first call for this
+   (type, periodic, length, coeff) and shared by every later caller in the
+   process. The table is 64-byte aligned and stays valid until the process
+   exits.
+
+   @param coeff blackman_coeff for kBlackman, kaiser_beta for kKaiser; ignored
+                otherwise.
+ */
+const float *GetSharedWindow(WindowType type, bool periodic, int32_t length,
+                             float coeff);
+
 class FeatureWindowFunction {
  public:
   FeatureWindowFunction() = default;
@@ -89,7 +128,9 @@ class FeatureWindowFunction {
   void Apply(float *wave) const;
 
  private:
-  std::vector<float> window_;  // of size opts.WindowSize()
+  // shared, see GetSharedWindow(); of size opts.WindowSize()
+  const float *window_ = nullptr;
+  int32_t window_size_ = 0;
 };
 
 int64_t FirstSampleOfFrame(int32_t frame, const FrameExtractionOptions &opts);
@@ -136,12 +177,27 @@ int32_t NumFrames(int64_t num_samples, const FrameExtractionOptions &opts,
   @param [out] log_energy_pre_window  If non-NULL, the log-energy of
                    the signal prior to pre-emphasis and multiplying by
                    the windowing function will be written to here.
+  @param [out] zero_crossing_rate  If non-NULL, see ProcessWindow().
 */
 void ExtractWindow(int64_t sample_offset, const std::vector<float> &wave,
                    int32_t f, const FrameExtractionOptions &opts,
                    const FeatureWindowFunction &window_function,
                    std::vector<float> *window,
-                   float *log_energy_pre_window = nullptr);
+                   float *log_energy_pre_window = nullptr,
+                   float *zero_crossing_rate = nullptr);
+
+/*
+  The same as above, for a waveform of wave_size samples and a window in
+  memory owned by the caller, e.g. one row of a batch matrix.
+
+  @param [out] window  opts.PaddedWindowSize() values. The padding after the
+                   first opts.WindowSize() values is set to zero.
+*/
+void ExtractWindow(int64_t sample_offset, const float *wave, int32_t wave_size,
+                   int32_t f, const FrameExtractionOptions &opts,
+                   const FeatureWindowFunction &window_function, float *window,
+                   float *log_energy_pre_window = nullptr,
+                   float *zero_crossing_rate = nullptr);
 
 /**
   This function does all the windowing steps after actually
@@ -159,10 +215,14 @@ void ExtractWindow(int64_t sample_offset, const std::vector<float> &wave,
    @param [out]   log_energy_pre_window If non-NULL, then after dithering and
       DC offset removal, this function will write to this pointer the log of
       the total energy (i.e. sum-squared) of the frame.
+   @param [out]   zero_crossing_rate If non-NULL, the fraction of adjacent
+      samples with a different sign, at the same point as
+      log_energy_pre_window.
  */
 void ProcessWindow(const FrameExtractionOptions &opts,
                    const FeatureWindowFunction &window_function, float *window,
-                   float *log_energy_pre_window = nullptr);
+                   float *log_energy_pre_window = nullptr,
+                   float *zero_crossing_rate = nullptr);
 
 // Compute the inner product of two vectors
 float InnerProduct(const float *a, const float *b, int32_t n);
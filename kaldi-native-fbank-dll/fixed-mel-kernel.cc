@@ -0,0 +1,87 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "fixed-mel-kernel.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace knf {
+
+template <int32_t kFftSize, int32_t kNumBins>
+static std::unique_ptr<MelKernel> MaybeCreate(int32_t fft_size,
+                                              const MelBanks &banks) {
+  if (fft_size != kFftSize || banks.NumBins() != kNumBins) {
+    return nullptr;
+  }
+
+  // The kernel assumes every bin lies inside the kFftSize/2+1 fft bins
+  constexpr int32_t kNumFftBins = kFftSize / 2 + 1;
+  for (const auto &b : banks.GetBins()) {
+    if (b.first < 0 ||
+        b.first + static_cast<int32_t>(b.second.size()) > kNumFftBins) {
+      return nullptr;
+    }
+  }
+
+  return std::make_unique<FixedMelKernel<kFftSize, kNumBins>>(banks);
+}
+
+static std::unique_ptr<MelKernel> CreateFixedMelKernel(int32_t fft_size,
+                                                       const MelBanks &banks) {
+  std::unique_ptr<MelKernel> kernel;
+  if ((kernel = MaybeCreate<512, 80>(fft_size, banks)) ||
+      (kernel = MaybeCreate<400, 80>(fft_size, banks)) ||
+      (kernel = MaybeCreate<400, 128>(fft_size, banks))) {
+    return kernel;
+  }
+
+  return nullptr;
+}
+
+static std::atomic<bool> fixed_kernels_enabled{true};
+
+void SetFixedKernelsEnabled(bool enabled) { fixed_kernels_enabled = enabled; }
+
+bool FixedKernelsEnabled() { return fixed_kernels_enabled; }
+
+const MelKernel *GetSharedMelKernel(const MelBanksOptions &opts,
+                                    int32_t fft_size, const MelBanks *banks) {
+  if (opts.htk_mode || opts.debug_mel || !FixedKernelsEnabled()) {
+    return nullptr;
+  }
+
+  // banks are shared and never freed, so their address identifies them
+  static std::mutex mutex;
+  static std::map<std::pair<const MelBanks *, int32_t>,
+                  std::unique_ptr<MelKernel>>
+      kernels;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto key = std::make_pair(banks, fft_size);
+  auto iter = kernels.find(key);
+  if (iter == kernels.end()) {
+    iter = kernels.emplace(key, CreateFixedMelKernel(fft_size, *banks)).first;
+  }
+  return iter->second.get();
+}
+
+}  // namespace knf
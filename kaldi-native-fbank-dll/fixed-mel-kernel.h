@@ -0,0 +1,162 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Spectrum-to-mel kernels with the FFT size and the number of mel bins fixed
+// at compile time, for the configurations that carry almost all traffic:
+//
+//   - kaldi fbank, 16 kHz, 25 ms / 10 ms, 512-point FFT, 80 bins
+//   - whisper, 400-point FFT, 80 or 128 bins
+//
+// FbankComputer and WhisperFeatureComputer pick one up in their constructor
+// via GetSharedMelKernel() and fall back to MelBanks when it returns
+// nullptr. The results are bit-identical to the generic path, which
+// SetFixedKernelsEnabled(false) selects for comparison.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FIXED_MEL_KERNEL_H_
+#define KALDI_NATIVE_FBANK_CSRC_FIXED_MEL_KERNEL_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include "mel-computations.h"
+
+namespace knf {
+
+class MelKernel {
+ public:
+  virtual ~MelKernel() = default;
+
+  virtual int32_t FftSize() const = 0;
+  virtual int32_t NumBins() const = 0;
+
+  // Same as MelBanks::Compute()
+  //
+  // @param power_spectrum 1-D array of size FftSize()/2+1
+  // @param mel_energies_out 1-D array of size NumBins()
+  virtual void Compute(const float *power_spectrum,
+                       float *mel_energies_out) const = 0;
+
+  // Same as ComputePowerSpectrum(), followed by a sqrt if !use_power
+  //
+  // @param rfft_out The output of Rfft::Compute(), FftSize() values. On
+  //                 return its first FftSize()/2+1 values are the power (or
+  //                 magnitude) spectrum.
+  virtual void ComputePowerSpectrum(float *rfft_out, bool use_power) const = 0;
+
+  // Replace each of the NumBins() values by log(max(x, epsilon))
+  virtual void ApplyLog(float *mel_energies) const = 0;
+};
+
+template <int32_t kFftSize, int32_t kNumBins>
+class FixedMelKernel : public MelKernel {
+ public:
+  static constexpr int32_t kNumFftBins = kFftSize / 2 + 1;
+
+  // banks.NumBins() must be kNumBins and its weights must not extend past
+  // kNumFftBins
+  explicit FixedMelKernel(const MelBanks &banks) {
+    const auto &bins = banks.GetBins();
+    int32_t total = 0;
+    for (int32_t i = 0; i != kNumBins; ++i) {
+      offset_[i] = bins[i].first;
+      size_[i] = static_cast<int32_t>(bins[i].second.size());
+      begin_[i] = total;
+      total += size_[i];
+    }
+    weights_.reset(new float[total > 0 ? total : 1]);
+    for (int32_t i = 0; i != kNumBins; ++i) {
+      std::copy(bins[i].second.begin(), bins[i].second.end(),
+                weights_.get() + begin_[i]);
+    }
+  }
+
+  int32_t FftSize() const override { return kFftSize; }
+  int32_t NumBins() const override { return kNumBins; }
+
+  void Compute(const float *power_spectrum,
+               float *mel_energies_out) const override {
+    const float *w = weights_.get();
+    for (int32_t i = 0; i != kNumBins; ++i) {
+      const float *p = power_spectrum + offset_[i];
+      const float *v = w + begin_[i];
+      int32_t n = size_[i];
+      float energy = 0;
+      for (int32_t k = 0; k != n; ++k) {
+        energy += v[k] * p[k];
+      }
+      mel_energies_out[i] = energy;
+    }
+  }
+
+  void ComputePowerSpectrum(float *rfft_out, bool use_power) const override {
+    // See ComputePowerSpectrum() in feature-functions.h for the layout
+    float *p = rfft_out;
+    float first_energy = p[0] * p[0];
+    float last_energy = p[1] * p[1];
+    for (int32_t i = 1; i != kFftSize / 2; ++i) {
+      float real = p[i * 2];
+      float im = p[i * 2 + 1];
+      p[i] = real * real + im * im;
+    }
+    p[0] = first_energy;
+    p[kFftSize / 2] = last_energy;
+
+    if (!use_power) {
+      for (int32_t i = 0; i != kNumFftBins; ++i) {
+        p[i] = std::sqrt(p[i]);
+      }
+    }
+  }
+
+  void ApplyLog(float *mel_energies) const override {
+    for (int32_t i = 0; i != kNumBins; ++i) {
+      auto t = std::max(mel_energies[i], std::numeric_limits<float>::epsilon());
+      mel_energies[i] = std::log(t);
+    }
+  }
+
+ private:
+  // bin i uses weights_[begin_[i], begin_[i] + size_[i]) on the fft bins
+  // starting at offset_[i]
+  int32_t offset_[kNumBins];
+  int32_t size_[kNumBins];
+  int32_t begin_[kNumBins];
+  std::unique_ptr<float[]> weights_;
+};
+
+// Returns a FixedMelKernel for (fft_size, banks->NumBins()) if that
+// configuration is compiled in, and nullptr otherwise, e.g., for htk_mode or
+// debug_mel, which only MelBanks supports.
+//
+// banks must come from GetSharedMelBanks(). The kernel is built once for
+// them and shared the same way, read-only, until the process exits.
+const MelKernel *GetSharedMelKernel(const MelBanksOptions &opts,
+                                    int32_t fft_size, const MelBanks *banks);
+
+// Whether computers created from now on use the compiled-in kernels,
+// including FixedFft in WhisperFeatureComputer. They are on by default;
+// tests turn them off to get the generic path for the same options.
+void SetFixedKernelsEnabled(bool enabled);
+bool FixedKernelsEnabled();
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FIXED_MEL_KERNEL_H_
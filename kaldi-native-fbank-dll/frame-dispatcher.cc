@@ -0,0 +1,88 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "frame-dispatcher.h"
+
+#include <utility>
+#include <vector>
+
+namespace knf {
+
+FrameDispatcher::FrameDispatcher(int32_t dim, FramesReadyCallback callback)
+    : dim_(dim), callback_(std::move(callback)) {
+  worker_ = std::thread(&FrameDispatcher::Run, this);
+}
+
+FrameDispatcher::~FrameDispatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  worker_.join();
+}
+
+void FrameDispatcher::Post(const float *frames, int32_t num_frames,
+                           int32_t first_frame) {
+  if (num_frames <= 0) {
+    return;
+  }
+
+  Block block;
+  block.frames.assign(frames, frames + num_frames * dim_);
+  block.num_frames = num_frames;
+  block.first_frame = first_frame;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(std::move(block));
+  }
+  cond_.notify_all();
+}
+
+void FrameDispatcher::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this] { return pending_.empty() && !busy_; });
+}
+
+void FrameDispatcher::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      // stop_ is set and everything has been delivered
+      break;
+    }
+
+    Block block = std::move(pending_.front());
+    pending_.pop_front();
+    busy_ = true;
+
+    // Run the callback without holding the lock so that Post() never
+    // waits for the consumer.
+    lock.unlock();
+    callback_(block.frames.data(), block.num_frames, block.first_frame);
+    lock.lock();
+
+    busy_ = false;
+    cond_.notify_all();
+  }
+}
+
+}  // namespace knf
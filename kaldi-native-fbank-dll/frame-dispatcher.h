@@ -0,0 +1,86 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_FRAME_DISPATCHER_H_
+#define KALDI_NATIVE_FBANK_CSRC_FRAME_DISPATCHER_H_
+
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace knf {
+
+// Receives a contiguous block of feature frames.
+//
+// @param frames Pointer to a 2-D array of shape [num_frames][dim], row major.
+//               It is only valid for the duration of the call.
+// @param num_frames Number of rows in frames.
+// @param first_frame Index of the first row, as returned by NumFramesReady()
+//                    before these frames were computed.
+using FramesReadyCallback = std::function<void(
+    const float *frames, int32_t num_frames, int32_t first_frame)>;
+
+// FrameDispatcher runs a FramesReadyCallback on its own worker thread.
+//
+// Post() copies the block and returns immediately, so the thread that
+// computes features never waits for the consumer. Blocks are delivered
+// in the order they were posted.
+class FrameDispatcher {
+ public:
+  // @param dim Number of floats per frame.
+  FrameDispatcher(int32_t dim, FramesReadyCallback callback);
+
+  // Delivers all pending blocks before joining the worker thread.
+  ~FrameDispatcher();
+
+  FrameDispatcher(const FrameDispatcher &) = delete;
+  FrameDispatcher &operator=(const FrameDispatcher &) = delete;
+
+  void Post(const float *frames, int32_t num_frames, int32_t first_frame);
+
+  // Block until every block posted so far has been delivered.
+  void Flush();
+
+ private:
+  struct Block {
+    std::vector<float> frames;
+    int32_t num_frames;
+    int32_t first_frame;
+  };
+
+  void Run();
+
+  int32_t dim_;
+  FramesReadyCallback callback_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Block> pending_;
+  bool busy_ = false;
+  bool stop_ = false;
+
+  std::thread worker_;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_FRAME_DISPATCHER_H_
@@ -0,0 +1,158 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "hash.h"
+
+#include <cstring>
+
+namespace knf {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t Read64(const uint8_t *p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t Read32(const uint8_t *p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t Round(uint64_t acc, uint64_t input) {
+  acc += input * kPrime2;
+  acc = Rotl(acc, 31);
+  return acc * kPrime1;
+}
+
+inline uint64_t MergeRound(uint64_t acc, uint64_t val) {
+  acc ^= Round(0, val);
+  return acc * kPrime1 + kPrime4;
+}
+
+// Process the 32-byte stripes of [p, p + size); returns the end of the last
+// full stripe
+const uint8_t *Stripes(const uint8_t *p, size_t size, uint64_t v[4]) {
+  const uint8_t *end = p + size / 32 * 32;
+  while (p != end) {
+    v[0] = Round(v[0], Read64(p));
+    v[1] = Round(v[1], Read64(p + 8));
+    v[2] = Round(v[2], Read64(p + 16));
+    v[3] = Round(v[3], Read64(p + 24));
+    p += 32;
+  }
+  return p;
+}
+
+// The tail of fewer than 32 bytes and the avalanche
+uint64_t Finalize(uint64_t h, const uint8_t *p, size_t len) {
+  while (len >= 8) {
+    h ^= Round(0, Read64(p));
+    h = Rotl(h, 27) * kPrime1 + kPrime4;
+    p += 8;
+    len -= 8;
+  }
+  if (len >= 4) {
+    h ^= static_cast<uint64_t>(Read32(p)) * kPrime1;
+    h = Rotl(h, 23) * kPrime2 + kPrime3;
+    p += 4;
+    len -= 4;
+  }
+  while (len > 0) {
+    h ^= (*p) * kPrime5;
+    h = Rotl(h, 11) * kPrime1;
+    ++p;
+    --len;
+  }
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+uint64_t Converge(const uint64_t v[4]) {
+  uint64_t h = Rotl(v[0], 1) + Rotl(v[1], 7) + Rotl(v[2], 12) + Rotl(v[3], 18);
+  h = MergeRound(h, v[0]);
+  h = MergeRound(h, v[1]);
+  h = MergeRound(h, v[2]);
+  return MergeRound(h, v[3]);
+}
+
+}  // namespace
+
+uint64_t Hash64(const void *data, size_t size, uint64_t seed) {
+  Hasher64 hasher(seed);
+  hasher.Update(data, size);
+  return hasher.Digest();
+}
+
+void Hasher64::Reset(uint64_t seed) {
+  seed_ = seed;
+  v_[0] = seed + kPrime1 + kPrime2;
+  v_[1] = seed + kPrime2;
+  v_[2] = seed;
+  v_[3] = seed - kPrime1;
+  total_ = 0;
+  buffered_ = 0;
+}
+
+void Hasher64::Update(const void *data, size_t size) {
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  total_ += size;
+  if (buffered_ + size < 32) {
+    if (size != 0) {
+      std::memcpy(buffer_ + buffered_, p, size);
+    }
+    buffered_ += size;
+    return;
+  }
+  if (buffered_ != 0) {
+    size_t fill = 32 - buffered_;
+    std::memcpy(buffer_ + buffered_, p, fill);
+    Stripes(buffer_, 32, v_);
+    p += fill;
+    size -= fill;
+    buffered_ = 0;
+  }
+  const uint8_t *rest = Stripes(p, size, v_);
+  buffered_ = size - (rest - p);
+  if (buffered_ != 0) {
+    std::memcpy(buffer_, rest, buffered_);
+  }
+}
+
+uint64_t Hasher64::Digest() const {
+  uint64_t h = total_ >= 32 ? Converge(v_) : seed_ + kPrime5;
+  h += total_;
+  return Finalize(h, buffer_, buffered_);
+}
+
+}  // namespace knf
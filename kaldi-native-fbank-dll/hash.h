@@ -0,0 +1,62 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Fast non-cryptographic hashing, for fingerprints of feature options and
+// of audio. Hash64() is the XXH64 algorithm of xxHash
+// (https://github.com/Cyan4973/xxHash), so values can be checked against
+// any xxHash implementation; it runs at several GB/s and is little-endian
+// only, like the rest of the library's file formats.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_HASH_H_
+#define KALDI_NATIVE_FBANK_CSRC_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace knf {
+
+uint64_t Hash64(const void *data, size_t size, uint64_t seed = 0);
+
+// Fingerprint of the canonical description of a set of options, i.e. the
+// output of their ToString(); equal options give equal fingerprints.
+inline uint64_t OptionsFingerprint(const std::string &options) {
+  return Hash64(options.data(), options.size());
+}
+
+// Hash64() of data given in pieces, e.g. audio as it arrives. The result is
+// the same as for the concatenation of the pieces.
+class Hasher64 {
+ public:
+  explicit Hasher64(uint64_t seed = 0) { Reset(seed); }
+
+  void Reset(uint64_t seed = 0);
+  void Update(const void *data, size_t size);
+  uint64_t Digest() const;
+
+ private:
+  uint64_t v_[4];
+  uint64_t seed_;
+  uint64_t total_ = 0;
+  uint8_t buffer_[32];
+  size_t buffered_ = 0;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_HASH_H_
@@ -0,0 +1,264 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Micro-benchmarks of every stage of the feature pipeline, and end-to-end
+// streaming benchmarks of the online extractors.
+//
+// Build with -DKALDI_NATIVE_FBANK_BUILD_BENCHMARKS=ON, then e.g.
+//
+//   ./kaldi-native-fbank-bench --benchmark_filter=Online
+//
+// The end-to-end benchmarks report
+//   - rtf: CPU seconds per second of audio, on one core
+//   - frames_per_second: frames computed per CPU second, on one core
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "feature-fbank.h"
+#include "feature-functions.h"
+#include "feature-mfcc.h"
+#include "feature-window.h"
+#include "kaldi-math.h"
+#include "mel-computations.h"
+#include "online-feature.h"
+#include "rfft.h"
+#include "whisper-feature.h"
+
+namespace knf {
+
+static constexpr float kSampleRate = 16000;
+
+// A few tones plus low-level noise, in the range of 16-bit samples;
+// the same for every run.
+static std::vector<float> MakeWaveform(int32_t num_samples) {
+  std::mt19937 gen(20260101);
+  std::normal_distribution<float> noise(0, 30);
+
+  std::vector<float> samples(num_samples);
+  for (int32_t i = 0; i != num_samples; ++i) {
+    float t = i / kSampleRate;
+    samples[i] = 3000 * std::sin(2 * M_PI * 220 * t) +
+                 1500 * std::sin(2 * M_PI * 1250 * t) +
+                 500 * std::sin(2 * M_PI * 3400 * t) + noise(gen);
+  }
+  return samples;
+}
+
+static FrameExtractionOptions BenchFrameOptions() {
+  FrameExtractionOptions opts;
+  opts.dither = 0;
+  opts.samp_freq = kSampleRate;
+  return opts;
+}
+
+static void BM_ExtractWindow(benchmark::State &state) {
+  FrameExtractionOptions opts = BenchFrameOptions();
+  FeatureWindowFunction window_function(opts);
+  std::vector<float> wave = MakeWaveform(static_cast<int32_t>(kSampleRate));
+  int32_t num_frames = NumFrames(wave.size(), opts);
+
+  std::vector<float> window;
+  float log_energy = 0;
+  int32_t f = 0;
+  for (auto _ : state) {
+    ExtractWindow(0, wave, f, opts, window_function, &window, &log_energy);
+    benchmark::DoNotOptimize(window.data());
+    f = (f + 1) % num_frames;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ExtractWindow);
+
+static void BM_ProcessWindow(benchmark::State &state) {
+  FrameExtractionOptions opts = BenchFrameOptions();
+  FeatureWindowFunction window_function(opts);
+  std::vector<float> frame = MakeWaveform(opts.WindowSize());
+
+  std::vector<float> window(opts.WindowSize());
+  float log_energy = 0;
+  for (auto _ : state) {
+    // ProcessWindow() works in place; the copy is small next to it
+    std::copy(frame.begin(), frame.end(), window.begin());
+    ProcessWindow(opts, window_function, window.data(), &log_energy);
+    benchmark::DoNotOptimize(window.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProcessWindow);
+
+// Arg: FFT size
+static void BM_Rfft(benchmark::State &state) {
+  int32_t n = static_cast<int32_t>(state.range(0));
+  Rfft rfft(n);
+  std::vector<float> input = MakeWaveform(n);
+
+  std::vector<float> buf(n);
+  for (auto _ : state) {
+    std::copy(input.begin(), input.end(), buf.begin());
+    rfft.Compute(buf.data());
+    benchmark::DoNotOptimize(buf.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Rfft)->RangeMultiplier(2)->Range(256, 2048);
+
+// Arg: FFT size
+static void BM_ComputePowerSpectrum(benchmark::State &state) {
+  int32_t n = static_cast<int32_t>(state.range(0));
+  Rfft rfft(n);
+  std::vector<float> fft = MakeWaveform(n);
+  rfft.Compute(fft.data());
+
+  std::vector<float> buf(n);
+  for (auto _ : state) {
+    std::copy(fft.begin(), fft.end(), buf.begin());
+    ComputePowerSpectrum(&buf);
+    benchmark::DoNotOptimize(buf.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ComputePowerSpectrum)->Arg(512);
+
+// Arg: number of mel bins
+static void BM_MelBanksCompute(benchmark::State &state) {
+  FrameExtractionOptions frame_opts = BenchFrameOptions();
+  MelBanksOptions mel_opts;
+  mel_opts.num_bins = static_cast<int32_t>(state.range(0));
+  if (mel_opts.num_bins > 80) {
+    // The lowest of that many bins are narrower than a bin of a 512-point
+    // FFT; 50 ms frames are padded to 1024 points.
+    frame_opts.frame_length_ms = 50;
+  }
+  MelBanks mel_banks(mel_opts, frame_opts, 1.0f);
+
+  int32_t n = frame_opts.PaddedWindowSize();
+  std::vector<float> power = MakeWaveform(n);
+  for (auto &p : power) {
+    p = p * p;
+  }
+
+  std::vector<float> mel(mel_opts.num_bins);
+  for (auto _ : state) {
+    mel_banks.Compute(power.data(), mel.data());
+    benchmark::DoNotOptimize(mel.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MelBanksCompute)->Arg(23)->Arg(80)->Arg(128);
+
+// Args: number of cepstra, number of mel bins. Same loop as
+// MfccComputer::Compute().
+static void BM_MfccDct(benchmark::State &state) {
+  int32_t num_ceps = static_cast<int32_t>(state.range(0));
+  int32_t num_bins = static_cast<int32_t>(state.range(1));
+  std::vector<float> dct_matrix = ComputeDctMatrix(num_ceps, num_bins);
+  std::vector<float> log_mel = MakeWaveform(num_bins);
+
+  std::vector<float> feature(num_ceps);
+  for (auto _ : state) {
+    for (int32_t i = 0; i != num_ceps; ++i) {
+      feature[i] = InnerProduct(dct_matrix.data() + i * num_bins,
+                                log_mel.data(), num_bins);
+    }
+    benchmark::DoNotOptimize(feature.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MfccDct)->Args({13, 23})->Args({40, 40})->Args({80, 80});
+
+// Arg: number of rows (frames) converted at once
+static void BM_WhisperConvert(benchmark::State &state) {
+  int32_t rows = static_cast<int32_t>(state.range(0));
+  WhisperFeatureComputer computer;
+  int32_t cols = computer.Dim();
+  std::vector<float> mel = MakeWaveform(rows * cols);
+  for (auto &m : mel) {
+    m = std::abs(m);
+  }
+
+  std::vector<float> out(mel.size());
+  for (auto _ : state) {
+    computer.Convert(mel.data(), rows, cols, out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_WhisperConvert)->Arg(1)->Arg(3000);
+
+// Feed 10 seconds of audio in chunks of state.range(0) samples, as a
+// streaming client would, then flush.
+template <class F, class Options>
+static void RunOnline(benchmark::State &state, const Options &opts) {
+  int32_t chunk_size = static_cast<int32_t>(state.range(0));
+  std::vector<float> wave =
+      MakeWaveform(10 * static_cast<int32_t>(kSampleRate));
+  int32_t num_samples = static_cast<int32_t>(wave.size());
+
+  int64_t num_frames = 0;
+  for (auto _ : state) {
+    F feature(opts);
+    for (int32_t i = 0; i < num_samples; i += chunk_size) {
+      int32_t n = std::min(chunk_size, num_samples - i);
+      feature.AcceptWaveform(kSampleRate, wave.data() + i, n);
+    }
+    feature.InputFinished();
+    num_frames += feature.NumFramesReady();
+    benchmark::DoNotOptimize(feature.GetFrame(feature.NumFramesReady() - 1));
+  }
+
+  double audio_seconds = state.iterations() * (num_samples / kSampleRate);
+  state.counters["rtf"] = benchmark::Counter(
+      audio_seconds, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  state.counters["frames_per_second"] = benchmark::Counter(
+      static_cast<double>(num_frames), benchmark::Counter::kIsRate);
+}
+
+static void BM_OnlineFbank(benchmark::State &state) {
+  FbankOptions opts;
+  opts.frame_opts = BenchFrameOptions();
+  opts.mel_opts.num_bins = 80;
+  RunOnline<OnlineFbank>(state, opts);
+}
+
+static void BM_OnlineMfcc(benchmark::State &state) {
+  MfccOptions opts;
+  opts.frame_opts = BenchFrameOptions();
+  RunOnline<OnlineMfcc>(state, opts);
+}
+
+static void BM_OnlineWhisperFbank(benchmark::State &state) {
+  RunOnline<OnlineWhisperFbank>(state, WhisperFeatureOptions());
+}
+
+// chunk sizes: 10 ms, 100 ms, 1 s
+BENCHMARK(BM_OnlineFbank)->Arg(160)->Arg(1600)->Arg(16000)->Unit(
+    benchmark::kMillisecond);
+BENCHMARK(BM_OnlineMfcc)->Arg(160)->Arg(1600)->Arg(16000)->Unit(
+    benchmark::kMillisecond);
+BENCHMARK(BM_OnlineWhisperFbank)->Arg(160)->Arg(1600)->Arg(16000)->Unit(
+    benchmark::kMillisecond);
+
+}  // namespace knf
+
+BENCHMARK_MAIN();
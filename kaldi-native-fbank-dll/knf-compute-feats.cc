@@ -0,0 +1,678 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Batch feature extraction, like Kaldi's compute-fbank-feats and
+// compute-mfcc-feats:
+//
+//   knf-compute-feats [options] <wav.scp> ark,scp:feats.ark,feats.scp
+//   knf-compute-feats [options] <wav.scp> ark:feats.ark
+//   knf-compute-feats [options] <wav.scp> store:feats.knfs
+//
+// Every line of wav.scp is "<utterance-id> <path>", where the path is a WAV
+// file (PCM 16/24 bit or 32-bit float; channels are averaged). The output
+// is a Kaldi binary archive of float matrices, and optionally the scp that
+// indexes it, readable by Kaldi (e.g. copy-feats) and kaldiio. With
+// --compress=true the matrices are stored the way "copy-feats
+// --compress=true" stores them, about 4x smaller. "store:" writes an
+// indexed feature store instead (see feature-store.h), for random access
+// by training data loaders.
+//
+// Utterances are computed by --num-threads workers, each with its own
+// reusable extractor, and written in the order of wav.scp. A summary with
+// the throughput and real-time factor is printed at the end.
+//
+// With --cache-memory-mb or --cache-dir, utterances whose audio was seen
+// before (with the same options) are taken from a FeatureCache instead of
+// being computed again; the cache directory can be kept between runs.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cctype>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "compressed-matrix.h"
+#include "feature-cache.h"
+#include "feature-fbank.h"
+#include "feature-mfcc.h"
+#include "feature-store.h"
+#include "feature-window.h"
+#include "hash.h"
+#include "offline-feature.h"
+#include "resample.h"
+#include "wave-reader.h"
+#include "whisper-feature.h"
+
+namespace knf {
+
+namespace {
+
+struct ComputeFeatsOptions {
+  std::string feature_type = "fbank";  // fbank, mfcc or whisper
+  FbankOptions fbank_opts;
+  MfccOptions mfcc_opts;
+  // number of mel bins of whisper features, 80 or 128
+  int32_t whisper_dim = 80;
+  // "true" or "false" to override the defaults, which differ between fbank
+  // (false) and mfcc (true)
+  std::string use_energy;
+  // scale samples to [-1, 1) instead of the 16-bit range
+  bool normalize = false;
+  int32_t num_threads = 0;  // 0: one per core
+  // write Kaldi compressed matrices; the method is Kaldi's numbering
+  bool compress = false;
+  int32_t compression_method = 1;
+  // feature cache; off if both are unset
+  int32_t cache_memory_mb = 0;
+  std::string cache_dir;
+};
+
+// One per worker, reused for every utterance it processes
+std::unique_ptr<OfflineFeature> CreateExtractor(
+    const ComputeFeatsOptions &opts) {
+  if (opts.feature_type == "fbank") {
+    return std::make_unique<OfflineFbank>(opts.fbank_opts);
+  }
+  if (opts.feature_type == "mfcc") {
+    return std::make_unique<OfflineMfcc>(opts.mfcc_opts);
+  }
+  if (opts.feature_type == "whisper") {
+    WhisperFeatureOptions whisper_opts(opts.fbank_opts.frame_opts,
+                                       opts.whisper_dim);
+    return std::make_unique<OfflineWhisperFbank>(whisper_opts);
+  }
+  return nullptr;
+}
+
+// --name=value command-line options
+class OptionParser {
+ public:
+  void Register(const std::string &name, float *v, const std::string &doc) {
+    Add(name, doc, ToString(*v),
+        [v](const std::string &s) { return ParseFloat(s, v); });
+  }
+  void Register(const std::string &name, int32_t *v, const std::string &doc) {
+    Add(name, doc, ToString(*v), [v](const std::string &s) {
+      float f;
+      if (!ParseFloat(s, &f) || f != static_cast<int32_t>(f)) {
+        return false;
+      }
+      *v = static_cast<int32_t>(f);
+      return true;
+    });
+  }
+  void Register(const std::string &name, bool *v, const std::string &doc) {
+    Add(name, doc, *v ? "true" : "false", [v](const std::string &s) {
+      if (s.empty() || s == "true") {
+        *v = true;
+      } else if (s == "false") {
+        *v = false;
+      } else {
+        return false;
+      }
+      return true;
+    });
+  }
+  void Register(const std::string &name, std::string *v,
+                const std::string &doc) {
+    Add(name, doc, *v, [v](const std::string &s) {
+      *v = s;
+      return true;
+    });
+  }
+
+  // Returns the positional arguments, or false on an unknown or malformed
+  // option
+  bool Parse(int argc, char *argv[], std::vector<std::string> *args) const {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg.compare(0, 2, "--") != 0) {
+        args->push_back(arg);
+        continue;
+      }
+      size_t eq = arg.find('=');
+      std::string name = arg.substr(2, eq == std::string::npos ? eq : eq - 2);
+      std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+      auto it = options_.find(name);
+      if (it == options_.end() || !it->second.set(value)) {
+        fprintf(stderr, "Invalid option %s\n", arg.c_str());
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void PrintUsage(const char *usage) const {
+    fprintf(stderr, "%s\nOptions:\n", usage);
+    for (const auto &p : options_) {
+      fprintf(stderr, "  --%-26s : %s (default: %s)\n", p.first.c_str(),
+              p.second.doc.c_str(), p.second.default_value.c_str());
+    }
+  }
+
+ private:
+  struct Option {
+    std::string doc;
+    std::string default_value;
+    std::function<bool(const std::string &)> set;
+  };
+
+  template <class T>
+  static std::string ToString(T v) {
+    std::ostringstream os;
+    os << v;
+    return os.str();
+  }
+
+  static bool ParseFloat(const std::string &s, float *v) {
+    char *end = nullptr;
+    *v = std::strtof(s.c_str(), &end);
+    return !s.empty() && *end == '\0';
+  }
+
+  void Add(const std::string &name, const std::string &doc,
+           const std::string &default_value,
+           std::function<bool(const std::string &)> set) {
+    options_[name] = Option{doc, default_value, std::move(set)};
+  }
+
+  std::map<std::string, Option> options_;
+};
+
+struct Utterance {
+  std::string key;
+  std::string path;
+
+  // filled in by a worker
+  bool ok = false;
+  std::string error;
+  double duration = 0;  // seconds of audio
+  int32_t num_frames = 0;
+  std::vector<float> feats;
+  // with --compress, the encoded matrix instead of feats
+  std::vector<uint8_t> compressed;
+};
+
+bool ReadScp(const std::string &filename, std::vector<Utterance> *utts) {
+  std::ifstream is(filename);
+  if (!is) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(is, line)) {
+    std::istringstream ss(line);
+    Utterance utt;
+    if (!(ss >> utt.key)) {
+      continue;  // blank line
+    }
+    std::getline(ss >> std::ws, utt.path);
+    // trailing spaces or '\r' of files written on Windows
+    while (!utt.path.empty() && std::isspace(
+                                    static_cast<unsigned char>(utt.path.back()))) {
+      utt.path.pop_back();
+    }
+    utts->push_back(std::move(utt));
+  }
+  return true;
+}
+
+// "ark,scp:a.ark,a.scp", "ark:a.ark" or "store:a.knfs"
+bool ParseWspecifier(const std::string &wspecifier, std::string *ark,
+                     std::string *scp, std::string *store) {
+  size_t colon = wspecifier.find(':');
+  if (colon == std::string::npos) {
+    return false;
+  }
+  std::string type = wspecifier.substr(0, colon);
+  std::string files = wspecifier.substr(colon + 1);
+  ark->clear();
+  scp->clear();
+  store->clear();
+  if (type == "store") {
+    *store = files;
+    return !store->empty();
+  }
+  if (type == "ark") {
+    *ark = files;
+  } else if (type == "ark,scp") {
+    size_t comma = files.find(',');
+    if (comma == std::string::npos) {
+      return false;
+    }
+    *ark = files.substr(0, comma);
+    *scp = files.substr(comma + 1);
+  } else {
+    return false;
+  }
+  return !ark->empty() && (type == "ark" || !scp->empty());
+}
+
+void ProcessUtterance(const ComputeFeatsOptions &opts,
+                      OfflineFeature *extractor, Utterance *utt) {
+  if (!utt->path.empty() && utt->path.back() == '|') {
+    utt->error = "piped commands are not supported";
+    return;
+  }
+  WaveFileReader reader;
+  if (!reader.Open(utt->path)) {
+    utt->error = "cannot read " + utt->path;
+    return;
+  }
+  const WaveInfo &info = reader.Info();
+  std::vector<float> wave(static_cast<size_t>(info.NumFrames()));
+  float scale = opts.normalize ? 1.0f / 32768 : 1.0f;
+  int32_t n = wave.empty() ? 0
+                           : reader.ReadMono(wave.data(),
+                                             static_cast<int32_t>(wave.size()),
+                                             scale);
+  if (n != static_cast<int32_t>(wave.size())) {
+    utt->error = "error reading " + utt->path;
+    return;
+  }
+  utt->duration = static_cast<double>(n) / info.sample_rate;
+
+  const FrameExtractionOptions &frame_opts = extractor->GetFrameOptions();
+  int32_t samp_freq = static_cast<int32_t>(frame_opts.samp_freq);
+  if (info.sample_rate != samp_freq) {
+    bool allowed = info.sample_rate > samp_freq ? frame_opts.allow_downsample
+                                                : frame_opts.allow_upsample;
+    if (!allowed) {
+      std::ostringstream os;
+      os << "sampling rate " << info.sample_rate << " != " << samp_freq
+         << " (see --allow-downsample and --allow-upsample)";
+      utt->error = os.str();
+      return;
+    }
+    // the filter Kaldi's online features use
+    LinearResample resampler(info.sample_rate, samp_freq,
+                             std::min(info.sample_rate, samp_freq) / 2.0f, 6);
+    std::vector<float> resampled;
+    resampler.Resample(wave.data(), static_cast<int32_t>(wave.size()), true,
+                       &resampled);
+    wave.swap(resampled);
+  }
+
+  utt->num_frames = extractor->Compute(wave, &utt->feats);
+  if (utt->num_frames == 0) {
+    utt->error = "the file is too short for a frame";
+    utt->feats.clear();
+    return;
+  }
+  if (opts.compress) {
+    // encoded by the worker, so the writer thread only copies bytes
+    int32_t dim = static_cast<int32_t>(utt->feats.size() / utt->num_frames);
+    if (!CompressMatrix(utt->feats.data(), utt->num_frames, dim,
+                        static_cast<CompressionMethod>(opts.compression_method),
+                        &utt->compressed)) {
+      utt->error = "cannot compress the features (NaN or infinity?)";
+      return;
+    }
+    std::vector<float>().swap(utt->feats);
+  }
+  utt->ok = true;
+}
+
+// Kaldi binary float matrix, as written by Matrix<float>::Write(os, true)
+void WriteKaldiMatrix(std::ostream &os, const float *data, int32_t rows,
+                      int32_t cols) {
+  os.write("\0B", 2);
+  os.write("FM ", 3);
+  char size = sizeof(int32_t);
+  os.put(size);
+  os.write(reinterpret_cast<const char *>(&rows), sizeof(rows));
+  os.put(size);
+  os.write(reinterpret_cast<const char *>(&cols), sizeof(cols));
+  os.write(reinterpret_cast<const char *>(data),
+           static_cast<std::streamsize>(rows) * cols * sizeof(float));
+}
+
+int Run(int argc, char *argv[]) {
+  const char *usage =
+      "Compute fbank, MFCC or whisper features for the files in a wav.scp\n"
+      "and write them as a Kaldi binary archive.\n"
+      "\n"
+      "Usage: knf-compute-feats [options] <wav.scp> <wspecifier>\n"
+      " e.g.: knf-compute-feats --num-mel-bins=80 wav.scp "
+      "ark,scp:feats.ark,feats.scp\n";
+
+  ComputeFeatsOptions opts;
+  FrameExtractionOptions &frame_opts = opts.fbank_opts.frame_opts;
+  MelBanksOptions &mel_opts = opts.fbank_opts.mel_opts;
+
+  OptionParser po;
+  po.Register("feature-type", &opts.feature_type, "fbank, mfcc or whisper");
+  po.Register("sample-frequency", &frame_opts.samp_freq,
+              "Sampling rate of the features");
+  po.Register("frame-shift", &frame_opts.frame_shift_ms,
+              "Frame shift in milliseconds");
+  po.Register("frame-length", &frame_opts.frame_length_ms,
+              "Frame length in milliseconds");
+  po.Register("dither", &frame_opts.dither,
+              "Accepted for compatibility with Kaldi; no dithering is done");
+  po.Register("preemphasis-coefficient", &frame_opts.preemph_coeff,
+              "Coefficient for use in signal preemphasis");
+  po.Register("remove-dc-offset", &frame_opts.remove_dc_offset,
+              "Subtract mean from waveform on each frame");
+  po.Register("window-type", &frame_opts.window_type,
+              "hamming, hanning, povey, rectangular, sine, blackman or "
+              "kaiser; add _periodic for the periodic form, e.g. "
+              "hanning_periodic");
+  po.Register("round-to-power-of-two", &frame_opts.round_to_power_of_two,
+              "Round window size to a power of two for the FFT");
+  po.Register("blackman-coeff", &frame_opts.blackman_coeff,
+              "Constant coefficient in the generalized Blackman window");
+  po.Register("kaiser-beta", &frame_opts.kaiser_beta,
+              "Shape parameter of the Kaiser window");
+  po.Register("snip-edges", &frame_opts.snip_edges,
+              "Only output frames that fit in the file");
+  po.Register("allow-downsample", &frame_opts.allow_downsample,
+              "Resample files with a higher sampling rate");
+  po.Register("allow-upsample", &frame_opts.allow_upsample,
+              "Resample files with a lower sampling rate");
+  po.Register("num-mel-bins", &mel_opts.num_bins,
+              "Number of triangular mel bins (80 or 128 for whisper)");
+  po.Register("low-freq", &mel_opts.low_freq, "Low cutoff of the mel bins");
+  po.Register("high-freq", &mel_opts.high_freq,
+              "High cutoff of the mel bins, <= 0 is relative to Nyquist");
+  po.Register("use-energy", &opts.use_energy,
+              "Add an energy dimension (fbank), or use it instead of C0 "
+              "(mfcc); false for fbank and true for mfcc if not given");
+  po.Register("energy-floor", &opts.fbank_opts.energy_floor,
+              "Floor on the energy");
+  po.Register("raw-energy", &opts.fbank_opts.raw_energy,
+              "Compute the energy before preemphasis and windowing");
+  po.Register("htk-compat", &opts.fbank_opts.htk_compat,
+              "Put the energy last, as HTK does");
+  po.Register("num-ceps", &opts.mfcc_opts.num_ceps,
+              "Number of cepstra (mfcc)");
+  po.Register("cepstral-lifter", &opts.mfcc_opts.cepstral_lifter,
+              "Cepstral liftering coefficient (mfcc)");
+  po.Register("normalize", &opts.normalize,
+              "Scale samples to [-1, 1) instead of the 16-bit range; whisper "
+              "models usually expect this");
+  po.Register("num-threads", &opts.num_threads,
+              "Number of worker threads, 0 for one per core");
+  po.Register("cache-memory-mb", &opts.cache_memory_mb,
+              "Keep up to this many MB of features of repeated audio in "
+              "memory, 0 for none");
+  po.Register("cache-dir", &opts.cache_dir,
+              "Existing directory to cache the features of repeated audio "
+              "in, kept between runs");
+  po.Register("compress", &opts.compress,
+              "Write compressed matrices, as copy-feats --compress=true");
+  po.Register("compression-method", &opts.compression_method,
+              "Compression method with --compress: 1 = auto, 2 = speech "
+              "feature (CM), 3 = 2 bytes (CM2), 5 = 1 byte (CM3)");
+
+  std::vector<std::string> args;
+  if (!po.Parse(argc, argv, &args) || args.size() != 2) {
+    po.PrintUsage(usage);
+    return 1;
+  }
+
+  if (!opts.use_energy.empty()) {
+    if (opts.use_energy != "true" && opts.use_energy != "false") {
+      fprintf(stderr, "Invalid --use-energy=%s\n", opts.use_energy.c_str());
+      return 1;
+    }
+    opts.fbank_opts.use_energy = opts.use_energy == "true";
+    opts.mfcc_opts.use_energy = opts.fbank_opts.use_energy;
+  }
+  // MFCC and whisper share the fbank flags
+  opts.mfcc_opts.frame_opts = frame_opts;
+  opts.mfcc_opts.mel_opts = mel_opts;
+  opts.mfcc_opts.energy_floor = opts.fbank_opts.energy_floor;
+  opts.mfcc_opts.raw_energy = opts.fbank_opts.raw_energy;
+  opts.mfcc_opts.htk_compat = opts.fbank_opts.htk_compat;
+  opts.whisper_dim = mel_opts.num_bins;
+
+  if (opts.compress &&
+      CompressedMatrixSize(
+          1, 1, static_cast<CompressionMethod>(opts.compression_method)) ==
+          0) {
+    fprintf(stderr, "Unsupported --compression-method=%d\n",
+            opts.compression_method);
+    return 1;
+  }
+
+  if (!CreateExtractor(opts)) {
+    fprintf(stderr, "Unknown --feature-type=%s\n", opts.feature_type.c_str());
+    return 1;
+  }
+
+  std::string ark_filename;
+  std::string scp_filename;
+  std::string store_filename;
+  if (!ParseWspecifier(args[1], &ark_filename, &scp_filename,
+                       &store_filename)) {
+    fprintf(stderr,
+            "Invalid wspecifier %s; expected ark:<ark>, "
+            "ark,scp:<ark>,<scp> or store:<file>\n",
+            args[1].c_str());
+    return 1;
+  }
+  if (!store_filename.empty() && opts.compress) {
+    fprintf(stderr, "--compress is not supported for a feature store\n");
+    return 1;
+  }
+
+  std::vector<Utterance> utts;
+  if (!ReadScp(args[0], &utts)) {
+    fprintf(stderr, "Cannot read %s\n", args[0].c_str());
+    return 1;
+  }
+
+  std::ofstream ark;
+  FeatureStoreWriter store;
+  uint64_t fingerprint = 0;
+  if (!store_filename.empty()) {
+    if (!store.Open(store_filename)) {
+      fprintf(stderr, "Cannot open %s for writing\n",
+              store_filename.c_str());
+      return 1;
+    }
+    fingerprint = OptionsFingerprint(CreateExtractor(opts)->OptionsString());
+  } else {
+    ark.open(ark_filename, std::ios::binary);
+    if (!ark) {
+      fprintf(stderr, "Cannot open %s for writing\n", ark_filename.c_str());
+      return 1;
+    }
+  }
+  std::ofstream scp;
+  if (!scp_filename.empty()) {
+    scp.open(scp_filename);
+    if (!scp) {
+      fprintf(stderr, "Cannot open %s for writing\n", scp_filename.c_str());
+      return 1;
+    }
+  }
+
+  int32_t num_threads = opts.num_threads > 0
+                            ? opts.num_threads
+                            : std::max(1u, std::thread::hardware_concurrency());
+  int32_t num_utts = static_cast<int32_t>(utts.size());
+
+  // Workers take utterances in order, but at most max_ahead past the next
+  // one to write, so that finished features never pile up in memory.
+  const int32_t max_ahead = 4 * num_threads;
+
+  std::shared_ptr<FeatureCache> cache;
+  if (opts.cache_memory_mb > 0 || !opts.cache_dir.empty()) {
+    FeatureCacheOptions cache_opts;
+    cache_opts.max_memory_bytes =
+        static_cast<int64_t>(std::max(opts.cache_memory_mb, 0)) << 20;
+    cache_opts.directory = opts.cache_dir;
+    cache = std::make_shared<FeatureCache>(cache_opts);
+  }
+  std::mutex mutex;
+  std::condition_variable cv;
+  int32_t next_to_compute = 0;
+  int32_t next_to_write = 0;
+  std::vector<char> done(num_utts, 0);
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> workers;
+  for (int32_t t = 0; t != num_threads; ++t) {
+    workers.emplace_back([&]() {
+      std::unique_ptr<OfflineFeature> extractor = CreateExtractor(opts);
+      extractor->SetCache(cache);
+      while (true) {
+        int32_t i;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [&]() {
+            return next_to_compute >= num_utts ||
+                   next_to_compute < next_to_write + max_ahead;
+          });
+          if (next_to_compute >= num_utts) {
+            return;
+          }
+          i = next_to_compute++;
+        }
+        ProcessUtterance(opts, extractor.get(), &utts[i]);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          done[i] = 1;
+        }
+        cv.notify_all();
+      }
+    });
+  }
+
+  int32_t num_success = 0;
+  int32_t num_fail = 0;
+  int64_t num_frames = 0;
+  double total_duration = 0;
+  for (int32_t i = 0; i != num_utts; ++i) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&]() { return done[i] != 0; });
+    }
+    Utterance &utt = utts[i];
+    if (utt.ok && store.IsOpen()) {
+      if (store.Write(utt.key, utt.feats.data(), utt.num_frames,
+                      static_cast<int32_t>(utt.feats.size() / utt.num_frames),
+                      fingerprint)) {
+        ++num_success;
+        num_frames += utt.num_frames;
+        total_duration += utt.duration;
+      } else {
+        fprintf(stderr,
+                "WARNING: cannot write utterance %s (repeated key?)\n",
+                utt.key.c_str());
+        ++num_fail;
+      }
+    } else if (utt.ok) {
+      ark << utt.key << ' ';
+      std::streamoff offset = ark.tellp();
+      if (opts.compress) {
+        ark.write("\0B", 2);
+        ark.write(reinterpret_cast<const char *>(utt.compressed.data()),
+                  static_cast<std::streamsize>(utt.compressed.size()));
+      } else {
+        WriteKaldiMatrix(
+            ark, utt.feats.data(), utt.num_frames,
+            static_cast<int32_t>(utt.feats.size() / utt.num_frames));
+      }
+      if (scp.is_open()) {
+        scp << utt.key << ' ' << ark_filename << ':' << offset << '\n';
+      }
+      ++num_success;
+      num_frames += utt.num_frames;
+      total_duration += utt.duration;
+    } else {
+      fprintf(stderr, "WARNING: failed for utterance %s: %s\n",
+              utt.key.c_str(), utt.error.c_str());
+      ++num_fail;
+    }
+    // release the memory as soon as it is written
+    std::vector<float>().swap(utt.feats);
+    std::vector<uint8_t>().swap(utt.compressed);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      next_to_write = i + 1;
+    }
+    cv.notify_all();
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  bool write_ok = true;
+  if (store.IsOpen()) {
+    write_ok = store.Close();
+  } else {
+    ark.flush();
+    write_ok = static_cast<bool>(ark);
+  }
+  if (scp.is_open()) {
+    scp.flush();
+    write_ok = write_ok && static_cast<bool>(scp);
+  }
+
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  fprintf(stderr,
+          "Done %d utterances, failed for %d. %.2f hours of audio, %lld "
+          "frames, in %.2f seconds with %d threads.\n",
+          num_success, num_fail, total_duration / 3600,
+          static_cast<long long>(num_frames), elapsed, num_threads);
+  if (total_duration > 0) {
+    fprintf(stderr,
+            "Throughput %.1f seconds of audio per second; RTF %.5f, or "
+            "%.5f per thread.\n",
+            total_duration / elapsed, elapsed / total_duration,
+            elapsed * num_threads / total_duration);
+  }
+  if (cache) {
+    FeatureCacheStats stats = cache->GetStats();
+    fprintf(stderr,
+            "Cache: %lld hits in memory, %lld on disk, %lld misses; %lld "
+            "evictions\n",
+            static_cast<long long>(stats.memory_hits),
+            static_cast<long long>(stats.disk_hits),
+            static_cast<long long>(stats.misses),
+            static_cast<long long>(stats.evictions));
+  }
+  if (!write_ok) {
+    fprintf(stderr, "Error writing %s\n", args[1].c_str());
+    return 1;
+  }
+  return num_success != 0 ? 0 : 1;
+}
+
+}  // namespace
+
+}  // namespace knf
+
+int main(int argc, char *argv[]) { return knf::Run(argc, argv); }
@@ -0,0 +1,185 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "mapped-file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+namespace knf {
+
+namespace {
+
+// Mapping offsets must be a multiple of this
+int64_t MapGranularity() {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwAllocationGranularity;
+#else
+  return sysconf(_SC_PAGESIZE);
+#endif
+}
+
+}  // namespace
+
+bool MappedFile::Open(const std::string &filename) {
+  Close();
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping = nullptr;
+  if (size.QuadPart > 0) {
+    // an empty file cannot be mapped
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+      CloseHandle(file);
+      return false;
+    }
+  }
+  file_ = file;
+  mapping_ = mapping;
+  size_ = size.QuadPart;
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  fd_ = fd;
+  size_ = st.st_size;
+#endif
+  return true;
+}
+
+void MappedFile::Close() {
+  Unmap();
+#ifdef _WIN32
+  if (mapping_ != nullptr) {
+    CloseHandle(mapping_);
+    mapping_ = nullptr;
+  }
+  if (file_ != nullptr) {
+    CloseHandle(file_);
+    file_ = nullptr;
+  }
+#else
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+#endif
+  size_ = -1;
+}
+
+void MappedFile::Unmap() {
+  if (view_ == nullptr) {
+    return;
+  }
+#ifdef _WIN32
+  UnmapViewOfFile(view_);
+#else
+  munmap(view_, view_size_);
+#endif
+  view_ = nullptr;
+  view_offset_ = 0;
+  view_size_ = 0;
+}
+
+const uint8_t *MappedFile::Map(int64_t offset, size_t length) {
+  if (offset < 0 || offset + static_cast<int64_t>(length) > size_ ||
+      length == 0) {
+    return nullptr;
+  }
+  if (view_ != nullptr && offset >= view_offset_ &&
+      offset + static_cast<int64_t>(length) <=
+          view_offset_ + static_cast<int64_t>(view_size_)) {
+    return view_ + (offset - view_offset_);
+  }
+
+  static const int64_t granularity = MapGranularity();
+  int64_t begin = offset / granularity * granularity;
+  int64_t end = std::min(
+      size_, std::max(offset + static_cast<int64_t>(length),
+                      begin + static_cast<int64_t>(kWindowSize)));
+  if (!MapView(begin, static_cast<size_t>(end - begin), true)) {
+    return nullptr;
+  }
+  return view_ + (offset - view_offset_);
+}
+
+const uint8_t *MappedFile::MapAll() {
+  if (size_ <= 0) {
+    return nullptr;
+  }
+  if (view_ != nullptr && view_offset_ == 0 &&
+      static_cast<int64_t>(view_size_) == size_) {
+    return view_;
+  }
+  if (!MapView(0, static_cast<size_t>(size_), false)) {
+    return nullptr;
+  }
+  return view_;
+}
+
+bool MappedFile::MapView(int64_t begin, size_t size, bool sequential) {
+  Unmap();
+#ifdef _WIN32
+  (void)sequential;
+  void *view = MapViewOfFile(mapping_, FILE_MAP_READ,
+                             static_cast<DWORD>(begin >> 32),
+                             static_cast<DWORD>(begin & 0xFFFFFFFF), size);
+  if (view == nullptr) {
+    return false;
+  }
+#else
+  void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd_, begin);
+  if (view == MAP_FAILED) {
+    return false;
+  }
+  // a window is read once, front to back; a whole file is read anywhere
+  madvise(view, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+
+  view_ = static_cast<uint8_t *>(view);
+  view_offset_ = begin;
+  view_size_ = size;
+  return true;
+}
+
+}  // namespace knf
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Read-only memory map of a file, one window at a time, so that very large
+// files can be read sequentially with a bounded amount of mapped memory, or
+// all at once for random access.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_MAPPED_FILE_H_
+#define KALDI_NATIVE_FBANK_CSRC_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace knf {
+
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile() { Close(); }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Returns false if the file cannot be opened
+  bool Open(const std::string &filename);
+  void Close();
+
+  bool IsOpen() const { return size_ >= 0; }
+
+  // Size of the file in bytes, -1 if it is not open
+  int64_t Size() const { return size_; }
+
+  // Pointer to the bytes [offset, offset + length) of the file, valid until
+  // the next call to Map() or Close(). The range must be inside the file.
+  // Returns nullptr on error.
+  //
+  // A window of at least kWindowSize bytes is mapped, so consecutive small
+  // ranges are served from the same mapping.
+  const uint8_t *Map(int64_t offset, size_t length);
+
+  // Pointer to the whole file, valid until Close(); later calls to Map()
+  // return pointers into it. For random access, e.g. of an indexed file.
+  // Returns nullptr on error or if the file is empty.
+  const uint8_t *MapAll();
+
+  static constexpr size_t kWindowSize = 16 << 20;
+
+ private:
+  void Unmap();
+  // Replace the current window with [begin, begin + size)
+  bool MapView(int64_t begin, size_t size, bool sequential);
+
+#ifdef _WIN32
+  void *file_ = nullptr;     // HANDLE
+  void *mapping_ = nullptr;  // HANDLE
+#else
+  int fd_ = -1;
+#endif
+  int64_t size_ = -1;
+
+  // the current window, [view_offset_, view_offset_ + view_size_)
+  uint8_t *view_ = nullptr;
+  int64_t view_offset_ = 0;
+  size_t view_size_ = 0;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_MAPPED_FILE_H_
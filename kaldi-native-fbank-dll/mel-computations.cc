@@ -23,7 +23,11 @@
 #include <stdio.h>
 
 #include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
 #include <vector>
 
 #include "feature-window.h"
@@ -445,6 +449,32 @@ void MelBanks::Compute(const float *power_spectrum,
   }
 }
 
+std::vector<float> ComputeDctMatrix(int32_t num_rows, int32_t num_cols) {
+  // this function is copied from
+  // https://github.com/kaldi-asr/kaldi/blob/master/src/matrix/matrix-functions.cc#L592
+
+  std::vector<float> ans(num_rows * num_cols);
+  float *p = ans.data();
+
+  float normalizer = std::sqrt(1.0 / num_cols);  // normalizer for X_0
+
+  for (int32_t i = 0; i != num_cols; ++i) {
+    p[i] = normalizer;
+  }
+
+  normalizer = std::sqrt(2.0 / num_cols);  // normalizer for other elements
+
+  for (int32_t k = 1; k != num_rows; ++k) {
+    for (int32_t n = 0; n != num_cols; ++n) {
+      *(p + k * num_cols + n) =
+          normalizer *
+          std::cos(static_cast<double>(M_PI) / num_cols * (n + 0.5) * k);
+    }
+  }
+
+  return ans;
+}
+
 void ComputeLifterCoeffs(float Q, std::vector<float> *coeffs) {
   // Compute liftering coefficients (scaling on cepstral coeffs)
   // coeffs are numbered slightly differently from HTK: the zeroth
@@ -454,4 +484,23 @@ void ComputeLifterCoeffs(float Q, std::vector<float> *coeffs) {
   }
 }
 
+const MelBanks *GetSharedMelBanks(const MelBanksOptions &opts,
+                                  const FrameExtractionOptions &frame_opts) {
+  // everything MelBanks reads from the options
+  std::ostringstream os;
+  os << opts.ToString() << "samp_freq: " << frame_opts.samp_freq
+     << "\npadded_window_size: " << frame_opts.PaddedWindowSize();
+  std::string key = os.str();
+
+  static std::mutex mutex;
+  static std::map<std::string, std::unique_ptr<MelBanks>> banks;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unique_ptr<MelBanks> &b = banks[key];
+  if (!b) {
+    b = std::make_unique<MelBanks>(opts, frame_opts, 1.0f);
+  }
+  return b.get();
+}
+
 }  // namespace knf
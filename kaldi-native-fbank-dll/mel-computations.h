@@ -158,6 +158,11 @@ class MelBanks {
 
   int32_t NumBins() const { return bins_.size(); }
 
+  // For each bin, the first nonzero fft bin and the weights from there on
+  const std::vector<std::pair<int32_t, std::vector<float>>> &GetBins() const {
+    return bins_;
+  }
+
  private:
   // for kaldi-compatible
   void InitKaldiMelBanks(const MelBanksOptions &opts,
@@ -180,6 +185,17 @@ class MelBanks {
   bool htk_mode_ = false;
 };
 
+// MelBanks for VTLN warping factor 1.0, built on the first call for these
+// options and shared, read-only, by every later caller in the process, like
+// GetSharedWindow(). Never null; valid until the process exits.
+const MelBanks *GetSharedMelBanks(const MelBanksOptions &opts,
+                                  const FrameExtractionOptions &frame_opts);
+
+// Compute the (num_rows x num_cols) DCT matrix used by MfccComputer,
+// row major. Row k holds the k-th DCT-II basis vector, normalized so that
+// the matrix is orthonormal when num_rows == num_cols.
+std::vector<float> ComputeDctMatrix(int32_t num_rows, int32_t num_cols);
+
 // Compute liftering coefficients (scaling on cepstral coeffs)
 // coeffs are numbered slightly differently from HTK: the zeroth
 // index is C0, which is not affected.
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "multichannel.h"
+
+namespace knf {
+
+namespace {
+
+// With the channel count known at compile time the inner loop is unrolled
+// and the frame loop can be vectorized.
+template <int32_t C>
+void DownmixImpl(const float *samples, int32_t num_frames, float *out) {
+  const float scale = 1.0f / C;
+  for (int32_t t = 0; t != num_frames; ++t) {
+    const float *frame = samples + static_cast<int64_t>(t) * C;
+    float sum = 0;
+    for (int32_t c = 0; c != C; ++c) {
+      sum += frame[c];
+    }
+    out[t] = sum * scale;
+  }
+}
+
+template <int32_t C>
+void DeinterleaveImpl(const float *samples, int32_t num_frames,
+                      float *const *out) {
+  for (int32_t t = 0; t != num_frames; ++t) {
+    const float *frame = samples + static_cast<int64_t>(t) * C;
+    for (int32_t c = 0; c != C; ++c) {
+      out[c][t] = frame[c];
+    }
+  }
+}
+
+}  // namespace
+
+void DownmixInterleaved(const float *samples, int32_t num_frames,
+                        int32_t num_channels, float *out) {
+  switch (num_channels) {
+    case 1:
+      return DownmixImpl<1>(samples, num_frames, out);
+    case 2:
+      return DownmixImpl<2>(samples, num_frames, out);
+    case 3:
+      return DownmixImpl<3>(samples, num_frames, out);
+    case 4:
+      return DownmixImpl<4>(samples, num_frames, out);
+    case 5:
+      return DownmixImpl<5>(samples, num_frames, out);
+    case 6:
+      return DownmixImpl<6>(samples, num_frames, out);
+    case 7:
+      return DownmixImpl<7>(samples, num_frames, out);
+    case 8:
+      return DownmixImpl<8>(samples, num_frames, out);
+    default:
+      break;
+  }
+
+  const float scale = 1.0f / num_channels;
+  for (int32_t t = 0; t != num_frames; ++t) {
+    const float *frame = samples + static_cast<int64_t>(t) * num_channels;
+    float sum = 0;
+    for (int32_t c = 0; c != num_channels; ++c) {
+      sum += frame[c];
+    }
+    out[t] = sum * scale;
+  }
+}
+
+void DeinterleaveChannels(const float *samples, int32_t num_frames,
+                          int32_t num_channels, float *const *out) {
+  switch (num_channels) {
+    case 1:
+      return DeinterleaveImpl<1>(samples, num_frames, out);
+    case 2:
+      return DeinterleaveImpl<2>(samples, num_frames, out);
+    case 3:
+      return DeinterleaveImpl<3>(samples, num_frames, out);
+    case 4:
+      return DeinterleaveImpl<4>(samples, num_frames, out);
+    case 5:
+      return DeinterleaveImpl<5>(samples, num_frames, out);
+    case 6:
+      return DeinterleaveImpl<6>(samples, num_frames, out);
+    case 7:
+      return DeinterleaveImpl<7>(samples, num_frames, out);
+    case 8:
+      return DeinterleaveImpl<8>(samples, num_frames, out);
+    default:
+      break;
+  }
+
+  for (int32_t t = 0; t != num_frames; ++t) {
+    const float *frame = samples + static_cast<int64_t>(t) * num_channels;
+    for (int32_t c = 0; c != num_channels; ++c) {
+      out[c][t] = frame[c];
+    }
+  }
+}
+
+}  // namespace knf
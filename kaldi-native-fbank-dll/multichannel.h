@@ -0,0 +1,42 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Helpers for interleaved multi-channel PCM, i.e. num_frames groups of
+// num_channels samples, as produced by most capture APIs and WAV files.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_MULTICHANNEL_H_
+#define KALDI_NATIVE_FBANK_CSRC_MULTICHANNEL_H_
+
+#include <cstdint>
+
+namespace knf {
+
+// out[t] = mean of the num_channels samples of frame t; out has room for
+// num_frames floats. Up to 8 channels have unrolled implementations; more
+// are supported, but slower.
+void DownmixInterleaved(const float *samples, int32_t num_frames,
+                        int32_t num_channels, float *out);
+
+// out[c][t] = sample c of frame t; each out[c] has room for num_frames
+// floats.
+void DeinterleaveChannels(const float *samples, int32_t num_frames,
+                          int32_t num_channels, float *const *out);
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_MULTICHANNEL_H_
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "offline-feature.h"
+
+#include <utility>
+
+#include "hash.h"
+
+namespace knf {
+
+int32_t OfflineFeature::Compute(const std::vector<float> &wave,
+                                std::vector<float> *feats) {
+  int32_t num_frames =
+      NumFrames(static_cast<int64_t>(wave.size()), GetFrameOptions());
+  int32_t dim = Dim();
+  if (num_frames == 0) {
+    feats->clear();
+    return 0;
+  }
+
+  FeatureCacheKey key;
+  if (cache_) {
+    key = MakeFeatureCacheKey(wave.data(), static_cast<int64_t>(wave.size()),
+                              options_fingerprint_);
+    int32_t rows = 0;
+    int32_t cols = 0;
+    if (cache_->Lookup(key, feats, &rows, &cols) && rows == num_frames &&
+        cols == dim) {
+      return num_frames;
+    }
+  }
+
+  feats->resize(static_cast<size_t>(num_frames) * dim);
+  ComputeFrames(wave, num_frames, feats->data());
+  if (cache_) {
+    cache_->Insert(key, feats->data(), num_frames, dim);
+  }
+  return num_frames;
+}
+
+void OfflineFeature::SetCache(std::shared_ptr<FeatureCache> cache) {
+  cache_ = std::move(cache);
+  if (cache_) {
+    options_fingerprint_ = OptionsFingerprint(OptionsString());
+  }
+}
+
+}  // namespace knf
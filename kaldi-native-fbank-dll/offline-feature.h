@@ -0,0 +1,120 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Features of whole utterances, like Kaldi's Fbank::Compute() and
+// Mfcc::Compute(), without the buffering of the online extractors. An
+// extractor is meant to be reused for many utterances, so the mel banks,
+// window and FFT tables are only set up once; it is not thread-safe, so
+// use one per thread. A FeatureCache can be put in front of it.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_OFFLINE_FEATURE_H_
+#define KALDI_NATIVE_FBANK_CSRC_OFFLINE_FEATURE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "feature-cache.h"
+#include "feature-fbank.h"
+#include "feature-mfcc.h"
+#include "feature-window.h"
+#include "whisper-feature.h"
+
+namespace knf {
+
+class OfflineFeature {
+ public:
+  virtual ~OfflineFeature() = default;
+
+  // wave is at GetFrameOptions().samp_freq. feats is resized to
+  // (number of frames) * Dim(), row major; returns the number of frames.
+  // Looks the utterance up in the cache first, if there is one.
+  int32_t Compute(const std::vector<float> &wave, std::vector<float> *feats);
+
+  virtual int32_t Dim() const = 0;
+  virtual const FrameExtractionOptions &GetFrameOptions() const = 0;
+
+  // The options as their ToString() prints them
+  virtual std::string OptionsString() const = 0;
+
+  // Share a cache between extractors, e.g. of several threads; nullptr to
+  // stop using one
+  void SetCache(std::shared_ptr<FeatureCache> cache);
+  const std::shared_ptr<FeatureCache> &GetCache() const { return cache_; }
+
+ protected:
+  // Compute num_frames frames of wave into feats
+  virtual void ComputeFrames(const std::vector<float> &wave,
+                             int32_t num_frames, float *feats) = 0;
+
+ private:
+  std::shared_ptr<FeatureCache> cache_;
+  uint64_t options_fingerprint_ = 0;
+};
+
+template <class C>
+class OfflineFeatureImpl : public OfflineFeature {
+ public:
+  explicit OfflineFeatureImpl(const typename C::Options &opts)
+      : computer_(opts),
+        window_function_(computer_.GetFrameOptions()),
+        window_(computer_.GetFrameOptions().PaddedWindowSize()) {}
+
+  int32_t Dim() const override { return computer_.Dim(); }
+
+  const FrameExtractionOptions &GetFrameOptions() const override {
+    return computer_.GetFrameOptions();
+  }
+
+  std::string OptionsString() const override {
+    return computer_.GetOptions().ToString();
+  }
+
+ protected:
+  void ComputeFrames(const std::vector<float> &wave, int32_t num_frames,
+                     float *feats) override {
+    const FrameExtractionOptions &frame_opts = computer_.GetFrameOptions();
+    int32_t dim = computer_.Dim();
+    bool need_raw_log_energy = computer_.NeedRawLogEnergy();
+    for (int32_t r = 0; r != num_frames; ++r) {
+      // the computer uses window_ as scratch space, padding included;
+      // ExtractWindow() zeroes the padding again
+      float raw_log_energy = 0.0f;
+      ExtractWindow(0, wave.data(), static_cast<int32_t>(wave.size()), r,
+                    frame_opts, window_function_, window_.data(),
+                    need_raw_log_energy ? &raw_log_energy : nullptr);
+      computer_.Compute(raw_log_energy, 1.0f, window_.data(),
+                        feats + static_cast<size_t>(r) * dim);
+    }
+  }
+
+ private:
+  C computer_;
+  FeatureWindowFunction window_function_;
+  std::vector<float> window_;
+};
+
+using OfflineFbank = OfflineFeatureImpl<FbankComputer>;
+using OfflineMfcc = OfflineFeatureImpl<MfccComputer>;
+using OfflineWhisperFbank = OfflineFeatureImpl<WhisperFeatureComputer>;
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_OFFLINE_FEATURE_H_
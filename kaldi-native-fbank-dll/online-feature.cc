@@ -24,60 +24,489 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "feature-window.h"
+#include "hash.h"
 #include "log.h"
 
 namespace knf {
 
+	RecyclingVector::ChunkTable::ChunkTable(int32_t base, int32_t capacity)
+		: base(base), capacity(capacity), chunks(new std::atomic<float*>[capacity]) {
+		for (int32_t i = 0; i != capacity; ++i) {
+			chunks[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
 	RecyclingVector::RecyclingVector(int32_t items_to_hold)
-		: items_to_hold_(items_to_hold == 0 ? -1 : items_to_hold),
-		first_available_index_(0) {
+		: table_(nullptr),
+		epoch_(0),
+		dim_(0),
+		max_frames_(items_to_hold == 0 ? -1 : items_to_hold),
+		max_bytes_(-1),
+		items_to_hold_(max_frames_),
+		first_available_index_(0),
+		size_(0),
+		first_live_chunk_(0),
+		first_draining_chunk_(0),
+		first_unfreed_chunk_(0),
+		spare_chunk_(nullptr),
+		num_chunks_(0),
+		peak_num_chunks_(0),
+		peak_retained_frames_(0) {
+		readers_[0].store(0, std::memory_order_relaxed);
+		readers_[1].store(0, std::memory_order_relaxed);
+		table_owner_.reset(new ChunkTable(0, 16));
+		table_.store(table_owner_.get(), std::memory_order_release);
+	}
+
+	RecyclingVector::~RecyclingVector() {
+		// Retired tables only hold pointers that are also in the current
+		// one or that were retired.
+		const ChunkTable* table = table_owner_.get();
+		for (int32_t i = first_live_chunk_; i < table->base + table->capacity; ++i) {
+			delete[] table->chunks[i - table->base].load(std::memory_order_relaxed);
+		}
+		for (float* chunk : retired_.chunks) {
+			delete[] chunk;
+		}
+		for (float* chunk : draining_.chunks) {
+			delete[] chunk;
+		}
+		delete[] spare_chunk_;
+	}
+
+	RecyclingVector::ReaderGuard::ReaderGuard(const RecyclingVector* v) {
+		for (;;) {
+			uint32_t epoch = v->epoch_.load(std::memory_order_seq_cst);
+			readers_ = &v->readers_[epoch % 2];
+			readers_->fetch_add(1, std::memory_order_seq_cst);
+			// If the epoch moved on meanwhile, the writer may not have seen
+			// us; register in the new one instead.
+			if (v->epoch_.load(std::memory_order_seq_cst) == epoch) {
+				return;
+			}
+			readers_->fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	RecyclingVector::ReaderGuard::~ReaderGuard() {
+		readers_->fetch_sub(1, std::memory_order_release);
+	}
+
+	const float* RecyclingVector::RowAddress(const ChunkTable* table,
+		int32_t index) const {
+		const float* chunk = table->chunks[index / kChunkSize - table->base].load(
+			std::memory_order_acquire);
+		return chunk + (index % kChunkSize) * dim_.load(std::memory_order_relaxed);
 	}
 
 	const float* RecyclingVector::At(int32_t index) const {
-		if (index < first_available_index_) {
+		ReaderGuard guard(this);
+		int32_t size = Size();
+		const ChunkTable* table = table_.load(std::memory_order_acquire);
+		int32_t first_available_index = FirstAvailableIndex();
+		if (index < first_available_index) {
 			KNF_LOG(FATAL) << "Attempted to retrieve feature vector that was "
 				"already removed by the RecyclingVector (index = "
 				<< index << "; "
-				<< "first_available_index = " << first_available_index_
+				<< "first_available_index = " << first_available_index
 				<< "; "
-				<< "size = " << Size() << ")";
+				<< "size = " << size << ")";
+			throw std::out_of_range("RecyclingVector::At");
+		}
+		if (index >= size) {
+			throw std::out_of_range("RecyclingVector::At");
 		}
-		// 'at' does size checking.
-		return items_.at(index - first_available_index_).data();
+		return RowAddress(table, index);
 	}
 
 	void RecyclingVector::PushBack(std::vector<float> item) {
-		// Note: -1 is a larger number when treated as unsigned
-		if (items_.size() == static_cast<size_t>(items_to_hold_)) {
-			items_.pop_front();
-			++first_available_index_;
+		float* p = PrepareBack(static_cast<int32_t>(item.size()));
+		std::copy(item.begin(), item.end(), p);
+		CommitBack();
+	}
+
+	float* RecyclingVector::NewChunk() {
+		float* chunk = spare_chunk_;
+		spare_chunk_ = nullptr;
+		if (chunk == nullptr) {
+			chunk = new float[kChunkSize * dim_.load(std::memory_order_relaxed)];
+			int32_t num_chunks = num_chunks_.load(std::memory_order_relaxed) + 1;
+			num_chunks_.store(num_chunks, std::memory_order_relaxed);
+			if (num_chunks > peak_num_chunks_.load(std::memory_order_relaxed)) {
+				peak_num_chunks_.store(num_chunks, std::memory_order_relaxed);
+			}
+		}
+		return chunk;
+	}
+
+	float* RecyclingVector::PrepareBack(int32_t dim) {
+		if (dim_.load(std::memory_order_relaxed) == 0) {
+			dim_.store(dim, std::memory_order_release);
+			UpdateItemsToHold();
+		}
+		KNF_CHECK_EQ(dim, dim_.load(std::memory_order_relaxed));
+
+		int32_t index = size_.load(std::memory_order_relaxed);
+		int32_t chunk_index = index / kChunkSize;
+
+		if (chunk_index >= table_owner_->base + table_owner_->capacity) {
+			ReplaceTable(chunk_index + 1);
+		}
+
+		std::atomic<float*>& entry =
+			table_owner_->chunks[chunk_index - table_owner_->base];
+		float* chunk = entry.load(std::memory_order_relaxed);
+		if (chunk == nullptr) {
+			chunk = NewChunk();
+			entry.store(chunk, std::memory_order_release);
+		}
+		return chunk + (index % kChunkSize) * dim;
+	}
+
+	void RecyclingVector::ReplaceTable(int32_t end_chunk) {
+		// Readers may still be looking at the old table, so we copy it
+		// instead of growing it in place. The entries of retired chunks are
+		// copied too: a reader that started before they were released may
+		// find the new table.
+		const ChunkTable* old_table = table_owner_.get();
+		int32_t base = first_unfreed_chunk_;
+		int32_t capacity = std::max(16, 2 * (end_chunk - base));
+		std::unique_ptr<ChunkTable> table(new ChunkTable(base, capacity));
+		for (int32_t i = base; i < old_table->base + old_table->capacity; ++i) {
+			table->chunks[i - base].store(
+				old_table->chunks[i - old_table->base].load(std::memory_order_relaxed),
+				std::memory_order_relaxed);
+		}
+		table_.store(table.get(), std::memory_order_release);
+		retired_.tables.push_back(std::move(table_owner_));
+		table_owner_ = std::move(table);
+	}
+
+	void RecyclingVector::CommitBack() {
+		int32_t size = size_.load(std::memory_order_relaxed) + 1;
+		// publish the frame written through PrepareBack()
+		size_.store(size, std::memory_order_release);
+
+		if (items_to_hold_ != -1) {
+			Release(size - items_to_hold_);
+		}
+
+		int32_t retained = size - FirstAvailableIndex();
+		if (retained > peak_retained_frames_.load(std::memory_order_relaxed)) {
+			peak_retained_frames_.store(retained, std::memory_order_relaxed);
+		}
+
+		FreeReleasedChunks();
+	}
+
+	void RecyclingVector::SetRetention(int32_t max_frames, int64_t max_bytes) {
+		max_frames_ = max_frames <= 0 ? -1 : max_frames;
+		max_bytes_ = max_bytes <= 0 ? -1 : max_bytes;
+		UpdateItemsToHold();
+
+		// apply the new limit right away instead of at the next frame
+		if (items_to_hold_ != -1) {
+			Release(Size() - items_to_hold_);
+			FreeReleasedChunks();
+		}
+	}
+
+	void RecyclingVector::UpdateItemsToHold() {
+		items_to_hold_ = max_frames_;
+
+		int32_t dim = dim_.load(std::memory_order_relaxed);
+		if (max_bytes_ == -1 || dim == 0) {
+			return;
+		}
+
+		// Memory is allocated a chunk at a time: the retained frames may
+		// straddle one more chunk than they fill, the writer keeps a partly
+		// used chunk plus a spare, and a released chunk is freed one frame
+		// later, once the readers have left.
+		int64_t bytes_per_frame = static_cast<int64_t>(dim) * sizeof(float);
+		int64_t max_frames = max_bytes_ / bytes_per_frame - 4 * kChunkSize;
+		max_frames = std::max<int64_t>(max_frames, 1);
+		if (items_to_hold_ == -1 || max_frames < items_to_hold_) {
+			items_to_hold_ = static_cast<int32_t>(
+				std::min<int64_t>(max_frames, std::numeric_limits<int32_t>::max()));
+		}
+	}
+
+	FrameStoreStats RecyclingVector::GetStats() const {
+		FrameStoreStats stats;
+		int64_t chunk_bytes =
+			static_cast<int64_t>(kChunkSize) * Dim() * sizeof(float);
+		stats.first_available_index = FirstAvailableIndex();
+		stats.num_frames = Size();
+		stats.retained_frames = stats.num_frames - stats.first_available_index;
+		stats.peak_retained_frames =
+			peak_retained_frames_.load(std::memory_order_relaxed);
+		stats.retained_bytes =
+			chunk_bytes * num_chunks_.load(std::memory_order_relaxed);
+		stats.peak_retained_bytes =
+			chunk_bytes * peak_num_chunks_.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void RecyclingVector::FreeReleasedChunks() {
+		int32_t first_needed_chunk =
+			first_available_index_.load(std::memory_order_acquire) / kChunkSize;
+		const ChunkTable* table = table_owner_.get();
+		for (; first_live_chunk_ < first_needed_chunk; ++first_live_chunk_) {
+			// The entry stays in the table: a reader may have looked up
+			// FirstAvailableIndex() before the release.
+			float* chunk = table->chunks[first_live_chunk_ - table->base].load(
+				std::memory_order_relaxed);
+			if (chunk != nullptr) {
+				retired_.chunks.push_back(chunk);
+			}
+		}
+
+		uint32_t epoch = epoch_.load(std::memory_order_relaxed);
+		if (!draining_.Empty()) {
+			if (readers_[(epoch - 1) % 2].load(std::memory_order_seq_cst) != 0) {
+				return;  // try again at the next frame
+			}
+			for (float* chunk : draining_.chunks) {
+				FreeChunk(chunk);
+			}
+			draining_.chunks.clear();
+			draining_.tables.clear();
+			first_unfreed_chunk_ = first_draining_chunk_;
+		}
+		if (!retired_.Empty()) {
+			// Readers that register from now on see the release; wait for
+			// the ones that are already in.
+			std::swap(draining_, retired_);
+			first_draining_chunk_ = first_live_chunk_;
+			epoch_.store(epoch + 1, std::memory_order_seq_cst);
+		}
+	}
+
+	void RecyclingVector::FreeChunk(float* chunk) {
+		if (spare_chunk_ == nullptr) {
+			spare_chunk_ = chunk;
+		}
+		else {
+			delete[] chunk;
+			num_chunks_.store(num_chunks_.load(std::memory_order_relaxed) - 1,
+				std::memory_order_relaxed);
 		}
-		items_.push_back(std::move(item));
 	}
 
 	int32_t RecyclingVector::Size() const {
-		return first_available_index_ + static_cast<int32_t>(items_.size());
+		return size_.load(std::memory_order_acquire);
+	}
+
+	int32_t RecyclingVector::FirstAvailableIndex() const {
+		return first_available_index_.load(std::memory_order_acquire);
+	}
+
+	int32_t RecyclingVector::Read(int32_t begin, int32_t end, float* out) const {
+		// The chunks of the frames seen as available now are not reclaimed
+		// before the guard goes, even if they are released meanwhile.
+		ReaderGuard guard(this);
+		int32_t size = Size();
+		const ChunkTable* table = table_.load(std::memory_order_acquire);
+		if (begin < FirstAvailableIndex()) {
+			return -1;
+		}
+		end = std::min(end, size);
+		if (begin >= end) {
+			return 0;
+		}
+
+		int32_t dim = dim_.load(std::memory_order_acquire);
+		for (int32_t i = begin; i < end;) {
+			// copy the rest of this chunk in one go
+			int32_t n = std::min(end - i, kChunkSize - i % kChunkSize);
+			const float* p = RowAddress(table, i);
+			std::copy(p, p + n * dim, out);
+			out += n * dim;
+			i += n;
+		}
+		return end - begin;
 	}
 
 	// discard the first n frames
 	void RecyclingVector::Pop(int32_t n) {
-		for (int32_t i = 0; i < n && !items_.empty(); ++i) {
-			items_.pop_front();
-			++first_available_index_;
+		int32_t first_available_index =
+			first_available_index_.load(std::memory_order_acquire);
+		Release(first_available_index + n);
+	}
+
+	void RecyclingVector::Release(int32_t end) {
+		end = std::min(end, Size());
+		int32_t first_available_index =
+			first_available_index_.load(std::memory_order_acquire);
+		// Several threads may release at the same time; the index only moves
+		// forward.
+		while (first_available_index < end &&
+			!first_available_index_.compare_exchange_weak(
+				first_available_index, end, std::memory_order_acq_rel,
+				std::memory_order_acquire)) {
 		}
 	}
 
+	void RecyclingVector::StartAt(int32_t index) {
+		KNF_CHECK_EQ(Size(), 0);
+		int32_t chunk_index = index / kChunkSize;
+		first_live_chunk_ = chunk_index;
+		first_draining_chunk_ = chunk_index;
+		first_unfreed_chunk_ = chunk_index;
+		if (chunk_index >= table_owner_->base + table_owner_->capacity) {
+			// nothing to copy: the vector is empty
+			ReplaceTable(chunk_index + 1);
+		}
+		first_available_index_.store(index, std::memory_order_release);
+		size_.store(index, std::memory_order_release);
+	}
+
+	namespace {
+
+		// The layout of a state written by OnlineGenericBaseFeature::SaveState(),
+		// in the byte order of the host:
+		//   char[4]     "KNFO"
+		//   uint32      version (1)
+		//   uint64      OptionsFingerprint() of the computer's options
+		//   uint8       input finished
+		//   int64       waveform offset
+		//   uint32      n, followed by n floats: the waveform remainder
+		//   int32       index of the first frame not released
+		//   int32       number of frames, including the released ones
+		//   int32       dim, followed by the frames not released
+		//   int32       input sampling rate of the resampler, 0 if none;
+		//               if not 0, followed by
+		//   int64       input sample offset of the resampler
+		//   int64       output sample offset of the resampler
+		//   uint32      n, followed by n floats: its input remainder
+		constexpr char kStateMagic[4] = { 'K', 'N', 'F', 'O' };
+		constexpr uint32_t kStateVersion = 1;
+
+		template <typename T>
+		void AppendState(T value, std::string* out) {
+			out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		void AppendStateFloats(const float* p, size_t n, std::string* out) {
+			if (n != 0) {
+				out->append(reinterpret_cast<const char*>(p), n * sizeof(float));
+			}
+		}
+
+		// The floats of a state need not be aligned
+		void CopyStateFloats(const uint8_t* p, size_t n, float* out) {
+			if (n != 0) {
+				std::memcpy(out, p, n * sizeof(float));
+			}
+		}
+
+		// Reads the fields of a state, checking that they fit in it
+		class StateReader {
+		public:
+			StateReader(const uint8_t* data, size_t size)
+				: p_(data), end_(data + size) {
+			}
+
+			template <typename T>
+			bool Read(T* value) {
+				if (static_cast<size_t>(end_ - p_) < sizeof(T)) {
+					return false;
+				}
+				std::memcpy(value, p_, sizeof(T));
+				p_ += sizeof(T);
+				return true;
+			}
+
+			// n floats, pointing into the state
+			bool ReadFloats(size_t n, const uint8_t** p) {
+				if (static_cast<size_t>(end_ - p_) / sizeof(float) < n) {
+					return false;
+				}
+				*p = p_;
+				p_ += n * sizeof(float);
+				return true;
+			}
+
+			bool AtEnd() const { return p_ == end_; }
+
+		private:
+			const uint8_t* p_;
+			const uint8_t* end_;
+		};
+
+	}  // namespace
+
 	template <class C>
 	OnlineGenericBaseFeature<C>::OnlineGenericBaseFeature(
 		const typename C::Options& opts)
 		: computer_(opts),
 		window_function_(computer_.GetFrameOptions()),
+		window_(computer_.GetFrameOptions().PaddedWindowSize()),
 		input_finished_(false),
-		waveform_offset_(0) {
+		waveform_offset_(0),
+		num_frames_computed_(0) {
+	}
+
+	template <class C>
+	bool OnlineGenericBaseFeature<C>::AddStage(std::unique_ptr<OnlineFeatureStage> stage) {
+		if (!stage || input_finished_ || waveform_offset_ != 0 ||
+			!waveform_remainder_.empty() || stage->InputDim() != Dim()) {
+			return false;
+		}
+		stages_.push_back(std::move(stage));
+		stage_buffers_.resize(stages_.size() + 1);
+		return true;
+	}
+
+	template <class C>
+	bool OnlineGenericBaseFeature<C>::EnableVad(const EnergyVadOptions& opts,
+		VadEventCallback callback) {
+		if (vad_ || input_finished_ || waveform_offset_ != 0 ||
+			!waveform_remainder_.empty()) {
+			return false;
+		}
+		vad_.reset(new EnergyVad(opts, std::move(callback)));
+		vad_->SetMaxFlags(max_vad_flags_);
+		return true;
+	}
+
+	template <class C>
+	void OnlineGenericBaseFeature<C>::SetRetention(int32_t max_frames, int64_t max_bytes) {
+		features_.SetRetention(max_frames, max_bytes);
+
+		// one byte per flag
+		max_vad_flags_ = -1;
+		if (max_frames > 0) {
+			max_vad_flags_ = max_frames;
+		}
+		if (max_bytes > 0 && (max_vad_flags_ == -1 || max_bytes < max_vad_flags_)) {
+			max_vad_flags_ = static_cast<int32_t>(
+				std::min<int64_t>(max_bytes, std::numeric_limits<int32_t>::max()));
+		}
+		if (vad_) {
+			vad_->SetMaxFlags(max_vad_flags_);
+			if (stages_.empty()) {
+				vad_->ReleaseSpeechFrames(features_.FirstAvailableIndex());
+			}
+		}
+	}
+
+	template <class C>
+	int32_t OnlineGenericBaseFeature<C>::StageLatency() const {
+		int32_t latency = 0;
+		for (const auto& stage : stages_) {
+			latency += stage->Latency();
+		}
+		return latency;
 	}
 
 	template <class C>
@@ -92,49 +521,143 @@ namespace knf {
 			KNF_LOG(FATAL) << "AcceptWaveform called after InputFinished() was called.";
 		}
 
-		KNF_CHECK_EQ(sampling_rate, computer_.GetFrameOptions().samp_freq);
-
-		waveform_remainder_.insert(waveform_remainder_.end(), waveform, waveform + n);
+		if (MaybeCreateResampler(sampling_rate)) {
+			resampler_->Resample(waveform, n, false, &resampled_);
+			waveform_remainder_.insert(waveform_remainder_.end(), resampled_.begin(),
+				resampled_.end());
+		}
+		else {
+			KNF_CHECK_EQ(sampling_rate, computer_.GetFrameOptions().samp_freq);
+			waveform_remainder_.insert(waveform_remainder_.end(), waveform, waveform + n);
+		}
 
 		ComputeFeatures();
 	}
 
 	template <class C>
 	void OnlineGenericBaseFeature<C>::InputFinished() {
+		if (resampler_ && !input_finished_) {
+			// the last few output samples need the zeros after the end
+			resampler_->Resample(nullptr, 0, true, &resampled_);
+			waveform_remainder_.insert(waveform_remainder_.end(), resampled_.begin(),
+				resampled_.end());
+		}
 		input_finished_ = true;
 		ComputeFeatures();
 	}
 
+	template <class C>
+	bool OnlineGenericBaseFeature<C>::MaybeCreateResampler(float sampling_rate) {
+		const FrameExtractionOptions& frame_opts = computer_.GetFrameOptions();
+		float expected_sampling_rate = frame_opts.samp_freq;
+		if (resampler_) {
+			KNF_CHECK_EQ(resampler_->GetInputSamplingRate(), sampling_rate);
+			return true;
+		}
+		if ((sampling_rate > expected_sampling_rate && frame_opts.allow_downsample) ||
+			(sampling_rate < expected_sampling_rate && frame_opts.allow_upsample)) {
+			// the same filter as Kaldi's OnlineGenericBaseFeature uses
+			resampler_ = std::make_unique<LinearResample>(
+				static_cast<int32_t>(sampling_rate),
+				static_cast<int32_t>(expected_sampling_rate),
+				std::min(sampling_rate / 2, expected_sampling_rate / 2), 6);
+			return true;
+		}
+		return false;
+	}
+
 	template <class C>
 	void OnlineGenericBaseFeature<C>::ComputeFeatures() {
 		const FrameExtractionOptions& frame_opts = computer_.GetFrameOptions();
 
 		int64_t num_samples_total = waveform_offset_ + waveform_remainder_.size();
 
-		int32_t num_frames_old = features_.Size();
+		int32_t num_frames_old = num_frames_computed_;
 
 		int32_t num_frames_new =
 			NumFrames(num_samples_total, frame_opts, input_finished_);
 
 		KNF_CHECK_GE(num_frames_new, num_frames_old);
 
+#if KNF_ENABLE_STATS
+		// charge the KNF_STATS_SCOPE()s below and in computer_ to this stream
+		ScopedStatsCollector stats_scope(&stats_);
+		stats_.AddFrames(num_frames_new - num_frames_old);
+#endif
+
 		// note: this online feature-extraction code does not support VTLN.
 		float vtln_warp = 1.0;
 
-		std::vector<float> window;
+		float* window = window_.data();
 		bool need_raw_log_energy = computer_.NeedRawLogEnergy();
 
+		bool has_stages = !stages_.empty();
+		if (frames_callback_ && !has_stages) {
+			callback_block_.clear();
+		}
+		if (has_stages) {
+			stage_buffers_[0].resize(
+				static_cast<size_t>(num_frames_new - num_frames_old) * computer_.Dim());
+		}
+
+		// frames passed on; fewer than num_frames_new - num_frames_old if the
+		// VAD drops silence
+		int32_t num_computed = 0;
+		int32_t first_output_frame = features_.Size();
+
+		int32_t dim = computer_.Dim();
 		for (int32_t frame = num_frames_old; frame < num_frames_new; ++frame) {
-			std::fill(window.begin(), window.end(), 0);
 			float raw_log_energy = 0.0;
-			ExtractWindow(waveform_offset_, waveform_remainder_, frame, frame_opts,
-				window_function_, &window,
-				need_raw_log_energy ? &raw_log_energy : nullptr);
+			float zero_crossing_rate = 0.0;
+			{
+				KNF_STATS_SCOPE(kWindow);
+				ExtractWindow(waveform_offset_, waveform_remainder_.data(),
+					static_cast<int32_t>(waveform_remainder_.size()), frame, frame_opts,
+					window_function_, window,
+					(need_raw_log_energy || vad_) ? &raw_log_energy : nullptr,
+					vad_ ? &zero_crossing_rate : nullptr);
+			}
+
+			if (vad_ && !vad_->AcceptFrame(raw_log_energy, zero_crossing_rate)) {
+				continue;  // silence: skip the FFT and everything after it
+			}
+			++num_computed;
 
-			std::vector<float> this_feature(computer_.Dim());
+			if (has_stages) {
+				float* this_feature = stage_buffers_[0].data() +
+					static_cast<size_t>(num_computed - 1) * dim;
+				computer_.Compute(raw_log_energy, vtln_warp, window, this_feature);
+				continue;
+			}
+
+			// computed in place; readers see it after CommitBack()
+			float* this_feature = features_.PrepareBack(dim);
 
-			computer_.Compute(raw_log_energy, vtln_warp, &window, this_feature.data());
-			features_.PushBack(std::move(this_feature));
+			computer_.Compute(raw_log_energy, vtln_warp, window, this_feature);
+			if (frames_callback_) {
+				KNF_STATS_SCOPE(kCopy);
+				callback_block_.insert(callback_block_.end(), this_feature,
+					this_feature + dim);
+			}
+			features_.CommitBack();
+		}
+		num_frames_computed_ = num_frames_new;
+		if (vad_ && input_finished_) {
+			vad_->InputFinished();
+		}
+		if (vad_ && !has_stages) {
+			// stored frames are speech frames; without stages their indices
+			// are the same, so the flags can follow the frame store
+			vad_->ReleaseSpeechFrames(features_.FirstAvailableIndex());
+		}
+
+		if (has_stages) {
+			if (num_computed > 0 || input_finished_) {
+				RunStages(num_computed);
+			}
+		}
+		else if (frames_callback_ && num_computed > 0) {
+			frames_callback_(callback_block_.data(), num_computed, first_output_frame);
 		}
 
 		// OK, we will now discard any portion of the signal that will not be
@@ -166,9 +689,162 @@ namespace knf {
 		}
 	}
 
+	template <class C>
+	void OnlineGenericBaseFeature<C>::RunStages(int32_t num_frames) {
+		const float* in = stage_buffers_[0].data();
+		int32_t n = num_frames;
+		for (size_t i = 0; i != stages_.size(); ++i) {
+			std::vector<float>& out = stage_buffers_[i + 1];
+			out.clear();
+			stages_[i]->Process(in, n, input_finished_, &out);
+			in = out.data();
+			n = static_cast<int32_t>(out.size() / stages_[i]->Dim());
+		}
+
+		KNF_STATS_SCOPE(kCopy);
+		int32_t dim = Dim();
+		int32_t first_frame = features_.Size();
+		for (int32_t f = 0; f != n; ++f) {
+			const float* src = in + static_cast<size_t>(f) * dim;
+			std::copy(src, src + dim, features_.PrepareBack(dim));
+			features_.CommitBack();
+		}
+
+		if (frames_callback_ && n > 0) {
+			frames_callback_(in, n, first_frame);
+		}
+	}
+
+	template <class C>
+	bool OnlineGenericBaseFeature<C>::SaveState(std::string* state) const {
+		if (!stages_.empty() || vad_) {
+			return false;
+		}
+
+		std::string out(kStateMagic, sizeof(kStateMagic));
+		AppendState(kStateVersion, &out);
+		AppendState(OptionsFingerprint(computer_.GetOptions().ToString()), &out);
+		AppendState(static_cast<uint8_t>(input_finished_ ? 1 : 0), &out);
+		AppendState(waveform_offset_, &out);
+		AppendState(static_cast<uint32_t>(waveform_remainder_.size()), &out);
+		AppendStateFloats(waveform_remainder_.data(), waveform_remainder_.size(), &out);
+
+		// Frames may be released concurrently, failing Read(); then try
+		// again from the new first frame.
+		int32_t num_frames = features_.Size();
+		int32_t dim = computer_.Dim();
+		int32_t first = 0;
+		int32_t n = -1;
+		std::vector<float> frames;
+		while (n == -1) {
+			first = features_.FirstAvailableIndex();
+			frames.resize(static_cast<size_t>(num_frames - first) * dim);
+			n = features_.Read(first, num_frames, frames.data());
+		}
+		AppendState(first, &out);
+		AppendState(num_frames, &out);
+		AppendState(dim, &out);
+		AppendStateFloats(frames.data(), static_cast<size_t>(n) * dim, &out);
+
+		if (resampler_) {
+			LinearResample::State resampler_state = resampler_->GetState();
+			AppendState(resampler_->GetInputSamplingRate(), &out);
+			AppendState(resampler_state.input_sample_offset, &out);
+			AppendState(resampler_state.output_sample_offset, &out);
+			AppendState(static_cast<uint32_t>(resampler_state.input_remainder.size()), &out);
+			AppendStateFloats(resampler_state.input_remainder.data(),
+				resampler_state.input_remainder.size(), &out);
+		}
+		else {
+			AppendState(static_cast<int32_t>(0), &out);
+		}
+
+		state->append(out);
+		return true;
+	}
+
+	template <class C>
+	bool OnlineGenericBaseFeature<C>::LoadState(const uint8_t* data, size_t size) {
+		if (!stages_.empty() || vad_ || resampler_ || input_finished_ ||
+			waveform_offset_ != 0 || !waveform_remainder_.empty() ||
+			features_.Size() != 0 || data == nullptr) {
+			return false;
+		}
+
+		// Check everything before changing anything
+		StateReader reader(data, size);
+		char magic[sizeof(kStateMagic)];
+		uint32_t version = 0;
+		uint64_t fingerprint = 0;
+		uint8_t input_finished = 0;
+		int64_t waveform_offset = 0;
+		uint32_t num_samples = 0;
+		const uint8_t* samples = nullptr;
+		int32_t first = 0;
+		int32_t num_frames = 0;
+		int32_t dim = 0;
+		const uint8_t* frames = nullptr;
+		int32_t resampler_rate = 0;
+		LinearResample::State resampler_state;
+		uint32_t num_remainder = 0;
+		const uint8_t* remainder = nullptr;
+
+		if (!reader.Read(&magic) ||
+			std::memcmp(magic, kStateMagic, sizeof(magic)) != 0 ||
+			!reader.Read(&version) || version != kStateVersion ||
+			!reader.Read(&fingerprint) ||
+			fingerprint != OptionsFingerprint(computer_.GetOptions().ToString()) ||
+			!reader.Read(&input_finished) || input_finished > 1 ||
+			!reader.Read(&waveform_offset) || waveform_offset < 0 ||
+			!reader.Read(&num_samples) || !reader.ReadFloats(num_samples, &samples) ||
+			!reader.Read(&first) || !reader.Read(&num_frames) ||
+			first < 0 || num_frames < first ||
+			!reader.Read(&dim) || dim != computer_.Dim() ||
+			!reader.ReadFloats(static_cast<size_t>(num_frames - first) * dim, &frames) ||
+			!reader.Read(&resampler_rate) || resampler_rate < 0) {
+			return false;
+		}
+		if (resampler_rate != 0 &&
+			(!reader.Read(&resampler_state.input_sample_offset) ||
+				!reader.Read(&resampler_state.output_sample_offset) ||
+				!reader.Read(&num_remainder) ||
+				!reader.ReadFloats(num_remainder, &remainder))) {
+			return false;
+		}
+		if (!reader.AtEnd()) {
+			return false;
+		}
+		if (resampler_rate != 0 &&
+			!MaybeCreateResampler(static_cast<float>(resampler_rate))) {
+			return false;  // the options do not allow it
+		}
+
+		if (resampler_) {
+			resampler_state.input_remainder.resize(num_remainder);
+			CopyStateFloats(remainder, num_remainder,
+				resampler_state.input_remainder.data());
+			resampler_->SetState(resampler_state);
+		}
+
+		input_finished_ = input_finished != 0;
+		waveform_offset_ = waveform_offset;
+		waveform_remainder_.resize(num_samples);
+		CopyStateFloats(samples, num_samples, waveform_remainder_.data());
+
+		features_.StartAt(first);
+		for (int32_t f = first; f != num_frames; ++f) {
+			CopyStateFloats(frames + static_cast<size_t>(f - first) * dim * sizeof(float),
+				dim, features_.PrepareBack(dim));
+			features_.CommitBack();
+		}
+		num_frames_computed_ = num_frames;
+		return true;
+	}
+
 	template class OnlineGenericBaseFeature<FbankComputer>;
 	template class OnlineGenericBaseFeature<MfccComputer>;
 	template class OnlineGenericBaseFeature<WhisperFeatureComputer>;
+	template class OnlineGenericBaseFeature<MultiFeatureComputer>;
 
 	// ʵ
 	OnlineFbankAdapter::OnlineFbankAdapter(const FbankComputer::Options& opts) : impl_(opts) {}
@@ -197,6 +873,62 @@ namespace knf {
 		return impl_.Dim();
 	}
 
+	void OnlineFbankAdapter::SetFramesCallback(FramesReadyCallback callback) {
+		impl_.SetFramesCallback(std::move(callback));
+	}
+
+	int32_t OnlineFbankAdapter::ReadFrames(int32_t begin, int32_t end, float* out) const {
+		return impl_.ReadFrames(begin, end, out);
+	}
+
+	void OnlineFbankAdapter::ReleaseFrames(int32_t end) {
+		impl_.ReleaseFrames(end);
+	}
+
+	void OnlineFbankAdapter::SetRetention(int32_t max_frames, int64_t max_bytes) {
+		impl_.SetRetention(max_frames, max_bytes);
+	}
+
+	FrameStoreStats OnlineFbankAdapter::GetFrameStoreStats() const {
+		return impl_.GetFrameStoreStats();
+	}
+
+	FeatureStats OnlineFbankAdapter::GetFeatureStats() const {
+		return impl_.GetFeatureStats();
+	}
+
+	void OnlineFbankAdapter::ResetFeatureStats() {
+		impl_.ResetFeatureStats();
+	}
+
+	bool OnlineFbankAdapter::AddStage(std::unique_ptr<OnlineFeatureStage> stage) {
+		return impl_.AddStage(std::move(stage));
+	}
+
+	int32_t OnlineFbankAdapter::StageLatency() const {
+		return impl_.StageLatency();
+	}
+
+	bool OnlineFbankAdapter::EnableVad(const EnergyVadOptions& opts, VadEventCallback callback) {
+		return impl_.EnableVad(opts, std::move(callback));
+	}
+
+	const EnergyVad* OnlineFbankAdapter::GetVad() const {
+		return impl_.GetVad();
+	}
+
+	std::string OnlineFbankAdapter::OptionsString() const {
+		return impl_.GetComputer().GetOptions().ToString();
+	}
+
+	bool OnlineFbankAdapter::SaveState(std::string* state) const {
+		return impl_.SaveState(state);
+	}
+
+	bool OnlineFbankAdapter::LoadState(const uint8_t* data, size_t size) {
+		return impl_.LoadState(data, size);
+	}
+
 	// OnlineMfccAdapter ʵ
 	OnlineMfccAdapter::OnlineMfccAdapter(const MfccComputer::Options& opts) : impl_(opts) {}
 
@@ -224,6 +956,62 @@ namespace knf {
 		return impl_.Dim();
 	}
 
+	void OnlineMfccAdapter::SetFramesCallback(FramesReadyCallback callback) {
+		impl_.SetFramesCallback(std::move(callback));
+	}
+
+	int32_t OnlineMfccAdapter::ReadFrames(int32_t begin, int32_t end, float* out) const {
+		return impl_.ReadFrames(begin, end, out);
+	}
+
+	void OnlineMfccAdapter::ReleaseFrames(int32_t end) {
+		impl_.ReleaseFrames(end);
+	}
+
+	void OnlineMfccAdapter::SetRetention(int32_t max_frames, int64_t max_bytes) {
+		impl_.SetRetention(max_frames, max_bytes);
+	}
+
+	FrameStoreStats OnlineMfccAdapter::GetFrameStoreStats() const {
+		return impl_.GetFrameStoreStats();
+	}
+
+	FeatureStats OnlineMfccAdapter::GetFeatureStats() const {
+		return impl_.GetFeatureStats();
+	}
+
+	void OnlineMfccAdapter::ResetFeatureStats() {
+		impl_.ResetFeatureStats();
+	}
+
+	bool OnlineMfccAdapter::AddStage(std::unique_ptr<OnlineFeatureStage> stage) {
+		return impl_.AddStage(std::move(stage));
+	}
+
+	int32_t OnlineMfccAdapter::StageLatency() const {
+		return impl_.StageLatency();
+	}
+
+	bool OnlineMfccAdapter::EnableVad(const EnergyVadOptions& opts, VadEventCallback callback) {
+		return impl_.EnableVad(opts, std::move(callback));
+	}
+
+	const EnergyVad* OnlineMfccAdapter::GetVad() const {
+		return impl_.GetVad();
+	}
+
+	std::string OnlineMfccAdapter::OptionsString() const {
+		return impl_.GetComputer().GetOptions().ToString();
+	}
+
+	bool OnlineMfccAdapter::SaveState(std::string* state) const {
+		return impl_.SaveState(state);
+	}
+
+	bool OnlineMfccAdapter::LoadState(const uint8_t* data, size_t size) {
+		return impl_.LoadState(data, size);
+	}
+
 	// OnlineWhisperFbankAdapter ʵ
 	OnlineWhisperFbankAdapter::OnlineWhisperFbankAdapter(const WhisperFeatureComputer::Options& opts)
 		: impl_(opts) {
@@ -253,4 +1041,153 @@ namespace knf {
 		return impl_.Dim();
 	}
 
+	void OnlineWhisperFbankAdapter::SetFramesCallback(FramesReadyCallback callback) {
+		impl_.SetFramesCallback(std::move(callback));
+	}
+
+	int32_t OnlineWhisperFbankAdapter::ReadFrames(int32_t begin, int32_t end, float* out) const {
+		return impl_.ReadFrames(begin, end, out);
+	}
+
+	void OnlineWhisperFbankAdapter::ReleaseFrames(int32_t end) {
+		impl_.ReleaseFrames(end);
+	}
+
+	void OnlineWhisperFbankAdapter::SetRetention(int32_t max_frames, int64_t max_bytes) {
+		impl_.SetRetention(max_frames, max_bytes);
+	}
+
+	FrameStoreStats OnlineWhisperFbankAdapter::GetFrameStoreStats() const {
+		return impl_.GetFrameStoreStats();
+	}
+
+	FeatureStats OnlineWhisperFbankAdapter::GetFeatureStats() const {
+		return impl_.GetFeatureStats();
+	}
+
+	void OnlineWhisperFbankAdapter::ResetFeatureStats() {
+		impl_.ResetFeatureStats();
+	}
+
+	bool OnlineWhisperFbankAdapter::AddStage(std::unique_ptr<OnlineFeatureStage> stage) {
+		return impl_.AddStage(std::move(stage));
+	}
+
+	int32_t OnlineWhisperFbankAdapter::StageLatency() const {
+		return impl_.StageLatency();
+	}
+
+	bool OnlineWhisperFbankAdapter::EnableVad(const EnergyVadOptions& opts, VadEventCallback callback) {
+		return impl_.EnableVad(opts, std::move(callback));
+	}
+
+	const EnergyVad* OnlineWhisperFbankAdapter::GetVad() const {
+		return impl_.GetVad();
+	}
+
+	std::string OnlineWhisperFbankAdapter::OptionsString() const {
+		return impl_.GetComputer().GetOptions().ToString();
+	}
+
+	bool OnlineWhisperFbankAdapter::SaveState(std::string* state) const {
+		return impl_.SaveState(state);
+	}
+
+	bool OnlineWhisperFbankAdapter::LoadState(const uint8_t* data, size_t size) {
+		return impl_.LoadState(data, size);
+	}
+
+	// OnlineMultiFeatureAdapter
+	OnlineMultiFeatureAdapter::OnlineMultiFeatureAdapter(const MultiFeatureComputer::Options& opts)
+		: impl_(opts) {
+	}
+
+	void OnlineMultiFeatureAdapter::AcceptWaveform(float sampling_rate, const float* waveform, int32_t n) {
+		impl_.AcceptWaveform(sampling_rate, waveform, n);
+	}
+
+	void OnlineMultiFeatureAdapter::InputFinished() {
+		impl_.InputFinished();
+	}
+
+	void OnlineMultiFeatureAdapter::Pop(int32_t n) {
+		impl_.Pop(n);
+	}
+
+	int32_t OnlineMultiFeatureAdapter::NumFramesReady() const {
+		return impl_.NumFramesReady();
+	}
+
+	const float* OnlineMultiFeatureAdapter::GetFrame(int32_t frame) const {
+		return impl_.GetFrame(frame);
+	}
+
+	int32_t OnlineMultiFeatureAdapter::Dim() const {
+		return impl_.Dim();
+	}
+
+	void OnlineMultiFeatureAdapter::SetFramesCallback(FramesReadyCallback callback) {
+		impl_.SetFramesCallback(std::move(callback));
+	}
+
+	int32_t OnlineMultiFeatureAdapter::ReadFrames(int32_t begin, int32_t end, float* out) const {
+		return impl_.ReadFrames(begin, end, out);
+	}
+
+	void OnlineMultiFeatureAdapter::ReleaseFrames(int32_t end) {
+		impl_.ReleaseFrames(end);
+	}
+
+	void OnlineMultiFeatureAdapter::SetRetention(int32_t max_frames, int64_t max_bytes) {
+		impl_.SetRetention(max_frames, max_bytes);
+	}
+
+	FrameStoreStats OnlineMultiFeatureAdapter::GetFrameStoreStats() const {
+		return impl_.GetFrameStoreStats();
+	}
+
+	FeatureStats OnlineMultiFeatureAdapter::GetFeatureStats() const {
+		return impl_.GetFeatureStats();
+	}
+
+	void OnlineMultiFeatureAdapter::ResetFeatureStats() {
+		impl_.ResetFeatureStats();
+	}
+
+	bool OnlineMultiFeatureAdapter::AddStage(std::unique_ptr<OnlineFeatureStage> stage) {
+		return impl_.AddStage(std::move(stage));
+	}
+
+	int32_t OnlineMultiFeatureAdapter::StageLatency() const {
+		return impl_.StageLatency();
+	}
+
+	bool OnlineMultiFeatureAdapter::EnableVad(const EnergyVadOptions& opts, VadEventCallback callback) {
+		return impl_.EnableVad(opts, std::move(callback));
+	}
+
+	const EnergyVad* OnlineMultiFeatureAdapter::GetVad() const {
+		return impl_.GetVad();
+	}
+
+	std::string OnlineMultiFeatureAdapter::OptionsString() const {
+		return impl_.GetComputer().GetOptions().ToString();
+	}
+
+	bool OnlineMultiFeatureAdapter::SaveState(std::string* state) const {
+		return impl_.SaveState(state);
+	}
+
+	bool OnlineMultiFeatureAdapter::LoadState(const uint8_t* data, size_t size) {
+		return impl_.LoadState(data, size);
+	}
+
+	int32_t OnlineMultiFeatureAdapter::HeadOffset(FeatureHead head) const {
+		return impl_.GetComputer().HeadOffset(head);
+	}
+
+	int32_t OnlineMultiFeatureAdapter::HeadDim(FeatureHead head) const {
+		return impl_.GetComputer().HeadDim(head);
+	}
+
 }  // namespace knf
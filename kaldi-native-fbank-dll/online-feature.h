@@ -21,17 +21,37 @@
 #ifndef KALDI_NATIVE_FBANK_CSRC_ONLINE_FEATURE_H_
 #define KALDI_NATIVE_FBANK_CSRC_ONLINE_FEATURE_H_
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "energy-vad.h"
 #include "feature-fbank.h"
 #include "feature-mfcc.h"
+#include "feature-multi.h"
+#include "feature-stage.h"
+#include "feature-stats.h"
 #include "feature-window.h"
+#include "frame-dispatcher.h"
+#include "resample.h"
 #include "whisper-feature.h"
 
 namespace knf {
 
+	// Memory used by a RecyclingVector, see RecyclingVector::GetStats()
+	struct FrameStoreStats {
+		int32_t num_frames = 0;             // frames computed so far
+		int32_t first_available_index = 0;  // frames below it were released
+		int32_t retained_frames = 0;        // num_frames - first_available_index
+		int32_t peak_retained_frames = 0;
+		int64_t retained_bytes = 0;         // memory held for frame data
+		int64_t peak_retained_bytes = 0;
+	};
+
 	/// This class serves as a storage for feature vectors with an option to limit
 	/// the memory usage by removing old elements. The deleted frames indices are
 	/// "remembered" so that regardless of the MAX_ITEMS setting, the user always
@@ -39,33 +59,159 @@ namespace knf {
 	/// This is useful when processing very long recordings which would otherwise
 	/// cause the memory to eventually blow up when the features are not being
 	/// removed.
+	///
+	/// Frames are stored in fixed-size chunks that never move, and Size() is an
+	/// atomic "published" watermark. One writer thread may call PushBack() (or
+	/// PrepareBack()/CommitBack()) while other threads call Size(), At(), Read()
+	/// and Pop()/Release() without any lock: a frame below Size() stays valid
+	/// until it is released. Released chunks are reclaimed by the writer, but
+	/// only once no Read() that started before the release is still running
+	/// (see ReaderGuard), so Read() is safe against any concurrent release. A
+	/// pointer returned by At() is not covered; it must not be used after its
+	/// frame was released.
 	class RecyclingVector {
 	public:
 		/// By default it does not remove any elements.
 		explicit RecyclingVector(int32_t items_to_hold = -1);
 
-		~RecyclingVector() = default;
+		~RecyclingVector();
 		RecyclingVector(const RecyclingVector&) = delete;
 		RecyclingVector& operator=(const RecyclingVector&) = delete;
 
 		// The pointer is owned by RecyclingVector
-		// Users should not free it
+		// Users should not free it. It stays valid until the frame is released.
 		const float* At(int32_t index) const;
 
 		void PushBack(std::vector<float> item);
 
+		// Writer only. Return storage for the next frame, of size dim. It is
+		// not visible to readers until CommitBack() is called. All frames
+		// must have the same dim.
+		float* PrepareBack(int32_t dim);
+		void CommitBack();
+
 		/// This method returns the size as if no "recycling" had happened,
 		/// i.e. equivalent to the number of times the PushBack method has been
 		/// called.
 		int32_t Size() const;
 
+		// Index of the oldest frame that has not been released
+		int32_t FirstAvailableIndex() const;
+
+		// Copy frames [begin, end) to out, which must have room for
+		// (end - begin) * Dim() floats. end is clipped to Size(). Returns the
+		// number of frames copied, starting at begin, or -1 (copying nothing)
+		// if begin < FirstAvailableIndex(), i.e. some of the frames were
+		// already released.
+		int32_t Read(int32_t begin, int32_t end, float* out) const;
+
 		// discard the first n frames
 		void Pop(int32_t n);
 
+		// discard all frames with index < end
+		void Release(int32_t end);
+
+		// 0 until the first frame is pushed
+		int32_t Dim() const { return dim_.load(std::memory_order_acquire); }
+
+		// Writer only. Keep at most max_frames frames and at most max_bytes
+		// bytes of frame data; older frames are released as new ones are
+		// committed. -1 means no limit. At least one frame is always kept.
+		void SetRetention(int32_t max_frames, int64_t max_bytes);
+
+		FrameStoreStats GetStats() const;
+
+		// Writer only, while Size() == 0. Make index the index of the next
+		// frame pushed, as if the frames before it had been pushed and
+		// released, e.g. to resume a stream from a saved state.
+		void StartAt(int32_t index);
+
 	private:
-		std::deque<std::vector<float>> items_;
+		// Number of frames per chunk
+		static constexpr int32_t kChunkSize = 64;
+
+		// Chunk i holds frames [i * kChunkSize, (i + 1) * kChunkSize); the
+		// table holds chunks [base, base + capacity). It is replaced (never
+		// modified in place) when it is full, by one that starts at the
+		// oldest chunk not freed yet, so its size follows the retained
+		// frames rather than all frames pushed. Entries of released chunks
+		// are left as they are: a reader that started before the release
+		// may still look them up.
+		struct ChunkTable {
+			ChunkTable(int32_t base, int32_t capacity);
+			int32_t base;
+			int32_t capacity;
+			std::unique_ptr<std::atomic<float*>[]> chunks;
+		};
+
+		// Chunks and tables that readers may still use, see ReaderGuard
+		struct Retired {
+			bool Empty() const { return chunks.empty() && tables.empty(); }
+			std::vector<float*> chunks;
+			std::vector<std::unique_ptr<ChunkTable>> tables;
+		};
+
+		// Registers a reader in readers_[epoch_ % 2] for its lifetime. The
+		// writer retires released chunks and replaced tables to retired_,
+		// and at the next reclaim moves them to draining_ and bumps epoch_;
+		// they are freed once the readers of the previous epoch have all
+		// left, as every reader that came later saw the release.
+		class ReaderGuard {
+		public:
+			explicit ReaderGuard(const RecyclingVector* v);
+			~ReaderGuard();
+			ReaderGuard(const ReaderGuard&) = delete;
+			ReaderGuard& operator=(const ReaderGuard&) = delete;
+
+		private:
+			std::atomic<int32_t>* readers_;
+		};
+
+		// index must be in table, i.e. the table was loaded after Size()
+		// and before FirstAvailableIndex()
+		const float* RowAddress(const ChunkTable* table, int32_t index) const;
+		float* NewChunk();
+		// Writer only. Publish a table for chunks [first_unfreed_chunk_,
+		// end_chunk) and more, and retire the current one.
+		void ReplaceTable(int32_t end_chunk);
+		// Writer only. Retire the chunks below FirstAvailableIndex() and free
+		// what was retired and no reader can still use.
+		void FreeReleasedChunks();
+		void FreeChunk(float* chunk);
+		void UpdateItemsToHold();
+
+		std::atomic<ChunkTable*> table_;
+		std::unique_ptr<ChunkTable> table_owner_;  // writer only
+
+		mutable std::atomic<uint32_t> epoch_;
+		mutable std::atomic<int32_t> readers_[2];
+		// writer only, see ReaderGuard
+		Retired retired_;
+		Retired draining_;
+
+		std::atomic<int32_t> dim_;
+		// writer only; items_to_hold_ is derived from the other two once
+		// dim_ is known
+		int32_t max_frames_;
+		int64_t max_bytes_;
 		int32_t items_to_hold_;
-		int32_t first_available_index_;
+		std::atomic<int32_t> first_available_index_;
+		std::atomic<int32_t> size_;
+
+		// writer only: chunks below first_live_chunk_ have been retired,
+		// those below first_draining_chunk_ moved to draining_ and those
+		// below first_unfreed_chunk_ freed
+		int32_t first_live_chunk_;
+		int32_t first_draining_chunk_;
+		int32_t first_unfreed_chunk_;
+		// writer only: a reclaimed chunk kept for reuse
+		float* spare_chunk_;
+
+		// chunks currently allocated, including spare_chunk_ and the retired
+		// ones not freed yet
+		std::atomic<int32_t> num_chunks_;
+		std::atomic<int32_t> peak_num_chunks_;
+		std::atomic<int32_t> peak_retained_frames_;
 	};
 
 	/// This is a templated class for online feature extraction;
@@ -77,7 +223,11 @@ namespace knf {
 		// Constructor from options class
 		explicit OnlineGenericBaseFeature(const typename C::Options& opts);
 
-		int32_t Dim() const { return computer_.Dim(); }
+		int32_t Dim() const {
+			return stages_.empty() ? computer_.Dim() : stages_.back()->Dim();
+		}
+
+		const C& GetComputer() const { return computer_; }
 
 		float FrameShiftInSeconds() const {
 			return computer_.GetFrameOptions().frame_shift_ms / 1000.0f;
@@ -93,10 +243,17 @@ namespace knf {
 
 		const float* GetFrame(int32_t frame) const { return features_.At(frame); }
 
+		// Thread-safe with respect to a concurrent AcceptWaveform(); see
+		// RecyclingVector::Read().
+		int32_t ReadFrames(int32_t begin, int32_t end, float* out) const {
+			return features_.Read(begin, end, out);
+		}
+
 		// This would be called from the application, when you get
-		// more wave data.  Note: the sampling_rate is only provided so
-		// the code can assert that it matches the sampling rate
-		// expected in the options.
+		// more wave data.  If sampling_rate differs from the sampling rate
+		// expected in the options, the waveform is resampled when
+		// frame_opts.allow_downsample / allow_upsample permit it; otherwise
+		// it must match.
 		//
 		// @param sampling_rate The sampling_rate of the input waveform
 		// @param waveform Pointer to a 1-D array of size n
@@ -105,13 +262,90 @@ namespace knf {
 
 		// InputFinished() tells the class you won't be providing any
 		// more waveform.  This will help flush out the last frame or two
-		// of features, in the case where snip-edges == false; it also
-		// affects the return value of IsLastFrame().
+		// of features, in the case where snip-edges == false (or the
+		// waveform is being resampled); it also affects the return value of
+		// IsLastFrame().
 		void InputFinished();
 
 		// discard the first n frames
 		void Pop(int32_t n) { features_.Pop(n); }
 
+		// discard all frames with index < end. Thread-safe with respect to a
+		// concurrent AcceptWaveform().
+		void ReleaseFrames(int32_t end) { features_.Release(end); }
+
+		// Bound the number of frames kept in memory, see
+		// RecyclingVector::SetRetention(). By default nothing is released
+		// until Pop() or ReleaseFrames() is called. The speech flags of a
+		// VAD are bounded by the same limits, see EnergyVad::SetMaxFlags().
+		void SetRetention(int32_t max_frames, int64_t max_bytes);
+
+		FrameStoreStats GetFrameStoreStats() const { return features_.GetStats(); }
+
+		// Per-stage timings of this stream. All zero unless built with
+		// KNF_ENABLE_STATS; see feature-stats.h.
+		FeatureStats GetFeatureStats() const {
+#if KNF_ENABLE_STATS
+			return stats_.Get();
+#else
+			return FeatureStats();
+#endif
+		}
+
+		void ResetFeatureStats() {
+#if KNF_ENABLE_STATS
+			stats_.Reset();
+#endif
+		}
+
+		// Append a stage that post-processes the computed frames before they
+		// are stored; NumFramesReady(), GetFrame(), Dim() and the frames
+		// callback then refer to the output of the last stage. Must be called
+		// before the first AcceptWaveform(). Returns false (and ignores the
+		// stage) if it is too late or stage->InputDim() != Dim().
+		bool AddStage(std::unique_ptr<OnlineFeatureStage> stage);
+
+		// Number of computed frames the output lags behind, summed over all
+		// stages
+		int32_t StageLatency() const;
+
+		// Classify every extracted frame with an EnergyVad and only compute
+		// features for speech frames; silence frames are dropped, so frame
+		// indices then count speech frames only (see VadEvent). The speech
+		// flags of frames before the first stored frame are released along
+		// with it (without stages), and at most the retention limit of
+		// flags is kept, so they stay bounded too. callback, if
+		// set, is invoked from AcceptWaveform()/InputFinished() at every
+		// segment boundary. Must be called before the first AcceptWaveform();
+		// returns false otherwise.
+		bool EnableVad(const EnergyVadOptions& opts, VadEventCallback callback);
+
+		// nullptr unless EnableVad() was called
+		const EnergyVad* GetVad() const { return vad_.get(); }
+
+		// If set, the callback is invoked at the end of every AcceptWaveform()
+		// and InputFinished() call that produced new frames, with all of those
+		// frames in one contiguous block. Pass an empty callback to disable it.
+		void SetFramesCallback(FramesReadyCallback callback) {
+			frames_callback_ = std::move(callback);
+		}
+
+		// Append the part of the state that depends on the waveform seen so
+		// far to *state: the samples kept for the next frames, the frames not
+		// released yet, the history of the resampler and whether the input
+		// has finished. Tables that follow from the options are not saved;
+		// LoadState() gets them from the shared caches again. Returns false
+		// if the stream has stages or a VAD, whose state is not captured.
+		bool SaveState(std::string* state) const;
+
+		// Resume from a state written by SaveState() of a stream with the
+		// same options, e.g. in another process. Must be called before the
+		// first AcceptWaveform(). Returns false, leaving the stream as it
+		// was, if it is too late, the options differ or the state is not
+		// valid. The callbacks and retention limits are not part of the
+		// state; set them again if needed.
+		bool LoadState(const uint8_t* data, size_t size);
+
 	private:
 		// This function computes any additional feature frames that it is possible to
 		// compute from 'waveform_remainder_', which at this point may contain more
@@ -121,10 +355,22 @@ namespace knf {
 		// waveform_remainder_ while incrementing waveform_offset_ by the same amount.
 		void ComputeFeatures();
 
+		// Run the num_frames frames in stage_buffers_[0] through stages_ and
+		// store the output.
+		void RunStages(int32_t num_frames);
+
+		// Create resampler_ if the waveform needs resampling and the options
+		// allow it; returns false if it doesn't need it.
+		bool MaybeCreateResampler(float sampling_rate);
+
 		C computer_;  // class that does the MFCC or PLP or filterbank computation
 
 		FeatureWindowFunction window_function_;
 
+		// One frame, padding included; ExtractWindow() writes it and the
+		// computer uses it as workspace
+		std::vector<float> window_;
+
 		// features_ is the Mfcc or Plp or Fbank features that we have already
 		// computed.
 
@@ -142,11 +388,41 @@ namespace knf {
 		// will be required for the next phase of computation).
 		// It is a 1-D tensor
 		std::vector<float> waveform_remainder_;
+
+		// Set iff AcceptWaveform() was called with a different sampling rate
+		// than the options expect
+		std::unique_ptr<LinearResample> resampler_;
+		// Output of resampler_, reused across calls
+		std::vector<float> resampled_;
+
+		// Number of frames computer_ has computed. The same as
+		// features_.Size() if there are no stages.
+		int32_t num_frames_computed_;
+
+		std::vector<std::unique_ptr<OnlineFeatureStage>> stages_;
+		std::unique_ptr<EnergyVad> vad_;
+		// see SetRetention(); -1 for no limit
+		int32_t max_vad_flags_ = -1;
+		// stage_buffers_[i] is the input of stages_[i]; the last one is the
+		// output of the last stage. Reused across calls.
+		std::vector<std::vector<float>> stage_buffers_;
+
+		FramesReadyCallback frames_callback_;
+
+		// Staging area for the frames passed to frames_callback_.
+		// It is reused across calls to avoid reallocation.
+		std::vector<float> callback_block_;
+
+#if KNF_ENABLE_STATS
+		FeatureStatsCollector stats_;
+#endif
 	};
 
 	using OnlineFbank = OnlineGenericBaseFeature<FbankComputer>;
 	using OnlineMfcc = OnlineGenericBaseFeature<MfccComputer>;
 	using OnlineWhisperFbank = OnlineGenericBaseFeature<WhisperFeatureComputer>;
+	// Several features per frame from one FFT, see MultiFeatureComputer
+	using OnlineMultiFeature = OnlineGenericBaseFeature<MultiFeatureComputer>;
 
 	// Abstract interface for online feature extractors
 	class IOnlineFeature {
@@ -170,6 +446,43 @@ namespace knf {
 
 		// Get feature dimension
 		virtual int32_t Dim() const = 0;
+
+		// Register a callback for newly computed frames. See
+		// OnlineGenericBaseFeature::SetFramesCallback().
+		virtual void SetFramesCallback(FramesReadyCallback callback) = 0;
+
+		// Copy frames [begin, end) to out; returns the number of frames copied,
+		// or -1 if some of them were released, see RecyclingVector::Read().
+		// May run concurrently with AcceptWaveform() on another thread.
+		virtual int32_t ReadFrames(int32_t begin, int32_t end, float* out) const = 0;
+
+		// Discard all frames with index < end. May run concurrently with
+		// AcceptWaveform() on another thread.
+		virtual void ReleaseFrames(int32_t end) = 0;
+
+		// Keep at most max_frames frames / max_bytes bytes; -1 means no limit.
+		virtual void SetRetention(int32_t max_frames, int64_t max_bytes) = 0;
+
+		virtual FrameStoreStats GetFrameStoreStats() const = 0;
+
+		virtual FeatureStats GetFeatureStats() const = 0;
+		virtual void ResetFeatureStats() = 0;
+
+		// See OnlineGenericBaseFeature::AddStage()
+		virtual bool AddStage(std::unique_ptr<OnlineFeatureStage> stage) = 0;
+		virtual int32_t StageLatency() const = 0;
+
+		// See OnlineGenericBaseFeature::EnableVad()
+		virtual bool EnableVad(const EnergyVadOptions& opts, VadEventCallback callback) = 0;
+		virtual const EnergyVad* GetVad() const = 0;
+
+		// The options of the feature computer as their ToString() prints
+		// them, e.g. for OptionsFingerprint(); stages are not included.
+		virtual std::string OptionsString() const = 0;
+
+		// See OnlineGenericBaseFeature::SaveState() and LoadState()
+		virtual bool SaveState(std::string* state) const = 0;
+		virtual bool LoadState(const uint8_t* data, size_t size) = 0;
 	};
 
 	// Adapter classes for specific feature extractors
@@ -183,6 +496,20 @@ namespace knf {
 		int32_t NumFramesReady() const override;
 		const float* GetFrame(int32_t frame) const override;
 		int32_t Dim() const override;
+		void SetFramesCallback(FramesReadyCallback callback) override;
+		int32_t ReadFrames(int32_t begin, int32_t end, float* out) const override;
+		void ReleaseFrames(int32_t end) override;
+		void SetRetention(int32_t max_frames, int64_t max_bytes) override;
+		FrameStoreStats GetFrameStoreStats() const override;
+		FeatureStats GetFeatureStats() const override;
+		void ResetFeatureStats() override;
+		bool AddStage(std::unique_ptr<OnlineFeatureStage> stage) override;
+		int32_t StageLatency() const override;
+		bool EnableVad(const EnergyVadOptions& opts, VadEventCallback callback) override;
+		const EnergyVad* GetVad() const override;
+		std::string OptionsString() const override;
+		bool SaveState(std::string* state) const override;
+		bool LoadState(const uint8_t* data, size_t size) override;
 
 	private:
 		OnlineFbank impl_;
@@ -198,6 +525,20 @@ namespace knf {
 		int32_t NumFramesReady() const override;
 		const float* GetFrame(int32_t frame) const override;
 		int32_t Dim() const override;
+		void SetFramesCallback(FramesReadyCallback callback) override;
+		int32_t ReadFrames(int32_t begin, int32_t end, float* out) const override;
+		void ReleaseFrames(int32_t end) override;
+		void SetRetention(int32_t max_frames, int64_t max_bytes) override;
+		FrameStoreStats GetFrameStoreStats() const override;
+		FeatureStats GetFeatureStats() const override;
+		void ResetFeatureStats() override;
+		bool AddStage(std::unique_ptr<OnlineFeatureStage> stage) override;
+		int32_t StageLatency() const override;
+		bool EnableVad(const EnergyVadOptions& opts, VadEventCallback callback) override;
+		const EnergyVad* GetVad() const override;
+		std::string OptionsString() const override;
+		bool SaveState(std::string* state) const override;
+		bool LoadState(const uint8_t* data, size_t size) override;
 
 	private:
 		OnlineMfcc impl_;
@@ -213,11 +554,58 @@ namespace knf {
 		int32_t NumFramesReady() const override;
 		const float* GetFrame(int32_t frame) const override;
 		int32_t Dim() const override;
+		void SetFramesCallback(FramesReadyCallback callback) override;
+		int32_t ReadFrames(int32_t begin, int32_t end, float* out) const override;
+		void ReleaseFrames(int32_t end) override;
+		void SetRetention(int32_t max_frames, int64_t max_bytes) override;
+		FrameStoreStats GetFrameStoreStats() const override;
+		FeatureStats GetFeatureStats() const override;
+		void ResetFeatureStats() override;
+		bool AddStage(std::unique_ptr<OnlineFeatureStage> stage) override;
+		int32_t StageLatency() const override;
+		bool EnableVad(const EnergyVadOptions& opts, VadEventCallback callback) override;
+		const EnergyVad* GetVad() const override;
+		std::string OptionsString() const override;
+		bool SaveState(std::string* state) const override;
+		bool LoadState(const uint8_t* data, size_t size) override;
 
 	private:
 		OnlineWhisperFbank impl_;
 	};
 
+	class OnlineMultiFeatureAdapter : public IOnlineFeature {
+	public:
+		explicit OnlineMultiFeatureAdapter(const MultiFeatureComputer::Options& opts);
+
+		void AcceptWaveform(float sampling_rate, const float* waveform, int32_t n) override;
+		void InputFinished() override;
+		void Pop(int32_t n) override;
+		int32_t NumFramesReady() const override;
+		const float* GetFrame(int32_t frame) const override;
+		int32_t Dim() const override;
+		void SetFramesCallback(FramesReadyCallback callback) override;
+		int32_t ReadFrames(int32_t begin, int32_t end, float* out) const override;
+		void ReleaseFrames(int32_t end) override;
+		void SetRetention(int32_t max_frames, int64_t max_bytes) override;
+		FrameStoreStats GetFrameStoreStats() const override;
+		FeatureStats GetFeatureStats() const override;
+		void ResetFeatureStats() override;
+		bool AddStage(std::unique_ptr<OnlineFeatureStage> stage) override;
+		int32_t StageLatency() const override;
+		bool EnableVad(const EnergyVadOptions& opts, VadEventCallback callback) override;
+		const EnergyVad* GetVad() const override;
+		std::string OptionsString() const override;
+		bool SaveState(std::string* state) const override;
+		bool LoadState(const uint8_t* data, size_t size) override;
+
+		// Where each head is in a frame, see MultiFeatureComputer
+		int32_t HeadOffset(FeatureHead head) const;
+		int32_t HeadDim(FeatureHead head) const;
+
+	private:
+		OnlineMultiFeature impl_;
+	};
+
 }  // namespace knf
 
 #endif  // KALDI_NATIVE_FBANK_CSRC_ONLINE_FEATURE_H_
@@ -0,0 +1,326 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is copied/modified from kaldi/src/feat/resample.cc
+
+#include "pch.h"
+#include "resample.h"
+
+#include <cmath>
+#include <map>
+#include <mutex>  // NOLINT
+#include <tuple>
+#include <vector>
+
+#include "kaldi-math.h"
+#include "log.h"
+
+namespace knf {
+
+struct LinearResample::Filter {
+  // The output grid repeats every output_samples_in_unit output samples,
+  // which span input_samples_in_unit input samples.
+  int32_t input_samples_in_unit;
+  int32_t output_samples_in_unit;
+
+  // For the i-th output sample of a unit: the index of the first input
+  // sample it uses, relative to the start of the unit, and the weights
+  std::vector<int32_t> first_index;
+  std::vector<std::vector<float>> weights;
+};
+
+namespace {
+
+int32_t Gcd(int32_t m, int32_t n) {
+  while (n != 0) {
+    int32_t r = m % n;
+    m = n;
+    n = r;
+  }
+  return m;
+}
+
+int64_t Lcm(int32_t m, int32_t n) {
+  return static_cast<int64_t>(m) / Gcd(m, n) * n;
+}
+
+// Hanning-windowed sinc, see LinearResample::FilterFunc() in Kaldi
+float FilterFunc(float t, float filter_cutoff, int32_t num_zeros) {
+  float window;
+  float filter;
+  if (std::fabs(t) < num_zeros / (2.0 * filter_cutoff)) {
+    window = 0.5 * (1 + std::cos(2 * M_PI * filter_cutoff / num_zeros * t));
+  } else {
+    window = 0.0;  // outside the support of the window function
+  }
+  if (t != 0) {
+    filter = std::sin(2 * M_PI * filter_cutoff * t) / (M_PI * t);
+  } else {
+    filter = 2 * filter_cutoff;  // limit of the function at t = 0
+  }
+  return filter * window;
+}
+
+std::shared_ptr<const LinearResample::Filter> CreateFilter(
+    int32_t samp_rate_in, int32_t samp_rate_out, float filter_cutoff,
+    int32_t num_zeros) {
+  auto filter = std::make_shared<LinearResample::Filter>();
+  int32_t base_freq = Gcd(samp_rate_in, samp_rate_out);
+  filter->input_samples_in_unit = samp_rate_in / base_freq;
+  filter->output_samples_in_unit = samp_rate_out / base_freq;
+
+  int32_t n = filter->output_samples_in_unit;
+  filter->first_index.resize(n);
+  filter->weights.resize(n);
+
+  double window_width = num_zeros / (2.0 * filter_cutoff);
+  for (int32_t i = 0; i < n; ++i) {
+    double output_t = i / static_cast<double>(samp_rate_out);
+    double min_t = output_t - window_width;
+    double max_t = output_t + window_width;
+    // we do ceil on the min and floor on the max, because if we did it
+    // the other way around we would unnecessarily include indexes just
+    // outside the window, with zero coefficients.
+    int32_t min_input_index = static_cast<int32_t>(std::ceil(min_t * samp_rate_in));
+    int32_t max_input_index = static_cast<int32_t>(std::floor(max_t * samp_rate_in));
+    int32_t num_indices = max_input_index - min_input_index + 1;
+    filter->first_index[i] = min_input_index;
+    filter->weights[i].resize(num_indices);
+    for (int32_t j = 0; j < num_indices; ++j) {
+      int32_t input_index = min_input_index + j;
+      double input_t = input_index / static_cast<double>(samp_rate_in);
+      double delta_t = input_t - output_t;
+      // sign of delta_t doesn't matter.
+      filter->weights[i][j] =
+          FilterFunc(delta_t, filter_cutoff, num_zeros) / samp_rate_in;
+    }
+  }
+  return filter;
+}
+
+// Filters for every set of parameters used so far. There are only a few
+// distinct sampling rates in practice, so they are never freed.
+std::shared_ptr<const LinearResample::Filter> GetFilter(
+    int32_t samp_rate_in, int32_t samp_rate_out, float filter_cutoff,
+    int32_t num_zeros) {
+  using Key = std::tuple<int32_t, int32_t, float, int32_t>;
+  static std::mutex *mutex = new std::mutex;
+  static auto *filters =
+      new std::map<Key, std::shared_ptr<const LinearResample::Filter>>;
+
+  Key key(samp_rate_in, samp_rate_out, filter_cutoff, num_zeros);
+  std::lock_guard<std::mutex> lock(*mutex);
+  auto &filter = (*filters)[key];
+  if (!filter) {
+    filter = CreateFilter(samp_rate_in, samp_rate_out, filter_cutoff,
+                          num_zeros);
+  }
+  return filter;
+}
+
+// Four independent partial sums, so that the compiler can keep them in one
+// SIMD register without reassociating a single sum.
+float Dot(const float *a, const float *b, int32_t n) {
+  float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  int32_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    s0 += a[i] * b[i];
+    s1 += a[i + 1] * b[i + 1];
+    s2 += a[i + 2] * b[i + 2];
+    s3 += a[i + 3] * b[i + 3];
+  }
+  for (; i < n; ++i) {
+    s0 += a[i] * b[i];
+  }
+  return (s0 + s1) + (s2 + s3);
+}
+
+}  // namespace
+
+LinearResample::LinearResample(int32_t samp_rate_in_hz,
+                               int32_t samp_rate_out_hz,
+                               float filter_cutoff_hz, int32_t num_zeros)
+    : samp_rate_in_(samp_rate_in_hz),
+      samp_rate_out_(samp_rate_out_hz),
+      filter_cutoff_(filter_cutoff_hz),
+      num_zeros_(num_zeros) {
+  KNF_CHECK(samp_rate_in_hz > 0 && samp_rate_out_hz > 0 &&
+            filter_cutoff_hz > 0.0 && filter_cutoff_hz * 2 <= samp_rate_in_hz &&
+            filter_cutoff_hz * 2 <= samp_rate_out_hz && num_zeros > 0);
+
+  filter_ = GetFilter(samp_rate_in_, samp_rate_out_, filter_cutoff_,
+                      num_zeros_);
+  Reset();
+}
+
+int64_t LinearResample::GetNumOutputSamples(int64_t input_num_samp,
+                                            bool flush) const {
+  // For exact computation, we measure time in "ticks" of 1.0 / tick_freq,
+  // where tick_freq is the least common multiple of samp_rate_in_ and
+  // samp_rate_out_.
+  int64_t tick_freq = Lcm(samp_rate_in_, samp_rate_out_);
+  int64_t ticks_per_input_period = tick_freq / samp_rate_in_;
+
+  // work out the number of ticks in the time interval
+  // [ 0, input_num_samp/samp_rate_in_ ).
+  int64_t interval_length_in_ticks = input_num_samp * ticks_per_input_period;
+  if (!flush) {
+    float window_width = num_zeros_ / (2.0 * filter_cutoff_);
+    // To count the window-width in ticks we take the floor. This
+    // is because since we're looking for the largest integer num-out-samp
+    // that fits in the interval, which is open on the right, a reduction
+    // in interval length of less than a tick will never make a difference.
+    int64_t window_width_ticks =
+        static_cast<int64_t>(std::floor(window_width * tick_freq));
+    interval_length_in_ticks -= window_width_ticks;
+  }
+  if (interval_length_in_ticks <= 0) {
+    return 0;
+  }
+
+  int64_t ticks_per_output_period = tick_freq / samp_rate_out_;
+  // Get the last output-sample in the closed interval, i.e. replacing [ ) with
+  // [ ].  Note: integer division rounds down.
+  int64_t last_output_samp = interval_length_in_ticks / ticks_per_output_period;
+  // We need the last output-sample in the open interval, so if it takes us to
+  // the end of the interval exactly, subtract one.
+  if (last_output_samp * ticks_per_output_period == interval_length_in_ticks) {
+    last_output_samp--;
+  }
+  // First output-sample index is zero, so the number of output samples
+  // is the last output-sample plus one.
+  return last_output_samp + 1;
+}
+
+void LinearResample::GetIndexes(int64_t samp_out, int64_t *first_samp_in,
+                                int32_t *samp_out_wrapped) const {
+  // A unit is the smallest nonzero amount of time that is an exact
+  // multiple of the input and output sample periods.
+  int64_t unit_index = samp_out / filter_->output_samples_in_unit;
+  *samp_out_wrapped =
+      static_cast<int32_t>(samp_out - unit_index * filter_->output_samples_in_unit);
+  *first_samp_in = filter_->first_index[*samp_out_wrapped] +
+                   unit_index * filter_->input_samples_in_unit;
+}
+
+void LinearResample::Resample(const float *input, int32_t input_dim,
+                              bool flush, std::vector<float> *output) {
+  int64_t tot_input_samp = input_sample_offset_ + input_dim;
+  int64_t tot_output_samp = GetNumOutputSamples(tot_input_samp, flush);
+
+  KNF_CHECK_GE(tot_output_samp, output_sample_offset_);
+
+  output->resize(tot_output_samp - output_sample_offset_);
+
+  int32_t remainder_dim = static_cast<int32_t>(input_remainder_.size());
+  std::vector<float> edge_samples;
+
+  // samp_out is the index into the total output signal, not just the part
+  // of it we are producing here.
+  for (int64_t samp_out = output_sample_offset_; samp_out < tot_output_samp;
+       samp_out++) {
+    int64_t first_samp_in;
+    int32_t samp_out_wrapped;
+    GetIndexes(samp_out, &first_samp_in, &samp_out_wrapped);
+    const std::vector<float> &weights = filter_->weights[samp_out_wrapped];
+    int32_t num_weights = static_cast<int32_t>(weights.size());
+    // first_input_index is the first index into "input" that we have a weight
+    // for.
+    int32_t first_input_index =
+        static_cast<int32_t>(first_samp_in - input_sample_offset_);
+    const float *samples;
+    if (first_input_index >= 0 && first_input_index + num_weights <= input_dim) {
+      samples = input + first_input_index;
+    } else {  // Handle edge cases.
+      // Gather the samples, so that the sum is the same Dot() whether the
+      // signal came in one piece or many.
+      edge_samples.assign(num_weights, 0.0f);
+      for (int32_t i = 0; i < num_weights; i++) {
+        int32_t input_index = first_input_index + i;
+        if (input_index < 0 && remainder_dim + input_index >= 0) {
+          edge_samples[i] = input_remainder_[remainder_dim + input_index];
+        } else if (input_index >= 0 && input_index < input_dim) {
+          edge_samples[i] = input[input_index];
+        } else if (input_index >= input_dim) {
+          // We're past the end of the input and are adding zero; should only
+          // happen if the user specified flush == true, or else we would not
+          // be trying to output this sample.
+          KNF_CHECK(flush);
+        }
+      }
+      samples = edge_samples.data();
+    }
+    (*output)[samp_out - output_sample_offset_] =
+        Dot(samples, weights.data(), num_weights);
+  }
+
+  if (flush) {
+    Reset();  // Reset the internal state.
+  } else {
+    SetRemainder(input, input_dim);
+    input_sample_offset_ = tot_input_samp;
+    output_sample_offset_ = tot_output_samp;
+  }
+}
+
+void LinearResample::SetRemainder(const float *input, int32_t input_dim) {
+  std::vector<float> old_remainder(input_remainder_);
+  int32_t old_dim = static_cast<int32_t>(old_remainder.size());
+  // max_remainder_needed is the width of the filter from side to side,
+  // measured in input samples.  you might think it should be half that,
+  // but you have to consider that you might be wanting to output samples
+  // that are "in the past" relative to the beginning of the latest
+  // input... anyway, storing more remainder than needed is not harmful.
+  int32_t max_remainder_needed = static_cast<int32_t>(
+      std::ceil(samp_rate_in_ * num_zeros_ / filter_cutoff_));
+  input_remainder_.assign(max_remainder_needed, 0.0f);
+  for (int32_t index = -max_remainder_needed; index < 0; index++) {
+    // we interpret "index" as an offset from the end of "input" and
+    // from the end of input_remainder_.
+    int32_t input_index = index + input_dim;
+    if (input_index >= 0) {
+      input_remainder_[index + max_remainder_needed] = input[input_index];
+    } else if (input_index + old_dim >= 0) {
+      input_remainder_[index + max_remainder_needed] =
+          old_remainder[input_index + old_dim];
+    }
+    // else leave it at zero.
+  }
+}
+
+void LinearResample::Reset() {
+  input_sample_offset_ = 0;
+  output_sample_offset_ = 0;
+  input_remainder_.clear();
+}
+
+LinearResample::State LinearResample::GetState() const {
+  State state;
+  state.input_sample_offset = input_sample_offset_;
+  state.output_sample_offset = output_sample_offset_;
+  state.input_remainder = input_remainder_;
+  return state;
+}
+
+void LinearResample::SetState(const State &state) {
+  input_sample_offset_ = state.input_sample_offset;
+  output_sample_offset_ = state.output_sample_offset;
+  input_remainder_ = state.input_remainder;
+}
+
+}  // namespace knf
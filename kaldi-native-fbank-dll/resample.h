@@ -0,0 +1,118 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is copied/modified from kaldi/src/feat/resample.h
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_RESAMPLE_H_
+#define KALDI_NATIVE_FBANK_CSRC_RESAMPLE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace knf {
+
+/*
+   LinearResample is a special case of resampling where the input and output
+   sampling rates are integers, so the output samples fall on a periodic
+   grid of input "phases". It uses a windowed-sinc filter with a Hanning
+   window, and its output is the same as that of Kaldi's LinearResample.
+
+   The polyphase filter table depends only on the constructor arguments and
+   is shared by every LinearResample with the same ones, so creating a
+   resampler per stream is cheap.
+
+   Usage: call Resample() with consecutive pieces of the signal and
+   flush == false, then once with flush == true (possibly with no input) to
+   get the last few samples. The output does not depend on how the signal is
+   split into pieces, down to the last bit.
+*/
+class LinearResample {
+ public:
+  /*
+    @param samp_rate_in_hz  Input sampling rate, in Hz
+    @param samp_rate_out_hz  Output sampling rate, in Hz
+    @param filter_cutoff_hz  Cutoff of the low-pass filter; it should be
+                 less than half of both sampling rates, e.g. 0.99 times
+                 that.
+    @param num_zeros  Number of zeros of the windowed sinc on each side,
+                 which controls the sharpness of the filter. Kaldi uses 6.
+  */
+  LinearResample(int32_t samp_rate_in_hz, int32_t samp_rate_out_hz,
+                 float filter_cutoff_hz, int32_t num_zeros);
+
+  // Resample the next input_dim samples of the signal and write the output
+  // that can be computed to output, which is resized as needed.
+  //
+  // If flush is true, the end of the signal is assumed to follow the input,
+  // and the object is reset afterwards so it can process a new signal.
+  void Resample(const float *input, int32_t input_dim, bool flush,
+                std::vector<float> *output);
+
+  // Forget the signal seen so far
+  void Reset();
+
+  int32_t GetInputSamplingRate() const { return samp_rate_in_; }
+  int32_t GetOutputSamplingRate() const { return samp_rate_out_; }
+
+  // What Reset() clears: the position in the signal and the input kept for
+  // the next output samples. It is all a resampler needs to carry on with a
+  // signal in another object with the same constructor arguments.
+  struct State {
+    int64_t input_sample_offset = 0;
+    int64_t output_sample_offset = 0;
+    std::vector<float> input_remainder;
+  };
+
+  State GetState() const;
+  void SetState(const State &state);
+
+  // The filter table, shared between resamplers with the same parameters
+  struct Filter;
+
+ private:
+  // Number of output samples for input_num_samp input samples; if flush is
+  // false, the ones that need input beyond the end are not counted.
+  int64_t GetNumOutputSamples(int64_t input_num_samp, bool flush) const;
+
+  // The first input sample and the weights to use for output sample
+  // samp_out, which is the samp_out_wrapped-th of its period.
+  void GetIndexes(int64_t samp_out, int64_t *first_samp_in,
+                  int32_t *samp_out_wrapped) const;
+
+  // Keep the last samples of the input that later outputs may need
+  void SetRemainder(const float *input, int32_t input_dim);
+
+  int32_t samp_rate_in_;
+  int32_t samp_rate_out_;
+  float filter_cutoff_;
+  int32_t num_zeros_;
+
+  std::shared_ptr<const Filter> filter_;
+
+  // Input samples before the current piece, and output samples produced
+  int64_t input_sample_offset_ = 0;
+  int64_t output_sample_offset_ = 0;
+
+  // The last few input samples, for outputs that straddle two pieces
+  std::vector<float> input_remainder_;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_RESAMPLE_H_
@@ -20,6 +20,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "log.h"
@@ -37,29 +40,58 @@ void rdft(int n, int isgn, double *a, int *ip, double *w);
 
 
 namespace knf {
+
+// The tables of rdft() for one n. rdft() fills them on its first call and
+// only reads them afterwards, so once filled they are shared by all Rfft
+// objects of that size.
+struct RfftTables {
+  std::vector<int32_t> ip;
+  std::vector<double> w;
+};
+
+static const RfftTables *GetSharedRfftTables(int32_t n) {
+  static std::mutex mutex;
+  static std::map<int32_t, std::unique_ptr<RfftTables>> tables;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unique_ptr<RfftTables> &t = tables[n];
+  if (!t) {
+    t = std::make_unique<RfftTables>();
+    t->ip.resize(2 + std::sqrt(n / 2));
+    t->w.resize(n / 2);
+
+    std::vector<double> zeros(n);
+    rdft(n, 1, zeros.data(), t->ip.data(), t->w.data());
+  }
+  return t.get();
+}
+
 class Rfft::RfftImpl {
  public:
-  explicit RfftImpl(int32_t n) : n_(n), ip_(2 + std::sqrt(n / 2)), w_(n / 2) {
+  explicit RfftImpl(int32_t n)
+      : n_(n), tables_(GetSharedRfftTables(n)), d_(n) {
     KNF_CHECK_EQ(n & (n - 1), 0);
   }
 
   void Compute(float *in_out) {
-    std::vector<double> d(in_out, in_out + n_);
+    std::copy(in_out, in_out + n_, d_.begin());
 
-    Compute(d.data());
+    Compute(d_.data());
 
-    std::copy(d.begin(), d.end(), in_out);
+    std::copy(d_.begin(), d_.end(), in_out);
   }
 
   void Compute(double *in_out) {
-    // 1 means forward fft
-    rdft(n_, 1, in_out, ip_.data(), w_.data());
+    // 1 means forward fft. The tables are already filled, so rdft() does
+    // not write to them.
+    rdft(n_, 1, in_out, const_cast<int32_t *>(tables_->ip.data()),
+         const_cast<double *>(tables_->w.data()));
   }
 
  private:
   int32_t n_;
-  std::vector<int32_t> ip_;
-  std::vector<double> w_;
+  const RfftTables *tables_;  // shared
+  std::vector<double> d_;     // workspace of Compute(float *)
 };
 
 Rfft::Rfft(int32_t n) : impl_(std::make_unique<RfftImpl>(n)) {}
@@ -0,0 +1,225 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The CM, CM2 and CM3 encodings of small matrices whose bytes can be worked
+// out by hand from Kaldi's CompressedMatrix code: the inputs are chosen so
+// that every quantized value is well away from a rounding boundary. Then
+// the decoded values of a random matrix, against the error bounds of each
+// format.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "compressed-matrix.h"
+#include "gtest/gtest.h"
+
+namespace knf {
+
+static std::vector<uint8_t> Compress(const std::vector<float> &data,
+                                     int32_t rows, int32_t cols,
+                                     CompressionMethod method) {
+  std::vector<uint8_t> out;
+  EXPECT_TRUE(CompressMatrix(data.data(), rows, cols, method, &out));
+  EXPECT_EQ(out.size(), CompressedMatrixSize(rows, cols, method));
+  return out;
+}
+
+static std::vector<float> Decompress(const std::vector<uint8_t> &bytes) {
+  int32_t rows = 0, cols = 0;
+  size_t num_bytes = 0;
+  EXPECT_TRUE(GetCompressedMatrixInfo(bytes.data(), bytes.size(), &rows,
+                                      &cols, &num_bytes));
+  EXPECT_EQ(num_bytes, bytes.size());
+  std::vector<float> out(static_cast<size_t>(rows) * cols);
+  EXPECT_TRUE(DecompressMatrix(bytes.data(), bytes.size(), out.data()));
+  return out;
+}
+
+// The token and the GlobalHeader {min_value, range, num_rows, num_cols},
+// little-endian
+static std::vector<uint8_t> Header(const char *token, float min_value,
+                                   float range, int32_t rows, int32_t cols) {
+  std::vector<uint8_t> ans(token, token + std::strlen(token));
+  auto append = [&ans](const void *p) {
+    const uint8_t *b = static_cast<const uint8_t *>(p);
+    ans.insert(ans.end(), b, b + 4);
+  };
+  append(&min_value);
+  append(&range);
+  append(&rows);
+  append(&cols);
+  return ans;
+}
+
+static std::vector<uint8_t> Concat(std::vector<uint8_t> a,
+                                   const std::vector<uint8_t> &b) {
+  a.insert(a.end(), b.begin(), b.end());
+  return a;
+}
+
+TEST(CompressedMatrix, TwoByte) {
+  // min 0, range 3: the values are 0, 1/3, 2/3 and 1 of 65535
+  std::vector<float> data = {0, 1, 2, 3};
+  std::vector<uint8_t> expected =
+      Concat(Header("CM2 ", 0, 3, 2, 2),
+             {0x00, 0x00, 0x55, 0x55, 0xaa, 0xaa, 0xff, 0xff});
+  EXPECT_EQ(Compress(data, 2, 2, CompressionMethod::kTwoByteAuto), expected);
+  // at most 8 rows, the automatic choice is CM2
+  EXPECT_EQ(Compress(data, 2, 2, CompressionMethod::kAutomatic), expected);
+}
+
+TEST(CompressedMatrix, OneByte) {
+  std::vector<float> data = {0, 1, 2, 3};
+  std::vector<uint8_t> expected =
+      Concat(Header("CM3 ", 0, 3, 2, 2), {0x00, 0x55, 0xaa, 0xff});
+  EXPECT_EQ(Compress(data, 2, 2, CompressionMethod::kOneByteAuto), expected);
+}
+
+TEST(CompressedMatrix, SpeechFeature) {
+  // One column 0 .. 7, so the percentiles are those of rows 0, 2, 6 and 7:
+  // 0, 2/7, 6/7 and 1 of 65535. The bytes are then 64ths of [0, 2),
+  // 128ths of [2, 6) and 63rds of [6, 7].
+  std::vector<float> data = {0, 1, 2, 3, 4, 5, 6, 7};
+  std::vector<uint8_t> expected =
+      Concat(Header("CM ", 0, 7, 8, 1),
+             {0x00, 0x00, 0x24, 0x49, 0x6d, 0xdb, 0xff, 0xff,  // percentiles
+              0x00, 0x20, 0x40, 0x60, 0x80, 0xa0, 0xc0, 0xff});
+  EXPECT_EQ(Compress(data, 8, 1, CompressionMethod::kSpeechFeature), expected);
+  // 8 rows are still too few for the automatic choice
+  EXPECT_EQ(Compress(data, 8, 1, CompressionMethod::kAutomatic)[2], '2');
+
+  // more than 8 rows, the automatic choice is CM
+  data.push_back(8);
+  std::vector<uint8_t> bytes =
+      Compress(data, 9, 1, CompressionMethod::kAutomatic);
+  EXPECT_EQ(std::string(bytes.begin(), bytes.begin() + 3), "CM ");
+  EXPECT_EQ(bytes.size(), 3 + 16 + 8 + 9u);
+}
+
+// With fewer than 5 rows the sorted values are the percentiles, each at
+// least one above the one before.
+TEST(CompressedMatrix, SpeechFeatureFewRows) {
+  std::vector<float> data = {0, 1, 2, 3};
+  std::vector<uint8_t> expected =
+      Concat(Header("CM ", 0, 3, 4, 1),
+             {0x00, 0x00, 0x55, 0x55, 0xaa, 0xaa, 0xff, 0xff,
+              0x00, 0x40, 0xc0, 0xff});
+  EXPECT_EQ(Compress(data, 4, 1, CompressionMethod::kSpeechFeature), expected);
+
+  // One row: the column of the minimum starts at 0, that of the maximum is
+  // pushed down to leave room for the three above it.
+  data = {1, 2};
+  expected = Concat(Header("CM ", 1, 1, 1, 2),
+                    {0x00, 0x00, 0x01, 0x00, 0x02, 0x00, 0x03, 0x00,
+                     0xfc, 0xff, 0xfd, 0xff, 0xfe, 0xff, 0xff, 0xff,
+                     0x00,    // column 0
+                     0xff});  // column 1
+  EXPECT_EQ(Compress(data, 1, 2, CompressionMethod::kSpeechFeature), expected);
+}
+
+// A constant matrix gets a range of 1 + |value| and decodes exactly.
+TEST(CompressedMatrix, Constant) {
+  std::vector<float> data(6, 5.0f);
+  std::vector<uint8_t> expected =
+      Concat(Header("CM2 ", 5, 6, 3, 2), std::vector<uint8_t>(12, 0));
+  EXPECT_EQ(Compress(data, 3, 2, CompressionMethod::kTwoByteAuto), expected);
+
+  for (auto method :
+       {CompressionMethod::kSpeechFeature, CompressionMethod::kTwoByteAuto,
+        CompressionMethod::kOneByteAuto}) {
+    EXPECT_EQ(Decompress(Compress(data, 3, 2, method)), data);
+  }
+}
+
+TEST(CompressedMatrix, RoundTrip) {
+  int32_t rows = 100, cols = 13;
+  std::mt19937 rng(0);
+  std::normal_distribution<float> dist(0, 1);
+  std::vector<float> data(rows * cols);
+  for (int32_t c = 0; c < cols; ++c) {
+    // columns of different scales, like features
+    for (int32_t r = 0; r < rows; ++r) {
+      data[r * cols + c] = (c + 1) * dist(rng) - 2 * c;
+    }
+  }
+  auto minmax = std::minmax_element(data.begin(), data.end());
+  float range = *minmax.second - *minmax.first;
+
+  // Linear formats: half a step, a little more as Kaldi rounds with + 0.499,
+  // plus float rounding
+  std::vector<float> out =
+      Decompress(Compress(data, rows, cols, CompressionMethod::kTwoByteAuto));
+  for (size_t i = 0; i != data.size(); ++i) {
+    EXPECT_NEAR(out[i], data[i], range / 65535 * 0.501 + 1e-5) << i;
+  }
+  out = Decompress(Compress(data, rows, cols, CompressionMethod::kOneByteAuto));
+  for (size_t i = 0; i != data.size(); ++i) {
+    EXPECT_NEAR(out[i], data[i], range / 255 * 0.501 + 1e-5) << i;
+  }
+
+  // CM: half of the coarsest step, 63 for the top quarter of the column,
+  // plus the quantization of the percentiles to 16 bits of the range
+  out = Decompress(
+      Compress(data, rows, cols, CompressionMethod::kSpeechFeature));
+  for (int32_t c = 0; c < cols; ++c) {
+    float lo = data[c], hi = data[c];
+    for (int32_t r = 0; r < rows; ++r) {
+      lo = std::min(lo, data[r * cols + c]);
+      hi = std::max(hi, data[r * cols + c]);
+    }
+    float bound = (hi - lo) / 63 * 0.5 + range / 65535 + 1e-5;
+    for (int32_t r = 0; r < rows; ++r) {
+      EXPECT_NEAR(out[r * cols + c], data[r * cols + c], bound)
+          << r << ", " << c;
+    }
+  }
+}
+
+TEST(CompressedMatrix, ArchiveEntryAndErrors) {
+  std::vector<float> data = {0, 1, 2, 3};
+  std::vector<uint8_t> bytes = {'\0', 'B'};
+  ASSERT_TRUE(CompressMatrix(data.data(), 2, 2,
+                             CompressionMethod::kTwoByteAuto, &bytes));
+  std::vector<float> decoded = Decompress(bytes);
+  for (size_t i = 0; i != data.size(); ++i) {
+    EXPECT_NEAR(decoded[i], data[i], 1e-5);
+  }
+
+  // truncated data, a bad token, an empty matrix and non-finite values
+  std::vector<float> out(4);
+  EXPECT_FALSE(DecompressMatrix(bytes.data(), bytes.size() - 1, out.data()));
+  bytes[4] = '4';
+  EXPECT_FALSE(DecompressMatrix(bytes.data(), bytes.size(), out.data()));
+  std::vector<uint8_t> ignored;
+  EXPECT_FALSE(CompressMatrix(data.data(), 0, 2,
+                              CompressionMethod::kTwoByteAuto, &ignored));
+  data[1] = NAN;
+  EXPECT_FALSE(CompressMatrix(data.data(), 2, 2,
+                              CompressionMethod::kOneByteAuto, &ignored));
+  data[1] = INFINITY;
+  EXPECT_FALSE(CompressMatrix(data.data(), 2, 2,
+                              CompressionMethod::kSpeechFeature, &ignored));
+  EXPECT_TRUE(ignored.empty());
+}
+
+}  // namespace knf
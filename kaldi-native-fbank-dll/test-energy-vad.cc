@@ -0,0 +1,292 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// EnergyVad on its own, against a direct statement of its rules: a frame
+// is speech if any of itself and the hangover_frames frames before it
+// passed the thresholds, and segment events are the changes of that flag.
+// Then the VAD inside OnlineFbank: streamed in pieces it must give the same
+// flags, events and frames as in one piece, the stored frames must be
+// those of a stream without VAD at the speech frames, and the flags must
+// be released along with the frames.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "energy-vad.h"
+#include "gtest/gtest.h"
+#include "kaldi-math.h"
+#include "online-feature.h"
+
+namespace knf {
+
+static bool operator==(const VadEvent &a, const VadEvent &b) {
+  return a.type == b.type && a.frame == b.frame &&
+         a.speech_frame == b.speech_frame;
+}
+
+static std::vector<uint8_t> Hangover(const std::vector<uint8_t> &active,
+                                     int32_t hangover_frames) {
+  std::vector<uint8_t> speech(active.size(), 0);
+  for (int32_t t = 0; t != static_cast<int32_t>(active.size()); ++t) {
+    for (int32_t s = std::max(0, t - hangover_frames); s <= t; ++s) {
+      speech[t] |= active[s];
+    }
+  }
+  return speech;
+}
+
+// The events of the speech flags, ending an open segment at the end
+static std::vector<VadEvent> Events(const std::vector<uint8_t> &speech) {
+  std::vector<VadEvent> events;
+  int32_t num_speech = 0;
+  uint8_t prev = 0;
+  for (int32_t t = 0; t <= static_cast<int32_t>(speech.size()); ++t) {
+    uint8_t cur = t < static_cast<int32_t>(speech.size()) ? speech[t] : 0;
+    if (cur != prev) {
+      events.push_back({cur ? VadEvent::kSpeechStart : VadEvent::kSpeechEnd,
+                        t, num_speech});
+    }
+    num_speech += cur;
+    prev = cur;
+  }
+  return events;
+}
+
+TEST(EnergyVad, Thresholds) {
+  EnergyVadOptions opts;
+  opts.hangover_frames = 0;
+  EnergyVad vad(opts);
+  // loud; quiet but noisy; quiet and tonal; too quiet even if noisy
+  EXPECT_TRUE(vad.AcceptFrame(13.0f, 0.0f));
+  EXPECT_TRUE(vad.AcceptFrame(11.0f, 0.3f));
+  EXPECT_FALSE(vad.AcceptFrame(12.9f, 0.29f));
+  EXPECT_FALSE(vad.AcceptFrame(10.9f, 0.9f));
+}
+
+TEST(EnergyVad, HangoverAndEvents) {
+  std::mt19937 gen(1);
+  for (int32_t hangover : {0, 1, 3, 20}) {
+    for (int32_t trial = 0; trial != 20; ++trial) {
+      // runs of active and inactive frames of random length
+      std::vector<uint8_t> active;
+      uint8_t value = trial % 2;
+      while (active.size() < 300) {
+        active.insert(active.end(), 1 + gen() % 30, value);
+        value ^= 1;
+      }
+
+      EnergyVadOptions opts;
+      opts.hangover_frames = hangover;
+      std::vector<VadEvent> events;
+      EnergyVad vad(opts, [&events](const VadEvent &e) {
+        events.push_back(e);
+      });
+      std::vector<uint8_t> speech = Hangover(active, hangover);
+      for (size_t t = 0; t != active.size(); ++t) {
+        EXPECT_EQ(vad.AcceptFrame(active[t] ? 20.0f : 0.0f, 0.0f),
+                  speech[t] != 0);
+      }
+      vad.InputFinished();
+      vad.InputFinished();  // only ends the segment once
+
+      std::vector<uint8_t> flags(active.size());
+      ASSERT_EQ(vad.GetFlags(0, flags.size(), flags.data()),
+                static_cast<int32_t>(flags.size()));
+      EXPECT_EQ(flags, speech);
+      EXPECT_EQ(events, Events(speech)) << hangover << ", " << trial;
+      EXPECT_EQ(vad.NumSpeechFrames(),
+                std::count(speech.begin(), speech.end(), 1));
+    }
+  }
+}
+
+TEST(EnergyVad, ReleaseFlags) {
+  EnergyVadOptions opts;
+  opts.hangover_frames = 0;
+  EnergyVad vad(opts);
+  // silence, speech, silence, speech: frames 0-2, 3-5, 6-7, 8-9
+  std::vector<uint8_t> speech = {0, 0, 0, 1, 1, 1, 0, 0, 1, 1};
+  for (uint8_t s : speech) {
+    vad.AcceptFrame(s ? 20.0f : 0.0f, 0.0f);
+  }
+
+  // Releasing speech frames [0, 2) releases the frames up to and including
+  // the second speech frame, frame 4.
+  vad.ReleaseSpeechFrames(2);
+  EXPECT_EQ(vad.FirstFlag(), 5);
+  uint8_t flags[10];
+  EXPECT_EQ(vad.GetFlags(0, 10, flags), 5);
+  EXPECT_EQ(std::vector<uint8_t>(flags, flags + 5),
+            std::vector<uint8_t>(speech.begin() + 5, speech.end()));
+
+  vad.ReleaseSpeechFrames(4);
+  EXPECT_EQ(vad.FirstFlag(), 9);
+  vad.ReleaseSpeechFrames(100);
+  EXPECT_EQ(vad.FirstFlag(), 10);
+  EXPECT_EQ(vad.GetFlags(0, 10, flags), 0);
+
+  // at most 3 flags from now on
+  vad.SetMaxFlags(3);
+  for (int32_t t = 0; t != 10; ++t) {
+    vad.AcceptFrame(20.0f, 0.0f);
+  }
+  EXPECT_EQ(vad.FirstFlag(), 17);
+  EXPECT_EQ(vad.GetFlags(0, 100, flags), 3);
+}
+
+// Tone bursts in faint noise: 0.3 s, a 0.1 s gap that the default hangover
+// bridges, 0.2 s, a 0.5 s gap, 0.3 s, 0.2 s of noise
+static std::vector<float> MakeWave() {
+  std::mt19937 gen(2);
+  std::uniform_real_distribution<float> noise(-1, 1);
+  std::vector<float> wave;
+  auto append = [&](double seconds, bool tone) {
+    int32_t n = static_cast<int32_t>(seconds * 16000);
+    for (int32_t i = 0; i != n; ++i) {
+      double t = i / 16000.0;
+      wave.push_back(noise(gen) +
+                     (tone ? 3000 * std::sin(2 * M_PI * 400 * t) : 0));
+    }
+  };
+  append(0.2, false);
+  append(0.3, true);
+  append(0.1, false);
+  append(0.2, true);
+  append(0.5, false);
+  append(0.3, true);
+  append(0.2, false);
+  return wave;
+}
+
+struct VadRun {
+  std::vector<float> frames;
+  std::vector<uint8_t> flags;
+  std::vector<VadEvent> events;
+};
+
+static VadRun RunFbank(const EnergyVadOptions &vad_opts, size_t chunk) {
+  FbankOptions opts;
+  opts.frame_opts.dither = 0;
+  OnlineFbank fbank(opts);
+  VadRun run;
+  EXPECT_TRUE(fbank.EnableVad(vad_opts, [&run](const VadEvent &e) {
+    run.events.push_back(e);
+  }));
+  std::vector<float> wave = MakeWave();
+  for (size_t pos = 0, n = chunk; pos < wave.size(); pos += n) {
+    n = std::min(n, wave.size() - pos);
+    fbank.AcceptWaveform(16000, wave.data() + pos, n);
+  }
+  fbank.InputFinished();
+
+  for (int32_t f = 0; f != fbank.NumFramesReady(); ++f) {
+    run.frames.insert(run.frames.end(), fbank.GetFrame(f),
+                      fbank.GetFrame(f) + fbank.Dim());
+  }
+  const EnergyVad *vad = fbank.GetVad();
+  run.flags.resize(vad->NumFrames());
+  vad->GetFlags(0, vad->NumFrames(), run.flags.data());
+  EXPECT_EQ(vad->NumSpeechFrames(), fbank.NumFramesReady());
+  return run;
+}
+
+TEST(EnergyVad, OnlineFbankStreaming) {
+  EnergyVadOptions vad_opts;
+  VadRun whole = RunFbank(vad_opts, 1 << 30);
+  for (size_t chunk : {1u, 160u, 333u, 4000u}) {
+    VadRun run = RunFbank(vad_opts, chunk);
+    EXPECT_EQ(run.flags, whole.flags) << chunk;
+    EXPECT_EQ(run.events, whole.events) << chunk;
+    EXPECT_EQ(run.frames, whole.frames) << chunk;
+  }
+
+  // The hangover of the stream is the one above on its raw decisions.
+  vad_opts.hangover_frames = 0;
+  VadRun active = RunFbank(vad_opts, 1 << 30);
+  EXPECT_EQ(whole.flags, Hangover(active.flags, 20));
+  EXPECT_EQ(whole.events, Events(whole.flags));
+  // two segments: the short gap is bridged, the long one is not
+  ASSERT_EQ(whole.events.size(), 4u);
+  EXPECT_EQ(Events(active.flags).size(), 6u);
+
+  // Stored frames are the frames of a stream without VAD at the speech
+  // frames.
+  FbankOptions opts;
+  opts.frame_opts.dither = 0;
+  OnlineFbank all(opts);
+  std::vector<float> wave = MakeWave();
+  all.AcceptWaveform(16000, wave.data(), wave.size());
+  all.InputFinished();
+  ASSERT_EQ(all.NumFramesReady(), static_cast<int32_t>(whole.flags.size()));
+  std::vector<float> speech_frames;
+  for (int32_t f = 0; f != all.NumFramesReady(); ++f) {
+    if (whole.flags[f]) {
+      speech_frames.insert(speech_frames.end(), all.GetFrame(f),
+                           all.GetFrame(f) + all.Dim());
+    }
+  }
+  EXPECT_EQ(speech_frames, whole.frames);
+}
+
+// The flags of the frames before the first stored frame are released with
+// it, and the retention limit bounds them too.
+TEST(EnergyVad, FlagsFollowFrameStore) {
+  FbankOptions opts;
+  opts.frame_opts.dither = 0;
+  std::vector<float> wave = MakeWave();
+  VadRun whole = RunFbank(EnergyVadOptions(), 1 << 30);
+  // frame index of every speech frame
+  std::vector<int32_t> speech_index;
+  for (int32_t t = 0; t != static_cast<int32_t>(whole.flags.size()); ++t) {
+    if (whole.flags[t]) {
+      speech_index.push_back(t);
+    }
+  }
+
+  OnlineFbank fbank(opts);
+  ASSERT_TRUE(fbank.EnableVad(EnergyVadOptions(), nullptr));
+  const EnergyVad *vad = fbank.GetVad();
+  size_t half = wave.size() / 2;
+  fbank.AcceptWaveform(16000, wave.data(), half);
+  int32_t release = fbank.NumFramesReady() - 5;
+  ASSERT_GT(release, 0);
+  fbank.ReleaseFrames(release);
+  fbank.AcceptWaveform(16000, wave.data() + half, wave.size() - half);
+  // the flags up to the last released speech frame went with it
+  EXPECT_EQ(vad->FirstFlag(), speech_index[release - 1] + 1);
+
+  std::vector<uint8_t> flags(vad->NumFrames());
+  int32_t n = vad->GetFlags(0, vad->NumFrames(), flags.data());
+  EXPECT_EQ(n, vad->NumFrames() - vad->FirstFlag());
+  EXPECT_EQ(std::vector<uint8_t>(flags.begin(), flags.begin() + n),
+            std::vector<uint8_t>(whole.flags.begin() + vad->FirstFlag(),
+                                 whole.flags.begin() + vad->NumFrames()));
+
+  OnlineFbank bounded(opts);
+  bounded.SetRetention(16, -1);
+  ASSERT_TRUE(bounded.EnableVad(EnergyVadOptions(), nullptr));
+  bounded.AcceptWaveform(16000, wave.data(), wave.size());
+  bounded.InputFinished();
+  EXPECT_LE(bounded.GetVad()->NumFrames() - bounded.GetVad()->FirstFlag(), 16);
+  EXPECT_EQ(bounded.GetFrameStoreStats().retained_frames, 16);
+}
+
+}  // namespace knf
@@ -0,0 +1,238 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks OnlineDeltaStage against Kaldi's add-deltas, i.e. ComputeDeltas()
+// on the whole utterance. The reference below follows DeltaFeatures in
+// kaldi/src/feat/feature-functions.cc statement by statement, with the
+// Vector operations written out as loops. The stage gets the frames in
+// pieces of various sizes and must give the same floats. A linear ramp
+// checks the replication of the first and last frames by hand.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "feature-delta.h"
+#include "gtest/gtest.h"
+#include "online-feature.h"
+
+namespace knf {
+
+class ReferenceDeltas {
+ public:
+  explicit ReferenceDeltas(const DeltaFeaturesOptions &opts) : opts_(opts) {
+    scales_.resize(opts.order + 1);
+    scales_[0].resize(1);
+    scales_[0][0] = 1.0;
+    for (int32_t i = 1; i <= opts.order; i++) {
+      std::vector<float> &prev_scales = scales_[i - 1],
+                         &cur_scales = scales_[i];
+      int32_t window = opts.window;
+      int32_t prev_offset = (static_cast<int32_t>(prev_scales.size() - 1)) / 2,
+              cur_offset = prev_offset + window;
+      cur_scales.assign(prev_scales.size() + 2 * window, 0);
+      float normalizer = 0.0;
+      for (int32_t j = -window; j <= window; j++) {
+        normalizer += j * j;
+        for (int32_t k = -prev_offset; k <= prev_offset; k++) {
+          cur_scales[j + k + cur_offset] +=
+              static_cast<float>(j) * prev_scales[k + prev_offset];
+        }
+      }
+      // cur_scales.Scale(1.0 / normalizer)
+      float alpha = 1.0 / normalizer;
+      for (auto &s : cur_scales) {
+        s *= alpha;
+      }
+    }
+  }
+
+  void Process(const std::vector<float> &input_feats, int32_t feat_dim,
+               int32_t frame, float *output_frame) const {
+    int32_t num_frames = static_cast<int32_t>(input_feats.size()) / feat_dim;
+    std::fill(output_frame, output_frame + (opts_.order + 1) * feat_dim, 0);
+    for (int32_t i = 0; i <= opts_.order; i++) {
+      const std::vector<float> &scales = scales_[i];
+      int32_t max_offset = (static_cast<int32_t>(scales.size()) - 1) / 2;
+      float *output = output_frame + i * feat_dim;
+      for (int32_t j = -max_offset; j <= max_offset; j++) {
+        int32_t offset_frame = frame + j;
+        if (offset_frame < 0)
+          offset_frame = 0;
+        else if (offset_frame >= num_frames)
+          offset_frame = num_frames - 1;
+        float scale = scales[j + max_offset];
+        if (scale != 0.0) {
+          // output.AddVec(scale, input_feats.Row(offset_frame))
+          const float *row = input_feats.data() + offset_frame * feat_dim;
+          for (int32_t d = 0; d != feat_dim; ++d) {
+            output[d] += scale * row[d];
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  DeltaFeaturesOptions opts_;
+  std::vector<std::vector<float>> scales_;
+};
+
+// ComputeDeltas()
+static std::vector<float> ReferenceComputeDeltas(
+    const DeltaFeaturesOptions &opts, const std::vector<float> &input_features,
+    int32_t dim) {
+  int32_t num_frames = static_cast<int32_t>(input_features.size()) / dim;
+  std::vector<float> output_features(input_features.size() * (opts.order + 1));
+  ReferenceDeltas delta(opts);
+  for (int32_t r = 0; r < num_frames; r++) {
+    delta.Process(input_features, dim, r,
+                  output_features.data() + r * dim * (opts.order + 1));
+  }
+  return output_features;
+}
+
+static std::vector<float> RandomFrames(int32_t num_frames, int32_t dim) {
+  std::mt19937 gen(num_frames);
+  std::uniform_real_distribution<float> dist(-20, 20);
+  std::vector<float> frames(num_frames * dim);
+  for (auto &x : frames) {
+    x = dist(gen);
+  }
+  return frames;
+}
+
+// Feed frames in pieces of chunk frames and check after each piece that
+// every frame with its full right context has been output.
+static std::vector<float> Stream(const std::vector<float> &frames, int32_t dim,
+                                 const DeltaFeaturesOptions &opts,
+                                 int32_t chunk) {
+  OnlineDeltaStage stage(dim, opts);
+  int32_t num_frames = static_cast<int32_t>(frames.size()) / dim;
+  std::vector<float> out;
+  for (int32_t f = 0; f < num_frames; f += chunk) {
+    int32_t n = std::min(chunk, num_frames - f);
+    stage.Process(frames.data() + f * dim, n, false, &out);
+    int32_t expected = std::max(0, f + n - stage.Latency());
+    EXPECT_EQ(static_cast<int32_t>(out.size()), expected * stage.Dim());
+  }
+  stage.Process(nullptr, 0, true, &out);
+  return out;
+}
+
+static void TestStreaming(const DeltaFeaturesOptions &opts) {
+  int32_t dim = 5;
+  for (int32_t num_frames : {1, 2, 3, 4, 5, 8, 9, 10, 50}) {
+    std::vector<float> frames = RandomFrames(num_frames, dim);
+    std::vector<float> expected = ReferenceComputeDeltas(opts, frames, dim);
+    for (int32_t chunk : {1, 3, 7, 64}) {
+      EXPECT_EQ(Stream(frames, dim, opts, chunk), expected)
+          << num_frames << " frames, chunks of " << chunk;
+    }
+  }
+}
+
+TEST(OnlineDeltaStage, AddDeltasDefault) {
+  TestStreaming(DeltaFeaturesOptions());
+}
+
+TEST(OnlineDeltaStage, OtherOrdersAndWindows) {
+  DeltaFeaturesOptions opts;
+  for (int32_t order : {0, 1, 2, 3}) {
+    for (int32_t window : {1, 2, 3}) {
+      opts.order = order;
+      opts.window = window;
+      TestStreaming(opts);
+    }
+  }
+}
+
+// Frame t holds t. Inside, the delta is the slope 1 and the delta-delta 0;
+// the first and last frames are repeated beyond the ends.
+TEST(OnlineDeltaStage, EdgeReplication) {
+  DeltaFeaturesOptions opts;
+  opts.order = 1;
+  std::vector<float> frames;
+  for (int32_t t = 0; t != 10; ++t) {
+    frames.push_back(static_cast<float>(t));
+  }
+  std::vector<float> out = Stream(frames, 1, opts, 3);
+  ASSERT_EQ(out.size(), 20u);
+  std::vector<float> deltas;
+  for (int32_t t = 0; t != 10; ++t) {
+    EXPECT_EQ(out[2 * t], t);
+    deltas.push_back(out[2 * t + 1]);
+  }
+  // t = 0 sees 0 0 0 1 2: (1 + 2 * 2) / 10; t = 1 sees 0 0 1 2 3:
+  // (-1 * 0 + 2 + 2 * 3) / 10; the end mirrors them.
+  std::vector<float> expected = {0.5, 0.8, 1, 1, 1, 1, 1, 1, 0.8, 0.5};
+  for (int32_t t = 0; t != 10; ++t) {
+    EXPECT_NEAR(deltas[t], expected[t], 1e-6) << t;
+  }
+
+  // A single frame is its own context: no change, up to the rounding of
+  // Kaldi's float scales, which do not quite sum to 0.
+  out = Stream({5.0f}, 1, DeltaFeaturesOptions(), 1);
+  EXPECT_EQ(out, ReferenceComputeDeltas(DeltaFeaturesOptions(), {5.0f}, 1));
+  ASSERT_EQ(out.size(), 3u);
+  EXPECT_EQ(out[0], 5);
+  EXPECT_NEAR(out[1], 0, 1e-6);
+  EXPECT_NEAR(out[2], 0, 1e-6);
+}
+
+// MFCC + deltas, as "compute-mfcc-feats | add-deltas"
+TEST(OnlineDeltaStage, AfterMfcc) {
+  MfccOptions mfcc_opts;
+  mfcc_opts.frame_opts.dither = 0;
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-3000, 3000);
+  std::vector<float> wave(16000);
+  for (auto &x : wave) {
+    x = dist(gen);
+  }
+
+  OnlineMfcc mfcc(mfcc_opts);
+  mfcc.AcceptWaveform(16000, wave.data(), wave.size());
+  mfcc.InputFinished();
+  int32_t dim = mfcc.Dim();
+  std::vector<float> feats;
+  for (int32_t f = 0; f != mfcc.NumFramesReady(); ++f) {
+    feats.insert(feats.end(), mfcc.GetFrame(f), mfcc.GetFrame(f) + dim);
+  }
+
+  DeltaFeaturesOptions opts;
+  OnlineMfcc with_deltas(mfcc_opts);
+  ASSERT_TRUE(
+      with_deltas.AddStage(std::make_unique<OnlineDeltaStage>(dim, opts)));
+  for (size_t pos = 0, n = 1111; pos < wave.size(); pos += n) {
+    n = std::min(n, wave.size() - pos);
+    with_deltas.AcceptWaveform(16000, wave.data() + pos, n);
+  }
+  with_deltas.InputFinished();
+  ASSERT_EQ(with_deltas.Dim(), 3 * dim);
+  std::vector<float> out;
+  for (int32_t f = 0; f != with_deltas.NumFramesReady(); ++f) {
+    out.insert(out.end(), with_deltas.GetFrame(f),
+               with_deltas.GetFrame(f) + 3 * dim);
+  }
+  EXPECT_EQ(out, ReferenceComputeDeltas(opts, feats, dim));
+}
+
+}  // namespace knf
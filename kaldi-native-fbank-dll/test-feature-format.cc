@@ -0,0 +1,207 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks the fp16, bf16 and int8 conversions of feature-format.h against
+// reference roundings computed in double precision, and the SIMD paths
+// against the scalar ones. Build with e.g. -mf16c (or on aarch64) to test
+// the hardware conversion.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "feature-format.h"
+#include "gtest/gtest.h"
+
+namespace knf {
+
+static uint32_t Bits(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+static float FromBits(uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+// Nearest of the two candidates, ties to the one with an even last bit
+static uint32_t NearestEven(double x, uint32_t lo, double lo_value,
+                            uint32_t hi, double hi_value) {
+  double d_lo = x - lo_value;
+  double d_hi = hi_value - x;
+  if (d_lo < d_hi) return lo;
+  if (d_hi < d_lo) return hi;
+  return (lo & 1) == 0 ? lo : hi;
+}
+
+// Round to the nearest half, ties to even, from the list of all halfs
+static uint16_t ReferenceFloatToHalf(float f) {
+  if (std::isnan(f)) return 0x7E00;
+  uint16_t sign = std::signbit(f) ? 0x8000 : 0;
+  double x = std::fabs(static_cast<double>(f));
+  // halfway between the largest half (65504) and the next step (65536)
+  if (x >= 65520.0) return sign | 0x7C00;
+  // positive halfs are ordered like their bit patterns
+  uint16_t lo = 0;
+  uint16_t hi = 0x7BFF;
+  if (x >= HalfToFloat(hi)) return sign | hi;
+  while (hi - lo > 1) {
+    uint16_t mid = (lo + hi) / 2;
+    if (HalfToFloat(mid) <= x) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return sign | static_cast<uint16_t>(NearestEven(x, lo, HalfToFloat(lo), hi,
+                                                  HalfToFloat(hi)));
+}
+
+static uint16_t ReferenceFloatToBFloat16(float f) {
+  if (std::isnan(f)) return 0x7FC0;
+  uint32_t lo = Bits(f) & 0xFFFF0000;
+  uint32_t hi = lo + 0x10000;
+  double x = f;
+  double lo_value = FromBits(lo);
+  // the step after the largest finite value is inf; compare to 2^128
+  double hi_value = (hi & 0x7F800000) == 0x7F800000
+                        ? std::copysign(std::ldexp(1.0, 128), x)
+                        : static_cast<double>(FromBits(hi));
+  if (std::signbit(f)) {
+    // magnitudes, so that lo is the smaller one
+    x = -x;
+    lo_value = -lo_value;
+    hi_value = -hi_value;
+  }
+  return static_cast<uint16_t>(
+      NearestEven(x, lo >> 16, lo_value, hi >> 16, hi_value));
+}
+
+// Random floats of all magnitudes and signs, plus the exact midpoints
+// between neighbouring halfs, where the tie rule matters
+static std::vector<float> TestValues() {
+  std::mt19937 gen(2026);
+  std::uniform_int_distribution<uint32_t> bits;
+  std::vector<float> values;
+  for (int32_t i = 0; i != 200000; ++i) {
+    float f = FromBits(bits(gen));
+    if (!std::isnan(f)) values.push_back(f);
+  }
+  std::uniform_real_distribution<float> features(-30.0f, 30.0f);
+  for (int32_t i = 0; i != 100000; ++i) {
+    values.push_back(features(gen));
+  }
+  for (uint32_t h = 0; h < 0x7BFF; h += 7) {
+    float mid = (HalfToFloat(h) + HalfToFloat(h + 1)) / 2;
+    values.push_back(mid);
+    values.push_back(-mid);
+  }
+  values.push_back(65504.0f);
+  values.push_back(65519.99f);
+  values.push_back(65520.0f);
+  values.push_back(std::numeric_limits<float>::infinity());
+  values.push_back(-std::numeric_limits<float>::infinity());
+  values.push_back(std::numeric_limits<float>::max());
+  values.push_back(std::numeric_limits<float>::denorm_min());
+  values.push_back(-0.0f);
+  return values;
+}
+
+TEST(FeatureFormat, HalfRoundTrip) {
+  for (uint32_t h = 0; h != 0x10000; ++h) {
+    float f = HalfToFloat(static_cast<uint16_t>(h));
+    uint16_t back = FloatToHalf(f);
+    if ((h & 0x7C00) == 0x7C00 && (h & 0x3FF) != 0) {
+      EXPECT_TRUE(std::isnan(f));
+      EXPECT_EQ(back, h | 0x200) << h;  // made quiet
+    } else {
+      EXPECT_EQ(back, h) << h;
+    }
+  }
+}
+
+TEST(FeatureFormat, FloatToHalfRoundsToNearestEven) {
+  std::vector<float> values = TestValues();
+  for (float f : values) {
+    ASSERT_EQ(FloatToHalf(f), ReferenceFloatToHalf(f)) << f;
+  }
+}
+
+TEST(FeatureFormat, ConvertToHalfMatchesScalar) {
+  std::vector<float> values = TestValues();
+  values.push_back(std::numeric_limits<float>::quiet_NaN());
+  values.push_back(-std::numeric_limits<float>::quiet_NaN());
+  values.push_back(1.0f);  // an odd count, so the tail loop runs too
+  RecordProperty("simd", HalfConversionIsSimd() ? "yes" : "no");
+  std::vector<uint16_t> out(values.size());
+  ConvertToHalf(values.data(), static_cast<int64_t>(values.size()),
+                out.data());
+  for (size_t i = 0; i != values.size(); ++i) {
+    ASSERT_EQ(out[i], FloatToHalf(values[i])) << values[i];
+  }
+}
+
+TEST(FeatureFormat, BFloat16RoundsToNearestEven) {
+  std::vector<float> values = TestValues();
+  std::vector<uint16_t> out(values.size());
+  ConvertToBFloat16(values.data(), static_cast<int64_t>(values.size()),
+                    out.data());
+  for (size_t i = 0; i != values.size(); ++i) {
+    ASSERT_EQ(out[i], ReferenceFloatToBFloat16(values[i])) << values[i];
+    ASSERT_EQ(FloatToBFloat16(BFloat16ToFloat(out[i])), out[i]);
+  }
+  EXPECT_TRUE(std::isnan(
+      BFloat16ToFloat(FloatToBFloat16(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+TEST(FeatureFormat, Int8Rows) {
+  const int32_t rows = 3;
+  const int32_t cols = 80;
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<float> dist(-20.0f, 5.0f);
+  std::vector<float> in(rows * cols);
+  for (auto &v : in) v = dist(gen);
+  std::fill(in.begin() + cols, in.begin() + 2 * cols, 0.0f);  // row 1: zeros
+  in[2 * cols + 5] = -40.0f;  // row 2: max at a negative value
+
+  std::vector<int8_t> q(rows * cols);
+  std::vector<float> scales(rows);
+  ASSERT_TRUE(ConvertFeatures(in.data(), rows, cols, FeatureFormat::kInt8,
+                              q.data(), scales.data()));
+  EXPECT_EQ(scales[1], 0.0f);
+  EXPECT_FLOAT_EQ(scales[2], 40.0f / 127);
+  EXPECT_EQ(q[2 * cols + 5], -127);
+  for (int32_t r = 0; r != rows; ++r) {
+    for (int32_t c = 0; c != cols; ++c) {
+      float v = in[r * cols + c];
+      int8_t expected = static_cast<int8_t>(
+          scales[r] == 0 ? 0 : std::nearbyint(v / scales[r]));
+      EXPECT_EQ(q[r * cols + c], expected);
+      EXPECT_LE(std::fabs(scales[r] * q[r * cols + c] - v),
+                scales[r] / 2 * 1.0001f);
+    }
+  }
+}
+
+}  // namespace knf
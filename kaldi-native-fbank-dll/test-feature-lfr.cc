@@ -0,0 +1,235 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks LfrCmvnStage against FunASR's apply_lfr() and apply_cmvn() from
+// funasr/frontends/wav_frontend.py. The reference below follows them
+// statement by statement on a whole utterance; the stage gets the same
+// frames in pieces of various sizes and must give the same floats.
+//
+// test-data/am.mvn is in the layout of the am.mvn files of FunASR models,
+// 80 x 7 wide, with made-up statistics.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "feature-lfr.h"
+#include "gtest/gtest.h"
+#include "online-feature.h"
+
+#ifndef KNF_TEST_DATA_DIR
+#define KNF_TEST_DATA_DIR "test-data"
+#endif
+
+namespace knf {
+
+// apply_lfr(), then apply_cmvn() if opts has statistics; inputs is
+// num_frames x dim
+static std::vector<float> ReferenceLfrCmvn(const std::vector<float> &inputs,
+                                           int32_t dim,
+                                           const LfrCmvnOptions &opts) {
+  int32_t lfr_m = opts.lfr_m;
+  int32_t lfr_n = opts.lfr_n;
+  int32_t T = static_cast<int32_t>(inputs.size()) / dim;
+  int32_t T_lfr = (T + lfr_n - 1) / lfr_n;  // np.ceil(T / lfr_n)
+
+  // left_padding = np.tile(inputs[0], ((lfr_m - 1) // 2, 1))
+  // inputs = np.vstack((left_padding, inputs))
+  std::vector<float> padded;
+  for (int32_t i = 0; i != (lfr_m - 1) / 2; ++i) {
+    padded.insert(padded.end(), inputs.begin(), inputs.begin() + dim);
+  }
+  padded.insert(padded.end(), inputs.begin(), inputs.end());
+  T = T + (lfr_m - 1) / 2;
+
+  std::vector<float> lfr;
+  for (int32_t i = 0; i != T_lfr; ++i) {
+    if (lfr_m <= T - i * lfr_n) {
+      lfr.insert(lfr.end(), padded.begin() + i * lfr_n * dim,
+                 padded.begin() + (i * lfr_n + lfr_m) * dim);
+    } else {  // process last LFR frame
+      int32_t num_padding = lfr_m - (T - i * lfr_n);
+      lfr.insert(lfr.end(), padded.begin() + i * lfr_n * dim, padded.end());
+      for (int32_t k = 0; k != num_padding; ++k) {
+        lfr.insert(lfr.end(), padded.end() - dim, padded.end());
+      }
+    }
+  }
+
+  // inputs = (inputs + means) * vars, with means from <AddShift> and vars
+  // from <Rescale>
+  if (!opts.neg_mean.empty()) {
+    size_t lfr_dim = opts.neg_mean.size();
+    for (size_t i = 0; i != lfr.size(); ++i) {
+      lfr[i] = (lfr[i] + opts.neg_mean[i % lfr_dim]) *
+               opts.inv_stddev[i % lfr_dim];
+    }
+  }
+  return lfr;
+}
+
+static std::vector<float> RandomFrames(int32_t num_frames, int32_t dim) {
+  std::mt19937 gen(num_frames);
+  std::uniform_real_distribution<float> dist(-10, 10);
+  std::vector<float> frames(num_frames * dim);
+  for (auto &x : frames) {
+    x = dist(gen);
+  }
+  return frames;
+}
+
+// Feed frames in pieces of chunk frames and check after each piece that
+// every output frame whose lfr_m frames are all there has been output.
+static std::vector<float> Stream(const std::vector<float> &frames, int32_t dim,
+                                 const LfrCmvnOptions &opts, int32_t chunk) {
+  LfrCmvnStage stage(dim, opts);
+  int32_t num_frames = static_cast<int32_t>(frames.size()) / dim;
+  int32_t left = (opts.lfr_m - 1) / 2;
+  std::vector<float> out;
+  for (int32_t f = 0; f < num_frames; f += chunk) {
+    int32_t n = std::min(chunk, num_frames - f);
+    stage.Process(frames.data() + f * dim, n, false, &out);
+    int32_t num_padded = f + n + left;
+    int32_t expected =
+        num_padded >= opts.lfr_m ? (num_padded - opts.lfr_m) / opts.lfr_n + 1
+                                 : 0;
+    EXPECT_EQ(static_cast<int32_t>(out.size()), expected * stage.Dim());
+  }
+  stage.Process(nullptr, 0, true, &out);
+  return out;
+}
+
+static void TestStreaming(int32_t dim, const LfrCmvnOptions &opts) {
+  for (int32_t num_frames : {1, 2, 3, 4, 5, 6, 7, 11, 12, 13, 61}) {
+    std::vector<float> frames = RandomFrames(num_frames, dim);
+    std::vector<float> expected = ReferenceLfrCmvn(frames, dim, opts);
+    // ceil(T / lfr_n) output frames
+    ASSERT_EQ(expected.size(), static_cast<size_t>(
+                                   (num_frames + opts.lfr_n - 1) /
+                                   opts.lfr_n * dim * opts.lfr_m));
+    for (int32_t chunk : {1, 2, 5, 64}) {
+      EXPECT_EQ(Stream(frames, dim, opts, chunk), expected)
+          << num_frames << " frames, chunks of " << chunk;
+    }
+  }
+}
+
+TEST(LfrCmvnStage, Lfr7x6) { TestStreaming(4, LfrCmvnOptions()); }
+
+TEST(LfrCmvnStage, OtherSizes) {
+  LfrCmvnOptions opts;
+  opts.lfr_m = 5;
+  opts.lfr_n = 3;
+  TestStreaming(3, opts);
+  opts.lfr_m = 4;  // even, so more right than left context
+  opts.lfr_n = 2;
+  TestStreaming(3, opts);
+  opts.lfr_m = 1;
+  opts.lfr_n = 1;
+  TestStreaming(3, opts);
+}
+
+TEST(LfrCmvnStage, LeftPadding) {
+  // frame i holds i
+  int32_t dim = 2;
+  std::vector<float> frames;
+  for (int32_t i = 0; i != 20; ++i) {
+    frames.insert(frames.end(), dim, static_cast<float>(i));
+  }
+  std::vector<float> out = Stream(frames, dim, LfrCmvnOptions(), 3);
+  // output 0 stacks 3 copies of frame 0, then frames 0 .. 3; output 1
+  // starts at padded frame 6, i.e. frame 3
+  std::vector<float> first(out.begin(), out.begin() + 7 * dim);
+  EXPECT_EQ(first, std::vector<float>({0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2,
+                                       3, 3}));
+  EXPECT_EQ(out[7 * dim], 3);
+  // 4 outputs; the last starts at frame 15 and repeats frame 19 twice
+  ASSERT_EQ(out.size(), 4u * 7 * dim);
+  std::vector<float> last(out.end() - 7 * dim, out.end());
+  EXPECT_EQ(last, std::vector<float>({15, 15, 16, 16, 17, 17, 18, 18, 19,
+                                      19, 19, 19, 19, 19}));
+}
+
+TEST(LfrCmvnStage, AmMvn) {
+  LfrCmvnOptions opts;
+  ASSERT_TRUE(ReadAmMvn(std::string(KNF_TEST_DATA_DIR) + "/am.mvn",
+                        &opts.neg_mean, &opts.inv_stddev));
+  ASSERT_EQ(opts.neg_mean.size(), 560u);
+  ASSERT_EQ(opts.inv_stddev.size(), 560u);
+  EXPECT_EQ(opts.neg_mean[0], -8.0f);
+  EXPECT_EQ(opts.neg_mean[80], -8.001f);
+  EXPECT_EQ(opts.neg_mean[559], -11.956f);
+  EXPECT_EQ(opts.inv_stddev[0], 0.1f);
+  EXPECT_EQ(opts.inv_stddev[559], 0.258f);
+
+  TestStreaming(80, opts);
+
+  // As the stage of an 80-bin fbank stream
+  FbankOptions fbank_opts;
+  fbank_opts.frame_opts.dither = 0;
+  fbank_opts.mel_opts.num_bins = 80;
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-3000, 3000);
+  std::vector<float> wave(16000);
+  for (auto &x : wave) {
+    x = dist(gen);
+  }
+
+  OnlineFbank fbank(fbank_opts);
+  fbank.AcceptWaveform(16000, wave.data(), wave.size());
+  fbank.InputFinished();
+  std::vector<float> feats;
+  for (int32_t f = 0; f != fbank.NumFramesReady(); ++f) {
+    feats.insert(feats.end(), fbank.GetFrame(f), fbank.GetFrame(f) + 80);
+  }
+
+  OnlineFbank lfr(fbank_opts);
+  ASSERT_TRUE(lfr.AddStage(std::make_unique<LfrCmvnStage>(80, opts)));
+  for (size_t pos = 0, n = 1000; pos < wave.size(); pos += n) {
+    n = std::min(n, wave.size() - pos);
+    lfr.AcceptWaveform(16000, wave.data() + pos, n);
+  }
+  lfr.InputFinished();
+  ASSERT_EQ(lfr.Dim(), 560);
+  std::vector<float> stacked;
+  for (int32_t f = 0; f != lfr.NumFramesReady(); ++f) {
+    stacked.insert(stacked.end(), lfr.GetFrame(f), lfr.GetFrame(f) + 560);
+  }
+  EXPECT_EQ(stacked, ReferenceLfrCmvn(feats, 80, opts));
+}
+
+TEST(LfrCmvnStage, ReadAmMvnRejectsMalformed) {
+  std::vector<float> neg_mean, inv_stddev;
+  std::istringstream no_rescale("<Nnet>\n<AddShift> 2 2\n"
+                                "<LearnRateCoef> 0 [ 1 2 ]\n</Nnet>\n");
+  EXPECT_FALSE(ReadAmMvn(no_rescale, &neg_mean, &inv_stddev));
+  std::istringstream bad_number("<AddShift> 2 2\n<LearnRateCoef> 0 [ 1 x ]\n"
+                                "<Rescale> 2 2\n<LearnRateCoef> 0 [ 1 2 ]\n");
+  EXPECT_FALSE(ReadAmMvn(bad_number, &neg_mean, &inv_stddev));
+  std::istringstream sizes_differ("<AddShift> 2 2\n<LearnRateCoef> 0 [ 1 2 ]\n"
+                                  "<Rescale> 1 1\n<LearnRateCoef> 0 [ 1 ]\n");
+  EXPECT_FALSE(ReadAmMvn(sizes_differ, &neg_mean, &inv_stddev));
+  EXPECT_FALSE(ReadAmMvn(std::string(KNF_TEST_DATA_DIR) + "/missing.mvn",
+                         &neg_mean, &inv_stddev));
+}
+
+}  // namespace knf
@@ -0,0 +1,191 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The compiled-in FixedMelKernel and FixedFft configurations give the same
+// floats as the generic MelBanks / fft() path they replace, which
+// SetFixedKernelsEnabled(false) selects. Every other configuration must not
+// get a kernel at all.
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "feature-fbank.h"
+#include "fixed-mel-kernel.h"
+#include "gtest/gtest.h"
+#include "kaldi-math.h"
+#include "mel-computations.h"
+#include "online-feature.h"
+#include "whisper-feature.h"
+
+namespace knf {
+
+// 1.5 seconds of tones, a chirp and noise
+static std::vector<float> MakeWave() {
+  std::mt19937 gen(7);
+  std::vector<float> wave(24000);
+  for (size_t i = 0; i != wave.size(); ++i) {
+    double t = i / 16000.0;
+    wave[i] = static_cast<float>(
+        6000 * std::sin(2 * M_PI * 300 * t) +
+        4000 * std::sin(2 * M_PI * (100 * t + 2000 * t * t)) +
+        1000 * (gen() / 2147483648.0 - 1.0));
+  }
+  return wave;
+}
+
+template <class F, class Options>
+static std::vector<float> Compute(const Options &opts, bool fixed) {
+  SetFixedKernelsEnabled(fixed);
+  F feature(opts);
+  SetFixedKernelsEnabled(true);
+
+  std::vector<float> wave = MakeWave();
+  feature.AcceptWaveform(16000, wave.data(), wave.size());
+  feature.InputFinished();
+  std::vector<float> out;
+  for (int32_t f = 0; f != feature.NumFramesReady(); ++f) {
+    const float *p = feature.GetFrame(f);
+    out.insert(out.end(), p, p + feature.Dim());
+  }
+  return out;
+}
+
+template <class F, class Options>
+static void ExpectSameAsGeneric(const Options &opts) {
+  std::vector<float> fixed = Compute<F>(opts, true);
+  std::vector<float> generic = Compute<F>(opts, false);
+  ASSERT_GT(fixed.size(), 0u);
+  EXPECT_EQ(fixed, generic);
+}
+
+static const MelKernel *KernelFor(const FbankOptions &opts) {
+  return GetSharedMelKernel(
+      opts.mel_opts, opts.frame_opts.PaddedWindowSize(),
+      GetSharedMelBanks(opts.mel_opts, opts.frame_opts));
+}
+
+// The mel banks of WhisperFeatureComputer
+static const MelKernel *KernelFor(const WhisperFeatureOptions &opts) {
+  WhisperFeatureComputer computer(opts);
+  FrameExtractionOptions frame_opts = computer.GetFrameOptions();
+  MelBanksOptions mel_opts;
+  mel_opts.num_bins = opts.dim;
+  mel_opts.low_freq = 0;
+  mel_opts.is_librosa = true;
+  return GetSharedMelKernel(mel_opts, frame_opts.PaddedWindowSize(),
+                            GetSharedMelBanks(mel_opts, frame_opts));
+}
+
+static FbankOptions Fbank80() {
+  FbankOptions opts;
+  opts.frame_opts.dither = 0;
+  opts.mel_opts.num_bins = 80;
+  return opts;
+}
+
+TEST(FixedMelKernel, Fbank512x80) {
+  FbankOptions opts = Fbank80();
+  ASSERT_NE(KernelFor(opts), nullptr);
+  ExpectSameAsGeneric<OnlineFbank>(opts);
+
+  opts.use_energy = true;
+  opts.frame_opts.window_type = "hamming";
+  opts.frame_opts.snip_edges = false;
+  ExpectSameAsGeneric<OnlineFbank>(opts);
+
+  opts.use_power = false;
+  opts.use_log_fbank = false;
+  ExpectSameAsGeneric<OnlineFbank>(opts);
+}
+
+TEST(FixedMelKernel, Whisper400x80) {
+  WhisperFeatureOptions opts;
+  ASSERT_NE(KernelFor(opts), nullptr);
+  ExpectSameAsGeneric<OnlineWhisperFbank>(opts);
+}
+
+TEST(FixedMelKernel, Whisper400x128) {
+  WhisperFeatureOptions opts;
+  opts.dim = 128;
+  ASSERT_NE(KernelFor(opts), nullptr);
+  ExpectSameAsGeneric<OnlineWhisperFbank>(opts);
+}
+
+// Sizes that are not compiled in, and mel options only MelBanks handles
+TEST(FixedMelKernel, FallsBackToMelBanks) {
+  FbankOptions opts = Fbank80();
+  opts.mel_opts.num_bins = 23;
+  EXPECT_EQ(KernelFor(opts), nullptr);
+
+  opts = Fbank80();
+  opts.frame_opts.frame_length_ms = 50;  // 1024-point FFT
+  EXPECT_EQ(KernelFor(opts), nullptr);
+
+  opts = Fbank80();
+  opts.frame_opts.samp_freq = 8000;  // 256-point FFT
+  EXPECT_EQ(KernelFor(opts), nullptr);
+
+  opts = Fbank80();
+  opts.mel_opts.htk_mode = true;
+  EXPECT_EQ(KernelFor(opts), nullptr);
+
+  WhisperFeatureOptions whisper_opts;
+  whisper_opts.dim = 64;
+  EXPECT_EQ(KernelFor(whisper_opts), nullptr);
+
+  EXPECT_NE(KernelFor(Fbank80()), nullptr);
+  SetFixedKernelsEnabled(false);
+  EXPECT_EQ(KernelFor(Fbank80()), nullptr);
+  SetFixedKernelsEnabled(true);
+}
+
+// A VTLN warp other than 1 needs its own mel banks, so FbankComputer uses
+// MelBanks for it even when the kernel exists.
+TEST(FixedMelKernel, VtlnWarpUsesMelBanks) {
+  FbankOptions opts = Fbank80();
+  FbankComputer fixed(opts);
+  SetFixedKernelsEnabled(false);
+  FbankComputer generic(opts);
+  SetFixedKernelsEnabled(true);
+
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<float> dist(-3000, 3000);
+  int32_t n = opts.frame_opts.PaddedWindowSize();
+  std::vector<float> frame(n);
+  for (auto &x : frame) {
+    x = dist(gen);
+  }
+
+  for (float warp : {0.9f, 1.0f, 1.1f}) {
+    std::vector<float> a = frame, b = frame;
+    std::vector<float> out_fixed(fixed.Dim()), out_generic(generic.Dim());
+    fixed.Compute(0, warp, &a, out_fixed.data());
+    generic.Compute(0, warp, &b, out_generic.data());
+    EXPECT_EQ(out_fixed, out_generic) << warp;
+  }
+
+  std::vector<float> a = frame, b = frame;
+  std::vector<float> warped(fixed.Dim()), unwarped(fixed.Dim());
+  fixed.Compute(0, 0.9f, &a, warped.data());
+  fixed.Compute(0, 1.0f, &b, unwarped.data());
+  EXPECT_NE(warped, unwarped);
+}
+
+}  // namespace knf
@@ -0,0 +1,308 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares fbank, MFCC and whisper features of a fixed set of waveforms
+// with reference outputs in test-data/golden, so that optimized kernels
+// (SIMD, float FFT, fast log, ...) can be checked against the scalar code
+// they replace.
+//
+// To regenerate the references with the current build, run the test with
+// the environment variable KNF_GOLDEN_REGENERATE=1. Only do that from the
+// plain scalar code path.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "kaldi-math.h"
+#include "online-feature.h"
+
+#ifndef KNF_TEST_DATA_DIR
+#define KNF_TEST_DATA_DIR "test-data"
+#endif
+
+namespace knf {
+
+static constexpr float kSampleRate = 16000;
+static constexpr int32_t kNumSamples = 8000;  // 0.5 seconds
+
+// Waveforms are generated, so the references only have to store outputs.
+// They cover tonal, broadband, silent and clipped input, in the range of
+// 16-bit samples.
+struct TestWaveform {
+  const char *name;
+  std::function<std::vector<float>()> generate;
+};
+
+static std::vector<TestWaveform> GetTestWaveforms() {
+  return {
+      {"tones",
+       []() {
+         std::vector<float> s(kNumSamples);
+         for (int32_t i = 0; i != kNumSamples; ++i) {
+           double t = i / kSampleRate;
+           s[i] = static_cast<float>(8000 * std::sin(2 * M_PI * 440 * t) +
+                                     3000 * std::sin(2 * M_PI * 2500 * t));
+         }
+         return s;
+       }},
+      {"chirp",
+       []() {
+         // 100 Hz to 7.9 kHz
+         std::vector<float> s(kNumSamples);
+         double duration = kNumSamples / kSampleRate;
+         double k = (7900 - 100) / duration;
+         for (int32_t i = 0; i != kNumSamples; ++i) {
+           double t = i / kSampleRate;
+           s[i] = static_cast<float>(
+               10000 * std::sin(2 * M_PI * (100 * t + 0.5 * k * t * t)));
+         }
+         return s;
+       }},
+      {"noise",
+       []() {
+         // std::mt19937 is fully specified, unlike the distributions, so
+         // map its output to [-1, 1) ourselves.
+         std::mt19937 gen(12345);
+         std::vector<float> s(kNumSamples);
+         for (auto &x : s) {
+           x = static_cast<float>(4000 * (gen() / 2147483648.0 - 1.0));
+         }
+         return s;
+       }},
+      {"silence_then_clipped",
+       []() {
+         // digital silence, then a clipped square-ish wave
+         std::vector<float> s(kNumSamples, 0);
+         for (int32_t i = kNumSamples / 2; i != kNumSamples; ++i) {
+           double v = 40000 * std::sin(2 * M_PI * 150 * i / kSampleRate);
+           s[i] = static_cast<float>(std::max(-32768.0, std::min(32767.0, v)));
+         }
+         return s;
+       }},
+  };
+}
+
+// Largest allowed differences from the reference.
+//
+// Relative errors are measured against the largest |value| of the frame
+// (at least 1), since a log-mel bin or cepstrum near zero is not more
+// important than the others.
+//
+// Float32 FFTs have a noise floor far below the strongest bin, and any
+// change in rounding moves the log of bins down there a lot without
+// affecting a model. If dynamic_range > 0, values more than dynamic_range
+// below the maximum of the frame are therefore clamped to that floor, in
+// both outputs, before comparing.
+struct Tolerance {
+  float max_abs;
+  float max_rel;
+  float dynamic_range;
+};
+
+struct FeatureConfig {
+  const char *name;
+  Tolerance tolerance;
+  // Compute features for a whole waveform, fed in pieces
+  std::function<std::vector<float>(const std::vector<float> &, int32_t *)>
+      compute;
+};
+
+template <class F, class Options>
+static std::vector<float> ComputeOnline(const Options &opts,
+                                        const std::vector<float> &wave,
+                                        int32_t *dim) {
+  F feature(opts);
+  // an odd chunk size, so that frames straddle AcceptWaveform() calls
+  const int32_t chunk = 1234;
+  for (int32_t i = 0; i < static_cast<int32_t>(wave.size()); i += chunk) {
+    int32_t n = std::min<int32_t>(chunk, wave.size() - i);
+    feature.AcceptWaveform(kSampleRate, wave.data() + i, n);
+  }
+  feature.InputFinished();
+
+  *dim = feature.Dim();
+  std::vector<float> out;
+  for (int32_t f = 0; f != feature.NumFramesReady(); ++f) {
+    const float *p = feature.GetFrame(f);
+    out.insert(out.end(), p, p + *dim);
+  }
+  return out;
+}
+
+static std::vector<FeatureConfig> GetFeatureConfigs() {
+  return {
+      {"fbank80",
+       {2e-3f, 1e-4f, 10.0f},
+       [](const std::vector<float> &wave, int32_t *dim) {
+         FbankOptions opts;
+         opts.frame_opts.dither = 0;
+         opts.mel_opts.num_bins = 80;
+         return ComputeOnline<OnlineFbank>(opts, wave, dim);
+       }},
+      {"fbank80_energy",
+       {2e-3f, 1e-4f, 10.0f},
+       [](const std::vector<float> &wave, int32_t *dim) {
+         FbankOptions opts;
+         opts.frame_opts.dither = 0;
+         opts.frame_opts.snip_edges = false;
+         opts.frame_opts.window_type = "hamming";
+         opts.mel_opts.num_bins = 80;
+         opts.use_energy = true;
+         return ComputeOnline<OnlineFbank>(opts, wave, dim);
+       }},
+      {"mfcc13",
+       {0.2f, 4e-3f, 0.0f},
+       [](const std::vector<float> &wave, int32_t *dim) {
+         MfccOptions opts;
+         opts.frame_opts.dither = 0;
+         return ComputeOnline<OnlineMfcc>(opts, wave, dim);
+       }},
+      {"whisper80",
+       {2e-3f, 5e-4f, 0.0f},
+       [](const std::vector<float> &wave, int32_t *dim) {
+         WhisperFeatureOptions opts;
+         return ComputeOnline<OnlineWhisperFbank>(opts, wave, dim);
+       }},
+      {"whisper128",
+       {2e-3f, 5e-4f, 0.0f},
+       [](const std::vector<float> &wave, int32_t *dim) {
+         WhisperFeatureOptions opts;
+         opts.dim = 128;
+         return ComputeOnline<OnlineWhisperFbank>(opts, wave, dim);
+       }},
+  };
+}
+
+// File format: "KNFG", int32 num_frames, int32 dim, then num_frames * dim
+// float32, all little endian.
+static bool ReadGolden(const std::string &filename, int32_t *num_frames,
+                       int32_t *dim, std::vector<float> *data) {
+  std::ifstream is(filename, std::ios::binary);
+  char magic[4];
+  if (!is.read(magic, 4) || std::string(magic, 4) != "KNFG") {
+    return false;
+  }
+  is.read(reinterpret_cast<char *>(num_frames), sizeof(int32_t));
+  is.read(reinterpret_cast<char *>(dim), sizeof(int32_t));
+  data->resize(static_cast<size_t>(*num_frames) * *dim);
+  is.read(reinterpret_cast<char *>(data->data()),
+          data->size() * sizeof(float));
+  return static_cast<bool>(is);
+}
+
+static void WriteGolden(const std::string &filename, int32_t num_frames,
+                        int32_t dim, const std::vector<float> &data) {
+  std::ofstream os(filename, std::ios::binary);
+  os.write("KNFG", 4);
+  os.write(reinterpret_cast<const char *>(&num_frames), sizeof(int32_t));
+  os.write(reinterpret_cast<const char *>(&dim), sizeof(int32_t));
+  os.write(reinterpret_cast<const char *>(data.data()),
+           data.size() * sizeof(float));
+}
+
+struct GoldenCase {
+  FeatureConfig feature;
+  TestWaveform wave;
+};
+
+static std::vector<GoldenCase> GetGoldenCases() {
+  std::vector<GoldenCase> ans;
+  for (const auto &feature : GetFeatureConfigs()) {
+    for (const auto &wave : GetTestWaveforms()) {
+      ans.push_back({feature, wave});
+    }
+  }
+  return ans;
+}
+
+class GoldenFeatureTest : public ::testing::TestWithParam<GoldenCase> {};
+
+TEST_P(GoldenFeatureTest, MatchesReference) {
+  const GoldenCase &c = GetParam();
+  std::string filename = std::string(KNF_TEST_DATA_DIR) + "/golden/" +
+                         c.feature.name + "-" + c.wave.name + ".bin";
+
+  int32_t dim = 0;
+  std::vector<float> features = c.feature.compute(c.wave.generate(), &dim);
+  int32_t num_frames = static_cast<int32_t>(features.size()) / dim;
+
+  const char *regenerate = std::getenv("KNF_GOLDEN_REGENERATE");
+  if (regenerate != nullptr && std::string(regenerate) == "1") {
+    WriteGolden(filename, num_frames, dim, features);
+    GTEST_SKIP() << "wrote " << filename;
+  }
+
+  int32_t ref_num_frames = 0;
+  int32_t ref_dim = 0;
+  std::vector<float> ref;
+  ASSERT_TRUE(ReadGolden(filename, &ref_num_frames, &ref_dim, &ref))
+      << "cannot read " << filename;
+  ASSERT_EQ(num_frames, ref_num_frames);
+  ASSERT_EQ(dim, ref_dim);
+
+  const Tolerance &tol = c.feature.tolerance;
+  float max_abs = 0;
+  float max_rel = 0;
+  int32_t worst = 0;
+  for (int32_t f = 0; f != num_frames; ++f) {
+    const float *r = ref.data() + f * dim;
+    const float *x = features.data() + f * dim;
+
+    float scale = 1;
+    float floor = -std::numeric_limits<float>::infinity();
+    if (tol.dynamic_range > 0) {
+      floor = *std::max_element(r, r + dim) - tol.dynamic_range;
+    }
+    for (int32_t d = 0; d != dim; ++d) {
+      scale = std::max(scale, std::abs(r[d]));
+    }
+
+    for (int32_t d = 0; d != dim; ++d) {
+      float abs_err = std::abs(std::max(x[d], floor) - std::max(r[d], floor));
+      if (abs_err > max_abs) {
+        max_abs = abs_err;
+        worst = f * dim + d;
+      }
+      max_rel = std::max(max_rel, abs_err / scale);
+    }
+  }
+
+  EXPECT_LE(max_abs, tol.max_abs)
+      << "frame " << worst / dim << ", bin " << worst % dim
+      << ": got " << features[worst] << ", expected " << ref[worst];
+  EXPECT_LE(max_rel, tol.max_rel);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Golden, GoldenFeatureTest, ::testing::ValuesIn(GetGoldenCases()),
+    [](const ::testing::TestParamInfo<GoldenCase> &info) {
+      std::string name =
+          std::string(info.param.feature.name) + "_" + info.param.wave.name;
+      return name;
+    });
+
+}  // namespace knf
@@ -0,0 +1,270 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks OnlineCmvnStage against Kaldi's OnlineCmvn, as used by
+// apply-cmvn-online: the smoothing with speaker and global statistics of
+// OnlineCmvn::SmoothOnlineCmvnStats() and the normalization of ApplyCmvn().
+//
+// The reference below follows those functions statement by statement, but
+// recomputes the statistics of every window from scratch instead of
+// updating them as frames arrive; the two only differ in the order of
+// double-precision additions. The constant-input tests check the
+// smoothing against values worked out by hand.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "feature-cmvn.h"
+#include "gtest/gtest.h"
+#include "kaldi-math.h"
+#include "online-feature.h"
+
+namespace knf {
+
+static constexpr float kSampleRate = 16000;
+
+// Log-mel features of 2 seconds of tones and noise; seed selects the noise
+static std::vector<float> ComputeFbank(uint32_t seed, int32_t *dim) {
+  std::mt19937 gen(seed);
+  std::vector<float> wave(2 * static_cast<int32_t>(kSampleRate));
+  for (size_t i = 0; i != wave.size(); ++i) {
+    double t = i / kSampleRate;
+    wave[i] = static_cast<float>(
+        5000 * std::sin(2 * M_PI * (200 + 50 * (seed % 7)) * t) *
+            std::sin(2 * M_PI * 1.5 * t) +
+        2000 * (gen() / 2147483648.0 - 1.0));
+  }
+
+  FbankOptions opts;
+  opts.frame_opts.dither = 0;
+  opts.mel_opts.num_bins = 23;
+  OnlineFbank fbank(opts);
+  fbank.AcceptWaveform(kSampleRate, wave.data(), wave.size());
+  fbank.InputFinished();
+
+  *dim = fbank.Dim();
+  std::vector<float> feats;
+  for (int32_t f = 0; f != fbank.NumFramesReady(); ++f) {
+    const float *p = fbank.GetFrame(f);
+    feats.insert(feats.end(), p, p + *dim);
+  }
+  return feats;
+}
+
+// Statistics of all frames, in the layout of OnlineCmvnState
+static std::vector<double> SumStats(const std::vector<float> &feats,
+                                    int32_t dim) {
+  std::vector<double> stats(2 * (dim + 1), 0);
+  for (size_t i = 0; i != feats.size(); ++i) {
+    double x = feats[i];
+    stats[i % dim] += x;
+    stats[dim + 1 + i % dim] += x * x;
+  }
+  stats[dim] = static_cast<double>(feats.size() / dim);
+  return stats;
+}
+
+// OnlineCmvn::SmoothOnlineCmvnStats()
+static void SmoothStats(const std::vector<double> &speaker_stats,
+                        const std::vector<double> &global_stats,
+                        const OnlineCmvnOptions &opts, int32_t dim,
+                        std::vector<double> *stats) {
+  double cur_count = (*stats)[dim];
+  if (cur_count >= opts.cmn_window) return;
+  if (!speaker_stats.empty()) {
+    double count_from_speaker = opts.cmn_window - cur_count,
+           speaker_count = speaker_stats[dim];
+    if (count_from_speaker > opts.speaker_frames)
+      count_from_speaker = opts.speaker_frames;
+    if (count_from_speaker > speaker_count) count_from_speaker = speaker_count;
+    if (count_from_speaker > 0.0) {
+      for (size_t i = 0; i != stats->size(); ++i) {
+        (*stats)[i] += count_from_speaker / speaker_count * speaker_stats[i];
+      }
+    }
+    cur_count = (*stats)[dim];
+  }
+  if (cur_count >= opts.cmn_window) return;
+  if (!global_stats.empty()) {
+    double count_from_global = opts.cmn_window - cur_count,
+           global_count = global_stats[dim];
+    if (count_from_global > opts.global_frames)
+      count_from_global = opts.global_frames;
+    if (count_from_global > 0.0) {
+      for (size_t i = 0; i != stats->size(); ++i) {
+        (*stats)[i] += count_from_global / global_count * global_stats[i];
+      }
+    }
+  }
+}
+
+// ApplyCmvn() on one frame
+static void ApplyStats(const std::vector<double> &stats, bool var_norm,
+                       int32_t dim, float *feat) {
+  double count = stats[dim];
+  if (!var_norm) {
+    float alpha = static_cast<float>(-1.0 / count);
+    for (int32_t d = 0; d != dim; ++d) {
+      float offset = static_cast<float>(alpha * stats[d]);
+      feat[d] += 1.0f * offset;
+    }
+    return;
+  }
+  for (int32_t d = 0; d != dim; ++d) {
+    double mean = stats[d] / count;
+    double var = (stats[dim + 1 + d] / count) - mean * mean, floor = 1.0e-20;
+    if (var < floor) var = floor;
+    double scale = 1.0 / std::sqrt(var);
+    double offset = -(mean * scale);
+    feat[d] *= static_cast<float>(scale);
+    feat[d] += 1.0f * static_cast<float>(offset);
+  }
+}
+
+// OnlineCmvn::GetFrame() for every frame
+static std::vector<float> KaldiOnlineCmvn(const std::vector<float> &feats,
+                                          int32_t dim,
+                                          const OnlineCmvnOptions &opts,
+                                          const OnlineCmvnState &state) {
+  int32_t num_frames = static_cast<int32_t>(feats.size() / dim);
+  std::vector<float> out(feats);
+  for (int32_t t = 0; t != num_frames; ++t) {
+    std::vector<double> stats(2 * (dim + 1), 0);
+    for (int32_t f = std::max(0, t - opts.cmn_window + 1); f <= t; ++f) {
+      for (int32_t d = 0; d != dim; ++d) {
+        double x = feats[static_cast<size_t>(f) * dim + d];
+        stats[d] += x;
+        stats[dim + 1 + d] += x * x;
+      }
+      stats[dim] += 1;
+    }
+    SmoothStats(state.speaker_stats, state.global_stats, opts, dim, &stats);
+    ApplyStats(stats, opts.normalize_variance, dim,
+               out.data() + static_cast<size_t>(t) * dim);
+  }
+  return out;
+}
+
+static std::vector<float> RunStage(const std::vector<float> &feats,
+                                   int32_t dim, const OnlineCmvnOptions &opts,
+                                   const OnlineCmvnState &state) {
+  OnlineCmvnStage stage(dim, opts, state);
+  std::vector<float> out;
+  // in pieces, as an online extractor would call it
+  int32_t num_frames = static_cast<int32_t>(feats.size() / dim);
+  for (int32_t f = 0; f < num_frames; f += 7) {
+    int32_t n = std::min(7, num_frames - f);
+    stage.Process(feats.data() + static_cast<size_t>(f) * dim, n, false, &out);
+  }
+  return out;
+}
+
+static void ExpectNear(const std::vector<float> &ref,
+                       const std::vector<float> &out, float tolerance) {
+  ASSERT_EQ(ref.size(), out.size());
+  float max_err = 0;
+  for (size_t i = 0; i != ref.size(); ++i) {
+    max_err = std::max(max_err, std::abs(ref[i] - out[i]));
+  }
+  EXPECT_LE(max_err, tolerance);
+}
+
+struct CmvnCase {
+  int32_t cmn_window;
+  int32_t speaker_frames;
+  int32_t global_frames;
+  bool normalize_variance;
+  bool with_speaker;
+  bool with_global;
+};
+
+TEST(OnlineCmvn, MatchesKaldi) {
+  int32_t dim = 0;
+  std::vector<float> feats = ComputeFbank(1, &dim);
+  std::vector<float> speaker = ComputeFbank(2, &dim);
+  std::vector<float> global = ComputeFbank(3, &dim);
+  ASSERT_GT(feats.size() / dim, 150u);
+
+  const CmvnCase cases[] = {
+      // Kaldi's defaults; the window never fills up
+      {600, 600, 200, false, false, true},
+      {600, 600, 200, true, false, true},
+      {600, 600, 200, false, true, true},
+      {600, 600, 200, true, true, true},
+      // a short window, which fills up, and every limit in play
+      {50, 30, 20, false, true, true},
+      {50, 30, 20, true, true, true},
+      {50, 200, 40, true, true, true},
+      {50, 30, 20, true, true, false},
+      {50, 30, 20, true, false, false},
+  };
+  for (const CmvnCase &c : cases) {
+    OnlineCmvnOptions opts;
+    opts.cmn_window = c.cmn_window;
+    opts.speaker_frames = c.speaker_frames;
+    opts.global_frames = c.global_frames;
+    opts.normalize_variance = c.normalize_variance;
+    OnlineCmvnState state;
+    if (c.with_speaker) state.speaker_stats = SumStats(speaker, dim);
+    if (c.with_global) state.global_stats = SumStats(global, dim);
+
+    SCOPED_TRACE(opts.ToString() + "speaker: " +
+                 std::to_string(c.with_speaker) +
+                 ", global: " + std::to_string(c.with_global));
+    ExpectNear(KaldiOnlineCmvn(feats, dim, opts, state),
+               RunStage(feats, dim, opts, state), 1e-4f);
+  }
+}
+
+// A constant feature of 1 with global statistics of mean 11 (and speaker
+// statistics of mean 5): frame t is normalized with the mean of the last
+// min(t + 1, cmn_window) frames and the smoothing frames added by Kaldi's
+// rules.
+TEST(OnlineCmvn, SmoothingCounts) {
+  const int32_t num_frames = 700;
+  std::vector<float> feats(num_frames, 1.0f);
+  OnlineCmvnOptions opts;  // 600, 600, 200
+
+  OnlineCmvnState global_only;
+  global_only.global_stats = {11000.0, 1000.0, 121000.0, 0.0};
+  std::vector<float> out = RunStage(feats, 1, opts, global_only);
+  for (int32_t t : {0, 9, 299, 399, 449, 599, 650}) {
+    double count = std::min(t + 1, 600);  // the window
+    double from_global = std::max(std::min(600 - count, 200.0), 0.0);
+    double mean = (count + 11 * from_global) / (count + from_global);
+    EXPECT_NEAR(out[t], 1 - mean, 1e-5) << "frame " << t;
+  }
+  EXPECT_EQ(out[599], 0.0f);
+
+  OnlineCmvnState with_speaker = global_only;
+  with_speaker.speaker_stats = {500.0, 100.0, 2500.0, 0.0};
+  out = RunStage(feats, 1, opts, with_speaker);
+  for (int32_t t : {0, 9, 299, 449, 499, 599}) {
+    double count = t + 1;
+    double from_speaker = std::min(600 - count, 100.0);
+    double from_global = std::min(600 - count - from_speaker, 200.0);
+    double mean = (count + 5 * from_speaker + 11 * from_global) /
+                  (count + from_speaker + from_global);
+    EXPECT_NEAR(out[t], 1 - mean, 1e-5) << "frame " << t;
+  }
+}
+
+}  // namespace knf
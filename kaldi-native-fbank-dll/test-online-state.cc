@@ -0,0 +1,202 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A stream saved with SaveState() in the middle of an utterance and loaded
+// into a fresh one with LoadState() carries on exactly as if it had never
+// stopped, with or without a resampler in front. States of streams with
+// other options, and damaged states, are rejected without touching the
+// stream.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "kaldi-math.h"
+#include "online-feature.h"
+
+namespace knf {
+
+static std::vector<float> MakeWave(int32_t samp_rate, int32_t n) {
+  std::mt19937 gen(samp_rate);
+  std::vector<float> wave(n);
+  for (int32_t i = 0; i != n; ++i) {
+    double t = static_cast<double>(i) / samp_rate;
+    wave[i] = static_cast<float>(6000 * std::sin(2 * M_PI * 330 * t) +
+                                 1000 * (gen() / 2147483648.0 - 1.0));
+  }
+  return wave;
+}
+
+// Feed wave[begin, end) in pieces that do not line up with frames
+template <class F>
+static void Feed(F *stream, float samp_rate, const std::vector<float> &wave,
+                 size_t begin, size_t end) {
+  for (size_t pos = begin, n = 777; pos < end; pos += n) {
+    n = std::min(n, end - pos);
+    stream->AcceptWaveform(samp_rate, wave.data() + pos, n);
+  }
+}
+
+// Frames [first, NumFramesReady())
+template <class F>
+static std::vector<float> Frames(const F &stream, int32_t first) {
+  std::vector<float> out;
+  for (int32_t f = first; f < stream.NumFramesReady(); ++f) {
+    const float *p = stream.GetFrame(f);
+    out.insert(out.end(), p, p + stream.Dim());
+  }
+  return out;
+}
+
+static std::vector<uint8_t> ToBytes(const std::string &s) {
+  return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+// Save after split samples, having released the frames before release,
+// then finish the utterance in a new stream
+template <class F, class Options>
+static void TestResume(const Options &opts, int32_t samp_rate, size_t split,
+                       int32_t release) {
+  std::vector<float> wave = MakeWave(samp_rate, samp_rate * 2 + 55);
+
+  F expected(opts);
+  Feed(&expected, samp_rate, wave, 0, wave.size());
+  expected.InputFinished();
+
+  F before(opts);
+  Feed(&before, samp_rate, wave, 0, split);
+  before.ReleaseFrames(release);
+  std::string state;
+  ASSERT_TRUE(before.SaveState(&state));
+
+  F after(opts);
+  std::vector<uint8_t> bytes = ToBytes(state);
+  ASSERT_TRUE(after.LoadState(bytes.data(), bytes.size()));
+  EXPECT_EQ(after.NumFramesReady(), before.NumFramesReady());
+  EXPECT_EQ(Frames(after, release), Frames(before, release));
+  Feed(&after, samp_rate, wave, split, wave.size());
+  after.InputFinished();
+
+  ASSERT_EQ(after.NumFramesReady(), expected.NumFramesReady());
+  EXPECT_EQ(Frames(after, release), Frames(expected, release));
+  // released frames stay released
+  std::vector<float> frame(after.Dim());
+  EXPECT_EQ(after.ReadFrames(release - 1, release, frame.data()), -1);
+}
+
+static FbankOptions GetFbankOptions() {
+  FbankOptions opts;
+  opts.frame_opts.dither = 0;
+  opts.mel_opts.num_bins = 80;
+  return opts;
+}
+
+TEST(OnlineState, Fbank) {
+  FbankOptions opts = GetFbankOptions();
+  // in the middle of a frame, and between two frames
+  TestResume<OnlineFbank>(opts, 16000, 12345, 10);
+  TestResume<OnlineFbank>(opts, 16000, 160 * 30 + 240, 1);
+
+  opts.frame_opts.snip_edges = false;
+  TestResume<OnlineFbank>(opts, 16000, 12345, 10);
+}
+
+TEST(OnlineState, Whisper) {
+  TestResume<OnlineWhisperFbank>(WhisperFeatureOptions(), 16000, 9999, 5);
+}
+
+// The history of the resampler is part of the state.
+TEST(OnlineState, Resampler) {
+  FbankOptions opts = GetFbankOptions();
+  opts.frame_opts.allow_upsample = true;
+  opts.frame_opts.allow_downsample = true;
+  TestResume<OnlineFbank>(opts, 8000, 6173, 10);
+  TestResume<OnlineFbank>(opts, 48000, 37037, 10);
+}
+
+TEST(OnlineState, AfterInputFinished) {
+  FbankOptions opts = GetFbankOptions();
+  std::vector<float> wave = MakeWave(16000, 8000);
+  OnlineFbank before(opts);
+  Feed(&before, 16000, wave, 0, wave.size());
+  before.InputFinished();
+  std::string state;
+  ASSERT_TRUE(before.SaveState(&state));
+
+  OnlineFbank after(opts);
+  std::vector<uint8_t> bytes = ToBytes(state);
+  ASSERT_TRUE(after.LoadState(bytes.data(), bytes.size()));
+  EXPECT_TRUE(after.IsLastFrame(after.NumFramesReady() - 1));
+  EXPECT_EQ(Frames(after, 0), Frames(before, 0));
+}
+
+TEST(OnlineState, Rejected) {
+  FbankOptions opts = GetFbankOptions();
+  std::vector<float> wave = MakeWave(16000, 8000);
+  OnlineFbank before(opts);
+  Feed(&before, 16000, wave, 0, 5000);
+  std::string state;
+  ASSERT_TRUE(before.SaveState(&state));
+  std::vector<uint8_t> bytes = ToBytes(state);
+
+  // Other options with the same dim: the fingerprint differs.
+  FbankOptions other_opts = opts;
+  other_opts.frame_opts.preemph_coeff = 0.9f;
+  OnlineFbank other(other_opts);
+  EXPECT_FALSE(other.LoadState(bytes.data(), bytes.size()));
+
+  OnlineFbank after(opts);
+  // every truncation, and trailing bytes
+  for (size_t n = 0; n != bytes.size(); ++n) {
+    EXPECT_FALSE(after.LoadState(bytes.data(), n)) << n;
+  }
+  std::vector<uint8_t> longer = bytes;
+  longer.push_back(0);
+  EXPECT_FALSE(after.LoadState(longer.data(), longer.size()));
+  std::vector<uint8_t> bad_magic = bytes;
+  bad_magic[0] = 'X';
+  EXPECT_FALSE(after.LoadState(bad_magic.data(), bad_magic.size()));
+  EXPECT_FALSE(after.LoadState(nullptr, 0));
+  EXPECT_EQ(after.NumFramesReady(), 0);
+
+  // none of that changed the stream
+  ASSERT_TRUE(after.LoadState(bytes.data(), bytes.size()));
+  EXPECT_EQ(Frames(after, 0), Frames(before, 0));
+  std::string again;
+  ASSERT_TRUE(after.SaveState(&again));
+  EXPECT_EQ(again, state);
+
+  // too late to load
+  EXPECT_FALSE(after.LoadState(bytes.data(), bytes.size()));
+  OnlineFbank started(opts);
+  Feed(&started, 16000, wave, 0, 100);
+  EXPECT_FALSE(started.LoadState(bytes.data(), bytes.size()));
+
+  // a VAD's state is not captured
+  OnlineFbank with_vad(opts);
+  ASSERT_TRUE(with_vad.EnableVad(EnergyVadOptions(), nullptr));
+  std::string ignored;
+  EXPECT_FALSE(with_vad.SaveState(&ignored));
+  EXPECT_FALSE(with_vad.LoadState(bytes.data(), bytes.size()));
+}
+
+}  // namespace knf
@@ -0,0 +1,168 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Readers of a RecyclingVector running while the writer appends and
+// releases frames. Meant to be run under AddressSanitizer and
+// ThreadSanitizer as well: a chunk freed while Read() copies from it shows
+// up there, and as garbage frames otherwise.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "online-feature.h"
+
+namespace knf {
+
+static constexpr int32_t kDim = 80;
+static constexpr int32_t kNumFrames = 200000;
+
+// Frame i holds i in every dimension
+static void PushFrames(RecyclingVector *v, std::atomic<bool> *done) {
+  for (int32_t i = 0; i != kNumFrames; ++i) {
+    float *p = v->PrepareBack(kDim);
+    std::fill(p, p + kDim, static_cast<float>(i));
+    v->CommitBack();
+  }
+  done->store(true);
+}
+
+// n frames read from out must be consecutive frames as written by
+// PushFrames(); returns the number of bad values
+static int32_t CheckFrames(const float *out, int32_t n) {
+  int32_t num_bad = 0;
+  for (int32_t f = 0; f != n; ++f) {
+    for (int32_t d = 0; d != kDim; ++d) {
+      num_bad += out[f * kDim + d] != out[0] + f;
+    }
+  }
+  return num_bad;
+}
+
+// The last 100 frames still held, over and over, while the retention limit
+// of 64 frames releases them and their chunks are reused. A read fails if
+// the first frame was released in between.
+static void ReadTail(RecyclingVector *v, bool release,
+                     const std::atomic<bool> &done, int32_t *num_reads,
+                     int32_t *num_bad) {
+  std::vector<float> out(100 * kDim);
+  while (!done.load()) {
+    int32_t size = v->Size();
+    int32_t begin = std::max(size - 100, v->FirstAvailableIndex());
+    int32_t n = v->Read(begin, size, out.data());
+    if (n > 0) {
+      *num_bad += CheckFrames(out.data(), n) + (out[0] != begin);
+      *num_reads += 1;
+    }
+    if (release) {
+      v->Release(size - 10);
+    }
+  }
+}
+
+TEST(RecyclingVector, ReadWhileRetentionReleases) {
+  RecyclingVector v;
+  v.SetRetention(64, -1);
+  std::atomic<bool> done(false);
+  int32_t num_reads = 0, num_bad = 0;
+  std::thread reader(ReadTail, &v, false, std::cref(done),
+                     &num_reads, &num_bad);
+  PushFrames(&v, &done);
+  reader.join();
+
+  EXPECT_EQ(num_bad, 0);
+  EXPECT_GT(num_reads, 0);
+  FrameStoreStats stats = v.GetStats();
+  EXPECT_EQ(stats.num_frames, kNumFrames);
+  EXPECT_EQ(stats.retained_frames, 64);
+}
+
+// Like the C API with release on read: the readers release what they read
+// and the writer reclaims the chunks.
+TEST(RecyclingVector, ReadersRelease) {
+  RecyclingVector v;
+  std::atomic<bool> done(false);
+  int32_t num_reads[2] = {0, 0}, num_bad[2] = {0, 0};
+  std::thread reader0(ReadTail, &v, true, std::cref(done),
+                      &num_reads[0], &num_bad[0]);
+  std::thread reader1(ReadTail, &v, true, std::cref(done),
+                      &num_reads[1], &num_bad[1]);
+  PushFrames(&v, &done);
+  reader0.join();
+  reader1.join();
+
+  EXPECT_EQ(num_bad[0] + num_bad[1], 0);
+  EXPECT_GT(num_reads[0] + num_reads[1], 0);
+
+  // With the readers gone, the writer frees what they released.
+  v.Release(v.Size());
+  float *p = v.PrepareBack(kDim);
+  std::fill(p, p + kDim, static_cast<float>(kNumFrames));
+  v.CommitBack();
+  p = v.PrepareBack(kDim);
+  std::fill(p, p + kDim, static_cast<float>(kNumFrames + 1));
+  v.CommitBack();
+  FrameStoreStats stats = v.GetStats();
+  EXPECT_EQ(stats.retained_frames, 2);
+  // the chunk in use and the spare
+  EXPECT_LE(stats.retained_bytes, 2 * 64 * kDim * sizeof(float));
+}
+
+TEST(RecyclingVector, ReadFailsForReleasedFrames) {
+  RecyclingVector v;
+  for (int32_t i = 0; i != 200; ++i) {
+    v.PushBack(std::vector<float>(kDim, static_cast<float>(i)));
+  }
+  v.Release(100);
+
+  std::vector<float> out(100 * kDim);
+  EXPECT_EQ(v.Read(99, 150, out.data()), -1);
+  EXPECT_EQ(v.Read(-1, 150, out.data()), -1);
+  EXPECT_EQ(v.Read(100, 1000, out.data()), 100);
+  EXPECT_EQ(CheckFrames(out.data(), 100), 0);
+  EXPECT_EQ(out[0], 100);
+  EXPECT_EQ(v.Read(150, 150, out.data()), 0);
+  EXPECT_EQ(v.Read(300, 400, out.data()), 0);
+}
+
+// Chunks are looked up by their index relative to the oldest one still
+// held, so a stream that is billions of samples in neither needs a table
+// for all of its frames nor keeps the tables it outgrew.
+TEST(RecyclingVector, TableFollowsRetainedFrames) {
+  RecyclingVector v;
+  v.StartAt(2000000000);
+  v.SetRetention(64, -1);
+  for (int32_t i = 0; i != 100000; ++i) {
+    v.PushBack(std::vector<float>(kDim, static_cast<float>(i)));
+  }
+  FrameStoreStats stats = v.GetStats();
+  EXPECT_EQ(stats.num_frames, 2000100000);
+  EXPECT_EQ(stats.retained_frames, 64);
+  // the retained frames, a partly used chunk and the spare
+  EXPECT_LE(stats.peak_retained_bytes, 4 * 64 * kDim * sizeof(float));
+
+  std::vector<float> out(64 * kDim);
+  EXPECT_EQ(v.Read(2000100000 - 64, 2000100000, out.data()), 64);
+  EXPECT_EQ(CheckFrames(out.data(), 64), 0);
+  EXPECT_EQ(out[0], 100000 - 64);
+}
+
+}  // namespace knf
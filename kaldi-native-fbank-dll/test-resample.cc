@@ -0,0 +1,196 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// LinearResample against the definition of Kaldi's resampler: output sample
+// m at time m / out_rate is the sum over every input sample n of
+// x[n] * FilterFunc(n / in_rate - m / out_rate) / in_rate, with zeros before
+// and after the signal. The reference evaluates it in double precision over
+// the whole signal, without the polyphase table. Streaming in pieces of any
+// size must give the same floats as one call, and so must the resampler
+// inside OnlineFbank.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "kaldi-math.h"
+#include "online-feature.h"
+#include "resample.h"
+
+namespace knf {
+
+static constexpr int32_t kNumZeros = 6;
+
+// Tones and noise, at about the level of 16-bit speech
+static std::vector<float> MakeWave(int32_t samp_rate, int32_t n) {
+  std::mt19937 gen(samp_rate);
+  std::uniform_real_distribution<float> noise(-1000, 1000);
+  std::vector<float> wave(n);
+  for (int32_t i = 0; i != n; ++i) {
+    double t = static_cast<double>(i) / samp_rate;
+    wave[i] = static_cast<float>(5000 * std::sin(2 * M_PI * 440 * t) +
+                                 3000 * std::sin(2 * M_PI * 2900 * t)) +
+              noise(gen);
+  }
+  return wave;
+}
+
+static double ReferenceFilter(double t, double cutoff) {
+  double window = 0;
+  if (std::fabs(t) < kNumZeros / (2.0 * cutoff)) {
+    window = 0.5 * (1 + std::cos(2 * M_PI * cutoff / kNumZeros * t));
+  }
+  double filter =
+      t != 0 ? std::sin(2 * M_PI * cutoff * t) / (M_PI * t) : 2 * cutoff;
+  return filter * window;
+}
+
+// All of the output, as after a flush: every output time before the end of
+// the input
+static std::vector<float> ReferenceResample(const std::vector<float> &in,
+                                            int32_t in_rate, int32_t out_rate,
+                                            double cutoff) {
+  int64_t num_in = in.size();
+  int64_t num_out = (num_in * out_rate + in_rate - 1) / in_rate;
+  std::vector<float> out(num_out);
+  double width = kNumZeros / (2.0 * cutoff);
+  for (int64_t m = 0; m != num_out; ++m) {
+    double t = static_cast<double>(m) / out_rate;
+    int64_t first = std::max<int64_t>(
+        0, static_cast<int64_t>(std::ceil((t - width) * in_rate)));
+    int64_t last = std::min<int64_t>(
+        num_in - 1, static_cast<int64_t>(std::floor((t + width) * in_rate)));
+    double sum = 0;
+    for (int64_t n = first; n <= last; ++n) {
+      sum += in[n] *
+             ReferenceFilter(static_cast<double>(n) / in_rate - t, cutoff) /
+             in_rate;
+    }
+    out[m] = static_cast<float>(sum);
+  }
+  return out;
+}
+
+// Pieces of the given sizes in turn, then a flush with no input
+static std::vector<float> Stream(LinearResample *resampler,
+                                 const std::vector<float> &in,
+                                 const std::vector<int32_t> &sizes) {
+  std::vector<float> out, piece;
+  size_t pos = 0;
+  for (size_t i = 0; pos < in.size(); ++i) {
+    int32_t n = std::min<int32_t>(sizes[i % sizes.size()], in.size() - pos);
+    resampler->Resample(in.data() + pos, n, false, &piece);
+    out.insert(out.end(), piece.begin(), piece.end());
+    pos += n;
+  }
+  resampler->Resample(nullptr, 0, true, &piece);
+  out.insert(out.end(), piece.begin(), piece.end());
+  return out;
+}
+
+static void TestRates(int32_t in_rate, int32_t out_rate) {
+  std::vector<float> in = MakeWave(in_rate, in_rate / 2 + 37);
+  float cutoff = std::min(in_rate, out_rate) / 2.0f;
+  LinearResample resampler(in_rate, out_rate, cutoff, kNumZeros);
+
+  std::vector<float> whole;
+  resampler.Resample(in.data(), in.size(), true, &whole);
+  std::vector<float> expected =
+      ReferenceResample(in, in_rate, out_rate, cutoff);
+  ASSERT_EQ(whole.size(), expected.size());
+  for (size_t i = 0; i != whole.size(); ++i) {
+    // a few float steps of outputs up to about 10000
+    EXPECT_NEAR(whole[i], expected[i], 0.005) << i;
+  }
+
+  // The flush resets the resampler, so it can take the signal again.
+  for (const auto &sizes : std::vector<std::vector<int32_t>>{
+           {1}, {7}, {13, 1, 160}, {4001}, {in_rate / 100}}) {
+    EXPECT_EQ(Stream(&resampler, in, sizes), whole) << sizes[0];
+  }
+}
+
+TEST(LinearResample, Upsample8kTo16k) { TestRates(8000, 16000); }
+
+TEST(LinearResample, Downsample48kTo16k) { TestRates(48000, 16000); }
+
+TEST(LinearResample, Downsample44100To16k) { TestRates(44100, 16000); }
+
+// Without a flush the outputs whose window reaches past the input are held
+// back; the flush gives them, up to the last output time before the end of
+// the input.
+TEST(LinearResample, FlushLength) {
+  for (int32_t n : {1, 2, 3, 100, 101, 8000, 8001}) {
+    LinearResample up(8000, 16000, 4000, kNumZeros);
+    std::vector<float> in = MakeWave(8000, n), held, rest;
+    up.Resample(in.data(), n, false, &held);
+    up.Resample(nullptr, 0, true, &rest);
+    EXPECT_EQ(held.size() + rest.size(), 2u * n) << n;
+    // the window is 6 / (2 * 4000) s, 6 input samples
+    EXPECT_EQ(held.size(), n > 6 ? 2u * (n - 6) : 0u) << n;
+
+    LinearResample down(48000, 16000, 8000, kNumZeros);
+    in = MakeWave(48000, n);
+    down.Resample(in.data(), n, false, &held);
+    down.Resample(nullptr, 0, true, &rest);
+    EXPECT_EQ(held.size() + rest.size(), (n + 2u) / 3) << n;
+  }
+}
+
+// OnlineFbank at 16 kHz given 8 or 48 kHz audio resamples it as above, in
+// whatever pieces it arrives.
+static void TestFbank(int32_t in_rate) {
+  std::vector<float> in = MakeWave(in_rate, in_rate + 123);
+  std::vector<float> resampled;
+  LinearResample resampler(in_rate, 16000, std::min(in_rate, 16000) / 2.0f,
+                           kNumZeros);
+  resampler.Resample(in.data(), in.size(), true, &resampled);
+
+  FbankOptions opts;
+  opts.frame_opts.dither = 0;
+  opts.frame_opts.allow_upsample = true;
+  opts.frame_opts.allow_downsample = true;
+  OnlineFbank expected(opts);
+  expected.AcceptWaveform(16000, resampled.data(), resampled.size());
+  expected.InputFinished();
+
+  OnlineFbank fbank(opts);
+  for (size_t pos = 0, n = 333; pos < in.size(); pos += n) {
+    n = std::min(n, in.size() - pos);
+    fbank.AcceptWaveform(in_rate, in.data() + pos, n);
+  }
+  fbank.InputFinished();
+
+  ASSERT_EQ(fbank.NumFramesReady(), expected.NumFramesReady());
+  ASSERT_GT(fbank.NumFramesReady(), 90);
+  for (int32_t f = 0; f != fbank.NumFramesReady(); ++f) {
+    std::vector<float> a(fbank.GetFrame(f), fbank.GetFrame(f) + fbank.Dim());
+    std::vector<float> b(expected.GetFrame(f),
+                         expected.GetFrame(f) + expected.Dim());
+    EXPECT_EQ(a, b) << f;
+  }
+}
+
+TEST(LinearResample, OnlineFbankUpsample) { TestFbank(8000); }
+
+TEST(LinearResample, OnlineFbankDownsample) { TestFbank(48000); }
+
+}  // namespace knf
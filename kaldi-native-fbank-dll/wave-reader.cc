@@ -0,0 +1,228 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "wave-reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "multichannel.h"
+
+namespace knf {
+
+namespace {
+
+// Format codes of the fmt chunk
+constexpr uint16_t kWaveFormatPcm = 1;
+constexpr uint16_t kWaveFormatIeeeFloat = 3;
+constexpr uint16_t kWaveFormatExtensible = 0xFFFE;
+
+// WAV files are little-endian, as are the platforms we build for
+uint16_t ReadUint16(const uint8_t *p) {
+  uint16_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint32_t ReadUint32(const uint8_t *p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+}  // namespace
+
+int32_t BytesPerSample(SampleFormat format) {
+  switch (format) {
+    case SampleFormat::kPcm16:
+      return 2;
+    case SampleFormat::kPcm24:
+      return 3;
+    case SampleFormat::kFloat32:
+      return 4;
+  }
+  return 0;
+}
+
+void ConvertSamples(const uint8_t *in, SampleFormat format, int64_t n,
+                    float scale, float *out) {
+  switch (format) {
+    case SampleFormat::kPcm16:
+      for (int64_t i = 0; i != n; ++i) {
+        int16_t v;
+        std::memcpy(&v, in + 2 * i, sizeof(v));
+        out[i] = v * scale;
+      }
+      break;
+    case SampleFormat::kPcm24: {
+      float s = scale / 256;
+      for (int64_t i = 0; i != n; ++i) {
+        const uint8_t *p = in + 3 * i;
+        // sign-extend through the top byte of an int32
+        int32_t v = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) |
+                                         (static_cast<uint32_t>(p[1]) << 16) |
+                                         (static_cast<uint32_t>(p[2]) << 24)) >>
+                    8;
+        out[i] = v * s;
+      }
+      break;
+    }
+    case SampleFormat::kFloat32: {
+      float s = scale * 32768;
+      for (int64_t i = 0; i != n; ++i) {
+        float v;
+        std::memcpy(&v, in + 4 * i, sizeof(v));
+        out[i] = v * s;
+      }
+      break;
+    }
+  }
+}
+
+bool WaveFileReader::Open(const std::string &filename) {
+  info_ = WaveInfo();
+  next_frame_ = 0;
+  if (!file_.Open(filename)) {
+    return false;
+  }
+  if (!ParseHeader()) {
+    file_.Close();
+    return false;
+  }
+  return true;
+}
+
+bool WaveFileReader::OpenRaw(const std::string &filename, int32_t sample_rate,
+                             int32_t num_channels, SampleFormat format) {
+  info_ = WaveInfo();
+  next_frame_ = 0;
+  if (sample_rate <= 0 || num_channels <= 0 || BytesPerSample(format) == 0 ||
+      !file_.Open(filename)) {
+    return false;
+  }
+  info_.sample_rate = sample_rate;
+  info_.num_channels = num_channels;
+  info_.format = format;
+  info_.data_offset = 0;
+  info_.data_size = file_.Size();
+  return true;
+}
+
+bool WaveFileReader::ParseHeader() {
+  int64_t size = file_.Size();
+  const uint8_t *p = size >= 12 ? file_.Map(0, 12) : nullptr;
+  if (p == nullptr || std::memcmp(p, "RIFF", 4) != 0 ||
+      std::memcmp(p + 8, "WAVE", 4) != 0) {
+    return false;
+  }
+
+  bool have_fmt = false;
+  uint16_t format_tag = 0;
+  uint16_t bits = 0;
+  int64_t offset = 12;
+  while (offset + 8 <= size) {
+    p = file_.Map(offset, 8);
+    if (p == nullptr) {
+      return false;
+    }
+    uint32_t chunk_size = ReadUint32(p + 4);
+    int64_t body = offset + 8;
+
+    if (std::memcmp(p, "fmt ", 4) == 0) {
+      if (chunk_size < 16 || body + chunk_size > size) {
+        return false;
+      }
+      const uint8_t *fmt = file_.Map(body, chunk_size);
+      if (fmt == nullptr) {
+        return false;
+      }
+      format_tag = ReadUint16(fmt);
+      info_.num_channels = ReadUint16(fmt + 2);
+      info_.sample_rate = static_cast<int32_t>(ReadUint32(fmt + 4));
+      bits = ReadUint16(fmt + 14);
+      if (format_tag == kWaveFormatExtensible) {
+        // the first two bytes of the sub-format GUID are the format code
+        if (chunk_size < 40) {
+          return false;
+        }
+        format_tag = ReadUint16(fmt + 24);
+      }
+      have_fmt = true;
+    } else if (std::memcmp(p, "data", 4) == 0) {
+      if (!have_fmt) {
+        return false;
+      }
+      info_.data_offset = body;
+      // Files still being written, or streamed, may have a placeholder
+      // size; use whatever is there.
+      info_.data_size = std::min<int64_t>(chunk_size, size - body);
+      break;
+    }
+
+    // chunks are padded to an even size
+    offset = body + chunk_size + (chunk_size & 1);
+  }
+
+  if (!have_fmt || info_.data_offset == 0 || info_.num_channels <= 0 ||
+      info_.sample_rate <= 0) {
+    return false;
+  }
+  if (format_tag == kWaveFormatPcm && bits == 16) {
+    info_.format = SampleFormat::kPcm16;
+  } else if (format_tag == kWaveFormatPcm && bits == 24) {
+    info_.format = SampleFormat::kPcm24;
+  } else if (format_tag == kWaveFormatIeeeFloat && bits == 32) {
+    info_.format = SampleFormat::kFloat32;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+int32_t WaveFileReader::ReadMono(float *out, int32_t max_frames, float scale) {
+  if (!file_.IsOpen() || max_frames < 0) {
+    return -1;
+  }
+  int32_t n = static_cast<int32_t>(
+      std::min<int64_t>(max_frames, info_.NumFrames() - next_frame_));
+  if (n <= 0) {
+    return 0;
+  }
+
+  int32_t block_align = info_.BlockAlign();
+  const uint8_t *p =
+      file_.Map(info_.data_offset + next_frame_ * block_align,
+                static_cast<size_t>(n) * block_align);
+  if (p == nullptr) {
+    return -1;
+  }
+
+  if (info_.num_channels == 1) {
+    ConvertSamples(p, info_.format, n, scale, out);
+  } else {
+    interleaved_.resize(static_cast<size_t>(n) * info_.num_channels);
+    ConvertSamples(p, info_.format, interleaved_.size(), scale,
+                   interleaved_.data());
+    DownmixInterleaved(interleaved_.data(), n, info_.num_channels, out);
+  }
+  next_frame_ += n;
+  return n;
+}
+
+}  // namespace knf
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c)  2026  manyeyes
+ *
+ * See LICENSE for clarification regarding multiple authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Streaming reader for WAV and headerless PCM files on top of MappedFile.
+// Samples are converted chunk by chunk, so a file of any length is read
+// with a small, constant amount of memory.
+
+#ifndef KALDI_NATIVE_FBANK_CSRC_WAVE_READER_H_
+#define KALDI_NATIVE_FBANK_CSRC_WAVE_READER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped-file.h"
+
+namespace knf {
+
+enum class SampleFormat : int32_t {
+  kPcm16 = 0,    // signed 16-bit little-endian
+  kPcm24 = 1,    // signed 24-bit little-endian, packed in 3 bytes
+  kFloat32 = 2,  // IEEE float, nominally in [-1, 1]
+};
+
+int32_t BytesPerSample(SampleFormat format);
+
+// Convert n samples to floats in the range of 16-bit samples, i.e.
+// [-32768, 32768), which is what Kaldi's wav reader produces and what the
+// default feature options expect; each is then multiplied by scale.
+void ConvertSamples(const uint8_t *in, SampleFormat format, int64_t n,
+                    float scale, float *out);
+
+struct WaveInfo {
+  int32_t sample_rate = 0;
+  int32_t num_channels = 0;
+  SampleFormat format = SampleFormat::kPcm16;
+  // where the samples are in the file
+  int64_t data_offset = 0;
+  int64_t data_size = 0;
+
+  int32_t BlockAlign() const { return num_channels * BytesPerSample(format); }
+  int64_t NumFrames() const { return data_size / BlockAlign(); }
+};
+
+class WaveFileReader {
+ public:
+  // Open a WAV file (PCM 16 or 24 bit, or 32-bit float, possibly
+  // WAVE_FORMAT_EXTENSIBLE). Returns false if it cannot be opened or is not
+  // a supported WAV file.
+  bool Open(const std::string &filename);
+
+  // Open a file of headerless interleaved samples
+  bool OpenRaw(const std::string &filename, int32_t sample_rate,
+               int32_t num_channels, SampleFormat format);
+
+  const WaveInfo &Info() const { return info_; }
+
+  // Read the next max_frames frames at most, with the channels averaged,
+  // into out, scaled as in ConvertSamples(). Returns the number of samples
+  // written to out; 0 at the end of the file, -1 on error.
+  int32_t ReadMono(float *out, int32_t max_frames, float scale = 1.0f);
+
+ private:
+  bool ParseHeader();
+
+  MappedFile file_;
+  WaveInfo info_;
+  int64_t next_frame_ = 0;
+  // interleaved samples of the current chunk, reused across calls
+  std::vector<float> interleaved_;
+};
+
+}  // namespace knf
+
+#endif  // KALDI_NATIVE_FBANK_CSRC_WAVE_READER_H_
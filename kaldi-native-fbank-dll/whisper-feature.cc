@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 
+#include "feature-stats.h"
 #include "log.h"
 #include "mel-computations.h"
 
@@ -124,6 +125,105 @@ static void fft(const std::vector<float> &in, std::vector<float> *out) {
   }
 }
 
+// fft() for a size known at compile time, e.g., the 400 samples of a whisper
+// frame. The recursion is resolved by the compiler and all cos/sin values
+// are computed once per size, in the same precision as in fft() and dft(),
+// so the output is bit-identical. Instead of copying the even and odd
+// samples it reads the input with a stride, and it works in place in the
+// output buffer: the two half-size transforms go to out[0, N) and
+// out[N, 2N), which is exactly where each butterfly reads them from.
+template <int32_t N, bool kOdd = (N % 2 == 1)>
+struct FixedFft;
+
+template <int32_t N>
+struct FixedFft<N, true> {
+  using Trig = decltype(cos(0.0f));
+
+  // (cos, -sin) of the angle of dft() for k * n, row major
+  static const std::vector<Trig> &Table() {
+    static const std::vector<Trig> table = [] {
+      std::vector<Trig> t(2 * N * N);
+      auto M_2PI_over_N = M_2PI / N;
+      for (int32_t k = 0; k < N; ++k) {
+        for (int32_t n = 0; n < N; ++n) {
+          float angle = M_2PI_over_N * k * n;
+          t[2 * (k * N + n) + 0] = cos(angle);
+          t[2 * (k * N + n) + 1] = sin(angle);
+        }
+      }
+      return t;
+    }();
+    return table;
+  }
+
+  static void Compute(const float *in, int32_t stride, float *out) {
+    if (N == 1) {
+      out[0] = in[0];
+      out[1] = 0;
+      return;
+    }
+
+    const Trig *t = Table().data();
+    for (int32_t k = 0; k < N; ++k) {
+      float re = 0;
+      float im = 0;
+      const Trig *row = t + 2 * k * N;
+      for (int32_t n = 0; n < N; ++n) {
+        re += in[n * stride] * row[2 * n + 0];
+        im -= in[n * stride] * row[2 * n + 1];
+      }
+      out[k * 2 + 0] = re;
+      out[k * 2 + 1] = im;
+    }
+  }
+};
+
+template <int32_t N>
+struct FixedFft<N, false> {
+  // the twiddle factors of fft(), (re, im) for k in [0, N/2)
+  static const std::vector<float> &Twiddles() {
+    static const std::vector<float> twiddles = [] {
+      std::vector<float> t(N);
+      for (int32_t k = 0; k < N / 2; ++k) {
+        float theta = M_2PI * k / N;
+        float re = cos(theta);
+        float im = -sin(theta);
+        t[2 * k + 0] = re;
+        t[2 * k + 1] = im;
+      }
+      return t;
+    }();
+    return twiddles;
+  }
+
+  // @param in N samples, in[0], in[stride], ...
+  // @param out 2 * N values, complex output
+  static void Compute(const float *in, int32_t stride, float *out) {
+    FixedFft<N / 2>::Compute(in, 2 * stride, out);
+    FixedFft<N / 2>::Compute(in + stride, 2 * stride, out + N);
+
+    const float *t = Twiddles().data();
+    for (int32_t k = 0; k < N / 2; ++k) {
+      float re = t[2 * k + 0];
+      float im = t[2 * k + 1];
+
+      float re_even = out[2 * k + 0];
+      float im_even = out[2 * k + 1];
+      float re_odd = out[2 * (k + N / 2) + 0];
+      float im_odd = out[2 * (k + N / 2) + 1];
+
+      out[2 * k + 0] = re_even + re * re_odd - im * im_odd;
+      out[2 * k + 1] = im_even + re * im_odd + im * re_odd;
+
+      out[2 * (k + N / 2) + 0] = re_even - re * re_odd + im * im_odd;
+      out[2 * (k + N / 2) + 1] = im_even - re * im_odd - im * re_odd;
+    }
+  }
+};
+
+// The frame size of whisper: 25 ms at 16 kHz, not rounded to a power of two
+static constexpr int32_t kWhisperFftSize = 400;
+
 WhisperFeatureComputer::WhisperFeatureComputer(
     const WhisperFeatureOptions &opts /*= {}*/)
     : opts_(opts) {
@@ -143,30 +243,51 @@ WhisperFeatureComputer::WhisperFeatureComputer(
   //mel_opts.high_freq = -400;
   mel_opts.is_librosa = true;
 
-  mel_banks_ = std::make_unique<MelBanks>(mel_opts, opts_.frame_opts, 1.0f);
+  mel_banks_ = GetSharedMelBanks(mel_opts, opts_.frame_opts);
+  fixed_kernel_ = GetSharedMelKernel(
+      mel_opts, opts_.frame_opts.PaddedWindowSize(), mel_banks_);
+  use_fixed_fft_ = FixedKernelsEnabled();
 }
 
 void WhisperFeatureComputer::Compute(float /*signal_raw_log_energy*/,
                                      float /*vtln_warp*/,
-                                     std::vector<float> *signal_frame,
-                                     float *feature) {
-  KNF_CHECK_EQ(signal_frame->size(), frame_opts_.PaddedWindowSize());
+                                     float *signal_frame, float *feature) {
   // we have already applied window function to signal_frame before
   // calling this method
-  std::vector<float> fft_out;
-  fft(*signal_frame, &fft_out);
-
-  int32_t num_fft = signal_frame->size();
-  std::vector<float> power(num_fft / 2 + 1);
-  for (int32_t i = 0; i <= num_fft / 2; ++i) {
-    float re = fft_out[2 * i + 0];
-    float im = fft_out[2 * i + 1];
-    power[i] = re * re + im * im;
+  std::vector<float> &fft_out = fft_out_;
+  int32_t num_fft = opts_.frame_opts.PaddedWindowSize();
+  {
+    KNF_STATS_SCOPE(kFft);
+    if (num_fft == kWhisperFftSize && use_fixed_fft_) {
+      fft_out.resize(2 * num_fft);
+      FixedFft<kWhisperFftSize>::Compute(signal_frame, 1, fft_out.data());
+    } else {
+      fft(std::vector<float>(signal_frame, signal_frame + num_fft), &fft_out);
+    }
+  }
+
+  std::vector<float> &power = power_;
+  power.resize(num_fft / 2 + 1);
+  {
+    KNF_STATS_SCOPE(kPowerSpectrum);
+    for (int32_t i = 0; i <= num_fft / 2; ++i) {
+      float re = fft_out[2 * i + 0];
+      float im = fft_out[2 * i + 1];
+      power[i] = re * re + im * im;
+    }
   }
   // feature is pre-allocated by the user
-  mel_banks_->Compute(power.data(), feature);
+  {
+    KNF_STATS_SCOPE(kMel);
+    if (fixed_kernel_) {
+      fixed_kernel_->Compute(power.data(), feature);
+    } else {
+      mel_banks_->Compute(power.data(), feature);
+    }
+  }
   int cols = mel_banks_->NumBins();
   int rows = 1;
+  KNF_STATS_SCOPE(kLog);
   try {
       Convert(feature, rows, cols, feature);
   }
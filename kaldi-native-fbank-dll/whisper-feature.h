@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "feature-window.h"
+#include "fixed-mel-kernel.h"
 #include "mel-computations.h"
 
 namespace knf {
@@ -51,8 +52,19 @@ class WhisperFeatureComputer {
     return opts_.frame_opts;
   }
 
+  const WhisperFeatureOptions &GetOptions() const { return opts_; }
+
+  void Compute(float signal_raw_log_energy, float vtln_warp,
+               std::vector<float> *signal_frame, float *feature) {
+    KNF_CHECK_EQ(signal_frame->size(), opts_.frame_opts.PaddedWindowSize());
+    Compute(signal_raw_log_energy, vtln_warp, signal_frame->data(), feature);
+  }
+
+  // The same as above with signal_frame pointing to
+  // GetFrameOptions().PaddedWindowSize() values, which need not be in a
+  // std::vector, e.g., a row of a batch matrix
   void Compute(float /*signal_raw_log_energy*/, float /*vtln_warp*/,
-               std::vector<float> *signal_frame, float *feature);
+               float *signal_frame, float *feature);
 
   void Convert(const float* features, int rows, int cols, float* output);
 
@@ -62,8 +74,17 @@ class WhisperFeatureComputer {
   using Options = WhisperFeatureOptions;
 
  private:
-  std::unique_ptr<MelBanks> mel_banks_;
+  // shared, see GetSharedMelBanks() and GetSharedMelKernel()
+  const MelBanks *mel_banks_ = nullptr;
+  // Not null if opts.dim is a compiled-in FixedMelKernel size
+  const MelKernel *fixed_kernel_ = nullptr;
+  // FixedKernelsEnabled() when constructed
+  bool use_fixed_fft_ = true;
   WhisperFeatureOptions opts_;
+
+  // per-frame buffers, reused
+  std::vector<float> fft_out_;
+  std::vector<float> power_;
 };
 
 }  // namespace knf